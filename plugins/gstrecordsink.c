@@ -0,0 +1,645 @@
+/* GStreamer
+ * Copyright (C) 2012 Duzy Chan <code@duzy.info>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE             /* O_DIRECT and fallocate */
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+#include "gstrecordsink.h"
+#include "../logutils.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_record_sink_debug);
+#define GST_CAT_DEFAULT gst_record_sink_debug
+
+#ifndef FALLOC_FL_KEEP_SIZE
+#define FALLOC_FL_KEEP_SIZE 0x01
+#endif
+
+#define GST_RECORD_SINK_ALIGN 4096
+#define GST_RECORD_SINK_CHUNK (1024 * 1024)
+#define GST_RECORD_SINK_DEFAULT_RING_SIZE (64 * 1024 * 1024)
+#define GST_RECORD_SINK_DEFAULT_PREALLOCATE (64 * 1024 * 1024)
+#define GST_RECORD_SINK_WAIT (10 * G_TIME_SPAN_MILLISECOND)
+#define GST_RECORD_SINK_STATS_PERIOD G_TIME_SPAN_SECOND
+
+static GstStaticPadTemplate gst_record_sink_sink_factory =
+GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+enum
+{
+  PROP_0,
+  PROP_LOCATION,
+  PROP_RING_SIZE,
+  PROP_PREALLOCATE,
+  PROP_DIRECT,
+  PROP_RING_LEVEL,
+  PROP_WRITE_LATENCY,
+  PROP_MAX_WRITE_LATENCY,
+};
+
+#define gst_record_sink_parent_class parent_class
+G_DEFINE_TYPE (GstRecordSink, gst_record_sink, GST_TYPE_BASE_SINK);
+
+static void
+gst_record_sink_init (GstRecordSink * sink)
+{
+  sink->location = NULL;
+  sink->ring_size = GST_RECORD_SINK_DEFAULT_RING_SIZE;
+  sink->preallocate = GST_RECORD_SINK_DEFAULT_PREALLOCATE;
+  sink->direct = FALSE;
+  sink->fd = -1;
+  sink->ring = NULL;
+  sink->writer = NULL;
+
+  g_mutex_init (&sink->lock);
+  g_mutex_init (&sink->stats_lock);
+  g_cond_init (&sink->cond);
+
+  gst_base_sink_set_sync (GST_BASE_SINK (sink), FALSE);
+}
+
+static void
+gst_record_sink_finalize (GstRecordSink * sink)
+{
+  g_free (sink->location);
+  sink->location = NULL;
+
+  g_mutex_clear (&sink->lock);
+  g_mutex_clear (&sink->stats_lock);
+  g_cond_clear (&sink->cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (G_OBJECT (sink));
+}
+
+static guint
+gst_record_sink_ring_level (GstRecordSink * sink)
+{
+  if (!sink->ring)
+    return 0;
+  return (guint) ((guint64) g_atomic_int_get (&sink->fill) * 100 /
+      sink->ring_size);
+}
+
+static void
+gst_record_sink_set_property (GstRecordSink * sink, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  switch (prop_id) {
+    case PROP_LOCATION:
+      g_free (sink->location);
+      sink->location = g_value_dup_string (value);
+      break;
+    case PROP_RING_SIZE:
+    {
+      guint size = g_value_get_uint (value);
+      sink->ring_size = MAX (GST_RECORD_SINK_ALIGN,
+          size - size % GST_RECORD_SINK_ALIGN);
+      break;
+    }
+    case PROP_PREALLOCATE:
+      sink->preallocate = g_value_get_uint64 (value);
+      break;
+    case PROP_DIRECT:
+      sink->direct = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (G_OBJECT (sink), prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_record_sink_get_property (GstRecordSink * sink, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  switch (prop_id) {
+    case PROP_LOCATION:
+      g_value_set_string (value, sink->location);
+      break;
+    case PROP_RING_SIZE:
+      g_value_set_uint (value, sink->ring_size);
+      break;
+    case PROP_PREALLOCATE:
+      g_value_set_uint64 (value, sink->preallocate);
+      break;
+    case PROP_DIRECT:
+      g_value_set_boolean (value, sink->direct);
+      break;
+    case PROP_RING_LEVEL:
+      g_value_set_uint (value, gst_record_sink_ring_level (sink));
+      break;
+    case PROP_WRITE_LATENCY:
+      g_mutex_lock (&sink->stats_lock);
+      g_value_set_uint64 (value, sink->latency);
+      g_mutex_unlock (&sink->stats_lock);
+      break;
+    case PROP_MAX_WRITE_LATENCY:
+      g_mutex_lock (&sink->stats_lock);
+      g_value_set_uint64 (value, sink->latency_max);
+      g_mutex_unlock (&sink->stats_lock);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (G_OBJECT (sink), prop_id, pspec);
+      break;
+  }
+}
+
+/**
+ * The ring is only locked for sleeping, the data is handed over between the
+ * streaming thread and the writer thread by the atomic %fill.
+ */
+static void
+gst_record_sink_wait (GstRecordSink * sink, volatile gint * waiting)
+{
+  g_mutex_lock (&sink->lock);
+  g_atomic_int_set (waiting, 1);
+  g_cond_wait_until (&sink->cond, &sink->lock,
+      g_get_monotonic_time () + GST_RECORD_SINK_WAIT);
+  g_atomic_int_set (waiting, 0);
+  g_mutex_unlock (&sink->lock);
+}
+
+static void
+gst_record_sink_wake (GstRecordSink * sink, volatile gint * waiting)
+{
+  if (g_atomic_int_get (waiting)) {
+    g_mutex_lock (&sink->lock);
+    g_cond_broadcast (&sink->cond);
+    g_mutex_unlock (&sink->lock);
+  }
+}
+
+static gboolean
+gst_record_sink_write (gint fd, const guint8 * data, gsize size,
+    gint64 offset)
+{
+  while (size) {
+    gssize n = offset < 0 ? write (fd, data, size) :
+        pwrite (fd, data, size, offset);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return FALSE;
+    }
+    data += n;
+    size -= n;
+    if (0 <= offset)
+      offset += n;
+  }
+  return TRUE;
+}
+
+static void
+gst_record_sink_clear_direct (gint fd)
+{
+#ifdef O_DIRECT
+  gint flags = fcntl (fd, F_GETFL);
+  if (flags != -1 && (flags & O_DIRECT))
+    fcntl (fd, F_SETFL, flags & ~O_DIRECT);
+#endif
+}
+
+static void
+gst_record_sink_preallocate (GstRecordSink * sink, guint64 end)
+{
+#ifdef HAVE_FALLOCATE
+  while (sink->preallocate && sink->allocated < end) {
+    if (fallocate (sink->fd, FALLOC_FL_KEEP_SIZE, sink->allocated,
+            sink->preallocate) != 0) {
+      GST_WARNING_OBJECT (sink, "preallocation stopped: %s",
+          g_strerror (errno));
+      sink->allocated = G_MAXUINT64;
+      break;
+    }
+    sink->allocated += sink->preallocate;
+  }
+#endif
+}
+
+static void
+gst_record_sink_update_stats (GstRecordSink * sink, gint64 latency)
+{
+  gint64 now = g_get_monotonic_time ();
+  GstStructure *s = NULL;
+
+  g_mutex_lock (&sink->stats_lock);
+  if (0 <= latency) {
+    sink->latency_sum += latency;
+    sink->latency_count += 1;
+    sink->latency_peak = MAX (sink->latency_peak, (guint64) latency);
+  }
+  if (GST_RECORD_SINK_STATS_PERIOD <= now - sink->stats_time) {
+    sink->latency = sink->latency_count ?
+        sink->latency_sum / sink->latency_count : 0;
+    sink->latency_max = sink->latency_peak;
+    sink->latency_sum = 0;
+    sink->latency_count = 0;
+    sink->latency_peak = 0;
+    sink->stats_time = now;
+    s = gst_structure_new ("recordsink-stats",
+        "write-latency", G_TYPE_UINT64, sink->latency,
+        "max-write-latency", G_TYPE_UINT64, sink->latency_max,
+        "ring-level", G_TYPE_UINT, gst_record_sink_ring_level (sink), NULL);
+  }
+  g_mutex_unlock (&sink->stats_lock);
+
+  if (s) {
+    gst_element_post_message (GST_ELEMENT (sink),
+        gst_message_new_element (GST_OBJECT (sink), s));
+  }
+}
+
+/**
+ * The writer thread, writing the ring out in chunks. With O_DIRECT only
+ * whole blocks are written, until the ring is drained.
+ */
+static gpointer
+gst_record_sink_writer (GstRecordSink * sink)
+{
+  gboolean direct = FALSE;
+  guint avail, chunk;
+  gint64 start;
+
+#ifdef O_DIRECT
+  gint flags = fcntl (sink->fd, F_GETFL);
+  direct = flags != -1 && (flags & O_DIRECT);
+#endif
+
+  for (;;) {
+    avail = g_atomic_int_get (&sink->fill);
+    if (direct && !g_atomic_int_get (&sink->draining))
+      avail -= avail % GST_RECORD_SINK_ALIGN;
+    chunk = MIN (avail, sink->ring_size - sink->read_pos);
+    chunk = MIN (chunk, GST_RECORD_SINK_CHUNK);
+
+    if (chunk == 0) {
+      if (g_atomic_int_get (&sink->quit) && g_atomic_int_get (&sink->fill) == 0)
+        break;
+      gst_record_sink_update_stats (sink, -1);
+      gst_record_sink_wait (sink, &sink->writer_waiting);
+      continue;
+    }
+
+    if (direct && chunk % GST_RECORD_SINK_ALIGN) {
+      /* the tail of the stream is not a whole block */
+      gst_record_sink_clear_direct (sink->fd);
+      direct = FALSE;
+    }
+
+    gst_record_sink_preallocate (sink, sink->written + chunk);
+
+    start = g_get_monotonic_time ();
+    if (!gst_record_sink_write (sink->fd, sink->ring + sink->read_pos, chunk,
+            -1)) {
+      GST_ELEMENT_ERROR (sink, RESOURCE, WRITE, (NULL),
+          ("%s: %s", sink->location, g_strerror (errno)));
+      g_atomic_int_set (&sink->failed, 1);
+      gst_record_sink_wake (sink, &sink->render_waiting);
+      break;
+    }
+    gst_record_sink_update_stats (sink, g_get_monotonic_time () - start);
+
+    sink->read_pos = (sink->read_pos + chunk) % sink->ring_size;
+    sink->written += chunk;
+    g_atomic_int_add (&sink->fill, -(gint) chunk);
+    gst_record_sink_wake (sink, &sink->render_waiting);
+  }
+
+  return NULL;
+}
+
+/**
+ * Wait until the writer thread has written everything in the ring.
+ */
+static gboolean
+gst_record_sink_drain (GstRecordSink * sink)
+{
+  gboolean ok = TRUE;
+
+  g_atomic_int_set (&sink->draining, 1);
+  gst_record_sink_wake (sink, &sink->writer_waiting);
+  while (0 < g_atomic_int_get (&sink->fill)) {
+    if (g_atomic_int_get (&sink->failed) || g_atomic_int_get (&sink->flushing)) {
+      ok = FALSE;
+      break;
+    }
+    gst_record_sink_wait (sink, &sink->render_waiting);
+  }
+  g_atomic_int_set (&sink->draining, 0);
+  return ok && !g_atomic_int_get (&sink->failed);
+}
+
+static gboolean
+gst_record_sink_start (GstBaseSink * basesink)
+{
+  GstRecordSink *sink = GST_RECORD_SINK (basesink);
+  gint flags = O_WRONLY | O_CREAT | O_TRUNC;
+
+  if (!sink->location) {
+    GST_ELEMENT_ERROR (sink, RESOURCE, NOT_FOUND,
+        ("No file name specified for writing."), (NULL));
+    return FALSE;
+  }
+#ifdef O_DIRECT
+  if (sink->direct) {
+    sink->fd = g_open (sink->location, flags | O_DIRECT, 0644);
+    if (sink->fd < 0)
+      GST_WARNING_OBJECT (sink, "O_DIRECT: %s", g_strerror (errno));
+  }
+#endif
+  if (sink->fd < 0)
+    sink->fd = g_open (sink->location, flags, 0644);
+
+  if (sink->fd < 0) {
+    GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE, (NULL),
+        ("%s: %s", sink->location, g_strerror (errno)));
+    return FALSE;
+  }
+
+  if (posix_memalign ((void **) &sink->ring, GST_RECORD_SINK_ALIGN,
+          sink->ring_size) != 0) {
+    GST_ELEMENT_ERROR (sink, RESOURCE, NO_SPACE_LEFT, (NULL),
+        ("failed to allocate %u bytes of ring", sink->ring_size));
+    sink->ring = NULL;
+    close (sink->fd);
+    sink->fd = -1;
+    return FALSE;
+  }
+
+  sink->write_pos = 0;
+  sink->read_pos = 0;
+  sink->fill = 0;
+  sink->draining = 0;
+  sink->flushing = 0;
+  sink->failed = 0;
+  sink->quit = 0;
+  sink->writer_waiting = 0;
+  sink->render_waiting = 0;
+  sink->offset = 0;
+  sink->written = 0;
+  sink->allocated = 0;
+  sink->sync_writes = FALSE;
+
+  g_mutex_lock (&sink->stats_lock);
+  sink->latency_sum = 0;
+  sink->latency_count = 0;
+  sink->latency = 0;
+  sink->latency_max = 0;
+  sink->latency_peak = 0;
+  sink->stats_time = g_get_monotonic_time ();
+  g_mutex_unlock (&sink->stats_lock);
+
+  sink->writer = g_thread_new ("recordsink",
+      (GThreadFunc) gst_record_sink_writer, sink);
+  return TRUE;
+}
+
+static gboolean
+gst_record_sink_stop (GstBaseSink * basesink)
+{
+  GstRecordSink *sink = GST_RECORD_SINK (basesink);
+
+  if (sink->writer) {
+    g_atomic_int_set (&sink->draining, 1);
+    g_atomic_int_set (&sink->quit, 1);
+    g_mutex_lock (&sink->lock);
+    g_cond_broadcast (&sink->cond);
+    g_mutex_unlock (&sink->lock);
+    g_thread_join (sink->writer);
+    sink->writer = NULL;
+  }
+
+  if (0 <= sink->fd) {
+    /* release the preallocated space beyond the end */
+    if (sink->allocated && ftruncate (sink->fd, sink->written) != 0)
+      GST_WARNING_OBJECT (sink, "truncate: %s", g_strerror (errno));
+    close (sink->fd);
+    sink->fd = -1;
+  }
+
+  free (sink->ring);
+  sink->ring = NULL;
+  return TRUE;
+}
+
+static gboolean
+gst_record_sink_unlock (GstBaseSink * basesink)
+{
+  GstRecordSink *sink = GST_RECORD_SINK (basesink);
+
+  g_atomic_int_set (&sink->flushing, 1);
+  g_mutex_lock (&sink->lock);
+  g_cond_broadcast (&sink->cond);
+  g_mutex_unlock (&sink->lock);
+  return TRUE;
+}
+
+static gboolean
+gst_record_sink_unlock_stop (GstBaseSink * basesink)
+{
+  GstRecordSink *sink = GST_RECORD_SINK (basesink);
+
+  g_atomic_int_set (&sink->flushing, 0);
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_record_sink_render (GstBaseSink * basesink, GstBuffer * buffer)
+{
+  GstRecordSink *sink = GST_RECORD_SINK (basesink);
+  GstFlowReturn ret = GST_FLOW_OK;
+  const guint8 *data;
+  GstMapInfo map;
+  gsize size;
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ)) {
+    GST_ELEMENT_ERROR (sink, RESOURCE, WRITE, (NULL),
+        ("failed to map buffer"));
+    return GST_FLOW_ERROR;
+  }
+
+  data = map.data;
+  size = map.size;
+
+  if (sink->sync_writes) {
+    if (gst_record_sink_write (sink->fd, data, size, sink->offset)) {
+      sink->offset += size;
+      sink->written = MAX (sink->written, sink->offset);
+    } else {
+      GST_ELEMENT_ERROR (sink, RESOURCE, WRITE, (NULL),
+          ("%s: %s", sink->location, g_strerror (errno)));
+      ret = GST_FLOW_ERROR;
+    }
+    goto end;
+  }
+
+  while (size) {
+    guint space, n;
+
+    if (g_atomic_int_get (&sink->failed)) {
+      ret = GST_FLOW_ERROR;
+      break;
+    }
+    if (g_atomic_int_get (&sink->flushing)) {
+      ret = GST_FLOW_FLUSHING;
+      break;
+    }
+
+    space = sink->ring_size - g_atomic_int_get (&sink->fill);
+    if (space == 0) {
+      GST_DEBUG_OBJECT (sink, "ring is full");
+      gst_record_sink_wait (sink, &sink->render_waiting);
+      continue;
+    }
+
+    n = MIN (size, space);
+    n = MIN (n, sink->ring_size - sink->write_pos);
+    memcpy (sink->ring + sink->write_pos, data, n);
+    sink->write_pos = (sink->write_pos + n) % sink->ring_size;
+    g_atomic_int_add (&sink->fill, n);
+    gst_record_sink_wake (sink, &sink->writer_waiting);
+
+    data += n;
+    size -= n;
+    sink->offset += n;
+  }
+
+end:
+  gst_buffer_unmap (buffer, &map);
+  return ret;
+}
+
+static gboolean
+gst_record_sink_event (GstBaseSink * basesink, GstEvent * event)
+{
+  GstRecordSink *sink = GST_RECORD_SINK (basesink);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_SEGMENT:
+    {
+      const GstSegment *segment = NULL;
+      gst_event_parse_segment (event, &segment);
+      if (segment->format != GST_FORMAT_BYTES || sink->fd < 0 ||
+          segment->start == sink->offset)
+        break;
+
+      /* Muxers seek back to rewrite their headers, which is done in place
+         once the ring is written out. */
+      if (!sink->sync_writes) {
+        if (!gst_record_sink_drain (sink))
+          GST_WARNING_OBJECT (sink, "ring not drained before seeking");
+        gst_record_sink_clear_direct (sink->fd);
+        sink->sync_writes = TRUE;
+      }
+      sink->offset = segment->start;
+      break;
+    }
+    case GST_EVENT_EOS:
+      if (0 <= sink->fd && !sink->sync_writes)
+        gst_record_sink_drain (sink);
+      break;
+    default:
+      break;
+  }
+
+  return GST_BASE_SINK_CLASS (parent_class)->event (basesink, event);
+}
+
+static void
+gst_record_sink_class_init (GstRecordSinkClass * klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstBaseSinkClass *basesink_class = GST_BASE_SINK_CLASS (klass);
+
+  object_class->set_property =
+      (GObjectSetPropertyFunc) gst_record_sink_set_property;
+  object_class->get_property =
+      (GObjectGetPropertyFunc) gst_record_sink_get_property;
+  object_class->finalize = (GObjectFinalizeFunc) gst_record_sink_finalize;
+
+  g_object_class_install_property (object_class, PROP_LOCATION,
+      g_param_spec_string ("location", "File Location",
+          "Location of the file to write", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_RING_SIZE,
+      g_param_spec_uint ("ring-size", "Ring Size",
+          "Size of the ring buffer in bytes",
+          GST_RECORD_SINK_ALIGN, G_MAXINT - G_MAXINT % GST_RECORD_SINK_ALIGN,
+          GST_RECORD_SINK_DEFAULT_RING_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_PREALLOCATE,
+      g_param_spec_uint64 ("preallocate", "Preallocate",
+          "Bytes of disk space to preallocate at a time (0 = disabled)",
+          0, G_MAXUINT64, GST_RECORD_SINK_DEFAULT_PREALLOCATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_DIRECT,
+      g_param_spec_boolean ("direct", "Direct I/O",
+          "Write with O_DIRECT, bypassing the page cache", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_RING_LEVEL,
+      g_param_spec_uint ("ring-level", "Ring Level",
+          "Percentage of the ring waiting to be written", 0, 100, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_WRITE_LATENCY,
+      g_param_spec_uint64 ("write-latency", "Write Latency",
+          "Average write latency of the last second in microseconds",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_MAX_WRITE_LATENCY,
+      g_param_spec_uint64 ("max-write-latency", "Max Write Latency",
+          "Maximum write latency of the last second in microseconds",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_set_static_metadata (element_class,
+      "Record Sink", "Sink/File",
+      "Write to a file through a ring buffer on a separate thread",
+      "Duzy Chan <code@duzy.info>");
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&gst_record_sink_sink_factory));
+
+  basesink_class->start = GST_DEBUG_FUNCPTR (gst_record_sink_start);
+  basesink_class->stop = GST_DEBUG_FUNCPTR (gst_record_sink_stop);
+  basesink_class->unlock = GST_DEBUG_FUNCPTR (gst_record_sink_unlock);
+  basesink_class->unlock_stop = GST_DEBUG_FUNCPTR (gst_record_sink_unlock_stop);
+  basesink_class->render = GST_DEBUG_FUNCPTR (gst_record_sink_render);
+  basesink_class->event = GST_DEBUG_FUNCPTR (gst_record_sink_event);
+
+  GST_DEBUG_CATEGORY_INIT (gst_record_sink_debug, "recordsink", 0,
+      "RecordSink");
+}
@@ -0,0 +1,97 @@
+/* GStreamer
+ * Copyright (C) 2012 Duzy Chan <code@duzy.info>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_RECORD_SINK_H__
+#define __GST_RECORD_SINK_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbasesink.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_RECORD_SINK \
+  (gst_record_sink_get_type ())
+#define GST_RECORD_SINK(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj),GST_TYPE_RECORD_SINK,GstRecordSink))
+#define GST_RECORD_SINK_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass),GST_TYPE_RECORD_SINK,GstRecordSinkClass))
+#define GST_IS_RECORD_SINK(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_RECORD_SINK))
+#define GST_IS_RECORD_SINK_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_RECORD_SINK))
+
+typedef struct _GstRecordSink GstRecordSink;
+typedef struct _GstRecordSinkClass GstRecordSinkClass;
+
+/**
+ * @brief A file sink writing through a ring buffer on its own thread.
+ *
+ * The streaming thread only copies into the ring, so a stalled disk does not
+ * hold back the pipeline until the ring is full.
+ */
+struct _GstRecordSink {
+  GstBaseSink base;
+
+  gchar *location;
+  guint ring_size;              /* bytes */
+  guint64 preallocate;          /* bytes per fallocate, 0 disables */
+  gboolean direct;              /* write with O_DIRECT */
+
+  gint fd;
+  guint8 *ring;
+  guint write_pos;              /* touched by the streaming thread only */
+  guint read_pos;               /* touched by the writer thread only */
+  volatile gint fill;           /* bytes in the ring, atomic */
+  volatile gint draining;       /* atomic */
+  volatile gint flushing;       /* atomic */
+  volatile gint failed;         /* atomic */
+  volatile gint quit;           /* atomic */
+  volatile gint writer_waiting; /* atomic */
+  volatile gint render_waiting; /* atomic */
+
+  GMutex lock;
+  GCond cond;
+  GThread *writer;
+
+  guint64 offset;               /* bytes rendered */
+  guint64 written;              /* bytes written to the file */
+  guint64 allocated;            /* bytes preallocated in the file */
+  gboolean sync_writes;         /* writing in place after a seek */
+
+  GMutex stats_lock;
+  guint64 latency_sum;          /* microseconds in the current period */
+  guint latency_count;
+  guint64 latency;              /* average of the last period */
+  guint64 latency_max;          /* maximum of the last period */
+  guint64 latency_peak;         /* maximum in the current period */
+  gint64 stats_time;
+};
+
+/**
+ * @brief GstRecordSinkClass
+ */
+struct _GstRecordSinkClass {
+  GstBaseSinkClass base_class;
+};
+
+GType gst_record_sink_get_type (void);
+
+G_END_DECLS
+
+#endif//__GST_RECORD_SINK_H__
@@ -0,0 +1,545 @@
+/* GStreamer
+ * Copyright (C) 2012 Duzy Chan <code@duzy.info>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <unistd.h>
+#include <string.h>
+#include "gststripescale.h"
+#include "../logutils.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_stripe_scale_debug);
+#define GST_CAT_DEFAULT gst_stripe_scale_debug
+
+#define GST_STRIPE_SCALE_MIN_ROWS 16    /* rows of the smallest stripe */
+#define GST_STRIPE_SCALE_ROW_ALIGN 4    /* keeps subsampled rows whole */
+#define GST_STRIPE_SCALE_DEFAULT_ADD_BORDERS TRUE
+
+#define GST_STRIPE_SCALE_FORMATS "{ I420, YV12, Y41B, Y42B, Y444, GRAY8 }"
+
+static GstStaticPadTemplate gst_stripe_scale_sink_factory =
+GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (GST_STRIPE_SCALE_FORMATS)));
+
+static GstStaticPadTemplate gst_stripe_scale_src_factory =
+GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (GST_STRIPE_SCALE_FORMATS)));
+
+enum
+{
+  PROP_0,
+  PROP_N_THREADS,
+  PROP_ADD_BORDERS,
+};
+
+/**
+ * A frame being scaled, the stripes count down %pending when they're done.
+ */
+typedef struct _GstStripeScaleFrame
+{
+  GstStripeScale *scale;
+  GstVideoFrame *in;
+  GstVideoFrame *out;
+  guint stripes;
+  gint pending;
+  GMutex lock;
+  GCond cond;
+} GstStripeScaleFrame;
+
+typedef struct _GstStripeScaleStripe
+{
+  GstStripeScaleFrame *frame;
+  guint index;
+} GstStripeScaleStripe;
+
+static GThreadPool *gst_stripe_scale_pool = NULL;
+static guint gst_stripe_scale_processors = 1;
+
+#define gst_stripe_scale_parent_class parent_class
+G_DEFINE_TYPE (GstStripeScale, gst_stripe_scale, GST_TYPE_VIDEO_FILTER);
+
+static void
+gst_stripe_scale_init (GstStripeScale * scale)
+{
+  guint c;
+
+  scale->n_threads = 0;
+  scale->add_borders = GST_STRIPE_SCALE_DEFAULT_ADD_BORDERS;
+  scale->stripes = 1;
+  scale->dest_x = 0;
+  scale->dest_y = 0;
+  scale->dest_width = 0;
+  scale->dest_height = 0;
+  for (c = 0; c < GST_VIDEO_MAX_COMPONENTS; ++c)
+    scale->columns[c] = NULL;
+}
+
+static void
+gst_stripe_scale_free_columns (GstStripeScale * scale)
+{
+  guint c;
+
+  for (c = 0; c < GST_VIDEO_MAX_COMPONENTS; ++c) {
+    g_free (scale->columns[c]);
+    scale->columns[c] = NULL;
+  }
+}
+
+static void
+gst_stripe_scale_finalize (GstStripeScale * scale)
+{
+  gst_stripe_scale_free_columns (scale);
+
+  G_OBJECT_CLASS (parent_class)->finalize (G_OBJECT (scale));
+}
+
+static void
+gst_stripe_scale_set_property (GstStripeScale * scale, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  switch (prop_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (scale);
+      scale->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (scale);
+      break;
+    case PROP_ADD_BORDERS:
+      GST_OBJECT_LOCK (scale);
+      scale->add_borders = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (scale);
+      gst_base_transform_reconfigure_src (GST_BASE_TRANSFORM (scale));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (G_OBJECT (scale), prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_stripe_scale_get_property (GstStripeScale * scale, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  switch (prop_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (scale);
+      g_value_set_uint (value, scale->n_threads);
+      GST_OBJECT_UNLOCK (scale);
+      break;
+    case PROP_ADD_BORDERS:
+      GST_OBJECT_LOCK (scale);
+      g_value_set_boolean (value, scale->add_borders);
+      GST_OBJECT_UNLOCK (scale);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (G_OBJECT (scale), prop_id, pspec);
+      break;
+  }
+}
+
+/**
+ * gst_stripe_scale_map:
+ *
+ * Map the destination pixel @index onto the source, sampling at the pixel
+ * centers. The two source pixels and the weight of the second one, in 1/256,
+ * are returned in @pos.
+ */
+static void
+gst_stripe_scale_map (gint src_size, gint dst_size, gint index, gint * pos)
+{
+  gint64 p = (gint64) (2 * index + 1) * src_size * 128 / dst_size - 128;
+
+  if (p < 0)
+    p = 0;
+  pos[0] = (gint) (p >> 8);
+  pos[2] = (gint) (p & 0xff);
+  if (src_size - 1 <= pos[0]) {
+    pos[0] = src_size - 1;
+    pos[2] = 0;
+  }
+  pos[1] = MIN (pos[0] + 1, src_size - 1);
+}
+
+/**
+ * gst_stripe_scale_stripe_rows:
+ *
+ * Get the rows of the component @c covered by the stripe @index.
+ */
+static void
+gst_stripe_scale_stripe_rows (const GstVideoFrame * out, guint c,
+    guint index, guint stripes, gint * first, gint * last)
+{
+  const GstVideoFormatInfo *finfo = out->info.finfo;
+  gint height = GST_VIDEO_FRAME_HEIGHT (out);
+  gint y0, y1;
+
+  y0 = (gint) ((gint64) height * index / stripes);
+  y0 -= y0 % GST_STRIPE_SCALE_ROW_ALIGN;
+  if (index + 1 == stripes) {
+    y1 = height;
+  } else {
+    y1 = (gint) ((gint64) height * (index + 1) / stripes);
+    y1 -= y1 % GST_STRIPE_SCALE_ROW_ALIGN;
+  }
+
+  *first = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, c, y0);
+  *last = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, c, y1);
+}
+
+/**
+ * gst_stripe_scale_do_stripe:
+ *
+ * Scale the rows of one stripe of every component into the destination
+ * rectangle, and paint the borders around it black.
+ */
+static void
+gst_stripe_scale_do_stripe (GstStripeScale * scale, GstVideoFrame * in,
+    GstVideoFrame * out, guint index, guint stripes)
+{
+  const GstVideoFormatInfo *finfo = out->info.finfo;
+  guint c;
+
+  for (c = 0; c < GST_VIDEO_FRAME_N_COMPONENTS (out); ++c) {
+    const guint8 *src = GST_VIDEO_FRAME_COMP_DATA (in, c);
+    guint8 *dst = GST_VIDEO_FRAME_COMP_DATA (out, c);
+    gint src_stride = GST_VIDEO_FRAME_COMP_STRIDE (in, c);
+    gint dst_stride = GST_VIDEO_FRAME_COMP_STRIDE (out, c);
+    gint src_height = GST_VIDEO_FRAME_COMP_HEIGHT (in, c);
+    gint dst_width = GST_VIDEO_FRAME_COMP_WIDTH (out, c);
+    gint dx = GST_VIDEO_FORMAT_INFO_SCALE_WIDTH (finfo, c, scale->dest_x);
+    gint dy = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, c, scale->dest_y);
+    gint dw = GST_VIDEO_FORMAT_INFO_SCALE_WIDTH (finfo, c, scale->dest_width);
+    gint dh = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, c,
+        scale->dest_height);
+    guint8 black = GST_VIDEO_FORMAT_INFO_IS_YUV (finfo) && c == 0 ? 16 :
+        GST_VIDEO_FORMAT_INFO_IS_YUV (finfo) ? 128 : 0;
+    const gint *columns = scale->columns[c];
+    gint first, last, x, y, row[3];
+
+    gst_stripe_scale_stripe_rows (out, c, index, stripes, &first, &last);
+
+    for (y = first; y < last; ++y) {
+      const guint8 *top, *bottom;
+      guint8 *d = dst + y * dst_stride;
+      gint fy;
+
+      if (y < dy || dy + dh <= y) {
+        memset (d, black, dst_width);
+        continue;
+      }
+      if (0 < dx)
+        memset (d, black, dx);
+      if (dx + dw < dst_width)
+        memset (d + dx + dw, black, dst_width - dx - dw);
+      d += dx;
+
+      gst_stripe_scale_map (src_height, dh, y - dy, row);
+      top = src + row[0] * src_stride;
+      bottom = src + row[1] * src_stride;
+      fy = row[2];
+
+      for (x = 0; x < dw; ++x) {
+        const gint *col = columns + x * 3;
+        gint fx = col[2];
+        gint t = top[col[0]] * (256 - fx) + top[col[1]] * fx;
+        gint b = bottom[col[0]] * (256 - fx) + bottom[col[1]] * fx;
+        d[x] = (guint8) ((t * (256 - fy) + b * fy + 32768) >> 16);
+      }
+    }
+  }
+}
+
+static void
+gst_stripe_scale_pool_func (GstStripeScaleStripe * stripe, gpointer data)
+{
+  GstStripeScaleFrame *frame = stripe->frame;
+
+  gst_stripe_scale_do_stripe (frame->scale, frame->in, frame->out,
+      stripe->index, frame->stripes);
+
+  g_mutex_lock (&frame->lock);
+  if (--frame->pending == 0)
+    g_cond_signal (&frame->cond);
+  g_mutex_unlock (&frame->lock);
+}
+
+static gpointer
+gst_stripe_scale_pool_init (gpointer data)
+{
+  GError *error = NULL;
+  glong n = sysconf (_SC_NPROCESSORS_ONLN);
+
+  gst_stripe_scale_processors = (guint) CLAMP (n, 1,
+      GST_STRIPE_SCALE_MAX_STRIPES);
+
+  /* the streaming threads scale a stripe of their own */
+  if (1 < gst_stripe_scale_processors) {
+    gst_stripe_scale_pool =
+        g_thread_pool_new ((GFunc) gst_stripe_scale_pool_func, NULL,
+        gst_stripe_scale_processors - 1, FALSE, &error);
+    if (error) {
+      ERROR ("stripe scaling thread pool: %s", error->message);
+      g_error_free (error);
+      gst_stripe_scale_pool = NULL;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * gst_stripe_scale_set_dest:
+ *
+ * Fit the picture into the output keeping its display aspect ratio, the
+ * rectangle is aligned to the chroma subsampling. Without borders the
+ * picture fills the whole output.
+ */
+static void
+gst_stripe_scale_set_dest (GstStripeScale * scale, GstVideoInfo * in_info,
+    GstVideoInfo * out_info, gboolean add_borders)
+{
+  gint out_width = GST_VIDEO_INFO_WIDTH (out_info);
+  gint out_height = GST_VIDEO_INFO_HEIGHT (out_info);
+  gint64 num, den;
+  gint width = out_width, height = out_height;
+
+  /* the display aspect ratio of the input in output pixels */
+  num = (gint64) GST_VIDEO_INFO_WIDTH (in_info) * GST_VIDEO_INFO_PAR_N (in_info)
+      * GST_VIDEO_INFO_PAR_D (out_info);
+  den = (gint64) GST_VIDEO_INFO_HEIGHT (in_info) *
+      GST_VIDEO_INFO_PAR_D (in_info) * GST_VIDEO_INFO_PAR_N (out_info);
+
+  if (add_borders && 0 < num && 0 < den) {
+    if (out_width * den <= out_height * num) {
+      height = (gint) (out_width * den / num);
+      height -= height % GST_STRIPE_SCALE_ROW_ALIGN;
+    } else {
+      width = (gint) (out_height * num / den);
+      width -= width % GST_STRIPE_SCALE_ROW_ALIGN;
+    }
+    width = CLAMP (width, 1, out_width);
+    height = CLAMP (height, 1, out_height);
+  }
+
+  scale->dest_width = width;
+  scale->dest_height = height;
+  scale->dest_x = (out_width - width) / 2;
+  scale->dest_x -= scale->dest_x % GST_STRIPE_SCALE_ROW_ALIGN;
+  scale->dest_y = (out_height - height) / 2;
+  scale->dest_y -= scale->dest_y % GST_STRIPE_SCALE_ROW_ALIGN;
+}
+
+static gboolean
+gst_stripe_scale_set_info (GstVideoFilter * filter, GstCaps * incaps,
+    GstVideoInfo * in_info, GstCaps * outcaps, GstVideoInfo * out_info)
+{
+  GstStripeScale *scale = GST_STRIPE_SCALE (filter);
+  static GOnce pool_once = G_ONCE_INIT;
+  gboolean add_borders;
+  guint c, threads;
+  gint x;
+
+  g_once (&pool_once, gst_stripe_scale_pool_init, NULL);
+
+  gst_stripe_scale_free_columns (scale);
+
+  GST_OBJECT_LOCK (scale);
+  threads = scale->n_threads ? scale->n_threads : gst_stripe_scale_processors;
+  add_borders = scale->add_borders;
+  GST_OBJECT_UNLOCK (scale);
+
+  gst_stripe_scale_set_dest (scale, in_info, out_info, add_borders);
+
+  for (c = 0; c < GST_VIDEO_INFO_N_COMPONENTS (out_info); ++c) {
+    gint src_width = GST_VIDEO_INFO_COMP_WIDTH (in_info, c);
+    gint dst_width = GST_VIDEO_FORMAT_INFO_SCALE_WIDTH (out_info->finfo, c,
+        scale->dest_width);
+
+    scale->columns[c] = g_new (gint, MAX (dst_width, 1) * 3);
+    for (x = 0; x < dst_width; ++x)
+      gst_stripe_scale_map (src_width, dst_width, x, scale->columns[c] + x * 3);
+  }
+
+  scale->stripes = MIN (threads, GST_STRIPE_SCALE_MAX_STRIPES);
+  scale->stripes = MIN (scale->stripes,
+      GST_VIDEO_INFO_HEIGHT (out_info) / GST_STRIPE_SCALE_MIN_ROWS);
+  scale->stripes = MAX (scale->stripes, 1);
+
+  GST_DEBUG_OBJECT (scale, "%dx%d -> %dx%d at %d,%d of %dx%d in %d stripes",
+      GST_VIDEO_INFO_WIDTH (in_info), GST_VIDEO_INFO_HEIGHT (in_info),
+      scale->dest_width, scale->dest_height, scale->dest_x, scale->dest_y,
+      GST_VIDEO_INFO_WIDTH (out_info), GST_VIDEO_INFO_HEIGHT (out_info),
+      scale->stripes);
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_stripe_scale_transform_frame (GstVideoFilter * filter,
+    GstVideoFrame * in, GstVideoFrame * out)
+{
+  GstStripeScale *scale = GST_STRIPE_SCALE (filter);
+  GstStripeScaleStripe stripes[GST_STRIPE_SCALE_MAX_STRIPES];
+  GstStripeScaleFrame frame;
+  guint n;
+
+  if (scale->stripes == 1 || gst_stripe_scale_pool == NULL) {
+    gst_stripe_scale_do_stripe (scale, in, out, 0, 1);
+    return GST_FLOW_OK;
+  }
+
+  frame.scale = scale;
+  frame.in = in;
+  frame.out = out;
+  frame.stripes = scale->stripes;
+  frame.pending = scale->stripes - 1;
+  g_mutex_init (&frame.lock);
+  g_cond_init (&frame.cond);
+
+  for (n = 1; n < frame.stripes; ++n) {
+    stripes[n].frame = &frame;
+    stripes[n].index = n;
+    g_thread_pool_push (gst_stripe_scale_pool, &stripes[n], NULL);
+  }
+
+  gst_stripe_scale_do_stripe (scale, in, out, 0, frame.stripes);
+
+  g_mutex_lock (&frame.lock);
+  while (0 < frame.pending)
+    g_cond_wait (&frame.cond, &frame.lock);
+  g_mutex_unlock (&frame.lock);
+
+  g_mutex_clear (&frame.lock);
+  g_cond_clear (&frame.cond);
+  return GST_FLOW_OK;
+}
+
+static GstCaps *
+gst_stripe_scale_transform_caps (GstBaseTransform * trans,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter)
+{
+  GstCaps *ret;
+  GstStructure *structure;
+  guint n;
+
+  ret = gst_caps_new_empty ();
+  for (n = 0; n < gst_caps_get_size (caps); ++n) {
+    structure = gst_caps_get_structure (caps, n);
+    if (0 < n && gst_caps_is_subset_structure (ret, structure))
+      continue;
+
+    structure = gst_structure_copy (structure);
+    gst_structure_set (structure,
+        "width", GST_TYPE_INT_RANGE, 1, G_MAXINT,
+        "height", GST_TYPE_INT_RANGE, 1, G_MAXINT, NULL);
+    /* the other side may take another ratio, the borders make up for it */
+    if (gst_structure_has_field (structure, "pixel-aspect-ratio"))
+      gst_structure_set (structure, "pixel-aspect-ratio",
+          GST_TYPE_FRACTION_RANGE, 1, G_MAXINT, G_MAXINT, 1, NULL);
+    gst_caps_append_structure (ret, structure);
+  }
+
+  if (filter) {
+    GstCaps *intersection = gst_caps_intersect_full (filter, ret,
+        GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (ret);
+    ret = intersection;
+  }
+  return ret;
+}
+
+static GstCaps *
+gst_stripe_scale_fixate_caps (GstBaseTransform * trans,
+    GstPadDirection direction, GstCaps * caps, GstCaps * othercaps)
+{
+  GstStructure *ins, *outs;
+  gint width = 0, height = 0, par_n = 1, par_d = 1;
+
+  othercaps = gst_caps_truncate (othercaps);
+  othercaps = gst_caps_make_writable (othercaps);
+
+  ins = gst_caps_get_structure (caps, 0);
+  outs = gst_caps_get_structure (othercaps, 0);
+
+  /* keep the size unless the other side asks for one */
+  if (gst_structure_get_int (ins, "width", &width))
+    gst_structure_fixate_field_nearest_int (outs, "width", width);
+  if (gst_structure_get_int (ins, "height", &height))
+    gst_structure_fixate_field_nearest_int (outs, "height", height);
+
+  /* and the pixel aspect ratio, the picture is letterboxed to fit */
+  gst_structure_get_fraction (ins, "pixel-aspect-ratio", &par_n, &par_d);
+  if (gst_structure_has_field (outs, "pixel-aspect-ratio"))
+    gst_structure_fixate_field_nearest_fraction (outs, "pixel-aspect-ratio",
+        par_n, par_d);
+
+  return gst_caps_fixate (othercaps);
+}
+
+static void
+gst_stripe_scale_class_init (GstStripeScaleClass * klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstBaseTransformClass *trans_class = GST_BASE_TRANSFORM_CLASS (klass);
+  GstVideoFilterClass *filter_class = GST_VIDEO_FILTER_CLASS (klass);
+
+  object_class->set_property =
+      (GObjectSetPropertyFunc) gst_stripe_scale_set_property;
+  object_class->get_property =
+      (GObjectGetPropertyFunc) gst_stripe_scale_get_property;
+  object_class->finalize = (GObjectFinalizeFunc) gst_stripe_scale_finalize;
+
+  g_object_class_install_property (object_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Stripes scaled in parallel per frame (0 = the processors)",
+          0, GST_STRIPE_SCALE_MAX_STRIPES, 0,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_ADD_BORDERS,
+      g_param_spec_boolean ("add-borders", "Add Borders",
+          "Add black borders to keep the display aspect ratio",
+          GST_STRIPE_SCALE_DEFAULT_ADD_BORDERS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_set_static_metadata (element_class,
+      "Stripe Scale", "Filter/Converter/Video/Scaler",
+      "Scale video in stripes on a shared thread pool",
+      "Duzy Chan <code@duzy.info>");
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&gst_stripe_scale_sink_factory));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&gst_stripe_scale_src_factory));
+
+  trans_class->passthrough_on_same_caps = TRUE;
+  trans_class->transform_caps =
+      GST_DEBUG_FUNCPTR (gst_stripe_scale_transform_caps);
+  trans_class->fixate_caps = GST_DEBUG_FUNCPTR (gst_stripe_scale_fixate_caps);
+
+  filter_class->set_info = GST_DEBUG_FUNCPTR (gst_stripe_scale_set_info);
+  filter_class->transform_frame =
+      GST_DEBUG_FUNCPTR (gst_stripe_scale_transform_frame);
+
+  GST_DEBUG_CATEGORY_INIT (gst_stripe_scale_debug, "stripescale", 0,
+      "StripeScale");
+}
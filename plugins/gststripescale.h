@@ -0,0 +1,82 @@
+/* GStreamer
+ * Copyright (C) 2012 Duzy Chan <code@duzy.info>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_STRIPE_SCALE_H__
+#define __GST_STRIPE_SCALE_H__
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <gst/video/gstvideofilter.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_STRIPE_SCALE \
+  (gst_stripe_scale_get_type ())
+#define GST_STRIPE_SCALE(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj),GST_TYPE_STRIPE_SCALE,GstStripeScale))
+#define GST_STRIPE_SCALE_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass),GST_TYPE_STRIPE_SCALE,GstStripeScaleClass))
+#define GST_IS_STRIPE_SCALE(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_STRIPE_SCALE))
+#define GST_IS_STRIPE_SCALE_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_STRIPE_SCALE))
+
+#define GST_STRIPE_SCALE_MAX_STRIPES 64
+
+typedef struct _GstStripeScale GstStripeScale;
+typedef struct _GstStripeScaleClass GstStripeScaleClass;
+
+/**
+ * @brief A bilinear video scaler splitting every frame into stripes.
+ *
+ * The stripes are scaled on a thread pool shared by every instance and
+ * sized to the processors of the host, the streaming thread scales one of
+ * them and waits for the others. As videoscale, the display aspect ratio
+ * is kept by adding black borders unless %add_borders is FALSE.
+ */
+struct _GstStripeScale {
+  GstVideoFilter base;
+
+  guint n_threads;              /* stripes per frame, 0 for the processors */
+  gboolean add_borders;         /* letterbox rather than stretch */
+  guint stripes;                /* stripes of the negotiated size */
+
+  /* the rectangle of the output the picture is scaled into */
+  gint dest_x;
+  gint dest_y;
+  gint dest_width;
+  gint dest_height;
+
+  /* for every component and output column: the two source columns and
+     the weight of the second one, in 1/256 */
+  gint *columns[GST_VIDEO_MAX_COMPONENTS];
+};
+
+/**
+ * @brief GstStripeScaleClass
+ */
+struct _GstStripeScaleClass {
+  GstVideoFilterClass base_class;
+};
+
+GType gst_stripe_scale_get_type (void);
+
+G_END_DECLS
+
+#endif//__GST_STRIPE_SCALE_H__
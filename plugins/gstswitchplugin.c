@@ -49,6 +49,8 @@
 #include "gsttcpmixsrc.h"
 #include "gstswitch.h"
 #include "gstconvbin.h"
+#include "gstrecordsink.h"
+#include "gststripescale.h"
 #include "../logutils.h"
 
 static gboolean
@@ -68,6 +70,16 @@ plugin_init (GstPlugin * plugin)
     return FALSE;
   }
 
+  if (!gst_element_register (plugin, "recordsink", GST_RANK_NONE,
+          GST_TYPE_RECORD_SINK)) {
+    return FALSE;
+  }
+
+  if (!gst_element_register (plugin, "stripescale", GST_RANK_NONE,
+          GST_TYPE_STRIPE_SCALE)) {
+    return FALSE;
+  }
+
   return TRUE;
 }
 
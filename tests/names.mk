@@ -4,6 +4,31 @@ TESTS = \
 	test-fuzz \
 	test-controller \
 	test-composite-mode \
+	test-failover \
+	test-audio-mix \
+	test-transition \
+	test-segments \
+	test-rotation \
+	test-iso \
+	test-compressed-input \
+	test-normalise \
+	test-video-format \
+	test-layout \
+	test-multibox \
+	test-tcp-control \
+	test-audio-level \
+	test-preview-shm \
+	test-local-input \
+	test-rtp-output \
+	test-client-policy \
+	test-queue-policy \
+	test-composite-mode-async \
+	test-av-sync \
+	test-stripe-scale \
+	test-ui-queue \
+	test-record-sink \
+	test-alignment \
+	test-mosaic-join \
 	$(null)
 
 UI_TESTS = \
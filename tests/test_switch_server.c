@@ -25,17 +25,22 @@
 
 #include <gst/gst.h>
 #include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
+#include <glib/gstdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/resource.h>
 #include <signal.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <string.h>
 #include "../tools/gstswitchclient.h"
 #include "../tools/gstcomposite.h"
 #include "../tools/gstcase.h"
+#include "../tools/gstvideomosaic.h"
 #include "../logutils.h"
 
 #define ASSERT_TEST_PIPELINE_ERRORS 0
@@ -74,6 +79,31 @@ static struct {
   gboolean enable_test_fuzz;
   gboolean enable_test_checking_timestamps;
   gboolean enable_test_multiple_clients;
+  gboolean enable_test_failover;
+  gboolean enable_test_audio_mix;
+  gboolean enable_test_transition;
+  gboolean enable_test_segments;
+  gboolean enable_test_rotation;
+  gboolean enable_test_iso;
+  gboolean enable_test_compressed_input;
+  gboolean enable_test_normalise;
+  gboolean enable_test_video_format;
+  gboolean enable_test_layout;
+  gboolean enable_test_multibox;
+  gboolean enable_test_tcp_control;
+  gboolean enable_test_audio_level;
+  gboolean enable_test_preview_shm;
+  gboolean enable_test_local_input;
+  gboolean enable_test_rtp_output;
+  gboolean enable_test_client_policy;
+  gboolean enable_test_queue_policy;
+  gboolean enable_test_composite_mode_async;
+  gboolean enable_test_av_sync;
+  gboolean enable_test_stripe_scale;
+  gboolean enable_test_ui_queue;
+  gboolean enable_test_record_sink;
+  gboolean enable_test_alignment;
+  gboolean enable_test_mosaic_join;
   gboolean test_external_server;
   gboolean test_external_ui;
   gboolean valgrind;
@@ -88,6 +118,31 @@ static struct {
   .enable_test_switching		= FALSE,
   .enable_test_fuzz			= FALSE,
   .enable_test_checking_timestamps	= FALSE,
+  .enable_test_failover			= FALSE,
+  .enable_test_audio_mix		= FALSE,
+  .enable_test_transition		= FALSE,
+  .enable_test_segments			= FALSE,
+  .enable_test_rotation			= FALSE,
+  .enable_test_iso			= FALSE,
+  .enable_test_compressed_input		= FALSE,
+  .enable_test_normalise		= FALSE,
+  .enable_test_video_format		= FALSE,
+  .enable_test_layout			= FALSE,
+  .enable_test_multibox			= FALSE,
+  .enable_test_tcp_control		= FALSE,
+  .enable_test_audio_level		= FALSE,
+  .enable_test_preview_shm		= FALSE,
+  .enable_test_local_input		= FALSE,
+  .enable_test_rtp_output		= FALSE,
+  .enable_test_client_policy		= FALSE,
+  .enable_test_queue_policy		= FALSE,
+  .enable_test_composite_mode_async		= FALSE,
+  .enable_test_av_sync		= FALSE,
+  .enable_test_stripe_scale		= FALSE,
+  .enable_test_ui_queue		= FALSE,
+  .enable_test_record_sink		= FALSE,
+  .enable_test_alignment		= FALSE,
+  .enable_test_mosaic_join		= FALSE,
   .test_external_server			= FALSE,
   .test_external_ui			= FALSE,
   .valgrind				= FALSE,
@@ -105,6 +160,31 @@ static GOptionEntry option_entries[] = {
   {"enable-test-fuzz",			0, 0, G_OPTION_ARG_NONE, &opts.enable_test_fuzz,		"Enable testing fuzz input",         NULL},
   {"enable-test-checking-timestamps",	0, 0, G_OPTION_ARG_NONE, &opts.enable_test_checking_timestamps,	"Enable testing checking timestamps",NULL},
   {"enable-test-multiple-clients",	0, 0, G_OPTION_ARG_NONE, &opts.enable_test_multiple_clients,	"Enable testing multiple clients",   NULL},
+  {"enable-test-failover",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_failover,		"Enable testing failover",           NULL},
+  {"enable-test-audio-mix",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_audio_mix,		"Enable testing audio mixing",       NULL},
+  {"enable-test-transition",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_transition,		"Enable testing transitions",        NULL},
+  {"enable-test-segments",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_segments,		"Enable testing segmented recording", NULL},
+  {"enable-test-rotation",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_rotation,		"Enable testing record rotation",    NULL},
+  {"enable-test-iso",			0, 0, G_OPTION_ARG_NONE, &opts.enable_test_iso,			"Enable testing ISO recording",      NULL},
+  {"enable-test-compressed-input",	0, 0, G_OPTION_ARG_NONE, &opts.enable_test_compressed_input,	"Enable testing compressed inputs",  NULL},
+  {"enable-test-normalise",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_normalise,		"Enable testing input normalisation", NULL},
+  {"enable-test-video-format",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_video_format,	"Enable testing output video format", NULL},
+  {"enable-test-layout",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_layout,		"Enable testing composite layouts",  NULL},
+  {"enable-test-multibox",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_multibox,		"Enable testing more than two composite channels",  NULL},
+  {"enable-test-tcp-control",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_tcp_control,		"Enable testing the TCP control protocol",  NULL},
+  {"enable-test-audio-level",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_audio_level,		"Enable testing the audio level meters",  NULL},
+  {"enable-test-preview-shm",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_preview_shm,		"Enable testing the shared memory previews",  NULL},
+  {"enable-test-local-input",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_local_input,		"Enable testing the Unix socket and shared memory inputs",  NULL},
+  {"enable-test-rtp-output",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_rtp_output,		"Enable testing the RTP output",  NULL},
+  {"enable-test-client-policy",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_client_policy,		"Enable testing the client policy of the TCP ports",  NULL},
+  {"enable-test-queue-policy",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_queue_policy,		"Enable testing the queueing policy of the pipelines",  NULL},
+  {"enable-test-composite-mode-async",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_composite_mode_async,		"Enable testing concurrent asynchronous composite mode changes",  NULL},
+  {"enable-test-av-sync",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_av_sync,		"Enable testing the audio and video of the recording stay in sync",  NULL},
+  {"enable-test-stripe-scale",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_stripe_scale,		"Enable testing stripescale against videoscale",  NULL},
+  {"enable-test-ui-queue",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_ui_queue,		"Enable testing the message queues of the UIs",  NULL},
+  {"enable-test-record-sink",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_record_sink,		"Enable testing the recordsink ring buffer",  NULL},
+  {"enable-test-alignment",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_alignment,		"Enable testing the inputs line up on one timeline",  NULL},
+  {"enable-test-mosaic-join",		0, 0, G_OPTION_ARG_NONE, &opts.enable_test_mosaic_join,		"Enable testing tiles joining the mosaic",  NULL},
   {"test-external-server",		0, 0, G_OPTION_ARG_NONE, &opts.test_external_server,		"Testing external server",           NULL},
   {"test-external-ui",			0, 0, G_OPTION_ARG_NONE, &opts.test_external_ui,		"Testing external ui",               NULL},
   {"valgrind",				0, 0, G_OPTION_ARG_NONE, &opts.valgrind,			"Use valgrind",                      NULL},
@@ -472,8 +552,13 @@ launch (const gchar *name, ...)
   return pid;
 }
 
+/*
+ * launch_server_with:
+ *
+ * Launch the server with an extra argument (or NULL).
+ */
 static GPid
-launch_server ()
+launch_server_with (const gchar *arg)
 {
   GPid pid;
 
@@ -499,13 +584,13 @@ launch_server ()
 	"../tools/gst-switch-srv", "-v",
 	"--gst-debug-no-color",
 	"--record=test-recording.data",
-	NULL);
+	arg, NULL);
   } else {
     pid = launch (
 	"../tools/gst-switch-srv", "-v",
 	"--gst-debug-no-color",
 	"--record=test-recording.data",
-	NULL);
+	arg, NULL);
   }
 
   sleep (5);
@@ -513,6 +598,12 @@ launch_server ()
   return pid;
 }
 
+static GPid
+launch_server ()
+{
+  return launch_server_with (NULL);
+}
+
 static GPid
 launch_ui ()
 {
@@ -532,6 +623,95 @@ close_pid (GPid pid)
   sleep (2); /* give a second for cleaning up */
 }
 
+static GstPadProbeReturn
+count_buffers (GstPad *pad, GstPadProbeInfo *info, gint *buffers)
+{
+  g_atomic_int_inc (buffers);
+  return GST_PAD_PROBE_OK;
+}
+
+/*
+ * probe_port:
+ *  @param desc the pipeline reading the stream, ending at "fakesink name=sink"
+ *  @param buffers the buffers reaching the sink in @seconds
+ *  @return the caps the sink negotiated, or NULL
+ *
+ * Read a server port for @seconds.
+ */
+static GstCaps *
+probe_port (const gchar *desc, gint seconds, gint *buffers)
+{
+  GstElement *pipeline, *sink;
+  GstCaps *caps;
+  GstPad *pad;
+  GError *error = NULL;
+
+  *buffers = 0;
+  pipeline = gst_parse_launch (desc, &error);
+  g_assert_no_error (error);
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_assert (sink);
+  pad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+      (GstPadProbeCallback) count_buffers, buffers, NULL);
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  sleep (seconds);
+  caps = gst_pad_get_current_caps (pad);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pad);
+  gst_object_unref (sink);
+  gst_object_unref (pipeline);
+  return caps;
+}
+
+/*
+ * assert_video_caps:
+ *
+ * Check the caps read by probe_port(), 0 for anything.
+ */
+static void
+assert_video_caps (GstCaps *caps, const gchar *format, gint width,
+    gint height, gint framerate)
+{
+  GstStructure *s;
+  gint value = 0, denom = 1;
+
+  g_assert (caps != NULL);
+  s = gst_caps_get_structure (caps, 0);
+  g_assert_cmpstr (gst_structure_get_name (s), ==, "video/x-raw");
+  if (format)
+    g_assert_cmpstr (gst_structure_get_string (s, "format"), ==, format);
+  if (width) {
+    g_assert (gst_structure_get_int (s, "width", &value));
+    g_assert_cmpint (value, ==, width);
+  }
+  if (height) {
+    g_assert (gst_structure_get_int (s, "height", &value));
+    g_assert_cmpint (value, ==, height);
+  }
+  if (framerate) {
+    g_assert (gst_structure_get_fraction (s, "framerate", &value, &denom));
+    g_assert_cmpint (value, ==, framerate * denom);
+  }
+}
+
+/*
+ * has_bytes:
+ *
+ * Search binary @data for the string @needle.
+ */
+static gboolean
+has_bytes (const gchar *data, gsize size, const gchar *needle)
+{
+  gsize len = strlen (needle), n;
+
+  for (n = 0; len <= size && n <= size - len; ++n) {
+    if (memcmp (data + n, needle, len) == 0)
+      return TRUE;
+  }
+  return FALSE;
+}
+
 static gboolean
 testcase_second_timer (testcase *t)
 {
@@ -663,6 +843,11 @@ typedef struct _testclient {
   gboolean enable_test_sinks;
   GMutex expected_compose_count_lock;
   gint expected_compose_count;
+  gint stall_seconds;
+  gboolean closed;
+  gint audio_level_count;
+  gint preview_port_last;
+  gint preview_port_unordered;
 } testclient;
 
 typedef struct _testclientClass {
@@ -691,6 +876,8 @@ testclient_init (testclient *client)
   client->sink0 = NULL;
   client->expected_compose_count = 0;
   client->enable_test_sinks = FALSE;
+  client->stall_seconds = 0;
+  client->closed = FALSE;
 }
 
 static void
@@ -794,6 +981,7 @@ static void
 testclient_connection_closed (testclient *client, GError *error)
 {
   INFO ("closed: %s", error ? error->message : "");
+  client->closed = TRUE;
   testclient_end (client);
 }
 
@@ -851,6 +1039,18 @@ testclient_new_mode (testclient *client, gint mode)
   client->new_mode_count += 1;
   g_assert_cmpint (mode, >=, COMPOSE_MODE_0);
   g_assert_cmpint (mode, <=, COMPOSE_MODE_3);
+  if (0 < client->stall_seconds) {
+    /* a slow or hung UI, the reply is held back once */
+    sleep (client->stall_seconds);
+    client->stall_seconds = 0;
+  }
+}
+
+static void
+testclient_audio_level (testclient *client, gint port, gdouble rms,
+    gdouble peak, gdouble decay)
+{
+  g_atomic_int_inc (&client->audio_level_count);
 }
 
 static void
@@ -871,6 +1071,9 @@ testclient_add_preview_port (testclient *client, gint port, gint type)
 {
   //INFO ("add-preview-port: %d, %d", port, type);
   client->preview_port_count += 1;
+  if (port < client->preview_port_last)
+    client->preview_port_unordered += 1;
+  client->preview_port_last = port;
   switch (client->preview_port_count) {
   case 1:
     client->preview_port_1 = port;
@@ -984,6 +1187,8 @@ testclient_class_init (testclientClass *klass)
     testclient_add_preview_port;
   client_class->new_mode_online = (GstSwitchClientNewModeOnlineFunc)
     testclient_new_mode;
+  client_class->audio_level = (GstSwitchClientAudioLevelFunc)
+    testclient_audio_level;
 }
 
 static gpointer
@@ -991,7 +1196,10 @@ testclient_run (gpointer data)
 {
   testclient *client = (testclient *) data;
   gboolean connect_ok = FALSE;
-  client->mainloop = g_main_loop_new (NULL, TRUE);
+  /* every client has its own loop, a stalled one holds back no other */
+  GMainContext *context = g_main_context_new ();
+  g_main_context_push_thread_default (context);
+  client->mainloop = g_main_loop_new (context, TRUE);
 
   connect_ok = gst_switch_client_connect (GST_SWITCH_CLIENT (client));
   g_assert (connect_ok);
@@ -1010,6 +1218,8 @@ testclient_run (gpointer data)
   testclient_set_compose_port (client, client->compose_port0);
 
   g_main_loop_run (client->mainloop);
+  g_main_context_pop_thread_default (context);
+  g_main_context_unref (context);
   return NULL;
 }
 
@@ -2226,79 +2436,2555 @@ test_checking_timestamps (void)
     close_pid (server_pid);
 }
 
+/*
+ * count_colours:
+ *
+ * Read a frame of the composite output and count its red and green pixels.
+ */
 static void
-test_multiple_clients (void)
+count_colours (gint *red, gint *green)
 {
-  ERROR ("TODO: test for multiple clients");
+  GstElement *pipeline, *sink;
+  GstSample *sample = NULL;
+  GstBuffer *buffer;
+  GstMapInfo map;
+  GError *error = NULL;
+  const guint8 *p;
+  gsize n;
+
+  *red = *green = 0;
+  pipeline = gst_parse_launch ("tcpclientsrc port=3001 ! gdpdepay "
+      "! videoconvert ! video/x-raw,format=RGB ! fakesink name=sink", &error);
+  g_assert_no_error (error);
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  sleep (2);
+  g_object_get (sink, "last-sample", &sample, NULL);
+  g_assert (sample);
+  buffer = gst_sample_get_buffer (sample);
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  for (n = 0; n + 3 <= map.size; n += 3) {
+    p = map.data + n;
+    if (200 < p[0] && p[1] < 60 && p[2] < 60)
+      *red += 1;
+    else if (p[0] < 60 && 200 < p[1] && p[2] < 60)
+      *green += 1;
+  }
+  gst_buffer_unmap (buffer, &map);
+  gst_sample_unref (sample);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (sink);
+  gst_object_unref (pipeline);
 }
 
 static void
-kill_children(void)
+test_failover (void)
 {
-    GList *child = NULL;
-    g_mutex_lock (&children_lock);
-    for (child = children; child; child = g_list_next (child)) {
-	GPid pid = (GPid) child->data;
-	//INFO ("kill %d", pid);
-	kill (pid, SIGKILL);
-	children = g_list_remove_link (children, child);
-    }
-    g_mutex_unlock (&children_lock);
-}
+  const gint seconds = 20;
+  GPid server_pid = 0;
+  testcase source1 = { "test-video-source1", 0 };
+  testcase source2 = { "test-video-stalled-source2", 0 };
+  testcase source3 = { "test-video-standby-source3", 0 };
+  testcase sink0 = { "test_video_compose_sink", 0 };
+  testclient *client;
+  gint compose_count, red, green, n;
 
-int main (int argc, char**argv)
-{
-  {
-    GOptionContext *context;
-    GOptionGroup *group;
-    GError *error = NULL;
-    gboolean ok;
-    group = g_option_group_new ("gst-switch-test", "gst-switch test suite",
-	"",
-	NULL, NULL);
-    context = g_option_context_new ("");
-    g_option_context_add_main_entries (context, option_entries, "test-switch-server");
-    g_option_context_add_group (context, group);
-    ok = g_option_context_parse (context, &argc, &argv, &error);
-    g_option_context_free (context);
-    if (!ok) {
-      g_print ("option parsing failed: %s\n", error->message);
-      return 1;
-    }
-  }
+  g_print ("\n");
 
-  atexit (&kill_children);
+  /* A is black, B red and the standby green, to tell them apart in the
+   * composite */
+  source1.live_seconds = seconds;
+  source1.desc = g_string_new ("videotestsrc pattern=2 ");
+  g_string_append_printf (source1.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (source1.desc, "! gdppay ! tcpclientsink name=tcp_sink port=3000 ");
 
-  srand (time (NULL));
+  /* source2 becomes B, but only delivers a frame per two seconds, so it's
+   * expected to be failed over to source3 once it's online */
+  source2.live_seconds = seconds;
+  source2.desc = g_string_new ("videotestsrc pattern=4 ");
+  g_string_append_printf (source2.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (source2.desc, "! identity sleep-time=2000000 ");
+  g_string_append_printf (source2.desc, "! gdppay ! tcpclientsink name=tcp_sink port=3000 ");
 
-  {
-    struct rlimit r;
-    r.rlim_cur = RLIM_INFINITY;
-    r.rlim_max = RLIM_INFINITY;
-    if (setrlimit (RLIMIT_NOFILE, &r) == 0) {
-      infinity_open_file = TRUE;
-    }
+  source3.live_seconds = seconds;
+  source3.desc = g_string_new ("videotestsrc pattern=5 ");
+  g_string_append_printf (source3.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (source3.desc, "! gdppay ! tcpclientsink name=tcp_sink port=3000 ");
+
+  sink0.live_seconds = seconds;
+  sink0.desc = g_string_new ("tcpclientsrc port=3001 ");
+  g_string_append_printf (sink0.desc, "! gdpdepay ");
+  g_string_append_printf (sink0.desc, "! videoconvert ");
+  g_string_append_printf (sink0.desc, "! "VIDEOSINK);
+
+  if (!opts.test_external_server) {
+    server_pid = launch_server_with ("--failover-deadline=500");
+    g_assert_cmpint (server_pid, !=, 0);
+    sleep (2); /* give a second for server to be online */
   }
 
-  gst_init (&argc, &argv);
-  g_test_init (&argc, &argv, NULL);
-  if (opts.enable_test_controller) {
-    g_test_add_func ("/gst-switch/controller", test_controller);
+  client = TESTCLIENT (g_object_new (TYPE_TESTCLIENT, NULL));
+  client->seconds = seconds;
+  testclient_run_thread (client);
+
+  testcase_run_thread (&source1);
+  sleep (1); /* give a second for source1 to be online */
+  testcase_run_thread (&source2);
+  sleep (1); /* make sure source2 is taking B */
+  testcase_run_thread (&sink0);
+  sleep (2); /* no standby yet */
+  compose_count = client->compose_port_count;
+  g_assert_cmpint (compose_count, >=, 1);
+  count_colours (&red, &green);
+  g_assert_cmpint (red, >, 0);
+  g_assert_cmpint (green, ==, 0);
+
+  testcase_run_thread (&source3);
+  sleep (4); /* give the standby time to be online and taken */
+
+  /* the UI is told the composite output changed */
+  g_assert_cmpint (client->compose_port_count, >, compose_count);
+  g_assert_cmpint (client->compose_port, ==, client->compose_port0);
+
+  /* the composite shows the standby, and the stalled input isn't taken
+   * back while it's still unhealthy */
+  compose_count = client->compose_port_count;
+  for (n = 0; n < 2; ++n) {
+    count_colours (&red, &green);
+    g_assert_cmpint (green, >, 0);
+    g_assert_cmpint (red, ==, 0);
   }
-  if (opts.enable_test_composite_mode) {
-    g_test_add_func ("/gst-switch/composite-mode", test_composite_mode);
+  g_assert_cmpint (client->compose_port_count, ==, compose_count);
+  testclient_end (client);
+  testclient_join (client);
+  g_object_unref (client);
+
+  testcase_join (&source1);
+  testcase_join (&source2);
+  testcase_join (&source3);
+  testcase_join (&sink0);
+
+  if (!opts.test_external_server)
+    close_pid (server_pid);
+
+  g_assert_cmpint (source1.error_count, ==, 0);
+  g_assert_cmpint (source3.error_count, ==, 0);
+  g_assert_cmpint (sink0.error_count, ==, 0);
+}
+
+static void
+test_transition (void)
+{
+  const gint seconds = 15;
+  GPid server_pid = 0;
+  testclient *client, *watcher;
+  gint compose_count, encode_count;
+  testcase source1 = { "test-transition-source1", 0 };
+  testcase source2 = { "test-transition-source2", 0 };
+  testcase source3 = { "test-transition-source3", 0 };
+  testcase sink0 = { "test_transition_compose_sink", 0 };
+  gboolean ok;
+
+  g_print ("\n");
+
+  source1.live_seconds = seconds;
+  source1.desc = g_string_new ("videotestsrc pattern=0 ");
+  g_string_append_printf (source1.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (source1.desc, "! gdppay ! tcpclientsink name=tcp_sink port=3000 ");
+
+  source2.live_seconds = seconds;
+  source2.desc = g_string_new ("videotestsrc pattern=1 ");
+  g_string_append_printf (source2.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (source2.desc, "! gdppay ! tcpclientsink name=tcp_sink port=3000 ");
+
+  source3.live_seconds = seconds;
+  source3.desc = g_string_new ("videotestsrc pattern=15 ");
+  g_string_append_printf (source3.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (source3.desc, "! gdppay ! tcpclientsink name=tcp_sink port=3000 ");
+
+  sink0.live_seconds = seconds;
+  sink0.desc = g_string_new ("tcpclientsrc port=3001 ");
+  g_string_append_printf (sink0.desc, "! gdpdepay ");
+  g_string_append_printf (sink0.desc, "! videoconvert ");
+  g_string_append_printf (sink0.desc, "! "VIDEOSINK);
+
+  if (!opts.test_external_server) {
+    server_pid = launch_server ();
+    g_assert_cmpint (server_pid, !=, 0);
+    sleep (2); /* give a second for server to be online */
   }
-  if (opts.enable_test_video) {
-    g_test_add_func ("/gst-switch/video", test_video);
-    g_test_add_func ("/gst-switch/video-recording-result", test_video_recording_result);
+
+  testcase_run_thread (&source1);
+  sleep (1); /* make sure source1 is taking A */
+  testcase_run_thread (&source2);
+  sleep (1); /* make sure source2 is taking B */
+  testcase_run_thread (&source3);
+  sleep (1); /* give a second for sources to be online */
+  testcase_run_thread (&sink0);
+
+  watcher = TESTCLIENT (g_object_new (TYPE_TESTCLIENT, NULL));
+  watcher->seconds = seconds;
+  testclient_run_thread (watcher);
+  sleep (1);
+  compose_count = watcher->compose_port_count;
+  encode_count = watcher->encode_port_count;
+
+  /* A, B and the preview are served on 3003, 3004 and 3005 */
+  client = TESTCLIENT (g_object_new (TYPE_TESTCLIENT, NULL));
+  ok = gst_switch_client_connect (GST_SWITCH_CLIENT (client));
+  g_assert (ok);
+  ok = gst_switch_client_transition (GST_SWITCH_CLIENT (client), 'A', 3005,
+      COMPOSITE_BLEND_CROSSFADE, 1000);
+  g_assert (ok);
+  sleep (3);
+  /* the UIs are told the ports as after a switch */
+  g_assert_cmpint (watcher->compose_port_count, >, compose_count);
+  g_assert_cmpint (watcher->encode_port_count, >, encode_count);
+  /* the old input of A is on the preview port now */
+  ok = gst_switch_client_transition (GST_SWITCH_CLIENT (client), 'B', 3003,
+      COMPOSITE_BLEND_DIP, 1000);
+  g_assert (ok);
+  sleep (3);
+  ok = gst_switch_client_transition (GST_SWITCH_CLIENT (client), 'A', 3004,
+      COMPOSITE_BLEND_WIPE, 1000);
+  g_assert (ok);
+  ok = gst_switch_client_transition (GST_SWITCH_CLIENT (client), 'B', 3005,
+      COMPOSITE_BLEND_WIPE, 1000);
+  g_assert (!ok); /* busy blending A */
+  g_object_unref (client);
+  testclient_end (watcher);
+  testclient_join (watcher);
+  g_object_unref (watcher);
+
+  testcase_join (&source1);
+  testcase_join (&source2);
+  testcase_join (&source3);
+  testcase_join (&sink0);
+
+  if (!opts.test_external_server)
+    close_pid (server_pid);
+
+  g_assert_cmpint (source1.error_count, ==, 0);
+  g_assert_cmpint (source2.error_count, ==, 0);
+  g_assert_cmpint (source3.error_count, ==, 0);
+  g_assert_cmpint (sink0.error_count, ==, 0);
+}
+
+static void
+test_segments (void)
+{
+  const gint seconds = 12;
+  GPid server_pid = 0;
+  testclient *client;
+  testcase video_source = { "test-segments-video-source", 0 };
+  testcase audio_source = { "test-segments-audio-source", 0 };
+  const gchar *name;
+  gint segments = 0;
+  GDir *dir;
+  gboolean ok;
+
+  g_print ("\n");
+
+  video_source.live_seconds = seconds;
+  video_source.desc = g_string_new ("videotestsrc pattern=0 ");
+  g_string_append_printf (video_source.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (video_source.desc, "! gdppay ! tcpclientsink name=tcp_sink port=3000 ");
+
+  audio_source.live_seconds = seconds;
+  audio_source.desc = g_string_new ("audiotestsrc freq=110 wave=2 ");
+  g_string_append_printf (audio_source.desc, "! gdppay ! tcpclientsink name=tcp_sink port=4000");
+
+  if (!opts.test_external_server) {
+    server_pid = launch_server_with ("--record-segment=5");
+    g_assert_cmpint (server_pid, !=, 0);
+    sleep (2); /* give a second for server to be online */
   }
-  if (opts.enable_test_audio) {
-    g_test_add_func ("/gst-switch/audio", test_audio);
-    g_test_add_func ("/gst-switch/audio-recording-result", test_audio_recording_result);
+
+  testcase_run_thread (&video_source);
+  testcase_run_thread (&audio_source);
+  sleep (4);
+
+  client = TESTCLIENT (g_object_new (TYPE_TESTCLIENT, NULL));
+  ok = gst_switch_client_connect (GST_SWITCH_CLIENT (client));
+  g_assert (ok);
+  ok = gst_switch_client_new_record (GST_SWITCH_CLIENT (client));
+  g_assert (ok);
+  g_object_unref (client);
+
+  testcase_join (&video_source);
+  testcase_join (&audio_source);
+
+  if (!opts.test_external_server)
+    close_pid (server_pid);
+
+  g_assert_cmpint (video_source.error_count, ==, 0);
+  g_assert_cmpint (audio_source.error_count, ==, 0);
+
+  if (opts.test_external_server)
+    return;
+
+  /* the playlist lists each segment, remove them all */
+  dir = g_dir_open (".", 0, NULL);
+  g_assert (dir);
+  while ((name = g_dir_read_name (dir))) {
+    if (g_str_has_prefix (name, "test-recording ") &&
+        g_str_has_suffix (name, ".m3u")) {
+      gchar *contents = NULL, **lines, **line;
+      g_assert (g_file_get_contents (name, &contents, NULL, NULL));
+      lines = g_strsplit (contents, "\n", -1);
+      for (line = lines; *line; ++line) {
+        if (**line == '\0' || **line == '#')
+          continue;
+        g_assert (g_file_test (*line, G_FILE_TEST_EXISTS));
+        g_assert (g_unlink (*line) == 0);
+        segments += 1;
+      }
+      g_strfreev (lines);
+      g_free (contents);
+      g_assert (g_unlink (name) == 0);
+    }
   }
-  if (opts.enable_test_ui) {
-    g_test_add_func ("/gst-switch/ui", test_ui);
-    g_test_add_func ("/gst-switch/recording-result", test_recording_result);
+  g_dir_close (dir);
+
+  /* the time limit and new_record both start a new segment */
+  g_assert_cmpint (segments, >=, 3);
+}
+
+static GList *
+list_recordings (void)
+{
+  GList *names = NULL;
+  const gchar *name;
+  GDir *dir = g_dir_open (".", 0, NULL);
+  g_assert (dir);
+  while ((name = g_dir_read_name (dir))) {
+    if (g_str_has_prefix (name, "test-recording ") &&
+        g_str_has_suffix (name, ".data"))
+      names = g_list_insert_sorted (names, g_strdup (name),
+          (GCompareFunc) g_strcmp0);
+  }
+  g_dir_close (dir);
+  return names;
+}
+
+static void
+remove_recordings (void)
+{
+  GList *names = list_recordings (), *name;
+  for (name = names; name; name = g_list_next (name))
+    g_unlink ((const gchar *) name->data);
+  g_list_free_full (names, g_free);
+}
+
+static void
+count_recorded_frame (GstElement *sink, GstBuffer *buffer, GstPad *pad,
+    gint *frames)
+{
+  *frames += 1;
+}
+
+static gint
+count_recorded_frames (const gchar *filename, gint *fps)
+{
+  GstElement *pipeline, *sink;
+  GstMessage *message;
+  GstCaps *caps;
+  GstPad *pad;
+  GstBus *bus;
+  gint frames = 0, fps_d = 1;
+  gchar *desc;
+
+  desc = g_strdup_printf ("filesrc location=\"%s\" ! avidemux name=demux "
+      "demux.video_0 ! fakesink name=sink signal-handoffs=true", filename);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  g_assert (pipeline);
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (count_recorded_frame),
+      &frames);
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  bus = gst_element_get_bus (pipeline);
+  message = gst_bus_timed_pop_filtered (bus, 30 * GST_SECOND,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  g_assert (message);
+  g_assert_cmpint (GST_MESSAGE_TYPE (message), ==, GST_MESSAGE_EOS);
+  gst_message_unref (message);
+  gst_object_unref (bus);
+
+  pad = gst_element_get_static_pad (sink, "sink");
+  caps = gst_pad_get_current_caps (pad);
+  if (caps) {
+    gst_structure_get_fraction (gst_caps_get_structure (caps, 0),
+        "framerate", fps, &fps_d);
+    *fps /= fps_d;
+    gst_caps_unref (caps);
+  }
+  gst_object_unref (pad);
+  gst_object_unref (sink);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  return frames;
+}
+
+/* the mean peak (in dB) of the recorded audio, past the first second */
+static gdouble
+recorded_audio_peak (const gchar *filename)
+{
+  GstElement *pipeline;
+  GstMessage *message;
+  const GstStructure *s;
+  const GValue *list;
+  GValueArray *va;
+  GstBus *bus;
+  gdouble sum = 0.0, peak;
+  gint count = 0, skip = 10;
+  gboolean done = FALSE;
+  guint i;
+  gchar *desc;
+
+  desc = g_strdup_printf ("filesrc location=\"%s\" ! avidemux name=demux "
+      "demux.audio_0 ! faad ! audioconvert "
+      "! level interval=100000000 ! fakesink sync=false", filename);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  g_assert (pipeline);
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  bus = gst_element_get_bus (pipeline);
+  while (!done) {
+    message = gst_bus_timed_pop_filtered (bus, 30 * GST_SECOND,
+        GST_MESSAGE_ELEMENT | GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+    g_assert (message);
+    g_assert_cmpint (GST_MESSAGE_TYPE (message), !=, GST_MESSAGE_ERROR);
+    if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_EOS) {
+      done = TRUE;
+    } else if ((s = gst_message_get_structure (message)) &&
+        gst_structure_has_name (s, "level") && skip-- <= 0) {
+      list = gst_structure_get_value (s, "peak");
+      va = (GValueArray *) g_value_get_boxed (list);
+      peak = -G_MAXDOUBLE;
+      for (i = 0; i < va->n_values; ++i)
+        peak = MAX (peak, g_value_get_double (va->values + i));
+      sum += MAX (peak, -100.0);
+      count += 1;
+    }
+    gst_message_unref (message);
+  }
+  gst_object_unref (bus);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  g_assert_cmpint (count, >, 0);
+  return sum / count;
+}
+
+static void
+test_audio_mix (void)
+{
+  const gint seconds = 20;
+  GPid server_pid = 0;
+  testclient *client;
+  testcase source1 = { "test-audio-mix-source1", 0 };
+  testcase source2 = { "test-audio-mix-source2", 0 };
+  testcase source3 = { "test-audio-mix-source3", 0 };
+  gdouble level[4];
+  GList *names, *name;
+  gboolean ok;
+  gint n;
+
+  g_print ("\n");
+
+  remove_recordings ();
+
+  source1.live_seconds = seconds;
+  source1.desc = g_string_new ("audiotestsrc freq=220 wave=0 is-live=true ");
+  g_string_append_printf (source1.desc, "! gdppay ! tcpclientsink name=tcp_sink port=4000");
+
+  source2.live_seconds = seconds;
+  source2.desc = g_string_new ("audiotestsrc freq=330 wave=0 is-live=true ");
+  g_string_append_printf (source2.desc, "! gdppay ! tcpclientsink name=tcp_sink port=4000");
+
+  source3.live_seconds = seconds;
+  source3.desc = g_string_new ("audiotestsrc freq=440 wave=0 is-live=true ");
+  g_string_append_printf (source3.desc, "! gdppay ! tcpclientsink name=tcp_sink port=4000");
+
+  if (!opts.test_external_server) {
+    server_pid = launch_server_with ("--audio-mix");
+    g_assert_cmpint (server_pid, !=, 0);
+    sleep (2); /* give a second for server to be online */
+  }
+
+  testcase_run_thread (&source1);
+  sleep (1); /* make sure source1 is taking 3003 */
+  testcase_run_thread (&source2);
+  sleep (1); /* make sure source2 is taking 3004 */
+  testcase_run_thread (&source3);
+  sleep (2); /* give a second for audios to be online */
+
+  /* each step is recorded into its own file, only 3003 is heard:
+     at unity gain, at a quarter gain, muted and ducked by 3005 which
+     keeps talking at zero gain */
+  client = TESTCLIENT (g_object_new (TYPE_TESTCLIENT, NULL));
+  ok = gst_switch_client_connect (GST_SWITCH_CLIENT (client));
+  g_assert (ok);
+  ok = gst_switch_client_set_audio_mute (GST_SWITCH_CLIENT (client), 3004, TRUE);
+  g_assert (ok);
+  ok = gst_switch_client_set_audio_gain (GST_SWITCH_CLIENT (client), 3005, 0.0);
+  g_assert (ok);
+  ok = gst_switch_client_new_record (GST_SWITCH_CLIENT (client));
+  g_assert (ok);
+  sleep (3);
+  ok = gst_switch_client_set_audio_gain (GST_SWITCH_CLIENT (client), 3003, 0.25);
+  g_assert (ok);
+  ok = gst_switch_client_new_record (GST_SWITCH_CLIENT (client));
+  g_assert (ok);
+  sleep (3);
+  ok = gst_switch_client_set_audio_gain (GST_SWITCH_CLIENT (client), 3003, 1.0);
+  g_assert (ok);
+  ok = gst_switch_client_set_audio_mute (GST_SWITCH_CLIENT (client), 3003, TRUE);
+  g_assert (ok);
+  ok = gst_switch_client_new_record (GST_SWITCH_CLIENT (client));
+  g_assert (ok);
+  sleep (3);
+  ok = gst_switch_client_set_audio_mute (GST_SWITCH_CLIENT (client), 3003, FALSE);
+  g_assert (ok);
+  ok = gst_switch_client_set_audio_duck (GST_SWITCH_CLIENT (client), 3005, TRUE);
+  g_assert (ok);
+  ok = gst_switch_client_new_record (GST_SWITCH_CLIENT (client));
+  g_assert (ok);
+  sleep (3);
+  ok = gst_switch_client_new_record (GST_SWITCH_CLIENT (client));
+  g_assert (ok);
+  ok = gst_switch_client_set_audio_gain (GST_SWITCH_CLIENT (client), 9999, 1.0);
+  g_assert (!ok);
+  g_object_unref (client);
+
+  testcase_join (&source1);
+  testcase_join (&source2);
+  testcase_join (&source3);
+
+  if (!opts.test_external_server)
+    close_pid (server_pid);
+
+  g_assert_cmpint (source1.error_count, ==, 0);
+  g_assert_cmpint (source2.error_count, ==, 0);
+  g_assert_cmpint (source3.error_count, ==, 0);
+
+  if (opts.test_external_server)
+    return;
+
+  /* the first file is from before the steps */
+  names = list_recordings ();
+  g_assert_cmpint (g_list_length (names), >=, 6);
+  for (n = 0, name = names->next; n < 4; ++n, name = name->next)
+    level[n] = recorded_audio_peak ((const gchar *) name->data);
+  g_list_free_full (names, g_free);
+
+  g_assert_cmpfloat (level[0], >, -10.0);
+  g_assert_cmpfloat (level[1], <, level[0] - 9.0);      /* -12 dB */
+  g_assert_cmpfloat (level[2], <, -60.0);
+  g_assert_cmpfloat (level[3], <, level[0] - 9.0);      /* ducked -12 dB */
+  g_assert_cmpfloat (level[3], >, level[2] + 20.0);
+
+  remove_recordings ();
+}
+
+static void
+test_rotation (void)
+{
+  const gint seconds = 16;
+  GPid server_pid = 0;
+  testclient *client;
+  testcase video_source = { "test-rotation-video-source", 0 };
+  testcase audio_source = { "test-rotation-audio-source", 0 };
+  gint64 rotated1, rotated2;
+  gint frames, expected, fps = 0;
+  GList *names;
+  gboolean ok;
+
+  g_print ("\n");
+
+  if (opts.test_external_server)
+    return; /* the recordings are not accessible */
+
+  remove_recordings ();
+
+  video_source.live_seconds = seconds;
+  video_source.desc = g_string_new ("videotestsrc pattern=0 ");
+  g_string_append_printf (video_source.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (video_source.desc, "! gdppay ! tcpclientsink name=tcp_sink port=3000 ");
+
+  audio_source.live_seconds = seconds;
+  audio_source.desc = g_string_new ("audiotestsrc freq=110 wave=2 ");
+  g_string_append_printf (audio_source.desc, "! gdppay ! tcpclientsink name=tcp_sink port=4000");
+
+  server_pid = launch_server ();
+  g_assert_cmpint (server_pid, !=, 0);
+  sleep (2); /* give a second for server to be online */
+
+  testcase_run_thread (&video_source);
+  testcase_run_thread (&audio_source);
+  sleep (4);
+
+  client = TESTCLIENT (g_object_new (TYPE_TESTCLIENT, NULL));
+  ok = gst_switch_client_connect (GST_SWITCH_CLIENT (client));
+  g_assert (ok);
+  ok = gst_switch_client_new_record (GST_SWITCH_CLIENT (client));
+  rotated1 = g_get_monotonic_time ();
+  g_assert (ok);
+  sleep (5);
+  ok = gst_switch_client_new_record (GST_SWITCH_CLIENT (client));
+  rotated2 = g_get_monotonic_time ();
+  g_assert (ok);
+  g_object_unref (client);
+
+  testcase_join (&video_source);
+  testcase_join (&audio_source);
+
+  close_pid (server_pid);
+
+  g_assert_cmpint (video_source.error_count, ==, 0);
+  g_assert_cmpint (audio_source.error_count, ==, 0);
+
+  /* the file between the two rotations covers the whole interval, frames
+     missing from it were dropped by rotating */
+  names = list_recordings ();
+  g_assert_cmpint (g_list_length (names), >=, 3);
+  frames = count_recorded_frames (
+      (const gchar *) g_list_nth_data (names, g_list_length (names) - 2),
+      &fps);
+  g_assert_cmpint (fps, >, 0);
+  expected = (gint) ((rotated2 - rotated1) * fps / G_USEC_PER_SEC);
+  g_print ("rotation: %d of %d frames dropped\n", MAX (expected - frames, 0),
+      expected);
+  g_assert_cmpint (expected - frames, <, fps);
+  g_list_free_full (names, g_free);
+
+  remove_recordings ();
+}
+
+static void
+test_iso (void)
+{
+  const gint seconds = 10;
+  GPid server_pid = 0;
+  testcase video_source = { "test-iso-video-source", 0 };
+  testcase audio_source = { "test-iso-audio-source", 0 };
+  const gchar *name;
+  gint video_files = 0, audio_files = 0;
+  GDir *dir;
+
+  g_print ("\n");
+
+  video_source.live_seconds = seconds;
+  video_source.desc = g_string_new ("videotestsrc pattern=0 ");
+  g_string_append_printf (video_source.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (video_source.desc, "! gdppay ! tcpclientsink name=tcp_sink port=3000 ");
+
+  audio_source.live_seconds = seconds;
+  audio_source.desc = g_string_new ("audiotestsrc freq=110 wave=2 ");
+  g_string_append_printf (audio_source.desc, "! gdppay ! tcpclientsink name=tcp_sink port=4000");
+
+  if (!opts.test_external_server) {
+    server_pid = launch_server_with ("--record-iso");
+    g_assert_cmpint (server_pid, !=, 0);
+    sleep (2); /* give a second for server to be online */
+  }
+
+  testcase_run_thread (&video_source);
+  testcase_run_thread (&audio_source);
+  testcase_join (&video_source);
+  testcase_join (&audio_source);
+
+  if (!opts.test_external_server)
+    close_pid (server_pid);
+
+  g_assert_cmpint (video_source.error_count, ==, 0);
+  g_assert_cmpint (audio_source.error_count, ==, 0);
+
+  if (opts.test_external_server)
+    return;
+
+  /* each input is recorded into a file of its own, by its codec ID */
+  dir = g_dir_open (".", 0, NULL);
+  g_assert (dir);
+  while ((name = g_dir_read_name (dir))) {
+    if (g_str_has_prefix (name, "test-recording input_") &&
+        g_str_has_suffix (name, ".mkv")) {
+      gchar *contents = NULL;
+      gsize size = 0;
+      g_assert (g_file_get_contents (name, &contents, &size, NULL));
+      g_assert_cmpint (size, >, 0);
+      if (has_bytes (contents, MIN (size, 4096), "V_VP8"))
+        video_files += 1;
+      if (has_bytes (contents, MIN (size, 4096), "A_AAC"))
+        audio_files += 1;
+      g_free (contents);
+      g_assert (g_unlink (name) == 0);
+    }
+  }
+  g_dir_close (dir);
+
+  g_assert_cmpint (video_files, >=, 1);
+  g_assert_cmpint (audio_files, >=, 1);
+}
+
+static void
+test_compressed_input (void)
+{
+  const gint seconds = 10;
+  GPid server_pid = 0;
+  testcase vp8_source = { "test-compressed-vp8-source", 0 };
+  testcase raw_source = { "test-compressed-raw-source", 0 };
+  testcase audio_source = { "test-compressed-audio-source", 0 };
+  GstCaps *caps;
+  gint buffers;
+
+  g_print ("\n");
+
+  remove_recordings ();
+
+  /* a GDP wrapped VP8 camera beside a raw one */
+  vp8_source.live_seconds = seconds;
+  vp8_source.desc = g_string_new ("videotestsrc pattern=0 ");
+  g_string_append_printf (vp8_source.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (vp8_source.desc, "! vp8enc deadline=1 ");
+  g_string_append_printf (vp8_source.desc, "! gdppay ! tcpclientsink name=tcp_sink port=3000 ");
+
+  raw_source.live_seconds = seconds;
+  raw_source.desc = g_string_new ("videotestsrc pattern=1 ");
+  g_string_append_printf (raw_source.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (raw_source.desc, "! gdppay ! tcpclientsink name=tcp_sink port=3000 ");
+
+  audio_source.live_seconds = seconds;
+  audio_source.desc = g_string_new ("audiotestsrc freq=110 wave=2 ");
+  g_string_append_printf (audio_source.desc, "! gdppay ! tcpclientsink name=tcp_sink port=4000");
+
+  if (!opts.test_external_server) {
+    server_pid = launch_server ();
+    g_assert_cmpint (server_pid, !=, 0);
+    sleep (2); /* give a second for server to be online */
+  }
+
+  /* the VP8 input comes first and is served on the first preview port */
+  testcase_run_thread (&vp8_source);
+  sleep (1);
+  testcase_run_thread (&raw_source);
+  testcase_run_thread (&audio_source);
+  sleep (3);
+
+  if (!opts.test_external_server) {
+    /* the compressed input is decoded to raw frames */
+    caps = probe_port ("tcpclientsrc port=3003 ! gdpdepay "
+        "! fakesink name=sink sync=false", 2, &buffers);
+    assert_video_caps (caps, "I420", W, H, 30);
+    gst_caps_unref (caps);
+    g_assert_cmpint (buffers, >, 0);
+
+    caps = probe_port ("tcpclientsrc port=3004 ! gdpdepay "
+        "! fakesink name=sink sync=false", 2, &buffers);
+    assert_video_caps (caps, "I420", W, H, 30);
+    gst_caps_unref (caps);
+    g_assert_cmpint (buffers, >, 0);
+  }
+
+  testcase_join (&vp8_source);
+  testcase_join (&raw_source);
+  testcase_join (&audio_source);
+
+  if (!opts.test_external_server)
+    close_pid (server_pid);
+
+  g_assert_cmpint (vp8_source.error_count, ==, 0);
+  g_assert_cmpint (raw_source.error_count, ==, 0);
+  g_assert_cmpint (audio_source.error_count, ==, 0);
+
+  remove_recordings ();
+}
+
+static void
+test_normalise (void)
+{
+  const gint seconds = 15;
+  GPid server_pid = 0;
+  testcase small_source = { "test-normalise-small-source", 0 };
+  testcase large_source = { "test-normalise-large-source", 0 };
+  testcase audio_source = { "test-normalise-audio-source", 0 };
+  GstCaps *caps;
+  gint buffers;
+
+  g_print ("\n");
+
+  remove_recordings ();
+
+  /* cameras of other sizes, pixel formats and frame rates */
+  small_source.live_seconds = seconds;
+  small_source.desc = g_string_new ("videotestsrc pattern=0 ");
+  g_string_append_printf (small_source.desc, "! video/x-raw,format=YUY2,width=%d,height=%d,framerate=15/1 ", W / 2, H / 2);
+  g_string_append_printf (small_source.desc, "! gdppay ! tcpclientsink name=tcp_sink port=3000 ");
+
+  large_source.live_seconds = seconds;
+  large_source.desc = g_string_new ("videotestsrc pattern=1 ");
+  g_string_append_printf (large_source.desc, "! video/x-raw,format=RGB,width=%d,height=%d,framerate=50/1 ", W * 3 / 2, H * 3 / 2);
+  g_string_append_printf (large_source.desc, "! gdppay ! tcpclientsink name=tcp_sink port=3000 ");
+
+  audio_source.live_seconds = seconds;
+  audio_source.desc = g_string_new ("audiotestsrc freq=110 wave=2 ");
+  g_string_append_printf (audio_source.desc, "! gdppay ! tcpclientsink name=tcp_sink port=4000");
+
+  if (!opts.test_external_server) {
+    server_pid = launch_server ();
+    g_assert_cmpint (server_pid, !=, 0);
+    sleep (2); /* give a second for server to be online */
+  }
+
+  testcase_run_thread (&small_source);
+  sleep (1);
+  testcase_run_thread (&large_source);
+  testcase_run_thread (&audio_source);
+  sleep (3);
+
+  if (!opts.test_external_server) {
+    /* the 15 fps YUY2 input is I420 of the output size and rate, more
+       frames are served than the camera gives */
+    caps = probe_port ("tcpclientsrc port=3003 ! gdpdepay "
+        "! fakesink name=sink sync=false", 4, &buffers);
+    assert_video_caps (caps, "I420", W, H, 30);
+    gst_caps_unref (caps);
+    g_assert_cmpint (buffers, >, 15 * 4 + 15);
+
+    /* the 50 fps RGB input is scaled down and dropped to the output rate */
+    caps = probe_port ("tcpclientsrc port=3004 ! gdpdepay "
+        "! fakesink name=sink sync=false", 4, &buffers);
+    assert_video_caps (caps, "I420", W, H, 30);
+    gst_caps_unref (caps);
+    g_assert_cmpint (buffers, >, 0);
+    g_assert_cmpint (buffers, <, 50 * 4 - 30);
+  }
+
+  testcase_join (&small_source);
+  testcase_join (&large_source);
+  testcase_join (&audio_source);
+
+  if (!opts.test_external_server)
+    close_pid (server_pid);
+
+  g_assert_cmpint (small_source.error_count, ==, 0);
+  g_assert_cmpint (large_source.error_count, ==, 0);
+  g_assert_cmpint (audio_source.error_count, ==, 0);
+
+  remove_recordings ();
+}
+
+static void
+test_video_format (void)
+{
+  const gint seconds = 15;
+  GPid server_pid = 0;
+  testclient *client;
+  testcase video_source1 = { "test-video-format-source1", 0 };
+  testcase video_source2 = { "test-video-format-source2", 0 };
+  testcase audio_source = { "test-video-format-audio-source", 0 };
+  GstCaps *caps;
+  gint buffers;
+  gboolean ok;
+
+  g_print ("\n");
+
+  video_source1.live_seconds = seconds;
+  video_source1.desc = g_string_new ("videotestsrc pattern=0 ");
+  g_string_append_printf (video_source1.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (video_source1.desc, "! gdppay ! tcpclientsink name=tcp_sink port=3000 ");
+
+  video_source2.live_seconds = seconds;
+  video_source2.desc = g_string_new ("videotestsrc pattern=1 ");
+  g_string_append_printf (video_source2.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (video_source2.desc, "! gdppay ! tcpclientsink name=tcp_sink port=3000 ");
+
+  audio_source.live_seconds = seconds;
+  audio_source.desc = g_string_new ("audiotestsrc freq=110 wave=2 ");
+  g_string_append_printf (audio_source.desc, "! gdppay ! tcpclientsink name=tcp_sink port=4000");
+
+  if (!opts.test_external_server) {
+    server_pid = launch_server_with ("--video-size=640x360");
+    g_assert_cmpint (server_pid, !=, 0);
+    sleep (2); /* give a second for server to be online */
+  }
+
+  testcase_run_thread (&video_source1);
+  testcase_run_thread (&video_source2);
+  testcase_run_thread (&audio_source);
+  sleep (3);
+
+  client = TESTCLIENT (g_object_new (TYPE_TESTCLIENT, NULL));
+  ok = gst_switch_client_connect (GST_SWITCH_CLIENT (client));
+  g_assert (ok);
+  caps = probe_port ("tcpclientsrc port=3001 ! gdpdepay "
+      "! fakesink name=sink sync=false", 2, &buffers);
+  assert_video_caps (caps, NULL, 640, 360, 30);
+  gst_caps_unref (caps);
+  g_assert_cmpint (buffers, >, 0);
+
+  ok = gst_switch_client_set_video_format (GST_SWITCH_CLIENT (client), W, H, 25);
+  g_assert (ok);
+  sleep (5); /* inputs of the former size are scaled */
+
+  /* the output follows the new format */
+  caps = probe_port ("tcpclientsrc port=3001 ! gdpdepay "
+      "! fakesink name=sink sync=false", 2, &buffers);
+  assert_video_caps (caps, NULL, W, H, 25);
+  gst_caps_unref (caps);
+  g_assert_cmpint (buffers, >, 0);
+
+  ok = gst_switch_client_set_video_format (GST_SWITCH_CLIENT (client), 0, 0, 0);
+  g_assert (!ok);
+  g_object_unref (client);
+
+  testcase_join (&video_source1);
+  testcase_join (&video_source2);
+  testcase_join (&audio_source);
+
+  if (!opts.test_external_server)
+    close_pid (server_pid);
+
+  g_assert_cmpint (video_source1.error_count, ==, 0);
+  g_assert_cmpint (video_source2.error_count, ==, 0);
+  g_assert_cmpint (audio_source.error_count, ==, 0);
+}
+
+static void
+test_layout (void)
+{
+  const gint seconds = 15;
+  const gchar *layouts =
+    "[test-quad]\n"
+    "a1=A;0;0;0.5;0.5\n"
+    "b1=B;0.5;0;0.5;0.5\n"
+    "a2=A;0;0.5;0.5;0.5;0;0.5\n"
+    "b2=B;0.5;0.5;0.5;0.5;3\n";
+  GPid server_pid = 0;
+  testclient *client;
+  testcase video_source1 = { "test-layout-source1", 0 };
+  testcase video_source2 = { "test-layout-source2", 0 };
+  testcase video_source3 = { "test-layout-source3", 0 };
+  gboolean ok;
+
+  g_print ("\n");
+
+  ok = g_file_set_contents ("test-layouts.conf", layouts, -1, NULL);
+  g_assert (ok);
+
+  video_source1.live_seconds = seconds;
+  video_source1.desc = g_string_new ("videotestsrc pattern=0 ");
+  g_string_append_printf (video_source1.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (video_source1.desc, "! gdppay ! tcpclientsink name=tcp_sink port=3000 ");
+
+  video_source2.live_seconds = seconds;
+  video_source2.desc = g_string_new ("videotestsrc pattern=1 ");
+  g_string_append_printf (video_source2.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (video_source2.desc, "! gdppay ! tcpclientsink name=tcp_sink port=3000 ");
+
+  video_source3.live_seconds = seconds;
+  video_source3.desc = g_string_new ("videotestsrc pattern=15 ");
+  g_string_append_printf (video_source3.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (video_source3.desc, "! gdppay ! tcpclientsink name=tcp_sink port=3000 ");
+
+  if (!opts.test_external_server) {
+    server_pid = launch_server_with ("--layouts=test-layouts.conf");
+    g_assert_cmpint (server_pid, !=, 0);
+    sleep (2); /* give a second for server to be online */
+  }
+
+  testcase_run_thread (&video_source1);
+  sleep (1); /* make sure source1 is taking A */
+  testcase_run_thread (&video_source2);
+  sleep (1); /* make sure source2 is taking B */
+  testcase_run_thread (&video_source3);
+  sleep (2);
+
+  client = TESTCLIENT (g_object_new (TYPE_TESTCLIENT, NULL));
+  ok = gst_switch_client_connect (GST_SWITCH_CLIENT (client));
+  g_assert (ok);
+  ok = gst_switch_client_set_layout (GST_SWITCH_CLIENT (client), "test-quad");
+  g_assert (ok);
+  sleep (3);
+  /* B is shown in two boxes, the blending follows the first one */
+  ok = gst_switch_client_transition (GST_SWITCH_CLIENT (client), 'B', 3005,
+      COMPOSITE_BLEND_CROSSFADE, 1000);
+  g_assert (ok);
+  sleep (3);
+  ok = gst_switch_client_set_layout (GST_SWITCH_CLIENT (client), "no-such-layout");
+  g_assert (!ok);
+  ok = gst_switch_client_set_layout (GST_SWITCH_CLIENT (client), "pip");
+  g_assert (ok);
+  g_object_unref (client);
+
+  testcase_join (&video_source1);
+  testcase_join (&video_source2);
+  testcase_join (&video_source3);
+
+  if (!opts.test_external_server)
+    close_pid (server_pid);
+
+  g_unlink ("test-layouts.conf");
+
+  g_assert_cmpint (video_source1.error_count, ==, 0);
+  g_assert_cmpint (video_source2.error_count, ==, 0);
+  g_assert_cmpint (video_source3.error_count, ==, 0);
+}
+
+static void
+test_multibox (void)
+{
+  const gint seconds = 15;
+  GPid server_pid = 0;
+  testclient *client;
+  testcase video_source[4] = {
+    { "test-multibox-source1", 0 },
+    { "test-multibox-source2", 0 },
+    { "test-multibox-source3", 0 },
+    { "test-multibox-source4", 0 },
+  };
+  gboolean ok;
+  gint n;
+
+  g_print ("\n");
+
+  for (n = 0; n < 4; ++n) {
+    video_source[n].live_seconds = seconds;
+    video_source[n].desc = g_string_new ("");
+    g_string_append_printf (video_source[n].desc, "videotestsrc pattern=%d ", n);
+    g_string_append_printf (video_source[n].desc, "! video/x-raw,width=%d,height=%d ", W, H);
+    g_string_append_printf (video_source[n].desc, "! gdppay ! tcpclientsink name=tcp_sink port=3000 ");
+  }
+
+  if (!opts.test_external_server) {
+    server_pid = launch_server ();
+    g_assert_cmpint (server_pid, !=, 0);
+    sleep (2); /* give a second for server to be online */
+  }
+
+  for (n = 0; n < 4; ++n) {
+    testcase_run_thread (&video_source[n]);
+    sleep (1); /* keep the port order */
+  }
+  sleep (1);
+
+  client = TESTCLIENT (g_object_new (TYPE_TESTCLIENT, NULL));
+  ok = gst_switch_client_connect (GST_SWITCH_CLIENT (client));
+  g_assert (ok);
+  ok = gst_switch_client_set_layout (GST_SWITCH_CLIENT (client), "grid-2x2");
+  g_assert (ok);
+  sleep (2);
+  /* C and D are empty, the previews are promoted into them */
+  ok = gst_switch_client_switch (GST_SWITCH_CLIENT (client), 'C', 3005);
+  g_assert (ok);
+  sleep (1);
+  ok = gst_switch_client_switch (GST_SWITCH_CLIENT (client), 'D', 3006);
+  g_assert (ok);
+  sleep (2);
+  ok = gst_switch_client_transition (GST_SWITCH_CLIENT (client), 'A', 3005,
+      COMPOSITE_BLEND_WIPE, 1000);
+  g_assert (ok);
+  sleep (2);
+  ok = gst_switch_client_set_layout (GST_SWITCH_CLIENT (client), "grid-3x3");
+  g_assert (ok);
+  sleep (2);
+  ok = gst_switch_client_switch (GST_SWITCH_CLIENT (client), 'J', 3003);
+  g_assert (!ok);
+  g_object_unref (client);
+
+  for (n = 0; n < 4; ++n)
+    testcase_join (&video_source[n]);
+
+  if (!opts.test_external_server)
+    close_pid (server_pid);
+
+  for (n = 0; n < 4; ++n)
+    g_assert_cmpint (video_source[n].error_count, ==, 0);
+}
+
+/**
+ * tcp_control_reply:
+ *
+ * Read the next reply of the TCP control port, skipping the events.
+ */
+static gchar *
+tcp_control_reply (GDataInputStream * input)
+{
+  gchar *line;
+  while ((line = g_data_input_stream_read_line (input, NULL, NULL, NULL))) {
+    if (!strstr (line, "\"event\""))
+      break;
+    g_free (line);
+  }
+  g_assert (line != NULL);
+  return line;
+}
+
+static void
+test_tcp_control (void)
+{
+  const gchar *requests =
+    "{\"id\":1,\"method\":\"subscribe\"}\n"
+    "{\"id\":2,\"method\":\"get_compose_port\"}\n"
+    "{\"id\":3,\"method\":\"no_such_method\"}\n"
+    "not json\n"
+    "{\"id\":5,\"method\":\"switch\",\"params\":[\"A\",3004]}\n";
+  const gint seconds = 10;
+  GPid server_pid = 0;
+  GSocketClient *socket_client;
+  GSocketConnection *connection;
+  GDataInputStream *input;
+  GOutputStream *output;
+  GError *error = NULL;
+  testcase video_source1 = { "test-tcp-control-source1", 0 };
+  testcase video_source2 = { "test-tcp-control-source2", 0 };
+  gchar *line;
+  gboolean ok;
+
+  g_print ("\n");
+
+  video_source1.live_seconds = seconds;
+  video_source1.desc = g_string_new ("videotestsrc pattern=0 ");
+  g_string_append_printf (video_source1.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (video_source1.desc, "! gdppay ! tcpclientsink port=3000 ");
+
+  video_source2.live_seconds = seconds;
+  video_source2.desc = g_string_new ("videotestsrc pattern=1 ");
+  g_string_append_printf (video_source2.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (video_source2.desc, "! gdppay ! tcpclientsink port=3000 ");
+
+  if (!opts.test_external_server) {
+    server_pid = launch_server ();
+    g_assert_cmpint (server_pid, !=, 0);
+    sleep (2); /* give a second for server to be online */
+  }
+
+  testcase_run_thread (&video_source1);
+  sleep (1); /* keep the port order */
+  testcase_run_thread (&video_source2);
+  sleep (2);
+
+  socket_client = g_socket_client_new ();
+  connection = g_socket_client_connect_to_host (socket_client, "localhost",
+      5000, NULL, &error);
+  g_assert_no_error (error);
+  input = g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM
+          (connection)));
+  output = g_io_stream_get_output_stream (G_IO_STREAM (connection));
+
+  /* all requests are pipelined and answered in order */
+  ok = g_output_stream_write_all (output, requests, strlen (requests), NULL,
+      NULL, &error);
+  g_assert_no_error (error);
+  g_assert (ok);
+
+  line = tcp_control_reply (input);
+  g_assert (strstr (line, "\"id\":1") && strstr (line, "\"result\""));
+  g_free (line);
+  line = tcp_control_reply (input);
+  g_assert (strstr (line, "\"id\":2") && strstr (line, "\"result\""));
+  g_free (line);
+  line = tcp_control_reply (input);
+  g_assert (strstr (line, "\"id\":3") && strstr (line, "\"error\""));
+  g_free (line);
+  line = tcp_control_reply (input);
+  g_assert (!strstr (line, "\"id\"") && strstr (line, "\"error\""));
+  g_free (line);
+  line = tcp_control_reply (input);
+  g_assert (strstr (line, "\"id\":5") && strstr (line, "true"));
+  g_free (line);
+
+  g_object_unref (input);
+  g_object_unref (connection);
+  g_object_unref (socket_client);
+
+  testcase_join (&video_source1);
+  testcase_join (&video_source2);
+
+  if (!opts.test_external_server)
+    close_pid (server_pid);
+
+  g_assert_cmpint (video_source1.error_count, ==, 0);
+  g_assert_cmpint (video_source2.error_count, ==, 0);
+}
+
+static void
+test_audio_level (void)
+{
+  const gchar *subscribe = "{\"id\":1,\"method\":\"subscribe\"}\n";
+  const gint seconds = 10;
+  GPid server_pid = 0;
+  GSocketClient *socket_client;
+  GSocketConnection *connection;
+  GDataInputStream *input;
+  GOutputStream *output;
+  GError *error = NULL;
+  testcase source1 = { "test-audio-level-source1", 0 };
+  gchar *line;
+  gint levels = 0, n;
+  gboolean ok;
+
+  g_print ("\n");
+
+  source1.live_seconds = seconds;
+  source1.desc = g_string_new ("audiotestsrc freq=110 wave=2 ");
+  g_string_append_printf (source1.desc, "! gdppay ! tcpclientsink port=4000 ");
+
+  if (!opts.test_external_server) {
+    server_pid = launch_server_with ("--audio-level-interval=50");
+    g_assert_cmpint (server_pid, !=, 0);
+    sleep (2); /* give a second for server to be online */
+  }
+
+  testcase_run_thread (&source1);
+  sleep (2);
+
+  socket_client = g_socket_client_new ();
+  connection = g_socket_client_connect_to_host (socket_client, "localhost",
+      5000, NULL, &error);
+  g_assert_no_error (error);
+  g_socket_set_timeout (g_socket_connection_get_socket (connection), 5);
+  input = g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM
+          (connection)));
+  output = g_io_stream_get_output_stream (G_IO_STREAM (connection));
+  ok = g_output_stream_write_all (output, subscribe, strlen (subscribe), NULL,
+      NULL, &error);
+  g_assert_no_error (error);
+  g_assert (ok);
+
+  /* levels are told without any client decoding the audio */
+  for (n = 0; n < 200 && levels < 10; ++n) {
+    line = g_data_input_stream_read_line (input, NULL, NULL, NULL);
+    if (!line)
+      break;
+    if (strstr (line, "\"event\":\"audio_level\""))
+      levels += 1;
+    g_free (line);
+  }
+  g_assert_cmpint (levels, ==, 10);
+
+  g_object_unref (input);
+  g_object_unref (connection);
+  g_object_unref (socket_client);
+
+  testcase_join (&source1);
+
+  if (!opts.test_external_server)
+    close_pid (server_pid);
+
+  g_assert_cmpint (source1.error_count, ==, 0);
+}
+
+static void
+test_preview_shm (void)
+{
+  const gint seconds = 10;
+  GPid server_pid = 0;
+  GSocketClient *socket_client;
+  GSocketConnection *connection;
+  GDataInputStream *input;
+  GOutputStream *output;
+  GError *error = NULL;
+  testcase video_source1 = { "test-preview-shm-source1", 0 };
+  gchar *line, *request, *path = NULL, *desc, *s;
+  gint port, buffers, n;
+  GstCaps *caps;
+  gboolean ok;
+
+  g_print ("\n");
+
+  video_source1.live_seconds = seconds;
+  video_source1.desc = g_string_new ("videotestsrc pattern=0 ");
+  g_string_append_printf (video_source1.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (video_source1.desc, "! gdppay ! tcpclientsink port=3000 ");
+
+  if (!opts.test_external_server) {
+    server_pid = launch_server_with ("--preview-shm");
+    g_assert_cmpint (server_pid, !=, 0);
+    sleep (2); /* give a second for server to be online */
+  }
+
+  testcase_run_thread (&video_source1);
+  sleep (2);
+
+  socket_client = g_socket_client_new ();
+  connection = g_socket_client_connect_to_host (socket_client, "localhost",
+      5000, NULL, &error);
+  g_assert_no_error (error);
+  input = g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM
+          (connection)));
+  output = g_io_stream_get_output_stream (G_IO_STREAM (connection));
+
+  /* look for the preview among the first allocated ports */
+  for (port = 3001; port < 3010 && path == NULL; ++port) {
+    request = g_strdup_printf ("{\"id\":%d,\"method\":\"get_preview_shm\","
+        "\"params\":[%d]}\n", port, port);
+    ok = g_output_stream_write_all (output, request, strlen (request), NULL,
+        NULL, &error);
+    g_assert_no_error (error);
+    g_assert (ok);
+    g_free (request);
+
+    line = tcp_control_reply (input);
+    g_assert (strstr (line, "\"result\""));
+    if ((s = strstr (line, "[\"/"))) {
+      path = g_strdup (s + 2);
+      *strchr (path, '"') = '\0';
+      g_assert (strstr (line, "video/x-raw"));
+    }
+    g_free (line);
+  }
+  g_assert (path != NULL);
+  g_assert (g_file_test (path, G_FILE_TEST_EXISTS));
+
+  g_object_unref (input);
+  g_object_unref (connection);
+  g_object_unref (socket_client);
+
+  /* frames are mapped without any TCP client, and keep coming to a client
+     connecting again after the first one went away */
+  desc = g_strdup_printf ("shmsrc socket-path=%s is-live=true "
+      "! fakesink name=sink", path);
+  for (n = 0; n < 2; ++n) {
+    caps = probe_port (desc, 3, &buffers);
+    if (caps)
+      gst_caps_unref (caps);
+    g_assert_cmpint (buffers, >, 30);
+    if (!opts.test_external_server)
+      g_assert_cmpint (kill (server_pid, 0), ==, 0);
+  }
+  g_free (desc);
+  g_free (path);
+
+  testcase_join (&video_source1);
+
+  if (!opts.test_external_server)
+    close_pid (server_pid);
+
+  g_assert_cmpint (video_source1.error_count, ==, 0);
+}
+
+static void
+test_local_input (void)
+{
+  const gchar *request = "{\"id\":1,\"method\":\"get_preview_ports\"}\n";
+  const gint seconds = 15;
+  GPid server_pid = 0;
+  GSocketClient *socket_client;
+  GSocketConnection *connection, *local;
+  GSocketAddress *saddr;
+  GDataInputStream *input;
+  GOutputStream *output;
+  GError *error = NULL;
+  testcase video_source1 = { "test-local-input-source1", 0 };
+  testcase video_source2 = { "test-local-input-source2", 0 };
+  gchar *dir, *arg, *path, *line;
+  gint previews = 0, buffers;
+  GstCaps *caps;
+  gboolean ok;
+
+  g_print ("\n");
+
+  dir = g_dir_make_tmp ("gst-switch-input-XXXXXX", &error);
+  g_assert_no_error (error);
+
+  if (!opts.test_external_server) {
+    arg = g_strdup_printf ("--input-dir=%s", dir);
+    server_pid = launch_server_with (arg);
+    g_assert_cmpint (server_pid, !=, 0);
+    g_free (arg);
+    sleep (2); /* give a second for server to be online */
+  }
+
+  /* a producer writing GDP into the Unix socket */
+  socket_client = g_socket_client_new ();
+  path = g_build_filename (dir, "video", NULL);
+  saddr = g_unix_socket_address_new (path);
+  local = g_socket_client_connect (socket_client, G_SOCKET_CONNECTABLE (saddr),
+      NULL, &error);
+  g_assert_no_error (error);
+  g_object_unref (saddr);
+  g_free (path);
+
+  video_source1.live_seconds = seconds;
+  video_source1.desc = g_string_new ("videotestsrc pattern=0 ");
+  g_string_append_printf (video_source1.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (video_source1.desc, "! gdppay ! fdsink fd=%d ",
+      g_socket_get_fd (g_socket_connection_get_socket (local)));
+
+  /* a producer writing GDP into shared memory */
+  path = g_build_filename (dir, "video-test2", NULL);
+  video_source2.live_seconds = seconds;
+  video_source2.desc = g_string_new ("videotestsrc pattern=1 ");
+  g_string_append_printf (video_source2.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (video_source2.desc, "! gdppay ! shmsink socket-path=%s ", path);
+  g_string_append_printf (video_source2.desc, "shm-size=%d wait-for-connection=true ", W * H * 8);
+  g_free (path);
+
+  /* the shared memory input comes first and takes the first port */
+  testcase_run_thread (&video_source2);
+  sleep (2);
+  testcase_run_thread (&video_source1);
+  sleep (3);
+
+  connection = g_socket_client_connect_to_host (socket_client, "localhost",
+      5000, NULL, &error);
+  g_assert_no_error (error);
+  input = g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM
+          (connection)));
+  output = g_io_stream_get_output_stream (G_IO_STREAM (connection));
+  ok = g_output_stream_write_all (output, request, strlen (request), NULL,
+      NULL, &error);
+  g_assert_no_error (error);
+  g_assert (ok);
+
+  /* both local inputs are served as the TCP inputs are */
+  line = tcp_control_reply (input);
+  for (arg = line; (arg = strchr (arg, '(')); ++arg)
+    previews += 1;
+  g_free (line);
+  g_assert_cmpint (previews, >=, 2);
+
+  g_object_unref (input);
+  g_object_unref (connection);
+
+  /* the frames of the shared memory input are decoded and served */
+  caps = probe_port ("tcpclientsrc port=3003 ! gdpdepay "
+      "! fakesink name=sink sync=false", 2, &buffers);
+  assert_video_caps (caps, NULL, 0, 0, 0);
+  gst_caps_unref (caps);
+  g_assert_cmpint (buffers, >, 0);
+
+  testcase_join (&video_source1);
+  testcase_join (&video_source2);
+  g_object_unref (local);
+  g_object_unref (socket_client);
+
+  if (!opts.test_external_server)
+    close_pid (server_pid);
+
+  g_rmdir (dir);
+  g_free (dir);
+
+  g_assert_cmpint (video_source1.error_count, ==, 0);
+  g_assert_cmpint (video_source2.error_count, ==, 0);
+}
+
+static void
+test_rtp_output (void)
+{
+  const gint seconds = 10;
+  GPid server_pid = 0;
+  GSocket *socket;
+  GInetAddress *any;
+  GSocketAddress *saddr;
+  GError *error = NULL;
+  testcase video_source1 = { "test-rtp-output-source1", 0 };
+  gchar packet[2048];
+  gssize size;
+  gint packets = 0, n;
+  gboolean ok;
+
+  g_print ("\n");
+
+  /* the receiver is bound before the server sends */
+  socket = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+      G_SOCKET_PROTOCOL_UDP, &error);
+  g_assert_no_error (error);
+  any = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  saddr = g_inet_socket_address_new (any, 5004);
+  ok = g_socket_bind (socket, saddr, TRUE, &error);
+  g_assert_no_error (error);
+  g_assert (ok);
+  g_object_unref (saddr);
+  g_object_unref (any);
+  g_socket_set_timeout (socket, 5);
+
+  video_source1.live_seconds = seconds;
+  video_source1.desc = g_string_new ("videotestsrc pattern=0 ");
+  g_string_append_printf (video_source1.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (video_source1.desc, "! gdppay ! tcpclientsink port=3000 ");
+
+  if (!opts.test_external_server) {
+    server_pid = launch_server_with ("--rtp-output=127.0.0.1:5004");
+    g_assert_cmpint (server_pid, !=, 0);
+    sleep (2); /* give a second for server to be online */
+  }
+
+  testcase_run_thread (&video_source1);
+
+  /* RFC 4175 packets without any TCP client on the output port */
+  for (n = 0; n < 1000 && packets < 100; ++n) {
+    size = g_socket_receive (socket, packet, sizeof (packet), NULL, &error);
+    g_assert_no_error (error);
+    g_assert_cmpint (size, >, 12);
+    g_assert_cmpint (size, <=, 1400);
+    g_assert_cmpint (packet[0] & 0xc0, ==, 0x80); /* RTP version 2 */
+    g_assert_cmpint (packet[1] & 0x7f, ==, 96);
+    packets += 1;
+  }
+  g_assert_cmpint (packets, ==, 100);
+  g_object_unref (socket);
+
+  testcase_join (&video_source1);
+
+  if (!opts.test_external_server)
+    close_pid (server_pid);
+
+  g_assert_cmpint (video_source1.error_count, ==, 0);
+}
+
+static void
+test_client_policy (void)
+{
+  const gint seconds = 15;
+  GPid server_pid = 0;
+  GSocketClient *client;
+  GSocketConnection *connection;
+  GSocket *socket;
+  GError *error = NULL;
+  testcase video_source1 = { "test-client-policy-source1", 0 };
+  gchar data[65536];
+  gssize size = 0;
+  gint64 deadline;
+  gboolean eof = FALSE;
+
+  g_print ("\n");
+
+  video_source1.live_seconds = seconds;
+  video_source1.desc = g_string_new ("videotestsrc pattern=0 ");
+  g_string_append_printf (video_source1.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (video_source1.desc, "! gdppay ! tcpclientsink port=3000 ");
+
+  if (!opts.test_external_server) {
+    server_pid = launch_server_with ("--client-disconnect-lag=1000");
+    g_assert_cmpint (server_pid, !=, 0);
+    sleep (2); /* give a second for server to be online */
+  }
+
+  testcase_run_thread (&video_source1);
+  sleep (2);
+
+  /* a stalled client of the output port is disconnected */
+  client = g_socket_client_new ();
+  connection = g_socket_client_connect_to_host (client, "127.0.0.1", 3001,
+      NULL, &error);
+  g_assert_no_error (error);
+  socket = g_socket_connection_get_socket (connection);
+  g_socket_set_timeout (socket, 5);
+  sleep (4);
+  deadline = g_get_monotonic_time () + 3 * G_USEC_PER_SEC;
+  while (g_get_monotonic_time () < deadline) {
+    size = g_socket_receive (socket, data, sizeof (data), NULL, &error);
+    if (size <= 0) {
+      g_clear_error (&error);
+      eof = TRUE;
+      break;
+    }
+  }
+  g_assert (eof);
+  g_object_unref (connection);
+
+  /* a new client gets the caps and the latest frame at once */
+  connection = g_socket_client_connect_to_host (client, "127.0.0.1", 3001,
+      NULL, &error);
+  g_assert_no_error (error);
+  socket = g_socket_connection_get_socket (connection);
+  g_socket_set_timeout (socket, 1);
+  size = g_socket_receive (socket, data, sizeof (data), NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (size, >, 0);
+  g_object_unref (connection);
+  g_object_unref (client);
+
+  testcase_join (&video_source1);
+
+  if (!opts.test_external_server)
+    close_pid (server_pid);
+
+  g_assert_cmpint (video_source1.error_count, ==, 0);
+}
+
+static void
+test_queue_policy (void)
+{
+  const gint seconds = 15;
+  GPid server_pid = 0;
+  testcase source1 = { "test-queue-policy-source1", 0 };
+  testcase source2 = { "test-queue-policy-source2", 0 };
+  testcase sink0 = { "test-queue-policy-sink0", 0 };
+  GstCaps *caps;
+  gchar *name, *path;
+  gint buffers;
+
+  g_print ("\n");
+
+  if (opts.test_external_server)
+    return;
+
+  source1.live_seconds = seconds;
+  source1.desc = g_string_new ("videotestsrc pattern=0 ");
+  g_string_append_printf (source1.desc, "! video/x-raw,width=%d,height=%d,framerate=30/1 ", W, H);
+  g_string_append_printf (source1.desc, "! gdppay ! tcpclientsink port=3000 ");
+
+  source2.live_seconds = seconds;
+  source2.desc = g_string_new ("videotestsrc pattern=1 ");
+  g_string_append_printf (source2.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (source2.desc, "! gdppay ! tcpclientsink port=3000 ");
+
+  server_pid = launch_server_with ("--preview-shm");
+  g_assert_cmpint (server_pid, !=, 0);
+  sleep (2); /* give a second for server to be online */
+
+  testcase_run_thread (&source1);
+  sleep (1); /* make sure source1 is taking A */
+  testcase_run_thread (&source2);
+  sleep (2); /* give a second for sources to be online */
+
+  /* a local reader of the first preview holding every frame for a second,
+     the shared memory fills up and the queue in front of it has to drop */
+  name = g_strdup_printf ("gst-switch-%d-preview-3003", (gint) server_pid);
+  path = g_build_filename (g_get_tmp_dir (), name, NULL);
+  g_assert (g_file_test (path, G_FILE_TEST_EXISTS));
+  sink0.live_seconds = seconds - 6;
+  sink0.desc = g_string_new ("");
+  g_string_append_printf (sink0.desc, "shmsrc socket-path=%s is-live=true ", path);
+  g_string_append_printf (sink0.desc, "! identity sleep-time=1000000 ");
+  g_string_append_printf (sink0.desc, "! fakesink sync=false ");
+  testcase_run_thread (&sink0);
+  g_free (path);
+  g_free (name);
+  sleep (2); /* let the shared memory fill up */
+
+  /* the stalled reader holds back neither the TCP preview of the same
+     input nor the composite, both keep close to the input rate */
+  caps = probe_port ("tcpclientsrc port=3003 ! gdpdepay "
+      "! fakesink name=sink sync=false", 3, &buffers);
+  assert_video_caps (caps, NULL, W, H, 0);
+  gst_caps_unref (caps);
+  g_assert_cmpint (buffers, >=, 30 * 3 * 2 / 3);
+
+  caps = probe_port ("tcpclientsrc port=3001 ! gdpdepay "
+      "! fakesink name=sink sync=false", 3, &buffers);
+  gst_caps_unref (caps);
+  g_assert_cmpint (buffers, >=, 30 * 3 * 2 / 3);
+
+  testcase_join (&source1);
+  testcase_join (&source2);
+  testcase_join (&sink0);
+
+  close_pid (server_pid);
+
+  g_assert_cmpint (source1.error_count, ==, 0);
+  g_assert_cmpint (source2.error_count, ==, 0);
+  g_assert_cmpint (sink0.error_count, ==, 0);
+}
+
+typedef struct _mode_calls
+{
+  GMainLoop *mainloop;
+  gint pending;
+  gint accepted;
+  gint busy;
+} mode_calls;
+
+static void
+mode_call_done (GObject *source, GAsyncResult *result, gpointer data)
+{
+  mode_calls *calls = (mode_calls *) data;
+  GError *error = NULL;
+  if (gst_switch_client_finish_request (GST_SWITCH_CLIENT (source), result,
+	  &error)) {
+    calls->accepted += 1;
+  } else if (error) {
+    if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_BUSY))
+      calls->busy += 1;
+    g_error_free (error);
+  }
+  if (--calls->pending == 0)
+    g_main_loop_quit (calls->mainloop);
+}
+
+static gboolean
+mode_calls_timeout (gpointer data)
+{
+  g_main_loop_quit (((mode_calls *) data)->mainloop);
+  return FALSE;
+}
+
+static void
+test_composite_mode_async (void)
+{
+  const gint seconds = 12;
+  GPid server_pid = 0;
+  testclient *client;
+  testcase source1 = { "test-composite-mode-async-source1", 0 };
+  testcase source2 = { "test-composite-mode-async-source2", 0 };
+  mode_calls calls = { NULL, 0, 0, 0 };
+  gboolean ok;
+  gint n;
+
+  g_print ("\n");
+
+  source1.live_seconds = seconds;
+  source1.desc = g_string_new ("videotestsrc pattern=0 ");
+  g_string_append_printf (source1.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (source1.desc, "! gdppay ! tcpclientsink port=3000 ");
+
+  source2.live_seconds = seconds;
+  source2.desc = g_string_new ("videotestsrc pattern=1 ");
+  g_string_append_printf (source2.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (source2.desc, "! gdppay ! tcpclientsink port=3000 ");
+
+  if (!opts.test_external_server) {
+    server_pid = launch_server ();
+    g_assert_cmpint (server_pid, !=, 0);
+    sleep (2); /* give a second for server to be online */
+  }
+
+  testcase_run_thread (&source1);
+  sleep (1); /* make sure source1 is taking A */
+  testcase_run_thread (&source2);
+  sleep (1); /* give a second for sources to be online */
+
+  client = TESTCLIENT (g_object_new (TYPE_TESTCLIENT, NULL));
+  ok = gst_switch_client_connect (GST_SWITCH_CLIENT (client));
+  g_assert (ok);
+  calls.mainloop = g_main_loop_new (NULL, TRUE);
+
+  /* only the first of the concurrent calls is sent */
+  for (n = 0; n < 8; ++n) {
+    calls.pending += 1;
+    gst_switch_client_set_composite_mode_async (GST_SWITCH_CLIENT (client),
+	COMPOSE_MODE_1 + (n % 2), mode_call_done, &calls);
+  }
+  g_timeout_add_seconds (5, mode_calls_timeout, &calls);
+  g_main_loop_run (calls.mainloop);
+  g_assert_cmpint (calls.pending, ==, 0);
+  g_assert_cmpint (calls.accepted, ==, 1);
+  g_assert_cmpint (calls.busy, ==, 7);
+
+  /* the next one is sent once the new mode is online */
+  g_timeout_add_seconds (2, mode_calls_timeout, &calls);
+  g_main_loop_run (calls.mainloop);
+  calls.pending += 1;
+  gst_switch_client_set_composite_mode_async (GST_SWITCH_CLIENT (client),
+      COMPOSE_MODE_3, mode_call_done, &calls);
+  g_timeout_add_seconds (5, mode_calls_timeout, &calls);
+  g_main_loop_run (calls.mainloop);
+  g_assert_cmpint (calls.accepted, ==, 2);
+
+  g_main_loop_unref (calls.mainloop);
+  g_object_unref (client);
+
+  testcase_join (&source1);
+  testcase_join (&source2);
+
+  if (!opts.test_external_server)
+    close_pid (server_pid);
+
+  g_assert_cmpint (source1.error_count, ==, 0);
+  g_assert_cmpint (source2.error_count, ==, 0);
+}
+
+typedef struct _stream_ends
+{
+  GstElement *pipeline;
+  GstClockTime video;
+  GstClockTime audio;
+  GstClockTime next_check;
+  GstClockTimeDiff max_offset;
+  guint checks;
+} stream_ends;
+
+static GstClockTime
+buffer_end (GstBuffer *buffer)
+{
+  GstClockTime t = GST_BUFFER_PTS (buffer);
+  if (GST_CLOCK_TIME_IS_VALID (t) && GST_BUFFER_DURATION_IS_VALID (buffer))
+    t += GST_BUFFER_DURATION (buffer);
+  return t;
+}
+
+static GstPadProbeReturn
+track_audio_end (GstPad *pad, GstPadProbeInfo *info, stream_ends *ends)
+{
+  GstClockTime t = buffer_end (GST_PAD_PROBE_INFO_BUFFER (info));
+  if (GST_CLOCK_TIME_IS_VALID (t) &&
+      (!GST_CLOCK_TIME_IS_VALID (ends->audio) || ends->audio < t))
+    ends->audio = t;
+  return GST_PAD_PROBE_OK;
+}
+
+/* once a second of video, see how far the audio demuxed so far is off */
+static GstPadProbeReturn
+track_video_end (GstPad *pad, GstPadProbeInfo *info, stream_ends *ends)
+{
+  GstClockTime t = buffer_end (GST_PAD_PROBE_INFO_BUFFER (info));
+  GstClockTimeDiff offset;
+  if (!GST_CLOCK_TIME_IS_VALID (t))
+    return GST_PAD_PROBE_OK;
+  if (!GST_CLOCK_TIME_IS_VALID (ends->video) || ends->video < t)
+    ends->video = t;
+  if (GST_CLOCK_TIME_IS_VALID (ends->audio) && ends->next_check <= t) {
+    offset = ABS (GST_CLOCK_DIFF (t, ends->audio));
+    if (ends->max_offset < offset)
+      ends->max_offset = offset;
+    ends->next_check = t + GST_SECOND;
+    ends->checks += 1;
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+demux_pad_added (GstElement *demux, GstPad *pad, stream_ends *ends)
+{
+  GstElement *sink = gst_element_factory_make ("fakesink", NULL);
+  GstPad *sink_pad = gst_element_get_static_pad (sink, "sink");
+  gchar *name = gst_pad_get_name (pad);
+  gboolean video = g_str_has_prefix (name, "video");
+
+  g_object_set (sink, "sync", FALSE, NULL);
+  gst_bin_add (GST_BIN (ends->pipeline), sink);
+  gst_element_sync_state_with_parent (sink);
+  g_assert (gst_pad_link (pad, sink_pad) == GST_PAD_LINK_OK);
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, video ?
+      (GstPadProbeCallback) track_video_end :
+      (GstPadProbeCallback) track_audio_end, ends, NULL);
+  gst_object_unref (sink_pad);
+  g_free (name);
+}
+
+static void
+test_av_sync (void)
+{
+  const gint seconds = 20;
+  GPid server_pid = 0;
+  testcase video_source = { "test-av-sync-video-source", 0 };
+  testcase audio_source = { "test-av-sync-audio-source", 0 };
+  stream_ends ends = { NULL, GST_CLOCK_TIME_NONE, GST_CLOCK_TIME_NONE,
+    GST_SECOND, 0, 0 };
+  GstElement *source, *demux;
+  testclient *client;
+  gboolean ok;
+  GstMessage *message;
+  GstBus *bus;
+  GList *names;
+
+  g_print ("\n");
+
+  remove_recordings ();
+
+  video_source.live_seconds = seconds;
+  video_source.desc = g_string_new ("videotestsrc pattern=0 is-live=true ");
+  g_string_append_printf (video_source.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (video_source.desc, "! gdppay ! tcpclientsink name=tcp_sink port=3000 ");
+
+  audio_source.live_seconds = seconds;
+  audio_source.desc = g_string_new ("audiotestsrc freq=110 wave=2 is-live=true ");
+  g_string_append_printf (audio_source.desc, "! gdppay ! tcpclientsink name=tcp_sink port=4000");
+
+  if (!opts.test_external_server) {
+    server_pid = launch_server ();
+    g_assert_cmpint (server_pid, !=, 0);
+    sleep (2); /* give a second for server to be online */
+  }
+
+  testcase_run_thread (&video_source);
+  testcase_run_thread (&audio_source);
+
+  /* a new record ends the first file cleanly */
+  sleep (15);
+  client = TESTCLIENT (g_object_new (TYPE_TESTCLIENT, NULL));
+  ok = gst_switch_client_connect (GST_SWITCH_CLIENT (client));
+  g_assert (ok);
+  ok = gst_switch_client_new_record (GST_SWITCH_CLIENT (client));
+  g_assert (ok);
+  g_object_unref (client);
+
+  testcase_join (&video_source);
+  testcase_join (&audio_source);
+
+  if (!opts.test_external_server)
+    close_pid (server_pid);
+
+  g_assert_cmpint (video_source.error_count, ==, 0);
+  g_assert_cmpint (audio_source.error_count, ==, 0);
+
+  if (opts.test_external_server)
+    return;
+
+  /* the audio recorded keeps up with the video all through the file */
+  names = list_recordings ();
+  g_assert (names);
+  ends.pipeline = gst_pipeline_new (NULL);
+  source = gst_element_factory_make ("filesrc", NULL);
+  demux = gst_element_factory_make ("avidemux", NULL);
+  g_object_set (source, "location", (const gchar *) names->data, NULL);
+  gst_bin_add_many (GST_BIN (ends.pipeline), source, demux, NULL);
+  g_assert (gst_element_link (source, demux));
+  g_signal_connect (demux, "pad-added", G_CALLBACK (demux_pad_added), &ends);
+  gst_element_set_state (ends.pipeline, GST_STATE_PLAYING);
+  bus = gst_element_get_bus (ends.pipeline);
+  message = gst_bus_timed_pop_filtered (bus, 30 * GST_SECOND,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  g_assert (message);
+  g_assert_cmpint (GST_MESSAGE_TYPE (message), ==, GST_MESSAGE_EOS);
+  gst_message_unref (message);
+  gst_object_unref (bus);
+  gst_element_set_state (ends.pipeline, GST_STATE_NULL);
+  gst_object_unref (ends.pipeline);
+  g_list_free_full (names, g_free);
+
+  g_assert (GST_CLOCK_TIME_IS_VALID (ends.video));
+  g_assert (GST_CLOCK_TIME_IS_VALID (ends.audio));
+  g_assert_cmpint (ends.video, >, 10 * GST_SECOND);
+  g_assert_cmpint (ends.checks, >=, 10);
+  g_assert_cmpint (ends.max_offset, <, 100 * GST_MSECOND);
+  g_assert_cmpint (ABS (GST_CLOCK_DIFF (ends.video, ends.audio)), <,
+      100 * GST_MSECOND);
+
+  remove_recordings ();
+}
+
+static void
+keep_scaled_frame (GstElement *sink, GstBuffer *buffer, GstPad *pad,
+    GstBuffer **frame)
+{
+  if (*frame == NULL)
+    *frame = gst_buffer_ref (buffer);
+}
+
+/*
+ * scale_frame:
+ *  @return the first I420 frame of a 640x480 test pattern scaled to 320x180
+ *
+ * Scale a frame with @scaler, in square pixels.
+ */
+static GstBuffer *
+scale_frame (const gchar *scaler)
+{
+  GstElement *pipeline, *sink;
+  GstBuffer *frame = NULL;
+  GstMessage *message;
+  GError *error = NULL;
+  GstBus *bus;
+  gchar *desc;
+
+  desc = g_strdup_printf ("videotestsrc num-buffers=1 pattern=smpte "
+      "! video/x-raw,format=I420,width=640,height=480,pixel-aspect-ratio=1/1 "
+      "! %s ! video/x-raw,width=320,height=180,pixel-aspect-ratio=1/1 "
+      "! fakesink name=sink signal-handoffs=true", scaler);
+  pipeline = gst_parse_launch (desc, &error);
+  g_free (desc);
+  g_assert_no_error (error);
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (keep_scaled_frame), &frame);
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  bus = gst_element_get_bus (pipeline);
+  message = gst_bus_timed_pop_filtered (bus, 5 * GST_SECOND,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  g_assert (message);
+  g_assert_cmpint (GST_MESSAGE_TYPE (message), ==, GST_MESSAGE_EOS);
+  gst_message_unref (message);
+  gst_object_unref (bus);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (sink);
+  gst_object_unref (pipeline);
+  g_assert (frame);
+  return frame;
+}
+
+static void
+test_stripe_scale (void)
+{
+  GstElementFactory *factory;
+  GstBuffer *striped, *reference;
+  GstMapInfo a, b;
+  guint64 diff = 0;
+  gsize n;
+
+  g_print ("\n");
+
+  factory = gst_element_factory_find ("stripescale");
+  if (!factory) {
+    ERROR ("stripescale is not installed");
+    return;
+  }
+  gst_object_unref (factory);
+
+  striped = scale_frame ("stripescale");
+  reference = scale_frame ("videoscale");
+
+  g_assert (gst_buffer_map (striped, &a, GST_MAP_READ));
+  g_assert (gst_buffer_map (reference, &b, GST_MAP_READ));
+  g_assert_cmpint (a.size, ==, 320 * 180 * 3 / 2);
+  g_assert_cmpint (a.size, ==, b.size);
+
+  /* the 4:3 picture is pillarboxed in the 16:9 frame, 40 pixels aside */
+  g_assert_cmpint (a.data[0], ==, 16);
+  g_assert_cmpint (a.data[319], ==, 16);
+  g_assert_cmpint (a.data[90 * 320 + 20], ==, 16);
+  g_assert_cmpint (a.data[90 * 320 + 20], ==, b.data[90 * 320 + 20]);
+  g_assert_cmpint (a.data[90 * 320 + 60], !=, 16);
+
+  /* and looks like the one videoscale made */
+  for (n = 0; n < a.size; ++n)
+    diff += ABS ((gint) a.data[n] - (gint) b.data[n]);
+  g_assert_cmpint (diff / a.size, <, 4);
+
+  gst_buffer_unmap (striped, &a);
+  gst_buffer_unmap (reference, &b);
+  gst_buffer_unref (striped);
+  gst_buffer_unref (reference);
+}
+
+static void
+test_ui_queue (void)
+{
+  enum { inputs = 32 };
+  const gint seconds = 30;
+  GPid server_pid = 0;
+  testclient *fast, *slow, *hung, *control;
+  testcase video_source = { "test-ui-queue-video-source", 0 };
+  testcase audio_source1 = { "test-ui-queue-audio-source1", 0 };
+  testcase audio_source2 = { "test-ui-queue-audio-source2", 0 };
+  testcase *audio_sources;
+  gint levels, n;
+  gboolean ok;
+
+  g_print ("\n");
+
+  if (opts.test_external_server)
+    return;
+
+  video_source.live_seconds = seconds;
+  video_source.desc = g_string_new ("videotestsrc pattern=0 ");
+  g_string_append_printf (video_source.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (video_source.desc, "! gdppay ! tcpclientsink port=3000 ");
+
+  audio_source1.live_seconds = seconds;
+  audio_source1.desc = g_string_new ("audiotestsrc freq=110 wave=2 ");
+  g_string_append_printf (audio_source1.desc, "! gdppay ! tcpclientsink port=4000");
+
+  audio_source2.live_seconds = seconds;
+  audio_source2.desc = g_string_new ("audiotestsrc freq=220 wave=2 ");
+  g_string_append_printf (audio_source2.desc, "! gdppay ! tcpclientsink port=4000");
+
+  server_pid = launch_server_with ("--audio-level-interval=50");
+  g_assert_cmpint (server_pid, !=, 0);
+  sleep (2); /* give a second for server to be online */
+
+  fast = TESTCLIENT (g_object_new (TYPE_TESTCLIENT, NULL));
+  slow = TESTCLIENT (g_object_new (TYPE_TESTCLIENT, NULL));
+  testclient_run_thread (fast);
+  testclient_run_thread (slow);
+  sleep (1);
+
+  testcase_run_thread (&video_source);
+  testcase_run_thread (&audio_source1);
+  testcase_run_thread (&audio_source2);
+  sleep (3);
+
+  control = TESTCLIENT (g_object_new (TYPE_TESTCLIENT, NULL));
+  ok = gst_switch_client_connect (GST_SWITCH_CLIENT (control));
+  g_assert (ok);
+
+  /* the slow UI holds a call for 3 seconds, the audio levels of both
+     inputs keep coming, far more than a UI may fall behind, and are
+     coalesced to the latest of each port */
+  slow->stall_seconds = 3;
+  ok = gst_switch_client_set_composite_mode (GST_SWITCH_CLIENT (control),
+      COMPOSE_MODE_1);
+  g_assert (ok);
+  sleep (2);
+  levels = g_atomic_int_get (&slow->audio_level_count);
+  sleep (4);
+  g_assert (!slow->closed);
+  g_assert_cmpint (slow->new_mode_count, >=, 1);
+  g_assert_cmpint (g_atomic_int_get (&slow->audio_level_count), >, levels);
+
+  /* the hung UI holds a call longer than the controller waits, the new
+     inputs pile up more distinct messages than it may fall behind */
+  hung = TESTCLIENT (g_object_new (TYPE_TESTCLIENT, NULL));
+  hung->stall_seconds = 15;
+  testclient_run_thread (hung);
+  sleep (1);
+  ok = gst_switch_client_set_composite_mode (GST_SWITCH_CLIENT (control),
+      COMPOSE_MODE_2);
+  g_assert (ok);
+  sleep (1);
+
+  audio_sources = g_new0 (testcase, inputs);
+  for (n = 0; n < inputs; ++n) {
+    audio_sources[n].name = g_strdup_printf ("test-ui-queue-audio-%d", n);
+    audio_sources[n].free_name = TRUE;
+    audio_sources[n].live_seconds = 12;
+    audio_sources[n].desc = g_string_new ("");
+    g_string_append_printf (audio_sources[n].desc, "audiotestsrc freq=%d ", 220 + n * 20);
+    g_string_append_printf (audio_sources[n].desc, "! gdppay ! tcpclientsink port=4000");
+    testcase_run_thread (&audio_sources[n]);
+  }
+  for (n = 0; n < inputs; ++n)
+    testcase_join (&audio_sources[n]);
+  g_free (audio_sources);
+
+  /* the hung UI is disconnected, the others got every preview in order */
+  testclient_join (hung);
+  g_assert (hung->closed);
+  g_assert (!fast->closed);
+  g_assert (!slow->closed);
+  g_assert_cmpint (fast->preview_port_count, >=, 3 + inputs);
+  g_assert_cmpint (slow->preview_port_count, ==, fast->preview_port_count);
+  g_assert_cmpint (fast->preview_port_unordered, ==, 0);
+  g_assert_cmpint (slow->preview_port_unordered, ==, 0);
+  g_assert_cmpint (slow->new_mode_count, ==, fast->new_mode_count);
+
+  testclient_end (fast);
+  testclient_end (slow);
+  testclient_join (fast);
+  testclient_join (slow);
+  g_object_unref (control);
+  g_object_unref (hung);
+  g_object_unref (fast);
+  g_object_unref (slow);
+
+  testcase_join (&video_source);
+  testcase_join (&audio_source1);
+  testcase_join (&audio_source2);
+
+  close_pid (server_pid);
+
+  g_assert_cmpint (video_source.error_count, ==, 0);
+  g_assert_cmpint (audio_source1.error_count, ==, 0);
+  g_assert_cmpint (audio_source2.error_count, ==, 0);
+}
+
+/*
+ * record_to:
+ *  @return the microseconds it took until EOS
+ *
+ * Record 50 frames of a moving test pattern into @location through @sink.
+ */
+static gint64
+record_to (const gchar *sink, const gchar *location)
+{
+  GstElement *pipeline;
+  GstMessage *message;
+  GError *error = NULL;
+  GstBus *bus;
+  gint64 start;
+  gchar *desc;
+
+  desc = g_strdup_printf ("videotestsrc num-buffers=50 pattern=ball "
+      "! video/x-raw,format=I420,width=160,height=120 "
+      "! %s location=\"%s\"", sink, location);
+  pipeline = gst_parse_launch (desc, &error);
+  g_free (desc);
+  g_assert_no_error (error);
+  start = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  bus = gst_element_get_bus (pipeline);
+  message = gst_bus_timed_pop_filtered (bus, 30 * GST_SECOND,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  start = g_get_monotonic_time () - start;
+  g_assert (message);
+  g_assert_cmpint (GST_MESSAGE_TYPE (message), ==, GST_MESSAGE_EOS);
+  gst_message_unref (message);
+  gst_object_unref (bus);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  return start;
+}
+
+/*
+ * slow_reader:
+ *
+ * Read a FIFO a block per millisecond, a disk slower than the recording.
+ */
+static gpointer
+slow_reader (const gchar *path)
+{
+  GByteArray *data = g_byte_array_new ();
+  guint8 block[4096];
+  gssize n;
+  gint fd;
+
+  fd = g_open (path, O_RDONLY, 0);
+  g_assert_cmpint (fd, >=, 0);
+  while ((n = read (fd, block, sizeof (block))) != 0) {
+    if (n < 0) {
+      g_assert_cmpint (errno, ==, EINTR);
+      continue;
+    }
+    g_byte_array_append (data, block, n);
+    g_usleep (1000);
+  }
+  close (fd);
+  return data;
+}
+
+static void
+test_record_sink (void)
+{
+  const gchar *reference = "test-record-sink-reference.data";
+  const gchar *recorded = "test-record-sink.data";
+  const gchar *fifo = "test-record-sink.fifo";
+  GstElementFactory *factory;
+  gchar *a = NULL, *b = NULL, *sink;
+  gsize a_size = 0, b_size = 0;
+  GByteArray *data;
+  GThread *reader;
+  gint64 elapsed;
+
+  g_print ("\n");
+
+  factory = gst_element_factory_find ("recordsink");
+  if (!factory) {
+    ERROR ("recordsink is not installed");
+    return;
+  }
+  gst_object_unref (factory);
+
+  record_to ("filesink", reference);
+  g_assert (g_file_get_contents (reference, &a, &a_size, NULL));
+  g_assert_cmpint (a_size, ==, 50 * 160 * 120 * 3 / 2);
+
+  /* a ring of two blocks, every frame wraps around it a few times, the
+     preallocated space is released at the end */
+  sink = g_strdup_printf ("recordsink ring-size=8192 preallocate=%d",
+      1024 * 1024);
+  record_to (sink, recorded);
+  g_assert (g_file_get_contents (recorded, &b, &b_size, NULL));
+  g_assert_cmpint (b_size, ==, a_size);
+  g_assert (memcmp (a, b, a_size) == 0);
+  g_free (b);
+  g_assert (g_unlink (recorded) == 0);
+
+  /* a writer slower than the stream holds back the stream rather than
+     losing data, the pipeline only ends once the reader has most of it */
+  g_unlink (fifo);
+  g_assert (mkfifo (fifo, 0644) == 0);
+  reader = g_thread_new ("slow-reader", (GThreadFunc) slow_reader,
+      (gpointer) fifo);
+  elapsed = record_to ("recordsink ring-size=8192 preallocate=0", fifo);
+  data = g_thread_join (reader);
+  g_assert_cmpint (data->len, ==, a_size);
+  g_assert (memcmp (a, data->data, a_size) == 0);
+  g_assert_cmpint (elapsed, >=, (a_size - 128 * 1024) / 4096 * 1000);
+  g_byte_array_unref (data);
+  g_assert (g_unlink (fifo) == 0);
+
+  g_free (sink);
+  g_free (a);
+  g_assert (g_unlink (reference) == 0);
+}
+
+static GstPadProbeReturn
+keep_last_pts (GstPad *pad, GstPadProbeInfo *info, GstClockTime *pts)
+{
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  if (GST_BUFFER_PTS_IS_VALID (buffer))
+    *pts = GST_BUFFER_PTS (buffer);
+  return GST_PAD_PROBE_OK;
+}
+
+/*
+ * read_pts:
+ *
+ * Read the server ports of @ports at once for @seconds, and keep the
+ * timestamp of the last buffer of each.
+ */
+static void
+read_pts (const gint *ports, GstClockTime *pts, gint count, gint seconds)
+{
+  GstElement *pipeline, *sink;
+  GError *error = NULL;
+  GString *desc;
+  GstPad *pad;
+  gchar *name;
+  gint n;
+
+  desc = g_string_new ("");
+  for (n = 0; n < count; ++n) {
+    g_string_append_printf (desc, "tcpclientsrc port=%d ! gdpdepay "
+        "! fakesink name=sink_%d sync=false ", ports[n], n);
+  }
+  pipeline = gst_parse_launch (desc->str, &error);
+  g_string_free (desc, TRUE);
+  g_assert_no_error (error);
+  for (n = 0; n < count; ++n) {
+    pts[n] = GST_CLOCK_TIME_NONE;
+    name = g_strdup_printf ("sink_%d", n);
+    sink = gst_bin_get_by_name (GST_BIN (pipeline), name);
+    g_free (name);
+    pad = gst_element_get_static_pad (sink, "sink");
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+        (GstPadProbeCallback) keep_last_pts, &pts[n], NULL);
+    gst_object_unref (pad);
+    gst_object_unref (sink);
+  }
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  sleep (seconds);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+static void
+test_alignment (void)
+{
+  const gint seconds = 15;
+  const gint ports[] = { 3001, 3003, 3004 };
+  GPid server_pid = 0;
+  testcase video_source1 = { "test-alignment-source1", 0 };
+  testcase video_source2 = { "test-alignment-source2", 0 };
+  GstClockTime pts[3];
+
+  g_print ("\n");
+
+  if (opts.test_external_server)
+    return;
+
+  video_source1.live_seconds = seconds;
+  video_source1.desc = g_string_new ("videotestsrc pattern=0 ");
+  g_string_append_printf (video_source1.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (video_source1.desc, "! gdppay ! tcpclientsink port=3000 ");
+
+  video_source2.live_seconds = seconds - 4;
+  video_source2.desc = g_string_new ("videotestsrc pattern=1 ");
+  g_string_append_printf (video_source2.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (video_source2.desc, "! gdppay ! tcpclientsink port=3000 ");
+
+  server_pid = launch_server ();
+  g_assert_cmpint (server_pid, !=, 0);
+  sleep (2); /* give a second for server to be online */
+
+  /* the inputs join seconds apart, their pipelines start that late */
+  testcase_run_thread (&video_source1);
+  sleep (4);
+  testcase_run_thread (&video_source2);
+  sleep (3);
+
+  /* the composite and both previews are stamped on one timeline */
+  read_pts (ports, pts, 3, 3);
+  g_assert (GST_CLOCK_TIME_IS_VALID (pts[0]));
+  g_assert (GST_CLOCK_TIME_IS_VALID (pts[1]));
+  g_assert (GST_CLOCK_TIME_IS_VALID (pts[2]));
+  g_assert_cmpint (ABS (GST_CLOCK_DIFF (pts[0], pts[1])), <, 250 * GST_MSECOND);
+  g_assert_cmpint (ABS (GST_CLOCK_DIFF (pts[0], pts[2])), <, 250 * GST_MSECOND);
+  g_assert_cmpint (pts[2], >, 6 * GST_SECOND);
+
+  testcase_join (&video_source1);
+  testcase_join (&video_source2);
+
+  close_pid (server_pid);
+
+  g_assert_cmpint (video_source1.error_count, ==, 0);
+  g_assert_cmpint (video_source2.error_count, ==, 0);
+}
+
+typedef struct _tile_frames
+{
+  GstElement *pipeline;
+  gint on_time;
+} tile_frames;
+
+/* count the frames coming into the mixer no later than its running time */
+static GstPadProbeReturn
+count_tile_frame (GstPad *pad, GstPadProbeInfo *info, tile_frames *frames)
+{
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  const GstSegment *segment;
+  GstClockTime position, now;
+  GstClock *clock;
+  GstEvent *event;
+
+  event = gst_pad_get_sticky_event (pad, GST_EVENT_SEGMENT, 0);
+  clock = gst_element_get_clock (frames->pipeline);
+  if (event && clock && GST_BUFFER_PTS_IS_VALID (buffer)) {
+    gst_event_parse_segment (event, &segment);
+    position = gst_segment_to_running_time (segment, GST_FORMAT_TIME,
+        GST_BUFFER_PTS (buffer));
+    now = gst_clock_get_time (clock) -
+        gst_element_get_base_time (frames->pipeline);
+    if (GST_CLOCK_TIME_IS_VALID (position) &&
+        now < position + 500 * GST_MSECOND)
+      g_atomic_int_inc (&frames->on_time);
+  }
+  if (event)
+    gst_event_unref (event);
+  if (clock)
+    gst_object_unref (clock);
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+probe_tile (GstVideoMosaic *mosaic, gint port, tile_frames *frames)
+{
+  GstElement *pipeline = GST_WORKER (mosaic)->pipeline;
+  GstElement *tile;
+  GstPad *pad, *mix_pad;
+  gchar *name;
+
+  g_assert (pipeline);
+  name = g_strdup_printf ("tile_%d", port);
+  tile = gst_bin_get_by_name (GST_BIN (pipeline), name);
+  g_free (name);
+  g_assert (tile);
+
+  pad = gst_element_get_static_pad (tile, "src");
+  mix_pad = gst_pad_get_peer (pad);
+  g_assert (mix_pad);
+
+  frames->pipeline = pipeline;
+  frames->on_time = 0;
+  gst_pad_add_probe (mix_pad, GST_PAD_PROBE_TYPE_BUFFER,
+      (GstPadProbeCallback) count_tile_frame, frames, NULL);
+
+  gst_object_unref (mix_pad);
+  gst_object_unref (pad);
+  gst_object_unref (tile);
+}
+
+static void
+test_mosaic_join (void)
+{
+  const gint seconds = 15;
+  GPid server_pid = 0;
+  testcase video_source1 = { "test-mosaic-join-source1", 0 };
+  testcase video_source2 = { "test-mosaic-join-source2", 0 };
+  tile_frames frames1, frames2;
+  GstVideoMosaic *mosaic;
+
+  g_print ("\n");
+
+  video_source1.live_seconds = seconds;
+  video_source1.desc = g_string_new ("videotestsrc pattern=0 is-live=true ");
+  g_string_append_printf (video_source1.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (video_source1.desc, "! gdppay ! tcpclientsink port=3000 ");
+
+  video_source2.live_seconds = seconds;
+  video_source2.desc = g_string_new ("videotestsrc pattern=1 is-live=true ");
+  g_string_append_printf (video_source2.desc, "! video/x-raw,width=%d,height=%d ", W, H);
+  g_string_append_printf (video_source2.desc, "! gdppay ! tcpclientsink port=3000 ");
+
+  if (!opts.test_external_server) {
+    server_pid = launch_server ();
+    g_assert_cmpint (server_pid, !=, 0);
+    sleep (2); /* give a second for server to be online */
+  }
+
+  testcase_run_thread (&video_source1);
+  testcase_run_thread (&video_source2);
+  sleep (2); /* give a second for the previews to be online */
+
+  /* the second tile joins the running mosaic seconds after the first */
+  mosaic = GST_VIDEO_MOSAIC (g_object_new (GST_TYPE_VIDEO_MOSAIC,
+          "name", "test-mosaic", "sink", "fakesink sync=true", NULL));
+  gst_video_mosaic_add_port (mosaic, 3003);
+  sleep (3);
+  gst_video_mosaic_add_port (mosaic, 3004);
+  sleep (1);
+
+  probe_tile (mosaic, 3003, &frames1);
+  probe_tile (mosaic, 3004, &frames2);
+  sleep (3);
+
+  /* both tiles keep feeding the mixer in time */
+  g_assert_cmpint (g_atomic_int_get (&frames1.on_time), >, 30);
+  g_assert_cmpint (g_atomic_int_get (&frames2.on_time), >, 30);
+
+  gst_worker_stop_force (GST_WORKER (mosaic), TRUE);
+  g_object_unref (mosaic);
+
+  testcase_join (&video_source1);
+  testcase_join (&video_source2);
+
+  if (!opts.test_external_server)
+    close_pid (server_pid);
+
+  g_assert_cmpint (video_source1.error_count, ==, 0);
+  g_assert_cmpint (video_source2.error_count, ==, 0);
+}
+
+static void
+test_multiple_clients (void)
+{
+  ERROR ("TODO: test for multiple clients");
+}
+
+static void
+kill_children(void)
+{
+    GList *child = NULL;
+    g_mutex_lock (&children_lock);
+    for (child = children; child; child = g_list_next (child)) {
+	GPid pid = (GPid) child->data;
+	//INFO ("kill %d", pid);
+	kill (pid, SIGKILL);
+	children = g_list_remove_link (children, child);
+    }
+    g_mutex_unlock (&children_lock);
+}
+
+int main (int argc, char**argv)
+{
+  {
+    GOptionContext *context;
+    GOptionGroup *group;
+    GError *error = NULL;
+    gboolean ok;
+    group = g_option_group_new ("gst-switch-test", "gst-switch test suite",
+	"",
+	NULL, NULL);
+    context = g_option_context_new ("");
+    g_option_context_add_main_entries (context, option_entries, "test-switch-server");
+    g_option_context_add_group (context, group);
+    ok = g_option_context_parse (context, &argc, &argv, &error);
+    g_option_context_free (context);
+    if (!ok) {
+      g_print ("option parsing failed: %s\n", error->message);
+      return 1;
+    }
+  }
+
+  atexit (&kill_children);
+
+  srand (time (NULL));
+
+  {
+    struct rlimit r;
+    r.rlim_cur = RLIM_INFINITY;
+    r.rlim_max = RLIM_INFINITY;
+    if (setrlimit (RLIMIT_NOFILE, &r) == 0) {
+      infinity_open_file = TRUE;
+    }
+  }
+
+  gst_init (&argc, &argv);
+  g_test_init (&argc, &argv, NULL);
+  if (opts.enable_test_controller) {
+    g_test_add_func ("/gst-switch/controller", test_controller);
+  }
+  if (opts.enable_test_composite_mode) {
+    g_test_add_func ("/gst-switch/composite-mode", test_composite_mode);
+  }
+  if (opts.enable_test_video) {
+    g_test_add_func ("/gst-switch/video", test_video);
+    g_test_add_func ("/gst-switch/video-recording-result", test_video_recording_result);
+  }
+  if (opts.enable_test_audio) {
+    g_test_add_func ("/gst-switch/audio", test_audio);
+    g_test_add_func ("/gst-switch/audio-recording-result", test_audio_recording_result);
+  }
+  if (opts.enable_test_ui) {
+    g_test_add_func ("/gst-switch/ui", test_ui);
+    g_test_add_func ("/gst-switch/recording-result", test_recording_result);
   }
   if (opts.enable_test_switching) {
     g_test_add_func ("/gst-switch/switching", test_switching);
@@ -2316,6 +5002,84 @@ int main (int argc, char**argv)
     g_test_add_func ("/gst-switch/checking-timestamps", test_checking_timestamps);
     g_test_add_func ("/gst-switch/recording-result", test_recording_result);
   }
+  if (opts.enable_test_failover) {
+    g_test_add_func ("/gst-switch/failover", test_failover);
+    g_test_add_func ("/gst-switch/recording-result", test_recording_result);
+  }
+  if (opts.enable_test_audio_mix) {
+    g_test_add_func ("/gst-switch/audio-mix", test_audio_mix);
+    g_test_add_func ("/gst-switch/audio-recording-result", test_audio_recording_result);
+  }
+  if (opts.enable_test_transition) {
+    g_test_add_func ("/gst-switch/transition", test_transition);
+    g_test_add_func ("/gst-switch/recording-result", test_recording_result);
+  }
+  if (opts.enable_test_segments) {
+    g_test_add_func ("/gst-switch/segments", test_segments);
+  }
+  if (opts.enable_test_rotation) {
+    g_test_add_func ("/gst-switch/rotation", test_rotation);
+  }
+  if (opts.enable_test_iso) {
+    g_test_add_func ("/gst-switch/iso", test_iso);
+  }
+  if (opts.enable_test_compressed_input) {
+    g_test_add_func ("/gst-switch/compressed-input", test_compressed_input);
+  }
+  if (opts.enable_test_normalise) {
+    g_test_add_func ("/gst-switch/normalise", test_normalise);
+  }
+  if (opts.enable_test_video_format) {
+    g_test_add_func ("/gst-switch/video-format", test_video_format);
+  }
+  if (opts.enable_test_layout) {
+    g_test_add_func ("/gst-switch/layout", test_layout);
+  }
+  if (opts.enable_test_multibox) {
+    g_test_add_func ("/gst-switch/multibox", test_multibox);
+  }
+  if (opts.enable_test_tcp_control) {
+    g_test_add_func ("/gst-switch/tcp-control", test_tcp_control);
+  }
+  if (opts.enable_test_audio_level) {
+    g_test_add_func ("/gst-switch/audio-level", test_audio_level);
+  }
+  if (opts.enable_test_preview_shm) {
+    g_test_add_func ("/gst-switch/preview-shm", test_preview_shm);
+  }
+  if (opts.enable_test_local_input) {
+    g_test_add_func ("/gst-switch/local-input", test_local_input);
+  }
+  if (opts.enable_test_rtp_output) {
+    g_test_add_func ("/gst-switch/rtp-output", test_rtp_output);
+  }
+  if (opts.enable_test_client_policy) {
+    g_test_add_func ("/gst-switch/client-policy", test_client_policy);
+  }
+  if (opts.enable_test_queue_policy) {
+    g_test_add_func ("/gst-switch/queue-policy", test_queue_policy);
+  }
+  if (opts.enable_test_composite_mode_async) {
+    g_test_add_func ("/gst-switch/composite-mode-async", test_composite_mode_async);
+  }
+  if (opts.enable_test_av_sync) {
+    g_test_add_func ("/gst-switch/av-sync", test_av_sync);
+  }
+  if (opts.enable_test_stripe_scale) {
+    g_test_add_func ("/gst-switch/stripe-scale", test_stripe_scale);
+  }
+  if (opts.enable_test_ui_queue) {
+    g_test_add_func ("/gst-switch/ui-queue", test_ui_queue);
+  }
+  if (opts.enable_test_record_sink) {
+    g_test_add_func ("/gst-switch/record-sink", test_record_sink);
+  }
+  if (opts.enable_test_alignment) {
+    g_test_add_func ("/gst-switch/alignment", test_alignment);
+  }
+  if (opts.enable_test_mosaic_join) {
+    g_test_add_func ("/gst-switch/mosaic-join", test_mosaic_join);
+  }
   if (opts.enable_test_multiple_clients) {
     g_test_add_func ("/gst-switch/multiple-clients", test_multiple_clients);
   }
@@ -0,0 +1,710 @@
+/* GstSwitch
+ * Copyright (C) 2013 Duzy Chan <code@duzy.info>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*! @file */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <gst/controller/gstinterpolationcontrolsource.h>
+#include <gst/controller/gstdirectcontrolbinding.h>
+#include "gstswitchserver.h"
+#include "gstaudiomix.h"
+#include "gstqueuepolicy.h"
+
+#define GST_AUDIO_MIX_CAPS "audio/x-raw,format=S16LE,rate=48000,channels=2,layout=interleaved"
+#define GST_AUDIO_MIX_LEVEL_INTERVAL (50 * GST_MSECOND)
+#define GST_AUDIO_MIX_RAMP_TIME (20 * GST_MSECOND)
+#define GST_AUDIO_MIX_DUCK_RAMP_TIME (200 * GST_MSECOND)
+#define GST_AUDIO_MIX_DUCK_HOLD_TIME (500 * GST_MSECOND)
+#define GST_AUDIO_MIX_DUCK_THRESHOLD -30.0      /* dB */
+#define GST_AUDIO_MIX_DUCK_GAIN 0.25    /* -12 dB */
+
+#define GST_AUDIO_MIX_LOCK(mix) (g_mutex_lock (&(mix)->lock))
+#define GST_AUDIO_MIX_UNLOCK(mix) (g_mutex_unlock (&(mix)->lock))
+#define GST_AUDIO_MIX_LOCK_POSITION(mix) (g_mutex_lock (&(mix)->position_lock))
+#define GST_AUDIO_MIX_UNLOCK_POSITION(mix) (g_mutex_unlock (&(mix)->position_lock))
+
+/**
+ *  GstAudioMixChannel:
+ *  @param mix the owner of the channel
+ *  @param port the input port
+ *  @param gain the linear gain requested for the input
+ *  @param mute TRUE if the input is muted
+ *  @param duck TRUE if the input ducks the other inputs while talking
+ *  @param ducked TRUE if the input is currently ducked by others
+ *  @param active_time the last time the input was louder than the
+ *         ducking threshold
+ *  @param position the stream time of the end of the last gained buffer
+ *  @param bin the input bin in the mixing pipeline
+ *  @param volume the volume element in %bin
+ *  @param mixpad the request pad of the mixer
+ *  @param control the gain control source bound to %volume
+ */
+typedef struct _GstAudioMixChannel
+{
+  GstAudioMix *mix;
+  gint port;
+  gdouble gain;
+  gboolean mute;
+  gboolean duck;
+  gboolean ducked;
+  GstClockTime active_time;
+  GstClockTime position;
+
+  GstElement *bin;
+  GstElement *volume;
+  GstPad *mixpad;
+  GstControlSource *control;
+} GstAudioMixChannel;
+
+/*!< @internal */
+extern gboolean verbose;
+
+#define parent_class gst_audio_mix_parent_class
+
+G_DEFINE_TYPE (GstAudioMix, gst_audio_mix, GST_TYPE_WORKER);
+
+/**
+ * gst_audio_mix_channel_free:
+ *
+ * Free a detached mixing channel.
+ */
+static void
+gst_audio_mix_channel_free (GstAudioMixChannel * channel)
+{
+  g_assert (channel->bin == NULL);
+  g_slice_free (GstAudioMixChannel, channel);
+}
+
+/**
+ * gst_audio_mix_channel_forget:
+ *
+ * Drop the references of a channel to the elements of a pipeline that is
+ * already gone.
+ */
+static void
+gst_audio_mix_channel_forget (GstAudioMixChannel * channel)
+{
+  if (!channel->bin)
+    return;
+
+  gst_object_unref (channel->mixpad);
+  gst_object_unref (channel->volume);
+  gst_object_unref (channel->control);
+  gst_object_unref (channel->bin);
+  channel->mixpad = NULL;
+  channel->volume = NULL;
+  channel->control = NULL;
+  channel->bin = NULL;
+}
+
+/**
+ * gst_audio_mix_init:
+ *
+ * Initialize the GstAudioMix instance.
+ */
+static void
+gst_audio_mix_init (GstAudioMix * mix)
+{
+  g_mutex_init (&mix->lock);
+  g_mutex_init (&mix->position_lock);
+  mix->channels = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+      NULL, (GDestroyNotify) gst_audio_mix_channel_free);
+  mix->ducking = FALSE;
+
+  //INFO ("init %p", mix);
+}
+
+/**
+ * gst_audio_mix_finalize:
+ *
+ * Destroying the GstAudioMix instance.
+ *
+ * @see GObject
+ */
+static void
+gst_audio_mix_finalize (GstAudioMix * mix)
+{
+  GHashTableIter iter;
+  GstAudioMixChannel *channel;
+
+  /* The pipeline and the input bins are gone with the parent. */
+  g_hash_table_iter_init (&iter, mix->channels);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) & channel)) {
+    gst_audio_mix_channel_forget (channel);
+  }
+  g_hash_table_destroy (mix->channels);
+
+  g_mutex_clear (&mix->lock);
+  g_mutex_clear (&mix->position_lock);
+
+  if (G_OBJECT_CLASS (parent_class)->finalize)
+    (*G_OBJECT_CLASS (parent_class)->finalize) (G_OBJECT (mix));
+}
+
+/**
+ * gst_audio_mix_get_pipeline_string:
+ * @return The mixing pipeline string, needs freeing when used
+ *
+ * Fetching the mixing pipeline invoked by the GstWorker. Inputs are not
+ * part of the string, they're attached to the running pipeline as bins
+ * so that no rebuilding is needed when audio sources come and go.
+ */
+static GString *
+gst_audio_mix_get_pipeline_string (GstAudioMix * mix)
+{
+  GString *desc;
+
+  desc = g_string_new ("");
+
+  g_string_append_printf (desc, "adder name=mix ");
+  g_string_append_printf (desc, "! %s ", GST_AUDIO_MIX_CAPS);
+  g_string_append_printf (desc, "! interaudiosink name=sink "
+      "channel=composite_audio ");
+
+  /* Keeps the mixer running while there are no inputs. */
+  g_string_append_printf (desc, "audiotestsrc name=silence "
+      "is-live=true wave=silence ");
+  g_string_append_printf (desc, "! %s ", GST_AUDIO_MIX_CAPS);
+  g_string_append_printf (desc, "! mix. ");
+  return desc;
+}
+
+/**
+ * gst_audio_mix_channel_gain:
+ * @return the effective linear gain of the channel
+ *
+ * Combine the requested gain with the mute and ducking states.
+ */
+static gdouble
+gst_audio_mix_channel_gain (GstAudioMixChannel * channel)
+{
+  if (channel->mute)
+    return 0.0;
+  if (channel->ducked)
+    return channel->gain * GST_AUDIO_MIX_DUCK_GAIN;
+  return channel->gain;
+}
+
+/**
+ * gst_audio_mix_ramp:
+ *
+ * Ramp the channel to its effective gain over @duration, starting right
+ * after the last buffer processed by the volume element. The ramp is
+ * interpolated per sample by the volume element.
+ *
+ * Requires the mix lock.
+ */
+static void
+gst_audio_mix_ramp (GstAudioMix * mix, GstAudioMixChannel * channel,
+    GstClockTime duration)
+{
+  GstTimedValueControlSource *source;
+  gdouble target = gst_audio_mix_channel_gain (channel) /
+      GST_AUDIO_MIX_MAX_GAIN;
+  gdouble current = target;
+  GstClockTime start;
+
+  if (!channel->control)
+    return;
+
+  GST_AUDIO_MIX_LOCK_POSITION (mix);
+  start = channel->position;
+  GST_AUDIO_MIX_UNLOCK_POSITION (mix);
+
+  if (!GST_CLOCK_TIME_IS_VALID (start))
+    start = 0;
+
+  source = GST_TIMED_VALUE_CONTROL_SOURCE (channel->control);
+  gst_control_source_get_value (channel->control, start, &current);
+  gst_timed_value_control_source_unset_all (source);
+  gst_timed_value_control_source_set (source, start, current);
+  gst_timed_value_control_source_set (source, start + duration, target);
+}
+
+/**
+ * gst_audio_mix_position_probe:
+ *
+ * Track the stream time reached by the volume element of a channel, gain
+ * ramps are scheduled from that point.
+ */
+static GstPadProbeReturn
+gst_audio_mix_position_probe (GstPad * pad, GstPadProbeInfo * info,
+    GstAudioMixChannel * channel)
+{
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  GstAudioMix *mix = channel->mix;
+
+  if (GST_BUFFER_PTS_IS_VALID (buffer)) {
+    GST_AUDIO_MIX_LOCK_POSITION (mix);
+    channel->position = GST_BUFFER_PTS (buffer);
+    if (GST_BUFFER_DURATION_IS_VALID (buffer))
+      channel->position += GST_BUFFER_DURATION (buffer);
+    GST_AUDIO_MIX_UNLOCK_POSITION (mix);
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+/**
+ * gst_audio_mix_attach:
+ * @return TRUE if the channel is attached to the mixer.
+ *
+ * Create the input bin of a channel and link it to the mixer.
+ *
+ * Requires the pipeline lock and the mix lock.
+ */
+static gboolean
+gst_audio_mix_attach (GstAudioMix * mix, GstAudioMixChannel * channel)
+{
+  GstWorker *worker = GST_WORKER (mix);
+  GstElement *mixer = NULL;
+  GstPad *srcpad = NULL, *pad = NULL;
+  GError *error = NULL;
+  gchar *name, *desc, *queue;
+
+  queue = gst_queue_policy_get_string (GST_QUEUE_ROLE_AUDIO, NULL);
+  desc = g_strdup_printf ("interaudiosrc channel=input_%d "
+      "! audioconvert ! audioresample ! %s "
+      "! level name=level_%d message=true interval=%" G_GUINT64_FORMAT " "
+      "! volume name=volume_%d ! %s", channel->port,
+      GST_AUDIO_MIX_CAPS, channel->port, GST_AUDIO_MIX_LEVEL_INTERVAL,
+      channel->port, queue);
+  g_free (queue);
+  if (verbose) {
+    g_print ("%s: %s\n", worker->name, desc);
+  }
+  channel->bin = gst_parse_bin_from_description (desc, TRUE, &error);
+  g_free (desc);
+  if (error)
+    goto error_parse;
+
+  name = g_strdup_printf ("channel_%d", channel->port);
+  gst_element_set_name (channel->bin, name);
+  g_free (name);
+
+  gst_queue_policy_watch (channel->bin);
+  gst_worker_align_sources (channel->bin);
+
+  gst_object_ref (channel->bin);
+  gst_bin_add (GST_BIN (worker->pipeline), channel->bin);
+
+  mixer = gst_worker_get_element_unlocked (worker, "mix");
+  channel->mixpad = gst_element_get_request_pad (mixer, "sink_%u");
+  gst_object_unref (mixer);
+
+  if (!channel->mixpad)
+    goto error_link;
+
+  srcpad = gst_element_get_static_pad (channel->bin, "src");
+  if (gst_pad_link (srcpad, channel->mixpad) != GST_PAD_LINK_OK) {
+    gst_object_unref (srcpad);
+    goto error_link;
+  }
+  gst_object_unref (srcpad);
+
+  name = g_strdup_printf ("volume_%d", channel->port);
+  channel->volume = gst_bin_get_by_name (GST_BIN (channel->bin), name);
+  g_free (name);
+
+  channel->control = gst_interpolation_control_source_new ();
+  g_object_set (channel->control, "mode", GST_INTERPOLATION_MODE_LINEAR, NULL);
+  gst_object_add_control_binding (GST_OBJECT (channel->volume),
+      gst_direct_control_binding_new (GST_OBJECT (channel->volume),
+          "volume", channel->control));
+
+  GST_AUDIO_MIX_LOCK_POSITION (mix);
+  channel->position = GST_CLOCK_TIME_NONE;
+  GST_AUDIO_MIX_UNLOCK_POSITION (mix);
+
+  pad = gst_element_get_static_pad (channel->volume, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+      (GstPadProbeCallback) gst_audio_mix_position_probe, channel, NULL);
+  gst_object_unref (pad);
+
+  gst_audio_mix_ramp (mix, channel, 0);
+
+  gst_element_sync_state_with_parent (channel->bin);
+
+  INFO ("mixing audio input %d", channel->port);
+  return TRUE;
+
+  /* Errors Handling */
+error_parse:
+  {
+    ERROR ("%s: invalid input %d: %s", worker->name, channel->port,
+        error->message);
+    g_error_free (error);
+    if (channel->bin) {
+      gst_object_unref (channel->bin);
+      channel->bin = NULL;
+    }
+    return FALSE;
+  }
+
+error_link:
+  {
+    ERROR ("%s: can't link input %d", worker->name, channel->port);
+    if (channel->mixpad) {
+      mixer = gst_worker_get_element_unlocked (worker, "mix");
+      gst_element_release_request_pad (mixer, channel->mixpad);
+      gst_object_unref (mixer);
+      gst_object_unref (channel->mixpad);
+      channel->mixpad = NULL;
+    }
+    gst_bin_remove (GST_BIN (worker->pipeline), channel->bin);
+    gst_object_unref (channel->bin);
+    channel->bin = NULL;
+    return FALSE;
+  }
+}
+
+/**
+ * gst_audio_mix_detach:
+ *
+ * Unlink the input bin of a channel from the mixer and drop it. The bin is
+ * stopped first so that no data is pushed into an unlinked pad.
+ *
+ * Requires the pipeline lock and the mix lock.
+ */
+static void
+gst_audio_mix_detach (GstAudioMix * mix, GstAudioMixChannel * channel)
+{
+  GstWorker *worker = GST_WORKER (mix);
+  GstElement *mixer;
+  GstPad *srcpad;
+
+  if (!channel->bin)
+    return;
+
+  gst_element_set_state (channel->bin, GST_STATE_NULL);
+
+  srcpad = gst_element_get_static_pad (channel->bin, "src");
+  gst_pad_unlink (srcpad, channel->mixpad);
+  gst_object_unref (srcpad);
+
+  mixer = gst_worker_get_element_unlocked (worker, "mix");
+  if (mixer) {
+    gst_element_release_request_pad (mixer, channel->mixpad);
+    gst_object_unref (mixer);
+  }
+
+  if (worker->pipeline)
+    gst_bin_remove (GST_BIN (worker->pipeline), channel->bin);
+
+  gst_audio_mix_channel_forget (channel);
+
+  INFO ("stopped mixing audio input %d", channel->port);
+}
+
+/**
+ * gst_audio_mix_prepare:
+ * @return TRUE if the mixing pipeline is prepared.
+ *
+ * Invoked when the GstWorker is preparing the pipeline. A new pipeline
+ * has no input bins yet, so all known channels are attached again.
+ */
+static gboolean
+gst_audio_mix_prepare (GstAudioMix * mix)
+{
+  GHashTableIter iter;
+  GstAudioMixChannel *channel;
+
+  g_return_val_if_fail (GST_IS_AUDIO_MIX (mix), FALSE);
+
+  GST_AUDIO_MIX_LOCK (mix);
+  g_hash_table_iter_init (&iter, mix->channels);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) & channel)) {
+    /* The old pipeline owned the bin. */
+    gst_audio_mix_channel_forget (channel);
+    gst_audio_mix_attach (mix, channel);
+  }
+  GST_AUDIO_MIX_UNLOCK (mix);
+  return TRUE;
+}
+
+/**
+ * gst_audio_mix_peak:
+ * @return the highest peak (in dB) of all audio channels of a level message
+ */
+static gdouble
+gst_audio_mix_peak (const GstStructure * s)
+{
+  const GValue *list = gst_structure_get_value (s, "peak");
+  gdouble peak = -G_MAXDOUBLE;
+  gint i, n;
+
+  if (list == NULL)
+    return peak;
+
+  if (GST_VALUE_HOLDS_LIST (list)) {
+    n = gst_value_list_get_size (list);
+    for (i = 0; i < n; ++i)
+      peak = MAX (peak, g_value_get_double (gst_value_list_get_value (list,
+                  i)));
+  } else if (G_VALUE_HOLDS (list, G_TYPE_VALUE_ARRAY)) {
+    GValueArray *va = (GValueArray *) g_value_get_boxed (list);
+    for (i = 0; i < va->n_values; ++i)
+      peak = MAX (peak, g_value_get_double (va->values + i));
+  }
+  return peak;
+}
+
+/**
+ * gst_audio_mix_update_level:
+ *
+ * Record the level of an input and duck or restore the other inputs when
+ * a ducking input starts or stops talking.
+ */
+static void
+gst_audio_mix_update_level (GstAudioMix * mix, gint port, gdouble peak)
+{
+  GstClockTime now = gst_util_get_timestamp ();
+  GstAudioMixChannel *channel;
+  GHashTableIter iter;
+  gboolean ducking = FALSE;
+
+  GST_AUDIO_MIX_LOCK (mix);
+  channel = g_hash_table_lookup (mix->channels, GINT_TO_POINTER (port));
+  if (channel && GST_AUDIO_MIX_DUCK_THRESHOLD < peak)
+    channel->active_time = now;
+
+  g_hash_table_iter_init (&iter, mix->channels);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) & channel)) {
+    if (channel->duck && !channel->mute &&
+        GST_CLOCK_TIME_IS_VALID (channel->active_time) &&
+        now - channel->active_time < GST_AUDIO_MIX_DUCK_HOLD_TIME) {
+      ducking = TRUE;
+      break;
+    }
+  }
+
+  if (ducking != mix->ducking) {
+    mix->ducking = ducking;
+    g_hash_table_iter_init (&iter, mix->channels);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) & channel)) {
+      if (!channel->duck) {
+        channel->ducked = ducking;
+        gst_audio_mix_ramp (mix, channel, GST_AUDIO_MIX_DUCK_RAMP_TIME);
+      }
+    }
+  }
+  GST_AUDIO_MIX_UNLOCK (mix);
+}
+
+/**
+ * gst_audio_mix_message:
+ *
+ * Handling level messages of the mixing inputs.
+ */
+static gboolean
+gst_audio_mix_message (GstAudioMix * mix, GstMessage * message)
+{
+  if (message->type == GST_MESSAGE_ELEMENT) {
+    const GstStructure *s = gst_message_get_structure (message);
+    gint port = 0;
+    if (gst_structure_has_name (s, "level") &&
+        sscanf (GST_OBJECT_NAME (message->src), "level_%d", &port) == 1) {
+      gst_audio_mix_update_level (mix, port, gst_audio_mix_peak (s));
+    }
+  }
+  return TRUE;
+}
+
+/**
+ * gst_audio_mix_add_input:
+ *  @param mix the GstAudioMix instance
+ *  @param port the audio input port
+ *  @return TRUE if the input is added to the mix.
+ *
+ *  Start mixing the audio input of @port at unity gain.
+ */
+gboolean
+gst_audio_mix_add_input (GstAudioMix * mix, gint port)
+{
+  GstWorker *worker = GST_WORKER (mix);
+  GstAudioMixChannel *channel;
+  gboolean result = TRUE;
+
+  g_return_val_if_fail (GST_IS_AUDIO_MIX (mix), FALSE);
+
+  g_mutex_lock (&worker->pipeline_lock);
+  GST_AUDIO_MIX_LOCK (mix);
+  if (g_hash_table_lookup (mix->channels, GINT_TO_POINTER (port))) {
+    WARN ("audio input %d is already mixed", port);
+    result = FALSE;
+    goto end;
+  }
+
+  channel = g_slice_new0 (GstAudioMixChannel);
+  channel->mix = mix;
+  channel->port = port;
+  channel->gain = 1.0;
+  channel->ducked = mix->ducking;
+  channel->active_time = GST_CLOCK_TIME_NONE;
+  channel->position = GST_CLOCK_TIME_NONE;
+  g_hash_table_insert (mix->channels, GINT_TO_POINTER (port), channel);
+
+  if (worker->pipeline)
+    result = gst_audio_mix_attach (mix, channel);
+
+end:
+  GST_AUDIO_MIX_UNLOCK (mix);
+  g_mutex_unlock (&worker->pipeline_lock);
+  return result;
+}
+
+/**
+ * gst_audio_mix_remove_input:
+ *  @param mix the GstAudioMix instance
+ *  @param port the audio input port
+ *
+ *  Stop mixing the audio input of @port.
+ */
+void
+gst_audio_mix_remove_input (GstAudioMix * mix, gint port)
+{
+  GstWorker *worker = GST_WORKER (mix);
+  GstAudioMixChannel *channel;
+
+  g_return_if_fail (GST_IS_AUDIO_MIX (mix));
+
+  g_mutex_lock (&worker->pipeline_lock);
+  GST_AUDIO_MIX_LOCK (mix);
+  channel = g_hash_table_lookup (mix->channels, GINT_TO_POINTER (port));
+  if (channel) {
+    gst_audio_mix_detach (mix, channel);
+    g_hash_table_remove (mix->channels, GINT_TO_POINTER (port));
+  }
+  GST_AUDIO_MIX_UNLOCK (mix);
+  g_mutex_unlock (&worker->pipeline_lock);
+}
+
+/**
+ * gst_audio_mix_set_gain:
+ *  @param mix the GstAudioMix instance
+ *  @param port the audio input port
+ *  @param gain the linear gain, 0.0 to GST_AUDIO_MIX_MAX_GAIN
+ *  @return TRUE if the input is found.
+ *
+ *  Ramp the audio input of @port to a new gain.
+ */
+gboolean
+gst_audio_mix_set_gain (GstAudioMix * mix, gint port, gdouble gain)
+{
+  GstAudioMixChannel *channel;
+  gboolean result = FALSE;
+
+  g_return_val_if_fail (GST_IS_AUDIO_MIX (mix), FALSE);
+
+  GST_AUDIO_MIX_LOCK (mix);
+  channel = g_hash_table_lookup (mix->channels, GINT_TO_POINTER (port));
+  if (channel) {
+    channel->gain = CLAMP (gain, 0.0, GST_AUDIO_MIX_MAX_GAIN);
+    gst_audio_mix_ramp (mix, channel, GST_AUDIO_MIX_RAMP_TIME);
+    result = TRUE;
+  }
+  GST_AUDIO_MIX_UNLOCK (mix);
+  return result;
+}
+
+/**
+ * gst_audio_mix_set_mute:
+ *  @param mix the GstAudioMix instance
+ *  @param port the audio input port
+ *  @param mute TRUE to mute the input
+ *  @return TRUE if the input is found.
+ *
+ *  Mute or unmute the audio input of @port.
+ */
+gboolean
+gst_audio_mix_set_mute (GstAudioMix * mix, gint port, gboolean mute)
+{
+  GstAudioMixChannel *channel;
+  gboolean result = FALSE;
+
+  g_return_val_if_fail (GST_IS_AUDIO_MIX (mix), FALSE);
+
+  GST_AUDIO_MIX_LOCK (mix);
+  channel = g_hash_table_lookup (mix->channels, GINT_TO_POINTER (port));
+  if (channel) {
+    channel->mute = mute;
+    gst_audio_mix_ramp (mix, channel, GST_AUDIO_MIX_RAMP_TIME);
+    result = TRUE;
+  }
+  GST_AUDIO_MIX_UNLOCK (mix);
+  return result;
+}
+
+/**
+ * gst_audio_mix_set_duck:
+ *  @param mix the GstAudioMix instance
+ *  @param port the audio input port
+ *  @param duck TRUE to make the input duck the others
+ *  @return TRUE if the input is found.
+ *
+ *  Make the audio input of @port a ducking input. The other inputs are
+ *  attenuated while a ducking input is above the ducking threshold.
+ */
+gboolean
+gst_audio_mix_set_duck (GstAudioMix * mix, gint port, gboolean duck)
+{
+  GstAudioMixChannel *channel;
+  gboolean result = FALSE;
+
+  g_return_val_if_fail (GST_IS_AUDIO_MIX (mix), FALSE);
+
+  GST_AUDIO_MIX_LOCK (mix);
+  channel = g_hash_table_lookup (mix->channels, GINT_TO_POINTER (port));
+  if (channel) {
+    channel->duck = duck;
+    channel->ducked = duck ? FALSE : mix->ducking;
+    gst_audio_mix_ramp (mix, channel, GST_AUDIO_MIX_DUCK_RAMP_TIME);
+    result = TRUE;
+  }
+  GST_AUDIO_MIX_UNLOCK (mix);
+  return result;
+}
+
+/**
+ * gst_audio_mix_class_init:
+ *
+ * Initialize the GstAudioMixClass.
+ */
+static void
+gst_audio_mix_class_init (GstAudioMixClass * klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GstWorkerClass *worker_class = GST_WORKER_CLASS (klass);
+
+  object_class->finalize = (GObjectFinalizeFunc) gst_audio_mix_finalize;
+
+  worker_class->prepare = (GstWorkerPrepareFunc) gst_audio_mix_prepare;
+  worker_class->message = (GstWorkerMessageFunc) gst_audio_mix_message;
+  worker_class->get_pipeline_string = (GstWorkerGetPipelineStringFunc)
+      gst_audio_mix_get_pipeline_string;
+}
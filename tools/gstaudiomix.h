@@ -0,0 +1,80 @@
+/* GstSwitch
+ * Copyright (C) 2013 Duzy Chan <code@duzy.info>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*! @file */
+
+#ifndef __GST_AUDIO_MIX_H__by_Duzy_Chan__
+#define __GST_AUDIO_MIX_H__by_Duzy_Chan__ 1
+#include "gstworker.h"
+
+#define GST_TYPE_AUDIO_MIX (gst_audio_mix_get_type ())
+#define GST_AUDIO_MIX(object) (G_TYPE_CHECK_INSTANCE_CAST ((object), GST_TYPE_AUDIO_MIX, GstAudioMix))
+#define GST_AUDIO_MIX_CLASS(class) (G_TYPE_CHECK_CLASS_CAST ((class), GST_TYPE_AUDIO_MIX, GstAudioMixClass))
+#define GST_IS_AUDIO_MIX(object) (G_TYPE_CHECK_INSTANCE_TYPE ((object), GST_TYPE_AUDIO_MIX))
+#define GST_IS_AUDIO_MIX_CLASS(class) (G_TYPE_CHECK_CLASS_TYPE ((class), GST_TYPE_AUDIO_MIX))
+
+#define GST_AUDIO_MIX_MAX_GAIN 10.0     /* the upper limit of "volume" */
+
+typedef struct _GstAudioMix GstAudioMix;
+typedef struct _GstAudioMixClass GstAudioMixClass;
+
+/**
+ *  GstAudioMix:
+ *  @param base the parent object
+ *  @param lock the lock for %channels
+ *  @param position_lock the lock for the channel stream positions
+ *  @param channels the mixed input channels, keyed by the input port
+ *  @param ducking TRUE if a ducking channel is currently talking over the
+ *         others
+ */
+struct _GstAudioMix
+{
+  GstWorker base;
+
+  GMutex lock;
+  GMutex position_lock;
+  GHashTable *channels;
+  gboolean ducking;
+};
+
+/**
+ *  GstAudioMixClass:
+ *  @param base_class the parent class
+ */
+struct _GstAudioMixClass
+{
+  GstWorkerClass base_class;
+};
+
+GType gst_audio_mix_get_type (void);
+gboolean gst_audio_mix_add_input (GstAudioMix * mix, gint port);
+void gst_audio_mix_remove_input (GstAudioMix * mix, gint port);
+gboolean gst_audio_mix_set_gain (GstAudioMix * mix, gint port, gdouble gain);
+gboolean gst_audio_mix_set_mute (GstAudioMix * mix, gint port,
+    gboolean mute);
+gboolean gst_audio_mix_set_duck (GstAudioMix * mix, gint port,
+    gboolean duck);
+
+#endif //__GST_AUDIO_MIX_H__by_Duzy_Chan__
@@ -30,9 +30,14 @@
 #endif
 
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 #include "gstswitchserver.h"
 #include "gstcase.h"
+#include "gstclientpolicy.h"
+#include "gstqueuepolicy.h"
 
 enum
 {
@@ -40,6 +45,7 @@ enum
   PROP_TYPE,
   PROP_SERVE,
   PROP_STREAM,
+  PROP_SHM_PATH,
   PROP_INPUT,
   PROP_BRANCH,
   PROP_PORT,
@@ -49,6 +55,7 @@ enum
   PROP_A_HEIGHT,
   PROP_B_WIDTH,
   PROP_B_HEIGHT,
+  PROP_FRAMERATE,
 };
 
 enum
@@ -59,6 +66,18 @@ enum
 //static guint gst_case_signals[SIGNAL__LAST] = { 0 };
 extern gboolean verbose;
 
+#define GST_CASE_ISO_ENCODER_THREADS 2
+#define GST_CASE_DECODER_THREADS 2
+#define GST_CASE_ISO_EOS_TIMEOUT 2      /* seconds */
+
+/* encoder threads taken by the ISO recordings of all inputs */
+static GMutex gst_case_iso_lock;
+static gint gst_case_iso_threads = 0;
+
+/* decoder threads taken by all compressed inputs */
+static GMutex gst_case_decode_lock;
+static gint gst_case_decode_threads = 0;
+
 #define gst_case_parent_class parent_class
 G_DEFINE_TYPE (GstCase, gst_case, GST_TYPE_WORKER);
 
@@ -74,6 +93,7 @@ gst_case_init (GstCase * cas)
 {
   cas->type = GST_CASE_UNKNOWN;
   cas->stream = NULL;
+  cas->shm_path = NULL;
   cas->input = NULL;
   cas->branch = NULL;
   cas->serve_type = GST_SERVE_NOTHING;
@@ -84,10 +104,27 @@ gst_case_init (GstCase * cas)
   cas->a_height = 0;
   cas->b_width = 0;
   cas->b_height = 0;
+  cas->framerate = GST_SWITCH_COMPOSITE_DEFAULT_FRAMERATE;
+
+  g_mutex_init (&cas->health_lock);
+  cas->health_time = GST_CLOCK_TIME_NONE;
+  cas->health_interval = 0;
+  cas->health_jitter = 0;
+  cas->error_time = GST_CLOCK_TIME_NONE;
+  cas->level_rms = cas->level_peak = cas->level_decay = -G_MAXDOUBLE;
+  cas->level_fresh = FALSE;
+
+  cas->iso_threads = 0;
+  cas->decode_threads = 0;
+  g_mutex_init (&cas->iso_lock);
+  g_cond_init (&cas->iso_cond);
+  cas->iso_ended = FALSE;
 
   //INFO ("init %p", cas);
 }
 
+static void gst_case_end_iso (GstCase * cas);
+
 /**
  * gst_case_dispose:
  *
@@ -98,6 +135,8 @@ gst_case_init (GstCase * cas)
 static void
 gst_case_dispose (GstCase * cas)
 {
+  gst_case_end_iso (cas);
+
   if (cas->stream) {
 #if 0
     GError *error = NULL;
@@ -123,6 +162,9 @@ gst_case_dispose (GstCase * cas)
   G_OBJECT_CLASS (parent_class)->dispose (G_OBJECT (cas));
 }
 
+static void gst_case_release_iso_threads (GstCase * cas);
+static void gst_case_release_decode_threads (GstCase * cas);
+
 /**
  * gst_case_finalize:
  *
@@ -133,6 +175,15 @@ gst_case_dispose (GstCase * cas)
 static void
 gst_case_finalize (GstCase * cas)
 {
+  gst_case_release_iso_threads (cas);
+  gst_case_release_decode_threads (cas);
+
+  g_free (cas->shm_path);
+
+  g_mutex_clear (&cas->health_lock);
+  g_mutex_clear (&cas->iso_lock);
+  g_cond_clear (&cas->iso_cond);
+
   if (G_OBJECT_CLASS (parent_class)->finalize)
     (*G_OBJECT_CLASS (parent_class)->finalize) (G_OBJECT (cas));
 }
@@ -158,6 +209,9 @@ gst_case_get_property (GstCase * cas, guint property_id,
     case PROP_STREAM:
       g_value_set_object (value, cas->stream);
       break;
+    case PROP_SHM_PATH:
+      g_value_set_string (value, cas->shm_path);
+      break;
     case PROP_INPUT:
       g_value_set_object (value, cas->input);
       break;
@@ -185,6 +239,9 @@ gst_case_get_property (GstCase * cas, guint property_id,
     case PROP_B_HEIGHT:
       g_value_set_uint (value, cas->b_height);
       break;
+    case PROP_FRAMERATE:
+      g_value_set_uint (value, cas->framerate);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (cas, property_id, pspec);
       break;
@@ -217,6 +274,10 @@ gst_case_set_property (GstCase * cas, guint property_id,
       cas->stream = G_INPUT_STREAM (stream);
     }
       break;
+    case PROP_SHM_PATH:
+      g_free (cas->shm_path);
+      cas->shm_path = g_value_dup_string (value);
+      break;
     case PROP_INPUT:
     {
       GObject *input = g_value_dup_object (value);
@@ -254,12 +315,50 @@ gst_case_set_property (GstCase * cas, guint property_id,
     case PROP_B_HEIGHT:
       cas->b_height = g_value_get_uint (value);
       break;
+    case PROP_FRAMERATE:
+      cas->framerate = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (G_OBJECT (cas), property_id, pspec);
       break;
   }
 }
 
+/**
+ * gst_case_records_iso:
+ * @return TRUE if the input of the case is recorded into its own file
+ */
+static gboolean
+gst_case_records_iso (GstCase * cas)
+{
+  return opts.record_iso && opts.record_filename != NULL;
+}
+
+/**
+ * gst_case_get_shm_path:
+ * @return the socket of the shared memory preview of the case, NULL if the
+ *         case has none
+ *
+ * Video branch cases expose their frames to local UIs as well when the
+ * server runs with --preview-shm.
+ */
+static gchar *
+gst_case_get_shm_path (GstCase * cas)
+{
+  gchar *name, *path;
+
+  if (!opts.preview_shm || cas->serve_type != GST_SERVE_VIDEO_STREAM)
+    return NULL;
+  if (!GST_CASE_IS_BRANCH_VIDEO (cas->type) && cas->type != GST_CASE_BRANCH_p)
+    return NULL;
+
+  name = g_strdup_printf ("gst-switch-%d-preview-%d", (gint) getpid (),
+      cas->sink_port);
+  path = g_build_filename (g_get_tmp_dir (), name, NULL);
+  g_free (name);
+  return path;
+}
+
 /**
  * gst_case_get_pipeline_string:
  * @return A GString instance representing the pipeline string.
@@ -275,22 +374,47 @@ gst_case_get_pipeline_string (GstCase * cas)
   gchar *scale = NULL;
   gchar *srctype = NULL;
   gchar *sink = NULL;
+  gchar *shm = NULL;
+  gchar *policy = NULL;
+  gchar *queue = NULL;
+  gchar name[2] = { 0 };
+  gboolean audio = cas->serve_type == GST_SERVE_AUDIO_STREAM;
 
   desc = g_string_new ("");
 
   switch (cas->type) {
     case GST_CASE_INPUT_a:
     case GST_CASE_INPUT_v:
-      g_string_append_printf (desc, "giostreamsrc name=source ");
+      if (cas->shm_path) {
+        /* a local producer writes the same stream into shared memory */
+        g_string_append_printf (desc, "shmsrc name=source socket-path=%s "
+            "is-live=true ", cas->shm_path);
+      } else {
+        g_string_append_printf (desc, "giostreamsrc name=source ");
+      }
       break;
     case GST_CASE_COMPOSITE_A:
     case GST_CASE_COMPOSITE_B:
+    case GST_CASE_COMPOSITE_C:
+    case GST_CASE_COMPOSITE_D:
+    case GST_CASE_COMPOSITE_E:
+    case GST_CASE_COMPOSITE_F:
+    case GST_CASE_COMPOSITE_G:
+    case GST_CASE_COMPOSITE_H:
+    case GST_CASE_COMPOSITE_I:
     case GST_CASE_COMPOSITE_a:
     case GST_CASE_PREVIEW:
       if (srctype == NULL)
         srctype = "input";
     case GST_CASE_BRANCH_A:
     case GST_CASE_BRANCH_B:
+    case GST_CASE_BRANCH_C:
+    case GST_CASE_BRANCH_D:
+    case GST_CASE_BRANCH_E:
+    case GST_CASE_BRANCH_F:
+    case GST_CASE_BRANCH_G:
+    case GST_CASE_BRANCH_H:
+    case GST_CASE_BRANCH_I:
     case GST_CASE_BRANCH_a:
     case GST_CASE_BRANCH_p:
       if (srctype == NULL)
@@ -312,22 +436,28 @@ gst_case_get_pipeline_string (GstCase * cas)
 
   switch (cas->type) {
     case GST_CASE_COMPOSITE_A:
-      if (channel == NULL)
-        channel = "a";
       if (scale == NULL)
         scale =
             g_strdup_printf ("videoscale ! video/x-raw,width=%d,height=%d",
             cas->a_width, cas->a_height);
     case GST_CASE_COMPOSITE_B:
-      if (channel == NULL)
-        channel = "b";
+    case GST_CASE_COMPOSITE_C:
+    case GST_CASE_COMPOSITE_D:
+    case GST_CASE_COMPOSITE_E:
+    case GST_CASE_COMPOSITE_F:
+    case GST_CASE_COMPOSITE_G:
+    case GST_CASE_COMPOSITE_H:
+    case GST_CASE_COMPOSITE_I:
+      if (channel == NULL) {
+        name[0] = g_ascii_tolower (gst_case_get_channel (cas->type));
+        channel = name;
+      }
       if (scale == NULL)
         scale =
             g_strdup_printf ("videoscale ! video/x-raw,width=%d,height=%d",
             cas->b_width, cas->b_height);
-      caps =
-          g_strdup_printf ("video/x-raw,width=%d,height=%d", cas->width,
-          cas->height);
+      /* the input is normalised, any size is passed on to the scaler */
+      caps = g_strdup ("video/x-raw");
       sink = "intervideosink";
     case GST_CASE_COMPOSITE_a:
       if (channel == NULL)
@@ -341,13 +471,19 @@ gst_case_get_pipeline_string (GstCase * cas)
       if (caps)
         g_string_append_printf (desc, "! %s ", caps);
       g_string_append_printf (desc, "! tee name=s ");
-      g_string_append_printf (desc, "s. ! queue2 ");
+      queue = gst_queue_policy_get_string (audio ? GST_QUEUE_ROLE_AUDIO :
+          GST_QUEUE_ROLE_PREVIEW, NULL);
+      g_string_append_printf (desc, "s. ! %s", queue);
+      g_free (queue);
       /*
          ASSESS ("assess-composite-%s-branch-%d", channel, cas->sink_port);
        */
       g_string_append_printf (desc, "! %s name=sink1 channel=branch_%d ",
           sink, cas->sink_port);
-      g_string_append_printf (desc, "s. ! queue2 ");
+      queue = gst_queue_policy_get_string (audio ? GST_QUEUE_ROLE_AUDIO :
+          GST_QUEUE_ROLE_COMPOSITE, NULL);
+      g_string_append_printf (desc, "s. ! %s", queue);
+      g_free (queue);
       if (scale) {
         /*
            g_string_append_printf (desc, "! %s", scale);
@@ -384,40 +520,85 @@ gst_case_get_pipeline_string (GstCase * cas)
            else 
            ASSESS ("assess-audio-input-%d", cas->sink_port);
          */
-        //g_string_append_printf (desc, "! gdpdepay ");
+        if (cas->type != GST_CASE_PREVIEW) {
+          /* the ISO recording needs the raw audio caps */
+          g_string_append_printf (desc, "! gdpdepay ");
+          if (gst_case_records_iso (cas))
+            g_string_append_printf (desc, "! tee name=iso_tee ");
+        }
         g_string_append_printf (desc, "! sink. ");
       } else if (cas->type == GST_CASE_PREVIEW) {
-        g_string_append_printf (desc, "source. " "! video/x-raw,width=%d,height=%d ", cas->width, cas->height); //cas->a_width, cas->a_height);
+        g_string_append_printf (desc, "source. ! video/x-raw ");
         /*
            ASSESS ("assess-video-preview-%d", cas->sink_port);
          */
         g_string_append_printf (desc, "! sink. ");
       } else {
+        /* the decoder is plugged in once the input is typefound */
         g_string_append_printf (desc, "source. ");
         ASSESS ("assess-video-input-%d", cas->sink_port);
-        g_string_append_printf (desc, "! gdpdepay ! sink. ");
+        g_string_append_printf (desc, "! typefind name=typefind ");
+        /* normalise rate, size and format once for all consumers */
+        g_string_append_printf (desc, "videorate name=normalise ");
+        /* the first converter only works on formats the scaler can't
+           take, the format is converted at the output size */
+        g_string_append_printf (desc, "! videoconvert ! %s ! videoconvert ",
+            gst_composite_get_scale_element ());
+        g_string_append_printf (desc, "! video/x-raw,format=%s,"
+            "width=%d,height=%d,framerate=%d/1 ", GST_SWITCH_COMPOSITE_FORMAT,
+            cas->width, cas->height, cas->framerate);
+        g_string_append_printf (desc, "! sink. ");
       }
       break;
     case GST_CASE_BRANCH_A:
     case GST_CASE_BRANCH_B:
+    case GST_CASE_BRANCH_C:
+    case GST_CASE_BRANCH_D:
+    case GST_CASE_BRANCH_E:
+    case GST_CASE_BRANCH_F:
+    case GST_CASE_BRANCH_G:
+    case GST_CASE_BRANCH_H:
+    case GST_CASE_BRANCH_I:
     case GST_CASE_BRANCH_a:
     case GST_CASE_BRANCH_p:
-      g_string_append_printf (desc, "tcpserversink name=sink port=%d ",
-          cas->sink_port);
+      policy = gst_client_policy_get_string (GST_CLIENT_ROLE_PREVIEW);
+      g_string_append_printf (desc, "tcpserversink name=sink %sport=%d ",
+          policy, cas->sink_port);
+      g_free (policy);
       g_string_append_printf (desc, "source. ");
       if (cas->serve_type == GST_SERVE_AUDIO_STREAM) {
         /*
            ASSESS ("assess-branch-source-%d", cas->sink_port);
          */
+        if (0 < opts.audio_level_interval) {
+          g_string_append_printf (desc, "! level name=level message=true "
+              "interval=%" G_GUINT64_FORMAT " ",
+              (guint64) opts.audio_level_interval * GST_MSECOND);
+        }
         g_string_append_printf (desc, "! faac ");
         /*
            ASSESS ("assess-branch-audio-encoded-%d", cas->sink_port);
          */
       } else {
-        g_string_append_printf (desc, "! video/x-raw,width=%d,height=%d ", cas->width, cas->height);    //cas->a_width, cas->a_height);
+        g_string_append_printf (desc, "! video/x-raw ");
         /*
            ASSESS ("assess-branch-source-%d", cas->sink_port);
          */
+        if ((shm = gst_case_get_shm_path (cas))) {
+          /* a stalled local reader must not hold back the TCP preview */
+          g_string_append_printf (desc, "! tee name=shm_tee ");
+          queue = gst_queue_policy_get_string (GST_QUEUE_ROLE_PREVIEW, NULL);
+          g_string_append_printf (desc, "shm_tee. ! %s", queue);
+          g_free (queue);
+          g_string_append_printf (desc, "! shmsink name=shm socket-path=%s "
+              "shm-size=%u wait-for-connection=false sync=false ", shm,
+              MAX (cas->width, 1920) * MAX (cas->height, 1080) * 2
+              * GST_CASE_SHM_FRAMES);
+          queue = gst_queue_policy_get_string (GST_QUEUE_ROLE_PREVIEW, NULL);
+          g_string_append_printf (desc, "shm_tee. ! %s", queue);
+          g_free (queue);
+          g_free (shm), shm = NULL;
+        }
       }
       g_string_append_printf (desc, "! gdppay ");
       /*
@@ -444,7 +625,7 @@ gst_case_client_socket_added (GstElement * element,
 {
   g_return_if_fail (G_IS_SOCKET (socket));
 
-  //INFO ("client-socket-added: %d", g_socket_get_fd (socket));
+  gst_client_policy_client_added (element, socket);
 }
 
 /**
@@ -463,6 +644,839 @@ gst_case_client_socket_removed (GstElement * element,
   g_socket_close (socket, NULL);
 }
 
+/**
+ * gst_case_buffer_probe:
+ *
+ * Invoked on every buffer reaching the sink of an input case, it records
+ * the arrival time and keeps a smoothed interval and jitter estimation.
+ */
+static GstPadProbeReturn
+gst_case_buffer_probe (GstPad * pad, GstPadProbeInfo * info, GstCase * cas)
+{
+  GstClockTime now = gst_util_get_timestamp ();
+  GstClockTimeDiff interval, diff;
+
+  g_mutex_lock (&cas->health_lock);
+  if (GST_CLOCK_TIME_IS_VALID (cas->health_time)) {
+    interval = GST_CLOCK_DIFF (cas->health_time, now);
+    if (cas->health_interval == 0) {
+      cas->health_interval = interval;
+    } else {
+      cas->health_interval = (cas->health_interval * 7 + interval) / 8;
+    }
+    diff = ABS (interval - (GstClockTimeDiff) cas->health_interval);
+    cas->health_jitter = (cas->health_jitter * 15 + diff) / 16;
+  }
+  cas->health_time = now;
+  g_mutex_unlock (&cas->health_lock);
+  return GST_PAD_PROBE_OK;
+}
+
+/**
+ * gst_case_acquire_iso_threads:
+ * @return the number of encoder threads granted, 0 if the budget shared by
+ *         all ISO recordings is used up
+ */
+static gint
+gst_case_acquire_iso_threads (GstCase * cas, gint want)
+{
+  gint budget = opts.record_iso_threads;
+  gint granted;
+
+  if (budget <= 0)
+    budget = MAX (1, sysconf (_SC_NPROCESSORS_ONLN) / 2);
+
+  g_mutex_lock (&gst_case_iso_lock);
+  granted = MIN (want, budget - gst_case_iso_threads);
+  if (0 < granted) {
+    gst_case_iso_threads += granted;
+    cas->iso_threads += granted;
+  } else {
+    granted = 0;
+  }
+  g_mutex_unlock (&gst_case_iso_lock);
+  return granted;
+}
+
+/**
+ * gst_case_release_iso_threads:
+ *
+ * Give the encoder threads of the case back to the shared budget.
+ */
+static void
+gst_case_release_iso_threads (GstCase * cas)
+{
+  g_mutex_lock (&gst_case_iso_lock);
+  gst_case_iso_threads -= cas->iso_threads;
+  cas->iso_threads = 0;
+  g_mutex_unlock (&gst_case_iso_lock);
+}
+
+/**
+ * gst_case_iso_filename:
+ * @return the file name of the ISO recording, need to be freed after used
+ *
+ * The ISO recording is named after the program recording, with the input
+ * name and a time stamp.
+ */
+static gchar *
+gst_case_iso_filename (GstCase * cas)
+{
+  const gchar *filename = opts.record_filename;
+  const gchar *dot = g_strrstr (filename, ".");
+  gchar stamp[128];
+  gchar *stem, *result;
+  time_t t = time (NULL);
+  struct tm *tm = localtime (&t);
+
+  if (tm == NULL) {
+    snprintf (stamp, sizeof (stamp), "%ld", (long) t);
+  } else {
+    strftime (stamp, sizeof (stamp), "%F %H%M%S", tm);
+  }
+
+  stem = dot ? g_strndup (filename, dot - filename) : g_strdup (filename);
+  result = g_strdup_printf ("%s %s %s.mkv", stem, GST_WORKER (cas)->name,
+      stamp);
+  g_free (stem);
+  return result;
+}
+
+/**
+ * gst_case_new_iso_bin:
+ * @return a bin recording a stream of @caps, with a "sink" pad
+ *
+ * Compressed streams are stored as they are, raw streams are encoded with
+ * a cheap preset, within the shared budget of encoder threads. The queue
+ * leaks, a slow disk only drops from the ISO recording, never from the
+ * program.
+ */
+static GstElement *
+gst_case_new_iso_bin (GstCase * cas, GstCaps * caps)
+{
+  GstStructure *structure = gst_caps_get_structure (caps, 0);
+  const gchar *media = gst_structure_get_name (structure);
+  GstElementFactory *factory = NULL;
+  GstElement *bin = NULL, *queue = NULL;
+  GstPad *pad = NULL;
+  GError *error = NULL;
+  GString *desc;
+  gchar *filename, *queue_desc;
+  gint threads;
+
+  desc = g_string_new ("");
+  queue_desc = gst_queue_policy_get_string (GST_QUEUE_ROLE_ISO, "iso_queue");
+  g_string_append_printf (desc, "%s", queue_desc);
+  g_free (queue_desc);
+
+  if (g_str_has_prefix (media, "video/x-raw")) {
+    threads = gst_case_acquire_iso_threads (cas, GST_CASE_ISO_ENCODER_THREADS);
+    if (threads == 0)
+      goto error_no_threads;
+    g_string_append_printf (desc, "! videoconvert ");
+    g_string_append_printf (desc, "! vp8enc deadline=1 cpu-used=16 "
+        "threads=%d ", threads);
+  } else if (g_str_has_prefix (media, "audio/x-raw")) {
+    if (gst_case_acquire_iso_threads (cas, 1) == 0)
+      goto error_no_threads;
+    g_string_append_printf (desc, "! audioconvert ! faac ");
+  }
+
+  if (g_str_has_prefix (media, "video/x-h264"))
+    g_string_append_printf (desc, "! h264parse ");
+
+  filename = gst_case_iso_filename (cas);
+  g_string_append_printf (desc, "! matroskamux ");
+  if ((factory = gst_element_factory_find ("recordsink"))) {
+    g_string_append_printf (desc, "! recordsink name=iso_sink "
+        "location=\"%s\" ", filename);
+    gst_object_unref (factory);
+  } else {
+    g_string_append_printf (desc, "! filesink name=iso_sink sync=false "
+        "location=\"%s\" ", filename);
+  }
+  INFO ("%s: recording %s into %s", GST_WORKER (cas)->name, media, filename);
+  g_free (filename);
+
+  bin = gst_parse_bin_from_description (desc->str, FALSE, &error);
+  g_string_free (desc, TRUE);
+
+  if (error) {
+    ERROR ("%s: %s", GST_WORKER (cas)->name, error->message);
+    g_error_free (error);
+    if (bin)
+      gst_object_unref (bin);
+    gst_case_release_iso_threads (cas);
+    return NULL;
+  }
+
+  gst_element_set_name (bin, "iso");
+  gst_queue_policy_watch (bin);
+  queue = gst_bin_get_by_name (GST_BIN (bin), "iso_queue");
+  pad = gst_element_get_static_pad (queue, "sink");
+  gst_element_add_pad (bin, gst_ghost_pad_new ("sink", pad));
+  gst_object_unref (pad);
+  gst_object_unref (queue);
+  return bin;
+
+error_no_threads:
+  {
+    WARN ("%s: no encoder threads left for the ISO recording",
+        GST_WORKER (cas)->name);
+    g_string_free (desc, TRUE);
+    return NULL;
+  }
+}
+
+/**
+ * gst_case_iso_probe:
+ *
+ * Invoked on the events into the tee of an input case, the ISO recording is
+ * attached once the caps of the input are known. The tee forwards the
+ * sticky events to the new branch.
+ */
+static GstPadProbeReturn
+gst_case_iso_probe (GstPad * pad, GstPadProbeInfo * info, GstCase * cas)
+{
+  GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+  GstElement *tee = NULL, *pipeline = NULL, *bin = NULL;
+  GstPad *tee_pad = NULL, *sink_pad = NULL;
+  GstCaps *caps = NULL;
+
+  if (GST_EVENT_TYPE (event) != GST_EVENT_CAPS)
+    return GST_PAD_PROBE_OK;
+
+  gst_event_parse_caps (event, &caps);
+  bin = gst_case_new_iso_bin (cas, caps);
+  if (!bin)
+    return GST_PAD_PROBE_REMOVE;
+
+  tee = gst_pad_get_parent_element (pad);
+  pipeline = GST_ELEMENT (gst_element_get_parent (tee));
+  gst_bin_add (GST_BIN (pipeline), bin);
+  gst_element_sync_state_with_parent (bin);
+
+  tee_pad = gst_element_get_request_pad (tee, "src_%u");
+  sink_pad = gst_element_get_static_pad (bin, "sink");
+  if (gst_pad_link (tee_pad, sink_pad) != GST_PAD_LINK_OK) {
+    gchar *str = gst_caps_to_string (caps);
+    ERROR ("%s: can't record %s", GST_WORKER (cas)->name, str);
+    g_free (str);
+    gst_element_release_request_pad (tee, tee_pad);
+    gst_element_set_state (bin, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN (pipeline), bin);
+    gst_case_release_iso_threads (cas);
+  }
+
+  gst_object_unref (sink_pad);
+  gst_object_unref (tee_pad);
+  gst_object_unref (pipeline);
+  gst_object_unref (tee);
+  return GST_PAD_PROBE_REMOVE;
+}
+
+/**
+ * gst_case_probe_iso:
+ *
+ * Attach the ISO recording to @tee once the caps of the input are known.
+ */
+static void
+gst_case_probe_iso (GstCase * cas, GstElement * tee)
+{
+  GstPad *pad = gst_element_get_static_pad (tee, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      (GstPadProbeCallback) gst_case_iso_probe, cas, NULL);
+  gst_object_unref (pad);
+}
+
+/**
+ * gst_case_iso_eos_probe:
+ *
+ * Invoked on the events reaching the file sink of the ISO recording.
+ */
+static GstPadProbeReturn
+gst_case_iso_eos_probe (GstPad * pad, GstPadProbeInfo * info, GstCase * cas)
+{
+  GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+
+  if (GST_EVENT_TYPE (event) != GST_EVENT_EOS)
+    return GST_PAD_PROBE_OK;
+
+  g_mutex_lock (&cas->iso_lock);
+  cas->iso_ended = TRUE;
+  g_cond_signal (&cas->iso_cond);
+  g_mutex_unlock (&cas->iso_lock);
+  return GST_PAD_PROBE_REMOVE;
+}
+
+/**
+ * gst_case_end_iso:
+ *
+ * Detach the ISO recording from its tee and end it with an EOS before the
+ * input is torn down, so that the muxer writes the cues and the duration.
+ * Waits at most GST_CASE_ISO_EOS_TIMEOUT seconds for the EOS to reach the
+ * file.
+ */
+static void
+gst_case_end_iso (GstCase * cas)
+{
+  GstWorker *worker = GST_WORKER (cas);
+  GstElement *bin = NULL, *sink = NULL, *tee = NULL, *parent = NULL;
+  GstPad *pad = NULL, *tee_pad = NULL;
+  GstState state = GST_STATE_NULL;
+  gint64 deadline;
+
+  if (!worker->pipeline || !gst_case_records_iso (cas))
+    return;
+
+  /* an ended input has already ended its ISO recording */
+  gst_element_get_state (worker->pipeline, &state, NULL, 0);
+  if (state != GST_STATE_PLAYING)
+    return;
+
+  bin = gst_bin_get_by_name (GST_BIN (worker->pipeline), "iso");
+  if (!bin)
+    return;
+
+  sink = gst_bin_get_by_name (GST_BIN (bin), "iso_sink");
+  pad = gst_element_get_static_pad (sink, "sink");
+  g_mutex_lock (&cas->iso_lock);
+  cas->iso_ended = FALSE;
+  g_mutex_unlock (&cas->iso_lock);
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      (GstPadProbeCallback) gst_case_iso_eos_probe, cas, NULL);
+  gst_object_unref (pad);
+  gst_object_unref (sink);
+
+  /* the input must not be ended by the EOS of one of its branches */
+  pad = gst_element_get_static_pad (bin, "sink");
+  if ((tee_pad = gst_pad_get_peer (pad))) {
+    tee = gst_pad_get_parent_element (tee_pad);
+    gst_pad_unlink (tee_pad, pad);
+    gst_element_release_request_pad (tee, tee_pad);
+    gst_object_unref (tee_pad);
+    gst_object_unref (tee);
+  }
+  gst_pad_send_event (pad, gst_event_new_eos ());
+  gst_object_unref (pad);
+
+  deadline = g_get_monotonic_time () + GST_CASE_ISO_EOS_TIMEOUT *
+      G_TIME_SPAN_SECOND;
+  g_mutex_lock (&cas->iso_lock);
+  while (!cas->iso_ended) {
+    if (!g_cond_wait_until (&cas->iso_cond, &cas->iso_lock, deadline)) {
+      WARN ("%s: the ISO recording was not ended", worker->name);
+      break;
+    }
+  }
+  g_mutex_unlock (&cas->iso_lock);
+
+  parent = GST_ELEMENT (gst_object_get_parent (GST_OBJECT (bin)));
+  gst_element_set_state (bin, GST_STATE_NULL);
+  gst_bin_remove (GST_BIN (parent), bin);
+  gst_object_unref (parent);
+  gst_object_unref (bin);
+}
+
+/**
+ * gst_case_acquire_decode_threads:
+ * @return the number of decoder threads granted, at least 1 even if the
+ *         budget shared by all compressed inputs is used up
+ */
+static gint
+gst_case_acquire_decode_threads (GstCase * cas, gint want)
+{
+  gint budget = opts.decode_threads;
+  gint granted;
+
+  if (budget <= 0)
+    budget = MAX (1, sysconf (_SC_NPROCESSORS_ONLN));
+
+  g_mutex_lock (&gst_case_decode_lock);
+  granted = CLAMP (budget - gst_case_decode_threads, 0, want);
+  gst_case_decode_threads += granted;
+  cas->decode_threads += granted;
+  g_mutex_unlock (&gst_case_decode_lock);
+
+  /* a decoder over the budget still decodes, on a single thread */
+  return MAX (granted, 1);
+}
+
+/**
+ * gst_case_release_decode_threads:
+ *
+ * Give the decoder threads of the case back to the shared budget.
+ */
+static void
+gst_case_release_decode_threads (GstCase * cas)
+{
+  g_mutex_lock (&gst_case_decode_lock);
+  gst_case_decode_threads -= cas->decode_threads;
+  cas->decode_threads = 0;
+  g_mutex_unlock (&gst_case_decode_lock);
+}
+
+/**
+ * gst_case_decoder_added:
+ *
+ * Invoked when decodebin plugs an element, the decoders of all inputs share
+ * a budget of threads so that many inputs can't take over the processors.
+ */
+static void
+gst_case_decoder_added (GstBin * decode, GstElement * element, GstCase * cas)
+{
+  GObjectClass *klass = G_OBJECT_GET_CLASS (element);
+  const gchar *property = NULL;
+
+  if (g_object_class_find_property (klass, "max-threads"))
+    property = "max-threads";
+  else if (g_object_class_find_property (klass, "threads"))
+    property = "threads";
+
+  if (property)
+    g_object_set (element, property, gst_case_acquire_decode_threads (cas,
+            GST_CASE_DECODER_THREADS), NULL);
+}
+
+/**
+ * gst_case_decoded_pad_added:
+ *
+ * Invoked when decodebin exposes a pad, the first raw video pad becomes
+ * the output of the decoder bin.
+ */
+static void
+gst_case_decoded_pad_added (GstElement * decode, GstPad * pad, GstPad * ghost)
+{
+  GstCaps *caps = gst_pad_query_caps (pad, NULL);
+  GstPad *target = gst_ghost_pad_get_target (GST_GHOST_PAD (ghost));
+  const gchar *media = gst_structure_get_name (gst_caps_get_structure (caps,
+          0));
+
+  if (!target && g_str_has_prefix (media, "video/x-raw"))
+    gst_ghost_pad_set_target (GST_GHOST_PAD (ghost), pad);
+
+  if (target)
+    gst_object_unref (target);
+  gst_caps_unref (caps);
+}
+
+/**
+ * gst_case_have_type:
+ *
+ * Invoked when the stream of a video input is typefound. GDP streams are
+ * depayloaded first, raw video passes decodebin as it is, compressed video
+ * (H.264, VP8 in IVF or Matroska, ...) is decoded once for the preview and
+ * the composite. The decoded video is normalised to the composite format.
+ */
+static void
+gst_case_have_type (GstElement * typefind, guint probability, GstCaps * caps,
+    GstCase * cas)
+{
+  GstStructure *structure = gst_caps_get_structure (caps, 0);
+  GstElement *pipeline = NULL, *bin = NULL, *decode = NULL;
+  GstElement *normalise = NULL, *tee = NULL;
+  GstPad *ghost = NULL;
+  GError *error = NULL;
+  GString *desc;
+
+  desc = g_string_new ("");
+  if (gst_structure_has_name (structure, "application/x-gdp"))
+    g_string_append_printf (desc, "gdpdepay ! ");
+  if (gst_case_records_iso (cas))
+    g_string_append_printf (desc, "tee name=iso_tee ! ");
+  g_string_append_printf (desc, "queue name=decode_queue ");
+  g_string_append_printf (desc, "! decodebin name=decode ");
+
+  bin = gst_parse_bin_from_description (desc->str, TRUE, &error);
+  g_string_free (desc, TRUE);
+
+  if (error) {
+    ERROR ("%s: %s", GST_WORKER (cas)->name, error->message);
+    g_error_free (error);
+    if (bin)
+      gst_object_unref (bin);
+    return;
+  }
+
+  gst_element_set_name (bin, "decoder");
+  gst_queue_policy_watch (bin);
+  ghost = gst_ghost_pad_new_no_target ("src", GST_PAD_SRC);
+  gst_element_add_pad (bin, ghost);
+
+  decode = gst_bin_get_by_name (GST_BIN (bin), "decode");
+  g_signal_connect (decode, "pad-added",
+      G_CALLBACK (gst_case_decoded_pad_added), ghost);
+  g_signal_connect (decode, "element-added",
+      G_CALLBACK (gst_case_decoder_added), cas);
+  gst_object_unref (decode);
+
+  tee = gst_bin_get_by_name (GST_BIN (bin), "iso_tee");
+  if (tee) {
+    gst_case_probe_iso (cas, tee);
+    gst_object_unref (tee);
+  }
+
+  pipeline = GST_ELEMENT (gst_element_get_parent (typefind));
+  normalise = gst_bin_get_by_name (GST_BIN (pipeline), "normalise");
+  gst_bin_add (GST_BIN (pipeline), bin);
+  if (!gst_element_link (typefind, bin) || !gst_element_link (bin, normalise)) {
+    gchar *str = gst_caps_to_string (caps);
+    ERROR ("%s: can't decode %s", GST_WORKER (cas)->name, str);
+    g_free (str);
+  }
+  gst_element_sync_state_with_parent (bin);
+
+  gst_object_unref (normalise);
+  gst_object_unref (pipeline);
+}
+
+/**
+ * gst_case_get_channel:
+ *  @param type the case type
+ *  @return the composite channel of a composite or branch type, 'A' to 'I'
+ *          for video and 'a' for audio, 0 for other types
+ */
+gint
+gst_case_get_channel (GstCaseType type)
+{
+  switch (type) {
+    case GST_CASE_COMPOSITE_A:
+    case GST_CASE_BRANCH_A:
+      return 'A';
+    case GST_CASE_COMPOSITE_B:
+    case GST_CASE_BRANCH_B:
+      return 'B';
+    case GST_CASE_COMPOSITE_a:
+    case GST_CASE_BRANCH_a:
+      return 'a';
+    default:
+      if (GST_CASE_COMPOSITE_C <= type && type <= GST_CASE_COMPOSITE_I)
+        return 'C' + (type - GST_CASE_COMPOSITE_C);
+      if (GST_CASE_BRANCH_C <= type && type <= GST_CASE_BRANCH_I)
+        return 'C' + (type - GST_CASE_BRANCH_C);
+      return 0;
+  }
+}
+
+/**
+ * gst_case_get_composite_type:
+ *  @param channel the composite channel, 'A' to 'I' or 'a'
+ *  @return the composite case type of the channel, or GST_CASE_UNKNOWN
+ */
+GstCaseType
+gst_case_get_composite_type (gint channel)
+{
+  switch (channel) {
+    case 'A':
+      return GST_CASE_COMPOSITE_A;
+    case 'B':
+      return GST_CASE_COMPOSITE_B;
+    case 'a':
+      return GST_CASE_COMPOSITE_a;
+    default:
+      if ('C' <= channel && channel < 'A' + GST_CASE_MAX_CHANNELS)
+        return GST_CASE_COMPOSITE_C + (channel - 'C');
+      return GST_CASE_UNKNOWN;
+  }
+}
+
+/**
+ * gst_case_get_branch_type:
+ *  @param type a composite or preview case type
+ *  @return the type of the branch serving the case, or GST_CASE_UNKNOWN
+ */
+GstCaseType
+gst_case_get_branch_type (GstCaseType type)
+{
+  gint channel = gst_case_get_channel (type);
+
+  switch (channel) {
+    case 'A':
+      return GST_CASE_BRANCH_A;
+    case 'B':
+      return GST_CASE_BRANCH_B;
+    case 'a':
+      return GST_CASE_BRANCH_a;
+    case 0:
+      return type == GST_CASE_PREVIEW ? GST_CASE_BRANCH_p : GST_CASE_UNKNOWN;
+    default:
+      return GST_CASE_BRANCH_C + (channel - 'C');
+  }
+}
+
+/**
+ * gst_case_get_audio_level:
+ *  @param cas the GstCase instance, it should be an audio branch case
+ *  @param rms return location for the RMS level (in dB)
+ *  @param peak return location for the peak level (in dB)
+ *  @param decay return location for the decaying peak level (in dB)
+ *  @return TRUE if a new level was measured since the last call
+ *
+ *  Get the last level measured on the audio of a branch case, the loudest
+ *  of all audio channels.
+ */
+gboolean
+gst_case_get_audio_level (GstCase * cas, gdouble * rms, gdouble * peak,
+    gdouble * decay)
+{
+  gboolean fresh;
+
+  g_return_val_if_fail (GST_IS_CASE (cas), FALSE);
+
+  g_mutex_lock (&cas->health_lock);
+  fresh = cas->level_fresh;
+  *rms = cas->level_rms;
+  *peak = cas->level_peak;
+  *decay = cas->level_decay;
+  cas->level_fresh = FALSE;
+  g_mutex_unlock (&cas->health_lock);
+  return fresh;
+}
+
+/**
+ * gst_case_get_shm:
+ *  @param cas the GstCase instance, it should be a video branch case
+ *  @param path return location for the socket of the shared memory preview
+ *  @param caps return location for the caps of the frames
+ *  @return TRUE if the case is exposing negotiated frames in shared memory
+ *
+ *  Get the shared memory preview of a case, the strings are to be freed.
+ */
+gboolean
+gst_case_get_shm (GstCase * cas, gchar ** path, gchar ** caps)
+{
+  GstElement *shm;
+  GstCaps *current = NULL;
+  GstPad *pad;
+
+  g_return_val_if_fail (GST_IS_CASE (cas), FALSE);
+
+  *path = *caps = NULL;
+
+  shm = gst_worker_get_element (GST_WORKER (cas), "shm");
+  if (!shm)
+    return FALSE;
+
+  pad = gst_element_get_static_pad (shm, "sink");
+  if (pad) {
+    current = gst_pad_get_current_caps (pad);
+    gst_object_unref (pad);
+  }
+  if (current) {
+    g_object_get (shm, "socket-path", path, NULL);
+    *caps = gst_caps_to_string (current);
+    gst_caps_unref (current);
+  }
+  gst_object_unref (shm);
+  return *path != NULL;
+}
+
+/**
+ * gst_case_get_health:
+ *  @param cas the GstCase instance, it should be an input case
+ *  @param deadline the maximum time a stream is allowed to stall
+ *  @return the health state of the case
+ *
+ *  Tell if the stream of the case is still flowing. A case is unhealthy if
+ *  no buffer arrived or an error was reported within the deadline, or if
+ *  the buffer interval is jittering more than half of the deadline.
+ */
+GstCaseHealth
+gst_case_get_health (GstCase * cas, GstClockTime deadline)
+{
+  GstCaseHealth health = GST_CASE_HEALTH_OK;
+  GstClockTime now = gst_util_get_timestamp ();
+
+  g_return_val_if_fail (GST_IS_CASE (cas), GST_CASE_HEALTH_ERROR);
+
+  g_mutex_lock (&cas->health_lock);
+  if (GST_CLOCK_TIME_IS_VALID (cas->error_time) &&
+      now < cas->error_time + deadline) {
+    health = GST_CASE_HEALTH_ERROR;
+  } else if (GST_CLOCK_TIME_IS_VALID (cas->health_time) &&
+      cas->health_time + deadline < now) {
+    health = GST_CASE_HEALTH_STALLED;
+  } else if (deadline / 2 < cas->health_jitter) {
+    health = GST_CASE_HEALTH_JITTER;
+  }
+  g_mutex_unlock (&cas->health_lock);
+  return health;
+}
+
+/**
+ * gst_case_set_channel:
+ *
+ * Re-point an inter element of a running case to a new channel. Only the
+ * element is restarted, the rest of the pipeline keeps running.
+ */
+static gboolean
+gst_case_set_channel (GstCase * cas, const gchar * name, const gchar * prefix,
+    gint port)
+{
+  GstWorker *worker = GST_WORKER (cas);
+  GstElement *element = NULL;
+  gchar *channel;
+
+  if (worker->pipeline)
+    element = gst_worker_get_element (worker, name);
+  if (!element) {
+    ERROR ("%s: no %s", worker->name, name);
+    return FALSE;
+  }
+
+  channel = g_strdup_printf ("%s_%d", prefix, port);
+  gst_element_set_state (element, GST_STATE_NULL);
+  g_object_set (element, "channel", channel, NULL);
+  gst_element_sync_state_with_parent (element);
+  g_free (channel);
+  gst_object_unref (element);
+  return TRUE;
+}
+
+/**
+ * gst_case_rewire:
+ *
+ * Make a composite or preview case read from the input of @port and feed
+ * the branch of @port.
+ */
+static gboolean
+gst_case_rewire (GstCase * cas, gint port)
+{
+  const gchar *sink = NULL;
+
+  switch (cas->type) {
+    case GST_CASE_COMPOSITE_A:
+    case GST_CASE_COMPOSITE_B:
+    case GST_CASE_COMPOSITE_C:
+    case GST_CASE_COMPOSITE_D:
+    case GST_CASE_COMPOSITE_E:
+    case GST_CASE_COMPOSITE_F:
+    case GST_CASE_COMPOSITE_G:
+    case GST_CASE_COMPOSITE_H:
+    case GST_CASE_COMPOSITE_I:
+    case GST_CASE_COMPOSITE_a:
+      sink = "sink1";
+      break;
+    case GST_CASE_PREVIEW:
+      sink = "sink";
+      break;
+    default:
+      ERROR ("can't rewire case %d", cas->type);
+      return FALSE;
+  }
+
+  if (!gst_case_set_channel (cas, "source", "input", port))
+    return FALSE;
+  return gst_case_set_channel (cas, sink, "branch", port);
+}
+
+/**
+ * gst_case_swap_input:
+ *  @param cas the GstCase instance
+ *  @param other the other GstCase instance
+ *  @return TRUE if the inputs are swapped
+ *
+ *  Swap the inputs (and branches) of two running cases in place, without
+ *  rebuilding their pipelines. This is much faster than replacing the
+ *  cases, but the cases must be of the same serve type.
+ */
+gboolean
+gst_case_swap_input (GstCase * cas, GstCase * other)
+{
+  GstCase *input, *branch;
+  gint port;
+
+  g_return_val_if_fail (GST_IS_CASE (cas), FALSE);
+  g_return_val_if_fail (GST_IS_CASE (other), FALSE);
+
+  if (cas->serve_type != other->serve_type) {
+    ERROR ("stream type not matched");
+    return FALSE;
+  }
+
+  port = cas->sink_port;
+  if (!gst_case_rewire (cas, other->sink_port) ||
+      !gst_case_rewire (other, port)) {
+    ERROR ("failed to swap %s and %s", GST_WORKER (cas)->name,
+        GST_WORKER (other)->name);
+    return FALSE;
+  }
+
+  input = cas->input, cas->input = other->input, other->input = input;
+  branch = cas->branch, cas->branch = other->branch, other->branch = branch;
+  cas->sink_port = other->sink_port, other->sink_port = port;
+  return TRUE;
+}
+
+/**
+ * gst_case_level_max:
+ * @return the highest value (in dB) of all audio channels of a level
+ *         message field
+ */
+static gdouble
+gst_case_level_max (const GstStructure * s, const gchar * field)
+{
+  const GValue *list = gst_structure_get_value (s, field);
+  gdouble value = -G_MAXDOUBLE;
+  gint i, n;
+
+  if (list == NULL)
+    return value;
+
+  if (GST_VALUE_HOLDS_LIST (list)) {
+    n = gst_value_list_get_size (list);
+    for (i = 0; i < n; ++i)
+      value = MAX (value, g_value_get_double (gst_value_list_get_value (list,
+                  i)));
+  } else if (G_VALUE_HOLDS (list, G_TYPE_VALUE_ARRAY)) {
+    GValueArray *va = (GValueArray *) g_value_get_boxed (list);
+    for (i = 0; i < va->n_values; ++i)
+      value = MAX (value, g_value_get_double (va->values + i));
+  }
+  return value;
+}
+
+/**
+ * gst_case_message:
+ *
+ * Invoked by GstWorker on pipeline messages, errors are recorded for the
+ * health monitor and audio levels for the level meters.
+ */
+static gboolean
+gst_case_message (GstCase * cas, GstMessage * message)
+{
+  const GstStructure *s;
+
+  switch (GST_MESSAGE_TYPE (message)) {
+    case GST_MESSAGE_ERROR:
+      g_mutex_lock (&cas->health_lock);
+      cas->error_time = gst_util_get_timestamp ();
+      g_mutex_unlock (&cas->health_lock);
+      /* shmsrc fails rather than ends when the producer goes away */
+      if (cas->shm_path && GST_IS_ELEMENT (GST_MESSAGE_SRC (message)) &&
+          g_strcmp0 (GST_MESSAGE_SRC_NAME (message), "source") == 0) {
+        INFO ("%s: shared memory input closed", GST_WORKER (cas)->name);
+        gst_case_end_iso (cas);
+        gst_worker_stop (GST_WORKER (cas));
+      }
+      break;
+    case GST_MESSAGE_ELEMENT:
+      s = gst_message_get_structure (message);
+      if (gst_structure_has_name (s, "level")) {
+        g_mutex_lock (&cas->health_lock);
+        cas->level_rms = gst_case_level_max (s, "rms");
+        cas->level_peak = gst_case_level_max (s, "peak");
+        cas->level_decay = gst_case_level_max (s, "decay");
+        cas->level_fresh = TRUE;
+        g_mutex_unlock (&cas->health_lock);
+      }
+      break;
+    default:
+      break;
+  }
+  return TRUE;
+}
+
 /**
  * gst_case_prepare:
  *
@@ -473,10 +1487,16 @@ gst_case_prepare (GstCase * cas)
 {
   GstWorker *worker = GST_WORKER (cas);
   GstElement *source = NULL;
+  GstElement *sink = NULL;
+  GstElement *tee = NULL;
+  GstElement *typefind = NULL;
+
+  gst_queue_policy_watch (worker->pipeline);
+
   switch (cas->type) {
     case GST_CASE_INPUT_a:
     case GST_CASE_INPUT_v:
-      if (!cas->stream) {
+      if (!cas->stream && !cas->shm_path) {
         ERROR ("no stream for new case");
         return FALSE;
       }
@@ -485,22 +1505,61 @@ gst_case_prepare (GstCase * cas)
         ERROR ("no source");
         return FALSE;
       }
-      g_object_set (source, "stream", cas->stream, NULL);
+      if (cas->stream)
+        g_object_set (source, "stream", cas->stream, NULL);
       gst_object_unref (source);
+
+      sink = gst_worker_get_element_unlocked (worker, "sink");
+      if (sink) {
+        GstPad *pad = gst_element_get_static_pad (sink, "sink");
+        gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+            (GstPadProbeCallback) gst_case_buffer_probe, cas, NULL);
+        gst_object_unref (pad);
+        gst_object_unref (sink);
+      }
+
+      g_mutex_lock (&cas->health_lock);
+      cas->health_time = gst_util_get_timestamp ();
+      g_mutex_unlock (&cas->health_lock);
+
+      gst_case_release_iso_threads (cas);
+      gst_case_release_decode_threads (cas);
+      tee = gst_worker_get_element_unlocked (worker, "iso_tee");
+      if (tee) {
+        gst_case_probe_iso (cas, tee);
+        gst_object_unref (tee);
+      }
+
+      typefind = gst_worker_get_element_unlocked (worker, "typefind");
+      if (typefind) {
+        g_signal_connect (typefind, "have-type",
+            G_CALLBACK (gst_case_have_type), cas);
+        gst_object_unref (typefind);
+      }
       break;
 
     case GST_CASE_BRANCH_A:
     case GST_CASE_BRANCH_B:
+    case GST_CASE_BRANCH_C:
+    case GST_CASE_BRANCH_D:
+    case GST_CASE_BRANCH_E:
+    case GST_CASE_BRANCH_F:
+    case GST_CASE_BRANCH_G:
+    case GST_CASE_BRANCH_H:
+    case GST_CASE_BRANCH_I:
     case GST_CASE_BRANCH_a:
     case GST_CASE_BRANCH_p:
     {
-      GstElement *sink = gst_worker_get_element_unlocked (worker, "sink");
+      sink = gst_worker_get_element_unlocked (worker, "sink");
 
       g_return_val_if_fail (GST_IS_ELEMENT (sink), FALSE);
 
       g_signal_connect (sink, "client-added",
           G_CALLBACK (gst_case_client_socket_added), cas);
 
+      g_signal_connect (sink, "client-removed",
+          G_CALLBACK (gst_client_policy_client_removed), cas);
+
       g_signal_connect (sink, "client-socket-removed",
           G_CALLBACK (gst_case_client_socket_removed), cas);
     }
@@ -548,6 +1607,11 @@ gst_case_class_init (GstCaseClass * klass)
           "Stream to read from",
           G_TYPE_INPUT_STREAM, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (object_class, PROP_SHM_PATH,
+      g_param_spec_string ("shm-path", "Shared Memory Path",
+          "Socket of a shared memory input, instead of the stream", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (object_class, PROP_INPUT,
       g_param_spec_object ("input", "Input",
           "The input of the case",
@@ -608,7 +1672,15 @@ gst_case_class_init (GstCaseClass * klass)
           GST_SWITCH_COMPOSITE_DEFAULT_HEIGHT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (object_class, PROP_FRAMERATE,
+      g_param_spec_uint ("framerate", "Framerate",
+          "Output frames per second", 1,
+          GST_SWITCH_COMPOSITE_MAX_FRAMERATE,
+          GST_SWITCH_COMPOSITE_DEFAULT_FRAMERATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   worker_class->prepare = (GstWorkerPrepareFunc) gst_case_prepare;
+  worker_class->message = (GstWorkerMessageFunc) gst_case_message;
   worker_class->get_pipeline_string = (GstWorkerGetPipelineStringFunc)
       gst_case_get_pipeline_string;
 }
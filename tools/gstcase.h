@@ -52,6 +52,10 @@ typedef struct _GstCaseClass GstCaseClass;
  *  @param GST_CASE_BRANCH_B special case for branching channel B to output
  *  @param GST_CASE_BRANCH_a special case for branching active audio to output
  *  @param GST_CASE_BRANCH_p special case for branching preview to output
+ *  @param GST_CASE_COMPOSITE_C special case for composite channel C, up to
+ *         GST_CASE_COMPOSITE_I for channel I
+ *  @param GST_CASE_BRANCH_C special case for branching channel C to output,
+ *         up to GST_CASE_BRANCH_I for channel I
  *  @param GST_CASE__LAST_TYPE
  */
 typedef enum
@@ -67,9 +71,33 @@ typedef enum
   GST_CASE_BRANCH_B,            /* video branch */
   GST_CASE_BRANCH_a,            /* audio branch */
   GST_CASE_BRANCH_p,            /* preview branch */
-  GST_CASE__LAST_TYPE = GST_CASE_BRANCH_p
+  GST_CASE_COMPOSITE_C,         /* more composite channels */
+  GST_CASE_COMPOSITE_D,
+  GST_CASE_COMPOSITE_E,
+  GST_CASE_COMPOSITE_F,
+  GST_CASE_COMPOSITE_G,
+  GST_CASE_COMPOSITE_H,
+  GST_CASE_COMPOSITE_I,
+  GST_CASE_BRANCH_C,            /* more video branches */
+  GST_CASE_BRANCH_D,
+  GST_CASE_BRANCH_E,
+  GST_CASE_BRANCH_F,
+  GST_CASE_BRANCH_G,
+  GST_CASE_BRANCH_H,
+  GST_CASE_BRANCH_I,
+  GST_CASE__LAST_TYPE = GST_CASE_BRANCH_I
 } GstCaseType;
 
+#define GST_CASE_MAX_CHANNELS 9 /* composite video channels, 'A' to 'I' */
+#define GST_CASE_SHM_FRAMES 4 /* frames held by a shared memory preview */
+
+#define GST_CASE_IS_COMPOSITE_VIDEO(type) \
+  ((type) == GST_CASE_COMPOSITE_A || (type) == GST_CASE_COMPOSITE_B || \
+      (GST_CASE_COMPOSITE_C <= (type) && (type) <= GST_CASE_COMPOSITE_I))
+#define GST_CASE_IS_BRANCH_VIDEO(type) \
+  ((type) == GST_CASE_BRANCH_A || (type) == GST_CASE_BRANCH_B || \
+      (GST_CASE_BRANCH_C <= (type) && (type) <= GST_CASE_BRANCH_I))
+
 /**
  *  GstSwitchServeStreamType:
  *  @param GST_SERVE_NOTHING the case is serving nothing
@@ -83,15 +111,50 @@ typedef enum
   GST_SERVE_AUDIO_STREAM,
 } GstSwitchServeStreamType;
 
+/**
+ *  GstCaseHealth:
+ *  @param GST_CASE_HEALTH_OK the stream is flowing normally
+ *  @param GST_CASE_HEALTH_STALLED no buffer arrived within the deadline
+ *  @param GST_CASE_HEALTH_JITTER the buffer interval is too irregular
+ *  @param GST_CASE_HEALTH_ERROR the pipeline reported an error recently
+ */
+typedef enum
+{
+  GST_CASE_HEALTH_OK,
+  GST_CASE_HEALTH_STALLED,
+  GST_CASE_HEALTH_JITTER,
+  GST_CASE_HEALTH_ERROR,
+} GstCaseHealth;
+
 /**
  *  GstCase:
  *  @param base the parent object
+ *  @param shm_path the socket of the shared memory input of an input case,
+ *         read instead of %stream
+ *  @param health_lock the lock for the health and level fields
+ *  @param health_time the time the last buffer arrived (input cases)
+ *  @param health_interval the smoothed buffer interval
+ *  @param health_jitter the smoothed deviation of the buffer interval
+ *  @param error_time the time the last error was reported
+ *  @param level_rms the last RMS level (in dB) of an audio branch case
+ *  @param level_peak the last peak level (in dB) of an audio branch case
+ *  @param level_decay the last decaying peak level (in dB) of an audio
+ *         branch case
+ *  @param level_fresh TRUE if the level was not taken yet
+ *  @param iso_threads the encoder threads taken by the ISO recording of an
+ *         input case
+ *  @param decode_threads the decoder threads taken by a compressed input
+ *         case
+ *  @param iso_lock the lock for %iso_ended
+ *  @param iso_cond signalled when %iso_ended is set
+ *  @param iso_ended TRUE if the EOS reached the end of the ISO recording
  */
 struct _GstCase
 {
   GstWorker base;
   GstCaseType type;
   GInputStream *stream;
+  gchar *shm_path;
   GstCase *input;
   GstCase *branch;
   GstSwitchServeStreamType serve_type;
@@ -103,6 +166,23 @@ struct _GstCase
   guint a_height;
   guint b_width;
   guint b_height;
+  guint framerate;
+
+  GMutex health_lock;
+  GstClockTime health_time;
+  GstClockTime health_interval;
+  GstClockTime health_jitter;
+  GstClockTime error_time;
+  gdouble level_rms;
+  gdouble level_peak;
+  gdouble level_decay;
+  gboolean level_fresh;
+
+  gint iso_threads;
+  gint decode_threads;
+  GMutex iso_lock;
+  GCond iso_cond;
+  gboolean iso_ended;
 };
 
 /**
@@ -115,5 +195,13 @@ struct _GstCaseClass
 };
 
 GType gst_case_get_type (void);
+gint gst_case_get_channel (GstCaseType type);
+GstCaseType gst_case_get_composite_type (gint channel);
+GstCaseType gst_case_get_branch_type (GstCaseType type);
+GstCaseHealth gst_case_get_health (GstCase * cas, GstClockTime deadline);
+gboolean gst_case_get_audio_level (GstCase * cas, gdouble * rms,
+    gdouble * peak, gdouble * decay);
+gboolean gst_case_swap_input (GstCase * cas, GstCase * other);
+gboolean gst_case_get_shm (GstCase * cas, gchar ** path, gchar ** caps);
 
 #endif //__GST_CASE_H__by_Duzy_Chan__
@@ -0,0 +1,160 @@
+/* GstSwitch
+ * Copyright (C) 2012,2013 Duzy Chan <code@duzy.info>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*! @file */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstswitchserver.h"
+#include "gstclientpolicy.h"
+
+/* The GstClientStatus of multihandlesink, which is not installed. */
+static const gchar *gst_client_policy_status_names[] = {
+  "ok", "closed", "removed", "slow", "error", "duplicate", "flushing",
+};
+
+/**
+ * gst_client_policy_get_recover:
+ *
+ * The recover-policy of tcpserversink applied to a client lagging more than
+ * the soft limit.
+ */
+static const gchar *
+gst_client_policy_get_recover (void)
+{
+  if (g_strcmp0 (opts.client_drop, "none") == 0)
+    return "none";
+  if (g_strcmp0 (opts.client_drop, "keyframe") == 0)
+    return "keyframe";
+  return "latest";
+}
+
+/**
+ * gst_client_policy_get_string:
+ *  @param role the clients the tcpserversink serves
+ *  @return the tcpserversink properties of the client policy, free after use
+ *
+ * A client lagging behind more than --client-max-lag (or --client-max-bytes)
+ * is resynced as --client-drop tells, and one that has taken nothing for
+ * --client-disconnect-lag (or lags more than that without resyncing) is
+ * disconnected, so a slow client neither grows the queue of the sink nor
+ * stalls the other clients. A new client gets the caps, as the stream
+ * header of gdppay, and a burst from the latest key frame rather than
+ * waiting for the next one.
+ *
+ * The encoded output is a muxed byte stream without key frame flags, whose
+ * container header is only sent once, so skipping any of it leaves the
+ * client unable to demux. Its clients are never resynced, only
+ * disconnected, and a new one starts at the next buffer.
+ */
+gchar *
+gst_client_policy_get_string (GstClientRole role)
+{
+  const gchar *units = "time";
+  gint64 soft_max, hard_max;
+  gint factor = role == GST_CLIENT_ROLE_ENCODE ?
+      GST_CLIENT_POLICY_ENCODE_FACTOR : 1;
+
+  if (0 < opts.client_max_bytes) {
+    units = "bytes";
+    soft_max = (gint64) opts.client_max_bytes * 1024 * factor;
+    hard_max = soft_max * GST_CLIENT_POLICY_BYTES_HARD_FACTOR;
+  } else {
+    soft_max = (gint64) opts.client_max_lag * GST_MSECOND * factor;
+    hard_max = (gint64) opts.client_disconnect_lag * GST_MSECOND * factor;
+  }
+
+  if (role == GST_CLIENT_ROLE_ENCODE) {
+    return g_strdup_printf ("sync-method=latest units-type=%s "
+        "units-soft-max=-1 units-max=%" G_GINT64_FORMAT " recover-policy=none "
+        "timeout=%" G_GUINT64_FORMAT " ", units, MAX (soft_max, hard_max),
+        (guint64) opts.client_disconnect_lag * GST_MSECOND * factor);
+  }
+
+  return g_strdup_printf ("sync-method=latest-keyframe units-type=%s "
+      "units-soft-max=%" G_GINT64_FORMAT " units-max=%" G_GINT64_FORMAT " "
+      "recover-policy=%s timeout=%" G_GUINT64_FORMAT " ", units, soft_max,
+      MAX (soft_max, hard_max), gst_client_policy_get_recover (),
+      (guint64) opts.client_disconnect_lag * GST_MSECOND * factor);
+}
+
+/**
+ * gst_client_policy_client_added:
+ *  @param sink the tcpserversink
+ *  @param socket the socket of the new client
+ *
+ * Invoked by the client-added handlers of the sinks.
+ */
+void
+gst_client_policy_client_added (GstElement * sink, GSocket * socket)
+{
+  gint port = 0;
+
+  g_object_get (sink, "current-port", &port, NULL);
+
+  INFO ("client %d connected to %d", g_socket_get_fd (socket), port);
+}
+
+/**
+ * gst_client_policy_client_removed:
+ *  @param sink the tcpserversink
+ *  @param socket the socket of the removed client
+ *  @param status why the client is removed, "slow" if it lagged too much
+ *
+ * Invoked on "client-removed" of the sinks, while the statistics of the
+ * client are still kept. The socket is closed later by the
+ * client-socket-removed handlers.
+ */
+void
+gst_client_policy_client_removed (GstElement * sink, GSocket * socket,
+    gint status, gpointer data)
+{
+  GstStructure *stats = NULL;
+  guint64 bytes = 0, dropped = 0, duration = 0;
+  gint port = 0;
+
+  g_return_if_fail (G_IS_SOCKET (socket));
+
+  g_object_get (sink, "current-port", &port, NULL);
+  g_signal_emit_by_name (sink, "get-stats", socket, &stats);
+  if (stats) {
+    gst_structure_get_uint64 (stats, "bytes-sent", &bytes);
+    gst_structure_get_uint64 (stats, "dropped-buffers", &dropped);
+    gst_structure_get_uint64 (stats, "connect-duration", &duration);
+    gst_structure_free (stats);
+  }
+
+  if (status < 0 || G_N_ELEMENTS (gst_client_policy_status_names) <=
+      (guint) status) {
+    status = 0;
+  }
+
+  INFO ("client %d of %d removed (%s): %" G_GUINT64_FORMAT " bytes in %"
+      G_GUINT64_FORMAT " ms, %" G_GUINT64_FORMAT " buffers dropped",
+      g_socket_get_fd (socket), port, gst_client_policy_status_names[status],
+      bytes, duration / GST_MSECOND, dropped);
+}
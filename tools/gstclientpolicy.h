@@ -0,0 +1,56 @@
+/* GstSwitch
+ * Copyright (C) 2012,2013 Duzy Chan <code@duzy.info>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*! @file */
+
+#ifndef __GST_CLIENT_POLICY_H__by_Duzy_Chan__
+#define __GST_CLIENT_POLICY_H__by_Duzy_Chan__ 1
+#include <gst/gst.h>
+#include <gio/gio.h>
+
+#define GST_CLIENT_POLICY_DEFAULT_MAX_LAG 500   /* ms */
+#define GST_CLIENT_POLICY_DEFAULT_DISCONNECT_LAG 5000   /* ms */
+#define GST_CLIENT_POLICY_BYTES_HARD_FACTOR 8
+#define GST_CLIENT_POLICY_ENCODE_FACTOR 4
+
+/**
+ *  GstClientRole:
+ *  @param GST_CLIENT_ROLE_PREVIEW the clients of a preview port
+ *  @param GST_CLIENT_ROLE_OUTPUT the clients of the composite output port
+ *  @param GST_CLIENT_ROLE_ENCODE the clients of the encoded output port
+ */
+typedef enum
+{
+  GST_CLIENT_ROLE_PREVIEW,
+  GST_CLIENT_ROLE_OUTPUT,
+  GST_CLIENT_ROLE_ENCODE,
+} GstClientRole;
+
+gchar *gst_client_policy_get_string (GstClientRole role);
+void gst_client_policy_client_added (GstElement * sink, GSocket * socket);
+void gst_client_policy_client_removed (GstElement * sink, GSocket * socket,
+    gint status, gpointer data);
+
+#endif //__GST_CLIENT_POLICY_H__by_Duzy_Chan__
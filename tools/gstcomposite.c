@@ -32,6 +32,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "gstswitchserver.h"
+#include "gstqueuepolicy.h"
 
 #define GST_COMPOSITE_LOCK(composite) (g_mutex_lock (&(composite)->lock))
 #define GST_COMPOSITE_UNLOCK(composite) (g_mutex_unlock (&(composite)->lock))
@@ -39,6 +40,10 @@
 #define GST_COMPOSITE_UNLOCK_TRANSITION(composite) (g_mutex_unlock (&(composite)->transition_lock))
 #define GST_COMPOSITE_LOCK_ADJUSTMENT(composite) (g_mutex_lock (&(composite)->adjustment_lock))
 #define GST_COMPOSITE_UNLOCK_ADJUSTMENT(composite) (g_mutex_unlock (&(composite)->adjustment_lock))
+#define GST_COMPOSITE_LOCK_BLEND(composite) (g_mutex_lock (&(composite)->blend_lock))
+#define GST_COMPOSITE_UNLOCK_BLEND(composite) (g_mutex_unlock (&(composite)->blend_lock))
+
+#define GST_COMPOSITE_BLEND_HOLD 200    /* ms */
 
 enum
 {
@@ -56,11 +61,13 @@ enum
   PROP_B_HEIGHT,
   PROP_WIDTH,
   PROP_HEIGHT,
+  PROP_FRAMERATE,
 };
 
 enum
 {
   SIGNAL_END_TRANSITION,
+  SIGNAL_END_BLEND,
   SIGNAL__LAST,                 /*!< @internal */
 };
 
@@ -76,6 +83,7 @@ G_DEFINE_TYPE (GstComposite, gst_composite, GST_TYPE_WORKER);
 
 static void gst_composite_set_mode (GstComposite *, GstCompositeMode);
 static void gst_composite_start_transition (GstComposite *);
+static gboolean gst_composite_close_blend (GstComposite *);
 
 /**
  * Initialize the GstComposite instance.
@@ -90,10 +98,25 @@ gst_composite_init (GstComposite * composite)
   composite->adjusting = FALSE;
   composite->transition = FALSE;
   composite->deprecated = FALSE;
+  composite->blending = FALSE;
+  composite->blend_layer = NULL;
+  composite->blend_pad = NULL;
+  composite->blend_dip = NULL;
+  composite->blend_box = -1;
+  composite->layout = NULL;
+  composite->num_boxes = 0;
+  composite->num_channels = 0;
+  composite->a_box = -1;
+  composite->b_box = -1;
 
   g_mutex_init (&composite->lock);
   g_mutex_init (&composite->transition_lock);
   g_mutex_init (&composite->adjustment_lock);
+  g_mutex_init (&composite->blend_lock);
+
+  composite->width = GST_SWITCH_COMPOSITE_DEFAULT_WIDTH;
+  composite->height = GST_SWITCH_COMPOSITE_DEFAULT_HEIGHT;
+  composite->framerate = GST_SWITCH_COMPOSITE_DEFAULT_FRAMERATE;
 
   gst_composite_set_mode (composite, DEFAULT_COMPOSE_MODE);
 
@@ -136,89 +159,125 @@ gst_composite_finalize (GstComposite * composite)
   g_mutex_clear (&composite->lock);
   g_mutex_clear (&composite->transition_lock);
   g_mutex_clear (&composite->adjustment_lock);
+  g_mutex_clear (&composite->blend_lock);
+
+  gst_layout_free (composite->layout);
 
   if (G_OBJECT_CLASS (parent_class)->finalize)
     (*G_OBJECT_CLASS (parent_class)->finalize) (G_OBJECT (composite));
 }
 
+/**
+ * gst_composite_compile_layout:
+ *
+ * Compile the current layout for the output size. The A/B positions are
+ * taken from the first box of each channel.
+ */
+static void
+gst_composite_compile_layout (GstComposite * composite)
+{
+  GstLayoutBox *box;
+  guint n;
+
+  composite->num_boxes = gst_layout_compile (composite->layout,
+      composite->width, composite->height, composite->boxes);
+
+  composite->num_channels = 0;
+  composite->a_box = composite->b_box = -1;
+  composite->a_x = composite->a_y = 0;
+  composite->a_width = composite->a_height = 0;
+  composite->b_x = composite->b_y = 0;
+  composite->b_width = composite->b_height = 0;
+
+  for (n = 0; n < composite->num_boxes; ++n) {
+    box = &composite->boxes[n];
+    if (composite->num_channels < box->channel - 'A' + 1)
+      composite->num_channels = box->channel - 'A' + 1;
+    if (box->channel == 'A' && composite->a_box < 0) {
+      composite->a_box = n;
+      composite->a_x = box->x;
+      composite->a_y = box->y;
+      composite->a_width = box->width;
+      composite->a_height = box->height;
+    } else if (box->channel == 'B' && composite->b_box < 0) {
+      composite->b_box = n;
+      composite->b_x = box->x;
+      composite->b_y = box->y;
+      composite->b_width = box->width;
+      composite->b_height = box->height;
+    }
+  }
+}
+
+/**
+ * gst_composite_apply_layout:
+ *
+ * Make @layout the current layout and start the transition to it.
+ */
+static void
+gst_composite_apply_layout (GstComposite * composite,
+    const GstLayout * layout)
+{
+  GstLayout *old = composite->layout;
+
+  composite->layout = gst_layout_copy (layout);
+  gst_layout_free (old);
+
+  gst_composite_compile_layout (composite);
+
+  /*
+     INFO ("new layout %s, %dx%d (%d boxes)", composite->layout->name,
+     composite->width, composite->height, composite->num_boxes);
+   */
+
+  gst_composite_start_transition (composite);
+}
+
+/**
+ * gst_composite_is_blending:
+ * @return TRUE if a channel is being blended.
+ *
+ * Read the blending state under the blend lock, it's cleared from the main
+ * loop while the streaming threads are running.
+ */
+static gboolean
+gst_composite_is_blending (GstComposite * composite)
+{
+  gboolean blending;
+
+  GST_COMPOSITE_LOCK_BLEND (composite);
+  blending = composite->blending;
+  GST_COMPOSITE_UNLOCK_BLEND (composite);
+  return blending;
+}
+
 /**
  * gst_composite_set_mode:
  *
- * Changing the composite mode.
+ * Changing the composite mode, that is applying the built-in layout of the
+ * mode.
  *
  * @see %GstCompositeMode
  */
 static void
 gst_composite_set_mode (GstComposite * composite, GstCompositeMode mode)
 {
+  const GstLayout *layout = gst_layout_get_builtin (mode);
+
   if (composite->transition) {
     WARN ("ignore changing mode in transition");
     return;
   }
 
-  composite->width = GST_SWITCH_COMPOSITE_DEFAULT_WIDTH;
-  composite->height = GST_SWITCH_COMPOSITE_DEFAULT_HEIGHT;
-
-  switch ((composite->mode = mode)) {
-    case COMPOSE_MODE_0:
-      composite->a_x = 0;
-      composite->a_y = 0;
-      composite->a_width = composite->width;
-      composite->a_height = composite->height;
-      composite->b_x = 0;
-      composite->b_y = 0;
-      composite->b_width = 0;
-      composite->b_height = 0;
-      composite->width = composite->a_width;
-      composite->height = composite->a_height;
-      break;
-    case COMPOSE_MODE_1:
-      composite->a_x = 0;
-      composite->a_y = 0;
-      composite->a_width = composite->width;
-      composite->a_height = composite->height;
-      composite->b_x = (guint) ((double) composite->a_width * 0.08 + 0.5);
-      composite->b_y = (guint) ((double) composite->a_height * 0.08 + 0.5);
-      composite->b_width = (guint) ((double) composite->a_width * 0.3 + 0.5);
-      composite->b_height = (guint) ((double) composite->a_height * 0.3 + 0.5);
-      composite->width = composite->a_width;
-      composite->height = composite->a_height;
-      break;
-    case COMPOSE_MODE_2:
-      composite->a_x = 0;
-      composite->a_y = 0;
-      composite->a_width = (guint) ((double) composite->width * 0.7 + 0.5);
-      composite->a_height = (guint) ((double) composite->height * 0.7 + 0.5);
-      composite->b_x = composite->a_width + 1;
-      composite->b_y = composite->a_y;
-      composite->b_width =
-          composite->width - composite->a_x - composite->a_width;
-      composite->b_height =
-          composite->height - composite->a_y - composite->a_height;
-      break;
-    case COMPOSE_MODE_3:
-      composite->a_width = (guint) ((double) composite->width * 0.5 + 0.5);
-      composite->a_height = (guint) ((double) composite->height * 0.5 + 0.5);
-      composite->a_x = 0;
-      composite->a_y = (composite->height - composite->a_height) / 2;
-      composite->b_x = composite->a_width + 1;
-      composite->b_y = composite->a_y;
-      composite->b_width =
-          composite->width - composite->a_x - composite->a_width;
-      composite->b_height = composite->a_height;
-      break;
-    default:
-      break;
+  if (gst_composite_is_blending (composite)) {
+    WARN ("ignore changing mode in blending");
+    return;
   }
 
-  /*
-     INFO ("new mode %d, %dx%d (%dx%d, %dx%d)", mode,
-     composite->width, composite->height,
-     composite->a_width, composite->a_height,
-     composite->b_width, composite->b_height);
-   */
+  g_return_if_fail (layout != NULL);
 
-  gst_composite_start_transition (composite);
+  composite->mode = mode;
+  gst_composite_apply_layout (composite, layout);
 }
 
 /**
@@ -299,6 +358,19 @@ gst_composite_set_property (GstComposite * composite, guint property_id,
     case PROP_B_HEIGHT:
       composite->b_height = g_value_get_uint (value);
       break;
+    case PROP_WIDTH:
+      composite->width = g_value_get_uint (value);
+      if (composite->layout)
+        gst_composite_compile_layout (composite);
+      break;
+    case PROP_HEIGHT:
+      composite->height = g_value_get_uint (value);
+      if (composite->layout)
+        gst_composite_compile_layout (composite);
+      break;
+    case PROP_FRAMERATE:
+      composite->framerate = g_value_get_uint (value);
+      break;
     case PROP_MODE:
     {
       guint mode = g_value_get_uint (value);
@@ -367,6 +439,9 @@ gst_composite_get_property (GstComposite * composite, guint property_id,
     case PROP_HEIGHT:
       g_value_set_uint (value, composite->height);
       break;
+    case PROP_FRAMERATE:
+      g_value_set_uint (value, composite->framerate);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (G_OBJECT (composite), property_id,
           pspec);
@@ -419,79 +494,50 @@ gst_composite_apply_parameters (GstComposite * composite)
 static GString *
 gst_composite_get_pipeline_string (GstComposite * composite)
 {
+  GstLayoutBox *box;
+  gchar alpha[G_ASCII_DTOSTR_BUF_SIZE];
   GString *desc;
+  gchar *queue;
+  guint n;
 
   desc = g_string_new ("");
 
-  g_string_append_printf (desc,
-      "intervideosrc name=source_a channel=composite_a_scaled ");
-  if (composite->mode == COMPOSE_MODE_0) {
-    g_string_append_printf (desc,
-        "source_a. ! video/x-raw,width=%d,height=%d ",
-        composite->a_width, composite->a_height);
-    /*
-       ASSESS ("assess-compose-a-source");
-     */
-    g_string_append_printf (desc, "! queue2 ");
-    g_string_append_printf (desc, "! identity name=mix ");
-  } else {
-    g_string_append_printf (desc,
-        "intervideosrc name=source_b channel=composite_b_scaled ");
+  /* every box is a mixer pad, scaled by the scaler */
+  g_string_append_printf (desc, "videomixer name=mix ");
+  for (n = 0; n < composite->num_boxes; ++n) {
+    box = &composite->boxes[n];
+    g_ascii_formatd (alpha, sizeof (alpha), "%.3f", box->alpha);
     g_string_append_printf (desc,
-        "videomixer name=mix "
-        "sink_0::xpos=%d "
-        "sink_0::ypos=%d "
-        "sink_0::zorder=0 "
-        "sink_1::xpos=%d "
-        "sink_1::ypos=%d "
-        "sink_1::zorder=1 ",
-        composite->a_x, composite->a_y, composite->b_x, composite->b_y);
-
-    // ===== B =====
-    g_string_append_printf (desc,
-        "source_b. ! video/x-raw,width=%d,height=%d ",
-        composite->b_width, composite->b_height);
-    ASSESS ("assess-compose-b-source");
-    g_string_append_printf (desc, "! queue2 ");
-#if 0
-    if (composite->width != composite->b_width ||
-        composite->height != composite->b_height) {
-      g_string_append_printf (desc,
-          "! videoscale ! video/x-raw,width=%d,height=%d ",
-          composite->b_width, composite->b_height);
-      /*
-         ASSESS ("assess-compose-b-scaled");
-       */
-    }
-#endif
-    g_string_append_printf (desc, "! mix.sink_1 ");
+        "sink_%d::xpos=%d "
+        "sink_%d::ypos=%d "
+        "sink_%d::zorder=%d "
+        "sink_%d::alpha=%s ",
+        n, box->x, n, box->y, n, box->zorder, n, alpha);
+  }
 
-    // ===== A =====
+  for (n = 0; n < composite->num_boxes; ++n) {
+    box = &composite->boxes[n];
     g_string_append_printf (desc,
-        "source_a. ! video/x-raw,width=%d,height=%d ",
-        composite->a_width, composite->a_height);
-    ASSESS ("assess-compose-a-source");
-    g_string_append_printf (desc, "! queue2 ");
-#if 0
-    if (composite->width != composite->a_width ||
-        composite->height != composite->a_height) {
-      g_string_append_printf (desc,
-          "! videoscale ! video/x-raw,width=%d,height=%d ",
-          composite->a_width, composite->a_height);
-      /*
-         ASSESS ("assess-compose-b-scaled");
-       */
-    }
-#endif
-    g_string_append_printf (desc, "! mix.sink_0 ");
+        "intervideosrc name=source_%d channel=composite_%d_scaled ", n, n);
+    g_string_append_printf (desc,
+        "source_%d. ! video/x-raw,width=%d,height=%d ",
+        n, box->width, box->height);
+    ASSESS ("assess-compose-%d-source", n);
+    queue = gst_queue_policy_get_string (GST_QUEUE_ROLE_COMPOSITE, NULL);
+    g_string_append_printf (desc, "! %s", queue);
+    g_free (queue);
+    g_string_append_printf (desc, "! mix.sink_%d ", n);
   }
 
-  g_string_append_printf (desc, "mix. ! video/x-raw,width=%d,height=%d ",
-      composite->width, composite->height);
+  g_string_append_printf (desc, "mix. ! video/x-raw,width=%d,height=%d,"
+      "framerate=%d/1 ", composite->width, composite->height,
+      composite->framerate);
   ASSESS ("assess-compose-result");
   g_string_append_printf (desc, "! tee name=result ");
 
-  g_string_append_printf (desc, "result. ! queue2 ");
+  queue = gst_queue_policy_get_string (GST_QUEUE_ROLE_PREVIEW, NULL);
+  g_string_append_printf (desc, "result. ! %s", queue);
+  g_free (queue);
   /*
      ASSESS ("assess-compose-to-output");
    */
@@ -500,7 +546,9 @@ gst_composite_get_pipeline_string (GstComposite * composite)
       "intervideosink name=out channel=composite_out ");
 
   if (opts.record_filename) {
-    g_string_append_printf (desc, "result. ! queue2 ");
+    queue = gst_queue_policy_get_string (GST_QUEUE_ROLE_RECORD, NULL);
+    g_string_append_printf (desc, "result. ! %s", queue);
+    g_free (queue);
     /*
        ASSESS ("assess-compose-to-record");
      */
@@ -512,6 +560,31 @@ gst_composite_get_pipeline_string (GstComposite * composite)
   return desc;
 }
 
+static gpointer
+gst_composite_find_scale_element (gpointer data)
+{
+  GstElementFactory *factory = gst_element_factory_find ("stripescale");
+  if (factory) {
+    gst_object_unref (factory);
+    return (gpointer) "stripescale";
+  }
+  return (gpointer) "videoscale";
+}
+
+/**
+ * gst_composite_get_scale_element:
+ * @return the name of the video scaling element
+ *
+ * The stripescale element of the gstswitch plugin scales every frame in
+ * parallel stripes, videoscale is used when the plugin is not installed.
+ */
+const gchar *
+gst_composite_get_scale_element (void)
+{
+  static GOnce once = G_ONCE_INIT;
+  return g_once (&once, gst_composite_find_scale_element, NULL);
+}
+
 /**
  * gst_composite_get_scaler_string:
  *
@@ -524,39 +597,45 @@ gst_composite_get_pipeline_string (GstComposite * composite)
 static GString *
 gst_composite_get_scaler_string (GstWorker * worker, GstComposite * composite)
 {
+  GstLayoutBox *box;
   GString *desc;
+  gchar *queue;
+  guint n;
 
   desc = g_string_new ("");
 
-  g_string_append_printf (desc,
-      "intervideosrc name=source_a channel=composite_a ");
-  g_string_append_printf (desc,
-      "intervideosink name=sink_a sync=false channel=composite_a_scaled ");
-
-  g_string_append_printf (desc,
-      "source_a. ! video/x-raw,width=%d,height=%d ",
-      composite->width, composite->height);
-  g_string_append_printf (desc,
-      "! queue2 ! videoscale ! video/x-raw,width=%d,height=%d ! sink_a. ",
-      composite->a_width, composite->a_height);
-
-  if (composite->mode == COMPOSE_MODE_0) {
-  } else {
-    g_string_append_printf (desc,
-        "intervideosrc name=source_b channel=composite_b ");
-    g_string_append_printf (desc,
-        "intervideosink name=sink_b sync=false channel=composite_b_scaled ");
-
+  for (n = 0; n < composite->num_boxes; ++n) {
+    box = &composite->boxes[n];
     g_string_append_printf (desc,
-        "source_b. ! video/x-raw,width=%d,height=%d ",
-        composite->width, composite->height);
+        "intervideosrc name=source_%d channel=composite_%c ", n,
+        g_ascii_tolower (box->channel));
     g_string_append_printf (desc,
-        "! queue2 ! videoscale ! video/x-raw,width=%d,height=%d ! sink_b. ",
-        composite->b_width, composite->b_height);
+        "intervideosink name=sink_%d sync=true channel=composite_%d_scaled ",
+        n, n);
+
+    /* inputs may still be normalised to a former output format */
+    queue = gst_queue_policy_get_string (GST_QUEUE_ROLE_COMPOSITE, NULL);
+    g_string_append_printf (desc, "source_%d. ! video/x-raw ", n);
+    g_string_append_printf (desc, "! %s! videorate ! %s "
+        "! video/x-raw,width=%d,height=%d,framerate=%d/1 ! sink_%d. ",
+        queue, gst_composite_get_scale_element (), box->width, box->height,
+        composite->framerate, n);
+    g_free (queue);
   }
   return desc;
 }
 
+/**
+ * gst_composite_prepare_scaler:
+ *
+ * Invoked when the scaler pipeline is prepared.
+ */
+static void
+gst_composite_prepare_scaler (GstWorker * scaler, GstComposite * composite)
+{
+  gst_queue_policy_watch (scaler->pipeline);
+}
+
 /**
  * gst_composite_prepare:
  * @return TRUE if the composite pipeline is well prepared.
@@ -568,12 +647,16 @@ gst_composite_prepare (GstComposite * composite)
 {
   g_return_val_if_fail (GST_IS_COMPOSITE (composite), FALSE);
 
+  gst_queue_policy_watch (GST_WORKER (composite)->pipeline);
+
   if (composite->scaler == NULL) {
     composite->scaler = GST_WORKER (g_object_new (GST_TYPE_WORKER,
             "name", "scale", NULL));
     composite->scaler->pipeline_func_data = composite;
     composite->scaler->pipeline_func = (GstWorkerGetPipelineString)
         gst_composite_get_scaler_string;
+    g_signal_connect (composite->scaler, "prepare-worker",
+        G_CALLBACK (gst_composite_prepare_scaler), composite);
   } else {
     GstWorkerClass *worker_class;
     worker_class = GST_WORKER_CLASS (G_OBJECT_GET_CLASS (composite->scaler));
@@ -781,9 +864,76 @@ gst_composite_null (GstComposite * composite)
         composite);
   }
 
+  if (gst_composite_is_blending (composite)) {
+    /* The blending is aborted with the pipeline. */
+    g_idle_add ((GSourceFunc) gst_composite_close_blend, composite);
+  }
+
   return composite->deprecated ? GST_WORKER_NR_END : GST_WORKER_NR_REPLAY;
 }
 
+/**
+ * gst_composite_set_format:
+ *  @param composite The GstComposite instance
+ *  @param width the output width
+ *  @param height the output height
+ *  @param framerate the output frames per second
+ *  @return TRUE if the new format is being applied
+ *
+ *  Change the output format. The layout of the current mode is derived
+ *  from the new size and the composite pipeline is restarted, the
+ *  "end-transition" signal is emitted when it's done.
+ */
+gboolean
+gst_composite_set_format (GstComposite * composite, guint width,
+    guint height, guint framerate)
+{
+  g_return_val_if_fail (GST_IS_COMPOSITE (composite), FALSE);
+
+  if (width < GST_SWITCH_COMPOSITE_MIN_PIP_W ||
+      height < GST_SWITCH_COMPOSITE_MIN_PIP_H ||
+      framerate < 1 || GST_SWITCH_COMPOSITE_MAX_FRAMERATE < framerate) {
+    WARN ("invalid output format %ux%u@%u", width, height, framerate);
+    return FALSE;
+  }
+
+  if (composite->transition || gst_composite_is_blending (composite)) {
+    WARN ("ignore changing format in transition");
+    return FALSE;
+  }
+
+  composite->width = width;
+  composite->height = height;
+  composite->framerate = framerate;
+  gst_composite_apply_layout (composite, composite->layout);
+  return composite->transition;
+}
+
+/**
+ * gst_composite_set_layout:
+ *  @param composite The GstComposite instance
+ *  @param layout the new layout
+ *  @return TRUE if the new layout is being applied
+ *
+ *  Change the layout. The layout is compiled for the output size and the
+ *  composite pipeline is restarted with a mixer pad per box, the
+ *  "end-transition" signal is emitted when it's done.
+ */
+gboolean
+gst_composite_set_layout (GstComposite * composite, const GstLayout * layout)
+{
+  g_return_val_if_fail (GST_IS_COMPOSITE (composite), FALSE);
+  g_return_val_if_fail (layout != NULL, FALSE);
+
+  if (composite->transition || gst_composite_is_blending (composite)) {
+    WARN ("ignore changing layout in transition");
+    return FALSE;
+  }
+
+  gst_composite_apply_layout (composite, layout);
+  return composite->transition;
+}
+
 /**
  * gst_composite_adjust_pip:
  *  @param composite The GstComposite instance
@@ -804,27 +954,41 @@ gst_composite_adjust_pip (GstComposite * composite, gint x, gint y,
   GValue value = { 0 };
   GstElement *element = NULL;
   gboolean done = FALSE;
+  GstLayoutBox *box;
+  gchar *name;
 
   g_return_val_if_fail (GST_IS_COMPOSITE (composite), FALSE);
 
   GST_COMPOSITE_LOCK (composite);
+  if (composite->b_box < 0) {
+    WARN ("no PIP in layout %s", composite->layout->name);
+    goto end;
+  }
+
   if (composite->adjusting) {
     WARN ("last PIP adjustment request is progressing");
     goto end;
   }
 
-  composite->b_x = x;
-  composite->b_y = y;
+  if (gst_composite_is_blending (composite)) {
+    WARN ("can't adjust PIP in blending");
+    goto end;
+  }
+
+  box = &composite->boxes[composite->b_box];
+  composite->b_x = box->x = x;
+  composite->b_y = box->y = y;
 
   if (composite->b_width != w || composite->b_height != h) {
-    composite->b_width = w;
-    composite->b_height = h;
+    composite->b_width = box->width = w;
+    composite->b_height = box->height = h;
     composite->adjusting = TRUE;
     gst_worker_stop (GST_WORKER (composite));
     result = TRUE;
     goto end;
   }
 
+  name = g_strdup_printf ("sink_%d", composite->b_box);
   element = gst_worker_get_element (GST_WORKER (composite), "mix");
   iter = gst_element_iterate_sink_pads (element);
   while (iter && !done) {
@@ -832,7 +996,7 @@ gst_composite_adjust_pip (GstComposite * composite, gint x, gint y,
       case GST_ITERATOR_OK:
       {
         GstPad *pad = g_value_get_object (&value);
-        if (g_strcmp0 (gst_pad_get_name (pad), "sink_1") == 0) {
+        if (g_strcmp0 (GST_PAD_NAME (pad), name) == 0) {
           g_object_set (pad, "xpos", composite->b_x,
               "ypos", composite->b_y, NULL);
           done = TRUE;
@@ -860,6 +1024,7 @@ gst_composite_adjust_pip (GstComposite * composite, gint x, gint y,
     g_value_unset (&value);
   if (iter)
     gst_iterator_free (iter);
+  g_free (name);
 
   composite->adjusting = FALSE;
 
@@ -874,6 +1039,311 @@ end:
   return result;
 }
 
+/**
+ * gst_composite_apply_blend:
+ *
+ * Apply the blending effect of @progress (0.0 to 1.0) to the mixer pads.
+ * The mixer does the actual alpha blending of the frames.
+ *
+ * Requires the blend lock.
+ */
+static void
+gst_composite_apply_blend (GstComposite * composite, gdouble progress)
+{
+  GstLayoutBox *box = &composite->boxes[composite->blend_box];
+  gint x = box->x;
+
+  switch (composite->blend) {
+    case COMPOSITE_BLEND_CROSSFADE:
+      g_object_set (composite->blend_pad, "alpha", progress * box->alpha,
+          NULL);
+      break;
+    case COMPOSITE_BLEND_WIPE:
+      /* A enters from the left edge, the others from the right edge. */
+      if (composite->blend_channel == 'A') {
+        x -= (gint) ((1.0 - progress) * box->width);
+      } else {
+        x += (gint) ((1.0 - progress) * box->width);
+      }
+      g_object_set (composite->blend_pad, "xpos", x, "ypos", box->y,
+          "alpha", box->alpha, NULL);
+      break;
+    case COMPOSITE_BLEND_DIP:
+      /* The layer is black behind the new source, it covers the old one
+       * first, then the new source is faded in from black. */
+      if (progress < 0.5) {
+        g_object_set (composite->blend_pad, "alpha", progress * 2 * box->alpha,
+            NULL);
+        g_object_set (composite->blend_dip, "alpha", 0.0, NULL);
+      } else {
+        g_object_set (composite->blend_pad, "alpha", box->alpha, NULL);
+        g_object_set (composite->blend_dip, "alpha", progress * 2 - 1.0, NULL);
+      }
+      break;
+  }
+}
+
+/**
+ * gst_composite_close_blend:
+ * @return Always FALSE to allow glib to cleanup the timeout source
+ *
+ * Remove the blending layer from the mixer, the blended channel is showing
+ * the new source by now.
+ */
+static gboolean
+gst_composite_close_blend (GstComposite * composite)
+{
+  GstElement *layer, *mix, *parent;
+  GstPad *pad, *srcpad;
+
+  g_return_val_if_fail (GST_IS_COMPOSITE (composite), FALSE);
+
+  GST_COMPOSITE_LOCK_BLEND (composite);
+  layer = composite->blend_layer;
+  pad = composite->blend_pad;
+  if (!layer) {
+    GST_COMPOSITE_UNLOCK_BLEND (composite);
+    return FALSE;
+  }
+  composite->blend_layer = NULL;
+  composite->blend_pad = NULL;
+  if (composite->blend_dip) {
+    gst_object_unref (composite->blend_dip);
+    composite->blend_dip = NULL;
+  }
+  GST_COMPOSITE_UNLOCK_BLEND (composite);
+
+  /* The layer is stopped first, the probe may be waiting for the lock. */
+  gst_element_set_state (layer, GST_STATE_NULL);
+
+  srcpad = gst_element_get_static_pad (layer, "src");
+  gst_pad_unlink (srcpad, pad);
+  gst_object_unref (srcpad);
+
+  mix = GST_ELEMENT (gst_object_get_parent (GST_OBJECT (pad)));
+  if (mix) {
+    gst_element_release_request_pad (mix, pad);
+    gst_object_unref (mix);
+  }
+
+  parent = GST_ELEMENT (gst_object_get_parent (GST_OBJECT (layer)));
+  if (parent) {
+    gst_bin_remove (GST_BIN (parent), layer);
+    gst_object_unref (parent);
+  }
+
+  gst_object_unref (pad);
+  gst_object_unref (layer);
+
+  GST_COMPOSITE_LOCK_BLEND (composite);
+  composite->blending = FALSE;
+  GST_COMPOSITE_UNLOCK_BLEND (composite);
+
+  INFO ("blended %d into %c", composite->blend_port,
+      (gchar) composite->blend_channel);
+  return FALSE;
+}
+
+/**
+ * gst_composite_end_blend:
+ * @return Always FALSE to allow glib to cleanup the idle source
+ *
+ * Invoked when the last blended frame is composed. The "end-blend" signal
+ * makes the new source the input of the channel, the layer is kept for a
+ * while until the new input reaches the mixer.
+ */
+static gboolean
+gst_composite_end_blend (GstComposite * composite)
+{
+  g_return_val_if_fail (GST_IS_COMPOSITE (composite), FALSE);
+
+  g_signal_emit (composite, gst_composite_signals[SIGNAL_END_BLEND], 0,
+      composite->blend_channel, composite->blend_port);
+
+  /* It's ok to discard the source ID here, the timeout is one-shot. */
+  g_timeout_add (GST_COMPOSITE_BLEND_HOLD,
+      (GSourceFunc) gst_composite_close_blend, composite);
+  return FALSE;
+}
+
+/**
+ * gst_composite_blend_probe:
+ *
+ * Drive the blending by the timestamps of the new source, so the effect
+ * advances exactly once per frame.
+ */
+static GstPadProbeReturn
+gst_composite_blend_probe (GstPad * pad, GstPadProbeInfo * info,
+    GstComposite * composite)
+{
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  GstClockTime pts = GST_BUFFER_PTS (buffer);
+  gdouble progress = 1.0;
+
+  if (!GST_CLOCK_TIME_IS_VALID (pts))
+    return GST_PAD_PROBE_OK;
+
+  GST_COMPOSITE_LOCK_BLEND (composite);
+  if (!composite->blend_pad || composite->blend_done)
+    goto end;
+
+  if (!GST_CLOCK_TIME_IS_VALID (composite->blend_start))
+    composite->blend_start = pts;
+
+  if (pts < composite->blend_start + composite->blend_duration)
+    progress = (gdouble) (pts - composite->blend_start) /
+        composite->blend_duration;
+
+  gst_composite_apply_blend (composite, progress);
+
+  if (1.0 <= progress) {
+    composite->blend_done = TRUE;
+    g_idle_add ((GSourceFunc) gst_composite_end_blend, composite);
+  }
+
+end:
+  GST_COMPOSITE_UNLOCK_BLEND (composite);
+  return GST_PAD_PROBE_OK;
+}
+
+/**
+ * gst_composite_start_blend:
+ *  @param composite The GstComposite instance
+ *  @param channel the channel to blend, 'A' to 'I'
+ *  @param port the port of the new source
+ *  @param blend the blending effect
+ *  @param duration the duration of the blending in milliseconds
+ *  @return TRUE if the blending is started
+ *
+ *  Blend the new source of @port into the channel. The new source is mixed
+ *  as an extra layer only while blending, and the "end-blend" signal is
+ *  emitted when it's fully shown. Nothing is added to the mixer when not
+ *  blending.
+ */
+gboolean
+gst_composite_start_blend (GstComposite * composite, gint channel,
+    gint port, GstCompositeBlend blend, guint duration)
+{
+  GstWorker *worker = GST_WORKER (composite);
+  GstElement *layer = NULL, *mix = NULL;
+  GstPad *srcpad = NULL;
+  GError *error = NULL;
+  gboolean result = FALSE;
+  GstLayoutBox *box;
+  gchar *desc, *queue;
+  guint n;
+
+  g_return_val_if_fail (GST_IS_COMPOSITE (composite), FALSE);
+
+  GST_COMPOSITE_LOCK (composite);
+  if (composite->transition || composite->adjusting ||
+      gst_composite_is_blending (composite)) {
+    WARN ("can't blend while the composite is changing");
+    goto end;
+  }
+
+  for (n = 0; n < composite->num_boxes; ++n) {
+    if (composite->boxes[n].channel == channel)
+      break;
+  }
+  if (composite->num_boxes <= n) {
+    WARN ("can't blend channel %c in layout %s", (gchar) channel,
+        composite->layout->name);
+    goto end;
+  }
+  box = &composite->boxes[n];
+
+  queue = gst_queue_policy_get_string (GST_QUEUE_ROLE_COMPOSITE, NULL);
+  /* dipping mixes the new source over black inside the layer */
+  desc = g_strdup_printf ("intervideosrc channel=input_%d "
+      "! video/x-raw ! videorate ! %s "
+      "! video/x-raw,width=%d,height=%d,framerate=%d/1 %s! %s", port,
+      gst_composite_get_scale_element (), box->width, box->height,
+      composite->framerate,
+      blend == COMPOSITE_BLEND_DIP ?
+      "! videomixer name=dip background=black sink_0::alpha=0.0 " : "",
+      queue);
+  layer = gst_parse_bin_from_description (desc, TRUE, &error);
+  g_free (queue);
+  g_free (desc);
+  if (error) {
+    ERROR ("%s: blending layer: %s", worker->name, error->message);
+    g_error_free (error);
+    if (layer)
+      gst_object_unref (layer);
+    goto end;
+  }
+
+  gst_queue_policy_watch (layer);
+  gst_worker_align_sources (layer);
+
+  mix = gst_worker_get_element (worker, "mix");
+  if (!mix) {
+    gst_object_unref (layer);
+    goto end;
+  }
+
+  GST_COMPOSITE_LOCK_BLEND (composite);
+  composite->blend = blend;
+  composite->blend_channel = channel;
+  composite->blend_port = port;
+  composite->blend_duration = duration * GST_MSECOND;
+  composite->blend_start = GST_CLOCK_TIME_NONE;
+  composite->blend_done = FALSE;
+  composite->blend_box = n;
+  composite->blend_dip = NULL;
+  if (blend == COMPOSITE_BLEND_DIP) {
+    GstElement *dip = gst_bin_get_by_name (GST_BIN (layer), "dip");
+    if (dip) {
+      composite->blend_dip = gst_element_get_static_pad (dip, "sink_0");
+      gst_object_unref (dip);
+    }
+  }
+  composite->blend_pad = gst_element_get_request_pad (mix, "sink_%u");
+  if (!composite->blend_pad ||
+      (blend == COMPOSITE_BLEND_DIP && !composite->blend_dip)) {
+    ERROR ("%s: no mixer pad for blending", worker->name);
+    if (composite->blend_pad) {
+      gst_element_release_request_pad (mix, composite->blend_pad);
+      gst_object_unref (composite->blend_pad);
+      composite->blend_pad = NULL;
+    }
+    if (composite->blend_dip) {
+      gst_object_unref (composite->blend_dip);
+      composite->blend_dip = NULL;
+    }
+    GST_COMPOSITE_UNLOCK_BLEND (composite);
+    gst_object_unref (layer);
+    gst_object_unref (mix);
+    goto end;
+  }
+  /* the layer is right above the box, in the gap left by the layout */
+  g_object_set (composite->blend_pad, "xpos", box->x, "ypos", box->y,
+      "zorder", box->zorder + 1, "alpha", 0.0, NULL);
+
+  gst_object_ref (layer);
+  gst_bin_add (GST_BIN (GST_OBJECT_PARENT (mix)), layer);
+  srcpad = gst_element_get_static_pad (layer, "src");
+  gst_pad_link (srcpad, composite->blend_pad);
+  gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_BUFFER,
+      (GstPadProbeCallback) gst_composite_blend_probe, composite, NULL);
+  gst_object_unref (srcpad);
+  composite->blend_layer = layer;
+  composite->blending = TRUE;
+  GST_COMPOSITE_UNLOCK_BLEND (composite);
+
+  gst_element_sync_state_with_parent (layer);
+  gst_object_unref (mix);
+
+  INFO ("blending %d into %c (%d, %d ms)", port, (gchar) channel, blend,
+      duration);
+  result = TRUE;
+
+end:
+  GST_COMPOSITE_UNLOCK (composite);
+  return result;
+}
+
 /**
  * gst_composite_retry_transition:
  * @return Always FALSE to allow glib to cleanup the timeout source
@@ -1013,6 +1483,13 @@ gst_composite_class_init (GstCompositeClass * klass)
           end_transition), NULL,
       NULL, g_cclosure_marshal_generic, G_TYPE_NONE, 0 /*1, G_TYPE_INT */ );
 
+  gst_composite_signals[SIGNAL_END_BLEND] =
+      g_signal_new ("end-blend", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (GstCompositeClass,
+          end_blend), NULL,
+      NULL, g_cclosure_marshal_generic, G_TYPE_NONE, 2, G_TYPE_INT,
+      G_TYPE_INT);
+
   g_object_class_install_property (object_class, PROP_MODE,
       g_param_spec_uint ("mode", "Mode",
           "Composite Mode",
@@ -1087,18 +1564,26 @@ gst_composite_class_init (GstCompositeClass * klass)
   g_object_class_install_property (object_class, PROP_WIDTH,
       g_param_spec_uint ("width",
           "Composite Width",
-          "Output frame width", 1,
+          "Output frame width, applied with the next mode", 1,
           G_MAXINT,
           GST_SWITCH_COMPOSITE_DEFAULT_WIDTH,
-          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (object_class, PROP_HEIGHT,
       g_param_spec_uint ("height",
           "Composite Height",
-          "Output frame height",
+          "Output frame height, applied with the next mode",
           1, G_MAXINT,
           GST_SWITCH_COMPOSITE_DEFAULT_HEIGHT,
-          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_FRAMERATE,
+      g_param_spec_uint ("framerate",
+          "Composite Framerate",
+          "Output frames per second, applied with the next mode",
+          1, GST_SWITCH_COMPOSITE_MAX_FRAMERATE,
+          GST_SWITCH_COMPOSITE_DEFAULT_FRAMERATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   worker_class->alive = (GstWorkerAliveFunc) gst_composite_alive;
   worker_class->null = (GstWorkerNullFunc) gst_composite_null;
@@ -28,6 +28,7 @@
 #ifndef __GST_COMPOSITE_H__by_Duzy_Chan__
 #define __GST_COMPOSITE_H__by_Duzy_Chan__ 1
 #include "gstworker.h"
+#include "gstlayout.h"
 
 #define GST_TYPE_COMPOSITE (gst_composite_get_type ())
 #define GST_COMPOSITE(object) (G_TYPE_CHECK_INSTANCE_CAST ((object), GST_TYPE_COMPOSITE, GstComposite))
@@ -47,6 +48,10 @@
 #define GST_SWITCH_COMPOSITE_MIN_PIP_H		240
 #endif
 
+#define GST_SWITCH_COMPOSITE_DEFAULT_FRAMERATE	30
+#define GST_SWITCH_COMPOSITE_MAX_FRAMERATE	120
+#define GST_SWITCH_COMPOSITE_FORMAT		"I420"
+
 #define DEFAULT_COMPOSE_MODE COMPOSE_MODE_3
 
 /**
@@ -61,6 +66,19 @@ typedef enum
   COMPOSE_MODE__LAST = COMPOSE_MODE_3
 } GstCompositeMode;
 
+#define GST_COMPOSITE_MAX_BLEND_DURATION 10000  /* ms */
+
+/**
+ *  @enum GstCompositeBlend:
+ */
+typedef enum
+{
+  COMPOSITE_BLEND_CROSSFADE,    /*!< fade the new source in over the old one */
+  COMPOSITE_BLEND_WIPE,         /*!< slide the new source in from the edge */
+  COMPOSITE_BLEND_DIP,          /*!< fade to black, then fade the new source in */
+  COMPOSITE_BLEND__LAST = COMPOSITE_BLEND_DIP
+} GstCompositeBlend;
+
 typedef struct _GstComposite GstComposite;
 typedef struct _GstCompositeClass GstCompositeClass;
 
@@ -68,31 +86,59 @@ typedef struct _GstCompositeClass GstCompositeClass;
  *  @brief The GstComposite class.
  *  @param base the parent object
  *  @param mode the composite mode, @see GstCompositeMode
+ *  @param layout the current layout, the built-in layout of %mode unless
+ *         another one is set
+ *  @param num_boxes the number of boxes of %layout
+ *  @param num_channels the number of channels shown by %layout, 'A' up to
+ *         the last channel of its boxes
+ *  @param boxes the boxes of %layout compiled for the output size
+ *  @param a_box the index of the first box of channel A, -1 if none
+ *  @param b_box the index of the first box of channel B (the PIP), -1 if
+ *         none
  *  @param lock lock for composite object
  *  @param transition_lock lock for transition of modes 
  *  @param adjustment_lock lock for PIP adjustment
  *  @param sink_port sink port number
  *  @param encode_sink_port encode port number
- *  @param a_x X position of A video
+ *  @param a_x X position of A video (of %a_box)
  *  @param a_y Y position of A video
  *  @param a_width width of A video
  *  @param a_height height of A video
- *  @param b_x X position of B video
+ *  @param b_x X position of B video (of %b_box)
  *  @param b_y Y position of B video
  *  @param b_width width of B video
  *  @param b_height height of B video
  *  @param width output width
  *  @param height output height
+ *  @param framerate output frames per second
  *  @param adjusting the status of adjusting PIP
  *  @param transition the status of transiting modes
  *  @param deprecated (deprecated)
  *  @param scaler the scaller for A/B videos
+ *  @param blend_lock lock for the blending states
+ *  @param blending TRUE if the switch of a channel is being blended
+ *  @param blend the blending effect, @see GstCompositeBlend
+ *  @param blend_channel the channel being blended, 'A' to 'I'
+ *  @param blend_port the port being blended in
+ *  @param blend_duration the duration of the blending
+ *  @param blend_start the stream time of the first blended frame
+ *  @param blend_done TRUE if the last blended frame is composed
+ *  @param blend_layer the bin feeding the new source into the mixer
+ *  @param blend_pad the mixer pad of %blend_layer
+ *  @param blend_dip the pad of the new source in the black dipping mixer
+ *  @param blend_box the box of the blended channel
  */
 struct _GstComposite
 {
   GstWorker base;
 
   GstCompositeMode mode;
+  GstLayout *layout;
+  guint num_boxes;
+  guint num_channels;
+  GstLayoutBox boxes[GST_LAYOUT_MAX_SLOTS];
+  gint a_box;
+  gint b_box;
 
   GMutex lock;
   GMutex transition_lock;
@@ -112,28 +158,51 @@ struct _GstComposite
 
   guint width;
   guint height;
+  guint framerate;
 
   gboolean adjusting;
   gboolean transition;
   gboolean deprecated;
 
   GstWorker *scaler;
+
+  GMutex blend_lock;
+  gboolean blending;
+  GstCompositeBlend blend;
+  gint blend_channel;
+  gint blend_port;
+  GstClockTime blend_duration;
+  GstClockTime blend_start;
+  gboolean blend_done;
+  GstElement *blend_layer;
+  GstPad *blend_pad;
+  GstPad *blend_dip;
+  gint blend_box;
 };
 
 /**
  *  GstCompositeClass:
  *  @param base_class the parent class
  *  @param end_transition signal handler of "end-transition"
+ *  @param end_blend signal handler of "end-blend"
  */
 struct _GstCompositeClass
 {
   GstWorkerClass base_class;
 
   void (*end_transition) (GstComposite * composite);
+  void (*end_blend) (GstComposite * composite, gint channel, gint port);
 };
 
 GType gst_composite_get_type (void);
+gboolean gst_composite_set_layout (GstComposite * composite,
+    const GstLayout * layout);
+gboolean gst_composite_set_format (GstComposite * composite, guint width,
+    guint height, guint framerate);
 gboolean gst_composite_adjust_pip (GstComposite * composite,
     gint x, gint y, gint w, gint h);
+gboolean gst_composite_start_blend (GstComposite * composite, gint channel,
+    gint port, GstCompositeBlend blend, guint duration);
+const gchar *gst_composite_get_scale_element (void);
 
 #endif //__GST_COMPOSITE_H__by_Duzy_Chan__
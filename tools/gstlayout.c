@@ -0,0 +1,327 @@
+/* GstSwitch
+ * Copyright (C) 2012,2013 Duzy Chan <code@duzy.info>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*! @file */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include "gstlayout.h"
+#include "../logutils.h"
+
+/**
+ * The built-in layouts, indexed by the composite mode.
+ */
+static const GstLayout gst_layout_builtins[] = {
+  {(gchar *) "none", 1, {
+          {'A', 0.0, 0.0, 1.0, 1.0, 0, 1.0}}},
+  {(gchar *) "pip", 2, {
+          {'A', 0.0, 0.0, 1.0, 1.0, 0, 1.0},
+          {'B', 0.08, 0.08, 0.3, 0.3, 1, 1.0}}},
+  {(gchar *) "preview", 2, {
+          {'A', 0.0, 0.0, 0.7, 0.7, 0, 1.0},
+          {'B', 0.7, 0.0, 0.3, 0.3, 1, 1.0}}},
+  {(gchar *) "equal", 2, {
+          {'A', 0.0, 0.25, 0.5, 0.5, 0, 1.0},
+          {'B', 0.5, 0.25, 0.5, 0.5, 1, 1.0}}},
+};
+
+#define T (1.0 / 3)
+
+/**
+ * The built-in panel layouts, showing more than two channels.
+ */
+static const GstLayout gst_layout_panels[] = {
+  {(gchar *) "grid-2x2", 4, {
+          {'A', 0.0, 0.0, 0.5, 0.5, 0, 1.0},
+          {'B', 0.5, 0.0, 0.5, 0.5, 0, 1.0},
+          {'C', 0.0, 0.5, 0.5, 0.5, 0, 1.0},
+          {'D', 0.5, 0.5, 0.5, 0.5, 0, 1.0}}},
+  {(gchar *) "1+3", 4, {
+          {'A', 0.0, 0.125, 0.75, 0.75, 0, 1.0},
+          {'B', 0.75, 0.125, 0.25, 0.25, 0, 1.0},
+          {'C', 0.75, 0.375, 0.25, 0.25, 0, 1.0},
+          {'D', 0.75, 0.625, 0.25, 0.25, 0, 1.0}}},
+  {(gchar *) "grid-3x3", 9, {
+          {'A', 0.0, 0.0, T, T, 0, 1.0},
+          {'B', T, 0.0, T, T, 0, 1.0},
+          {'C', 2 * T, 0.0, T, T, 0, 1.0},
+          {'D', 0.0, T, T, T, 0, 1.0},
+          {'E', T, T, T, T, 0, 1.0},
+          {'F', 2 * T, T, T, T, 0, 1.0},
+          {'G', 0.0, 2 * T, T, T, 0, 1.0},
+          {'H', T, 2 * T, T, T, 0, 1.0},
+          {'I', 2 * T, 2 * T, T, T, 0, 1.0}}},
+};
+
+#undef T
+
+/**
+ * The layouts loaded from the layout file. It's only changed at startup,
+ * before any composite is created, so it needs no lock.
+ */
+static GList *gst_layout_list = NULL;
+
+/**
+ * gst_layout_parse_slot:
+ * @return TRUE if @value describes a valid slot
+ *
+ * Parse a slot value "CHANNEL;X;Y;WIDTH;HEIGHT[;ZORDER[;ALPHA]]".
+ */
+static gboolean
+gst_layout_parse_slot (gchar ** value, gsize length, guint index,
+    GstLayoutSlot * slot)
+{
+  gdouble v[4];
+  gchar *end;
+  gint n;
+
+  if (length < 5 || 7 < length)
+    return FALSE;
+
+  g_strstrip (value[0]);
+  if (strlen (value[0]) != 1)
+    return FALSE;
+  slot->channel = g_ascii_toupper (value[0][0]);
+  if (slot->channel < 'A' || 'A' + GST_CASE_MAX_CHANNELS <= slot->channel)
+    return FALSE;
+
+  for (n = 0; n < 4; ++n) {
+    v[n] = g_ascii_strtod (value[n + 1], &end);
+    if (end == value[n + 1] || v[n] < 0.0 || 1.0 < v[n])
+      return FALSE;
+  }
+  slot->x = v[0], slot->y = v[1];
+  slot->width = v[2], slot->height = v[3];
+  if (slot->width <= 0.0 || slot->height <= 0.0 ||
+      1.0 < slot->x + slot->width || 1.0 < slot->y + slot->height)
+    return FALSE;
+
+  slot->zorder = index;
+  if (5 < length) {
+    guint64 z = g_ascii_strtoull (value[5], &end, 10);
+    if (end == value[5] || GST_LAYOUT_MAX_SLOTS <= z)
+      return FALSE;
+    slot->zorder = (guint) z;
+  }
+
+  slot->alpha = 1.0;
+  if (6 < length) {
+    slot->alpha = g_ascii_strtod (value[6], &end);
+    if (end == value[6] || slot->alpha < 0.0 || 1.0 < slot->alpha)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+/**
+ * gst_layout_load:
+ *  @param filename the layout file
+ *  @param error the error if it's failed
+ *  @return TRUE if all layouts in the file are loaded
+ *
+ *  Load the layouts of a key file. Each group is a layout and each key of a
+ *  group is a slot, in the form "CHANNEL;X;Y;WIDTH;HEIGHT[;ZORDER[;ALPHA]]"
+ *  where positions and sizes are fractions of the output size, e.g.
+ *
+ *      [side-by-side]
+ *      left=A;0;0.25;0.5;0.5
+ *      right=B;0.5;0.25;0.5;0.5;1;0.8
+ *
+ *  This is only called at startup.
+ */
+gboolean
+gst_layout_load (const gchar * filename, GError ** error)
+{
+  GKeyFile *file = g_key_file_new ();
+  gchar **groups = NULL, **keys = NULL, **value = NULL;
+  GList *layouts = NULL;
+  GstLayout *layout;
+  gsize length, n, k;
+  gboolean result = FALSE;
+
+  if (!g_key_file_load_from_file (file, filename, G_KEY_FILE_NONE, error))
+    goto end;
+
+  groups = g_key_file_get_groups (file, NULL);
+  for (n = 0; groups[n]; ++n) {
+    if (gst_layout_lookup (groups[n])) {
+      g_set_error (error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
+          "layout %s is already defined", groups[n]);
+      goto end;
+    }
+
+    keys = g_key_file_get_keys (file, groups[n], &length, error);
+    if (!keys)
+      goto end;
+    if (length < 1 || GST_LAYOUT_MAX_SLOTS < length) {
+      g_set_error (error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
+          "layout %s has %d slots (1 to %d)", groups[n], (gint) length,
+          GST_LAYOUT_MAX_SLOTS);
+      goto end;
+    }
+
+    layout = g_new0 (GstLayout, 1);
+    layout->name = g_strdup (groups[n]);
+    layout->num_slots = length;
+    layouts = g_list_append (layouts, layout);
+
+    for (k = 0; k < layout->num_slots; ++k) {
+      value = g_key_file_get_string_list (file, groups[n], keys[k], &length,
+          error);
+      if (!value)
+        goto end;
+      if (!gst_layout_parse_slot (value, length, k, &layout->slots[k])) {
+        g_set_error (error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
+            "invalid slot %s of layout %s", keys[k], groups[n]);
+        goto end;
+      }
+      g_strfreev (value), value = NULL;
+    }
+    g_strfreev (keys), keys = NULL;
+  }
+
+  gst_layout_list = g_list_concat (gst_layout_list, layouts);
+  layouts = NULL;
+  result = TRUE;
+
+end:
+  g_list_free_full (layouts, (GDestroyNotify) gst_layout_free);
+  g_strfreev (value);
+  g_strfreev (keys);
+  g_strfreev (groups);
+  g_key_file_free (file);
+  return result;
+}
+
+/**
+ * gst_layout_get_builtin:
+ *  @param mode the composite mode
+ *  @return the built-in layout of the composite mode, or NULL
+ */
+const GstLayout *
+gst_layout_get_builtin (guint mode)
+{
+  if (G_N_ELEMENTS (gst_layout_builtins) <= mode)
+    return NULL;
+  return &gst_layout_builtins[mode];
+}
+
+/**
+ * gst_layout_lookup:
+ *  @param name the layout name
+ *  @return the built-in or loaded layout of the name, or NULL
+ */
+const GstLayout *
+gst_layout_lookup (const gchar * name)
+{
+  GList *item;
+  guint n;
+
+  for (n = 0; n < G_N_ELEMENTS (gst_layout_builtins); ++n) {
+    if (g_strcmp0 (gst_layout_builtins[n].name, name) == 0)
+      return &gst_layout_builtins[n];
+  }
+
+  for (n = 0; n < G_N_ELEMENTS (gst_layout_panels); ++n) {
+    if (g_strcmp0 (gst_layout_panels[n].name, name) == 0)
+      return &gst_layout_panels[n];
+  }
+
+  for (item = gst_layout_list; item; item = g_list_next (item)) {
+    if (g_strcmp0 (((GstLayout *) item->data)->name, name) == 0)
+      return (const GstLayout *) item->data;
+  }
+  return NULL;
+}
+
+/**
+ * gst_layout_copy:
+ *  @return a copy of @layout, to be freed by %gst_layout_free
+ */
+GstLayout *
+gst_layout_copy (const GstLayout * layout)
+{
+  GstLayout *copy = g_memdup (layout, sizeof (GstLayout));
+  copy->name = g_strdup (layout->name);
+  return copy;
+}
+
+/**
+ * gst_layout_free:
+ *
+ * Free a copied or loaded layout.
+ */
+void
+gst_layout_free (GstLayout * layout)
+{
+  if (layout) {
+    g_free (layout->name);
+    g_free (layout);
+  }
+}
+
+/**
+ * gst_layout_compile:
+ *  @param layout the layout
+ *  @param width the output width
+ *  @param height the output height
+ *  @param boxes GST_LAYOUT_MAX_SLOTS boxes to be filled
+ *  @return the number of boxes
+ *
+ *  Compute the pixel boxes of the layout for an output size, so that
+ *  applying the layout is only setting the mixer pads.
+ */
+guint
+gst_layout_compile (const GstLayout * layout, guint width, guint height,
+    GstLayoutBox * boxes)
+{
+  const GstLayoutSlot *slot;
+  GstLayoutBox *box;
+  guint n;
+
+  for (n = 0; n < layout->num_slots; ++n) {
+    slot = &layout->slots[n];
+    box = &boxes[n];
+    box->channel = slot->channel;
+    box->x = (guint) (slot->x * width + 0.5);
+    box->y = (guint) (slot->y * height + 0.5);
+    box->width = (guint) (slot->width * width + 0.5);
+    box->height = (guint) (slot->height * height + 0.5);
+    if (width < box->x + box->width)
+      box->width = width - box->x;
+    if (height < box->y + box->height)
+      box->height = height - box->y;
+    if (box->width < 1)
+      box->width = 1;
+    if (box->height < 1)
+      box->height = 1;
+    box->zorder = slot->zorder * 2;
+    box->alpha = slot->alpha;
+  }
+  return layout->num_slots;
+}
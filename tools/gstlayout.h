@@ -0,0 +1,102 @@
+/* GstSwitch
+ * Copyright (C) 2012,2013 Duzy Chan <code@duzy.info>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*! @file */
+
+#ifndef __GST_LAYOUT_H__by_Duzy_Chan__
+#define __GST_LAYOUT_H__by_Duzy_Chan__ 1
+#include "gstcase.h"
+
+#define GST_LAYOUT_MAX_SLOTS 16
+
+typedef struct _GstLayoutSlot GstLayoutSlot;
+typedef struct _GstLayoutBox GstLayoutBox;
+typedef struct _GstLayout GstLayout;
+
+/**
+ *  @brief A slot of a layout, relative to the output size.
+ *  @param channel the channel shown in the slot, 'A' to 'I'
+ *  @param x the X position, 0.0 to 1.0 of the output width
+ *  @param y the Y position, 0.0 to 1.0 of the output height
+ *  @param width the width, 0.0 to 1.0 of the output width
+ *  @param height the height, 0.0 to 1.0 of the output height
+ *  @param zorder the stacking order, higher slots are drawn above
+ *  @param alpha the opacity, 0.0 to 1.0
+ */
+struct _GstLayoutSlot
+{
+  gint channel;
+  gdouble x;
+  gdouble y;
+  gdouble width;
+  gdouble height;
+  guint zorder;
+  gdouble alpha;
+};
+
+/**
+ *  @brief A slot compiled for an output size, ready for the mixer pads.
+ *  @param channel the channel shown in the box, 'A' to 'I'
+ *  @param x the X position in pixels
+ *  @param y the Y position in pixels
+ *  @param width the width in pixels
+ *  @param height the height in pixels
+ *  @param zorder the mixer zorder, every box leaves a gap above it for a
+ *         blending layer
+ *  @param alpha the opacity, 0.0 to 1.0
+ */
+struct _GstLayoutBox
+{
+  gint channel;
+  guint x;
+  guint y;
+  guint width;
+  guint height;
+  guint zorder;
+  gdouble alpha;
+};
+
+/**
+ *  @brief A composite layout.
+ *  @param name the name of the layout
+ *  @param num_slots the number of slots
+ *  @param slots the slots
+ */
+struct _GstLayout
+{
+  gchar *name;
+  guint num_slots;
+  GstLayoutSlot slots[GST_LAYOUT_MAX_SLOTS];
+};
+
+gboolean gst_layout_load (const gchar * filename, GError ** error);
+const GstLayout *gst_layout_get_builtin (guint mode);
+const GstLayout *gst_layout_lookup (const gchar * name);
+GstLayout *gst_layout_copy (const GstLayout * layout);
+void gst_layout_free (GstLayout * layout);
+guint gst_layout_compile (const GstLayout * layout, guint width,
+    guint height, GstLayoutBox * boxes);
+
+#endif //__GST_LAYOUT_H__by_Duzy_Chan__
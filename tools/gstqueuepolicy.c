@@ -0,0 +1,173 @@
+/* GstSwitch
+ * Copyright (C) 2012,2013 Duzy Chan <code@duzy.info>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*! @file */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstqueuepolicy.h"
+#include "../logutils.h"
+
+#define GST_QUEUE_POLICY_WATCHED "gst-queue-policy-watched"
+#define GST_QUEUE_POLICY_OVERRUNS "gst-queue-policy-overruns"
+
+static const gchar *gst_queue_policy_role_names[] = {
+  "composite", "preview", "audio", "record", "iso",
+};
+
+static gint gst_queue_policy_count = 0;
+
+/**
+ * gst_queue_policy_get_string:
+ *  @param role what the queue feeds
+ *  @param name the name of the queue, or NULL for a new one
+ *  @return the queue of the role for a pipeline string, free after use
+ *
+ * A queue feeding the composite holds a single frame and one feeding a
+ * preview or an output a few, both dropping the oldest frame when full, so
+ * a slow consumer shows up as dropped frames rather than a growing latency.
+ * Audio and the recorder are never dropped, they're limited in time
+ * instead, the recorder allowing the encoders to fall behind longer. The
+ * recording of a single input is limited in time too but drops the oldest,
+ * the input must never wait for its own recording.
+ */
+gchar *
+gst_queue_policy_get_string (GstQueueRole role, const gchar * name)
+{
+  gchar *queue, *s;
+
+  g_return_val_if_fail (role <= GST_QUEUE_ROLE_ISO, NULL);
+
+  if (name) {
+    queue = g_strdup (name);
+  } else {
+    queue = g_strdup_printf ("%s_queue_%d", gst_queue_policy_role_names[role],
+        g_atomic_int_add (&gst_queue_policy_count, 1));
+  }
+
+  switch (role) {
+    case GST_QUEUE_ROLE_COMPOSITE:
+    case GST_QUEUE_ROLE_PREVIEW:
+      s = g_strdup_printf ("queue name=%s leaky=downstream "
+          "max-size-buffers=%d max-size-bytes=0 max-size-time=0 ", queue,
+          role == GST_QUEUE_ROLE_COMPOSITE ? GST_QUEUE_POLICY_COMPOSITE_FRAMES
+          : GST_QUEUE_POLICY_PREVIEW_FRAMES);
+      break;
+    case GST_QUEUE_ROLE_ISO:
+      s = g_strdup_printf ("queue name=%s leaky=downstream "
+          "max-size-buffers=0 max-size-bytes=0 max-size-time=%"
+          G_GUINT64_FORMAT " ", queue,
+          (guint64) GST_QUEUE_POLICY_ISO_TIME * GST_MSECOND);
+      break;
+    case GST_QUEUE_ROLE_AUDIO:
+    case GST_QUEUE_ROLE_RECORD:
+    default:
+      s = g_strdup_printf ("queue name=%s max-size-buffers=0 max-size-bytes=0 "
+          "max-size-time=%" G_GUINT64_FORMAT " ", queue,
+          (guint64) (role == GST_QUEUE_ROLE_AUDIO ? GST_QUEUE_POLICY_AUDIO_TIME
+              : GST_QUEUE_POLICY_RECORD_TIME) * GST_MSECOND);
+      break;
+  }
+
+  g_free (queue);
+  return s;
+}
+
+/**
+ * gst_queue_policy_overrun:
+ *
+ * Invoked when a queue is full, that is when a leaky queue drops a frame
+ * or a queue blocks its upstream. The first overrun and every
+ * GST_QUEUE_POLICY_REPORT_OVERRUNS-th of a queue are reported with its fill.
+ */
+static void
+gst_queue_policy_overrun (GstElement * queue, gpointer data)
+{
+  guint overruns, buffers = 0;
+  guint64 time = 0;
+  gchar *path;
+
+  overruns = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (queue),
+          GST_QUEUE_POLICY_OVERRUNS)) + 1;
+  g_object_set_data (G_OBJECT (queue), GST_QUEUE_POLICY_OVERRUNS,
+      GUINT_TO_POINTER (overruns));
+
+  if (overruns != 1 && overruns % GST_QUEUE_POLICY_REPORT_OVERRUNS != 0)
+    return;
+
+  g_object_get (queue, "current-level-buffers", &buffers,
+      "current-level-time", &time, NULL);
+  path = gst_object_get_path_string (GST_OBJECT (queue));
+  WARN ("%s: %u overruns, %u buffers, %" G_GUINT64_FORMAT " ms queued",
+      path, overruns, buffers, time / GST_MSECOND);
+  g_free (path);
+}
+
+/**
+ * gst_queue_policy_watch:
+ *  @param element a pipeline or bin
+ *
+ * Report the overruns of the queues in @element, once it's parsed.
+ */
+void
+gst_queue_policy_watch (GstElement * element)
+{
+  GstIterator *it;
+  GValue item = G_VALUE_INIT;
+  GstElement *queue;
+  GstElementFactory *factory;
+  gboolean done = FALSE;
+
+  g_return_if_fail (GST_IS_BIN (element));
+
+  it = gst_bin_iterate_recurse (GST_BIN (element));
+  while (!done) {
+    switch (gst_iterator_next (it, &item)) {
+      case GST_ITERATOR_OK:
+        queue = GST_ELEMENT (g_value_get_object (&item));
+        factory = gst_element_get_factory (queue);
+        if (factory && g_strcmp0 (GST_OBJECT_NAME (factory), "queue") == 0 &&
+            !g_object_get_data (G_OBJECT (queue), GST_QUEUE_POLICY_WATCHED)) {
+          g_object_set_data (G_OBJECT (queue), GST_QUEUE_POLICY_WATCHED,
+              GINT_TO_POINTER (TRUE));
+          g_signal_connect (queue, "overrun",
+              G_CALLBACK (gst_queue_policy_overrun), NULL);
+        }
+        g_value_reset (&item);
+        break;
+      case GST_ITERATOR_RESYNC:
+        gst_iterator_resync (it);
+        break;
+      case GST_ITERATOR_ERROR:
+      case GST_ITERATOR_DONE:
+        done = TRUE;
+        break;
+    }
+  }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+}
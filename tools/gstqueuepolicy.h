@@ -0,0 +1,59 @@
+/* GstSwitch
+ * Copyright (C) 2012,2013 Duzy Chan <code@duzy.info>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*! @file */
+
+#ifndef __GST_QUEUE_POLICY_H__by_Duzy_Chan__
+#define __GST_QUEUE_POLICY_H__by_Duzy_Chan__ 1
+#include <gst/gst.h>
+
+#define GST_QUEUE_POLICY_COMPOSITE_FRAMES 1
+#define GST_QUEUE_POLICY_PREVIEW_FRAMES 3
+#define GST_QUEUE_POLICY_AUDIO_TIME 200 /* ms */
+#define GST_QUEUE_POLICY_RECORD_TIME 1000       /* ms */
+#define GST_QUEUE_POLICY_ISO_TIME 2000  /* ms */
+#define GST_QUEUE_POLICY_REPORT_OVERRUNS 100
+
+/**
+ *  GstQueueRole:
+ *  @param GST_QUEUE_ROLE_COMPOSITE the video feeding the composite
+ *  @param GST_QUEUE_ROLE_PREVIEW the video feeding a preview or an output
+ *  @param GST_QUEUE_ROLE_AUDIO the audio feeding the mixer or a preview
+ *  @param GST_QUEUE_ROLE_RECORD the streams feeding the recorder
+ *  @param GST_QUEUE_ROLE_ISO an input feeding its own recording
+ */
+typedef enum
+{
+  GST_QUEUE_ROLE_COMPOSITE,
+  GST_QUEUE_ROLE_PREVIEW,
+  GST_QUEUE_ROLE_AUDIO,
+  GST_QUEUE_ROLE_RECORD,
+  GST_QUEUE_ROLE_ISO,
+} GstQueueRole;
+
+gchar *gst_queue_policy_get_string (GstQueueRole role, const gchar * name);
+void gst_queue_policy_watch (GstElement * element);
+
+#endif //__GST_QUEUE_POLICY_H__by_Duzy_Chan__
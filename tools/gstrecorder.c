@@ -36,6 +36,25 @@
 #include "gstswitchserver.h"
 #include "gstcomposite.h"
 #include "gstrecorder.h"
+#include "gstclientpolicy.h"
+#include "gstqueuepolicy.h"
+
+#define GST_RECORDER_LOCK_DRIFT(rec) (g_mutex_lock (&(rec)->drift_lock))
+#define GST_RECORDER_UNLOCK_DRIFT(rec) (g_mutex_unlock (&(rec)->drift_lock))
+
+#define GST_RECORDER_AUDIO_RATE 48000
+#define GST_RECORDER_AUDIO_CAPS "audio/x-raw,format=S16LE,rate=48000,channels=2,layout=interleaved"
+#define GST_RECORDER_AUDIO_FRAME 4      /* bytes of one S16LE stereo sample */
+#define GST_RECORDER_DRIFT_SMOOTHING 16
+#define GST_RECORDER_DRIFT_THRESHOLD (20 * GST_MSECOND)
+#define GST_RECORDER_DRIFT_MAX_STEP 200 /* one sample in 200, 0.5% */
+
+#define GST_RECORDER_LOCK_SEGMENT(rec) (g_mutex_lock (&(rec)->segment_lock))
+#define GST_RECORDER_UNLOCK_SEGMENT(rec) (g_mutex_unlock (&(rec)->segment_lock))
+#define GST_RECORDER_DISK_LEVEL_WARNING 50    /* percent of the ring */
+#define GST_RECORDER_DISK_LATENCY_WARNING 100000      /* us */
+#define GST_RECORDER_LOCK_FILE(rec) (g_mutex_lock (&(rec)->file_lock))
+#define GST_RECORDER_UNLOCK_FILE(rec) (g_mutex_unlock (&(rec)->file_lock))
 
 enum
 {
@@ -44,6 +63,7 @@ enum
   PROP_PORT,
   PROP_WIDTH,
   PROP_HEIGHT,
+  PROP_FRAMERATE,
 };
 
 enum
@@ -70,6 +90,29 @@ gst_recorder_init (GstRecorder * rec)
   rec->mode = 0;
   rec->width = 0;
   rec->height = 0;
+  rec->framerate = GST_SWITCH_COMPOSITE_DEFAULT_FRAMERATE;
+  rec->video_time = GST_CLOCK_TIME_NONE;
+  rec->audio_start = GST_CLOCK_TIME_NONE;
+  rec->audio_frames = 0;
+  rec->offset = 0;
+  rec->base_offset = 0;
+  rec->measured = 0;
+  rec->correction = 0;
+  rec->segment_base = NULL;
+  rec->manifest = NULL;
+  rec->file_bin = NULL;
+  rec->next_file_bin = NULL;
+  rec->video_file_pad = NULL;
+  rec->audio_file_pad = NULL;
+  rec->video_block = 0;
+  rec->audio_block = 0;
+  rec->blocked_file_pads = 0;
+  rec->file_count = 0;
+  rec->rotation_dropped = 0;
+
+  g_mutex_init (&rec->drift_lock);
+  g_mutex_init (&rec->segment_lock);
+  g_mutex_init (&rec->file_lock);
 
   //INFO ("init %p", rec);
 }
@@ -88,6 +131,37 @@ gst_recorder_dispose (GstRecorder * rec)
   G_OBJECT_CLASS (parent_class)->dispose (G_OBJECT (rec));
 }
 
+/**
+ * gst_recorder_forget_file:
+ *
+ * Drop the references to the file branch of the previous pipeline.
+ */
+static void
+gst_recorder_forget_file (GstRecorder * rec)
+{
+  GST_RECORDER_LOCK_FILE (rec);
+  if (rec->file_bin) {
+    gst_object_unref (rec->file_bin);
+    rec->file_bin = NULL;
+  }
+  if (rec->next_file_bin) {
+    gst_object_unref (rec->next_file_bin);
+    rec->next_file_bin = NULL;
+  }
+  if (rec->video_file_pad) {
+    gst_object_unref (rec->video_file_pad);
+    rec->video_file_pad = NULL;
+  }
+  if (rec->audio_file_pad) {
+    gst_object_unref (rec->audio_file_pad);
+    rec->audio_file_pad = NULL;
+  }
+  rec->video_block = 0;
+  rec->audio_block = 0;
+  rec->blocked_file_pads = 0;
+  GST_RECORDER_UNLOCK_FILE (rec);
+}
+
 /**
  * gst_recorder_finalize:
  *
@@ -98,6 +172,20 @@ gst_recorder_dispose (GstRecorder * rec)
 static void
 gst_recorder_finalize (GstRecorder * rec)
 {
+  if (rec->manifest) {
+    g_string_free (rec->manifest, TRUE);
+    rec->manifest = NULL;
+  }
+
+  g_free (rec->segment_base);
+  rec->segment_base = NULL;
+
+  gst_recorder_forget_file (rec);
+
+  g_mutex_clear (&rec->drift_lock);
+  g_mutex_clear (&rec->segment_lock);
+  g_mutex_clear (&rec->file_lock);
+
   if (G_OBJECT_CLASS (parent_class)->finalize)
     (*G_OBJECT_CLASS (parent_class)->finalize) (G_OBJECT (rec));
 }
@@ -126,6 +214,9 @@ gst_recorder_get_property (GstRecorder * rec, guint property_id,
     case PROP_HEIGHT:
       g_value_set_uint (value, rec->height);
       break;
+    case PROP_FRAMERATE:
+      g_value_set_uint (value, rec->framerate);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (rec, property_id, pspec);
       break;
@@ -156,6 +247,9 @@ gst_recorder_set_property (GstRecorder * rec, guint property_id,
     case PROP_HEIGHT:
       rec->height = g_value_get_uint (value);
       break;
+    case PROP_FRAMERATE:
+      rec->framerate = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (G_OBJECT (rec), property_id, pspec);
       break;
@@ -211,8 +305,27 @@ gst_recorder_new_filename (GstRecorder * rec)
 static GString *
 gst_recorder_get_pipeline_string (GstRecorder * rec)
 {
-  const gchar *filename = gst_recorder_new_filename (rec);
+  const gchar *filename = NULL;
+  gboolean recording = opts.record_filename != NULL;
+  gboolean segmented = FALSE;
   GString *desc;
+  gchar *policy, *queue;
+
+  GST_RECORDER_LOCK_SEGMENT (rec);
+  g_free (rec->segment_base);
+  rec->segment_base = NULL;
+  if (recording && (0 < opts.record_segment_time ||
+          0 < opts.record_segment_size) &&
+      (filename = gst_recorder_new_filename (rec))) {
+    const gchar *dot = g_strrstr (filename, ".");
+    const gchar *slash = g_strrstr (filename, "/");
+    if (dot && (!slash || slash < dot))
+      rec->segment_base = g_strndup (filename, dot - filename);
+    else
+      rec->segment_base = g_strdup (filename);
+    segmented = TRUE;
+  }
+  GST_RECORDER_UNLOCK_SEGMENT (rec);
 
   //INFO ("Recording to %s and port %d", filename, rec->sink_port);
 
@@ -224,12 +337,14 @@ gst_recorder_get_pipeline_string (GstRecorder * rec)
       "channel=composite_audio ");
 
   g_string_append_printf (desc,
-      "source_video. ! video/x-raw,width=%d,height=%d ",
-      rec->width, rec->height);
+      "source_video. ! video/x-raw,width=%d,height=%d,framerate=%d/1 ",
+      rec->width, rec->height, rec->framerate);
   /*
      ASSESS ("assess-record-video-source");
    */
-  g_string_append_printf (desc, "! queue2 ");
+  queue = gst_queue_policy_get_string (GST_QUEUE_ROLE_RECORD, NULL);
+  g_string_append_printf (desc, "! %s", queue);
+  g_free (queue);
   /*
      ASSESS ("assess-record-video-encode-queued");
    */
@@ -237,13 +352,30 @@ gst_recorder_get_pipeline_string (GstRecorder * rec)
   /*
      ASSESS ("assess-record-video-encoded");
    */
+  if (recording) {
+    g_string_append_printf (desc, "! tee name=video_encoded ");
+    if (segmented) {
+      queue = gst_queue_policy_get_string (GST_QUEUE_ROLE_RECORD, NULL);
+      g_string_append_printf (desc, "video_encoded. ! %s! disk_sink.video ",
+          queue);
+      g_free (queue);
+    }
+    queue = gst_queue_policy_get_string (GST_QUEUE_ROLE_RECORD, NULL);
+    g_string_append_printf (desc, "video_encoded. ! %s", queue);
+    g_free (queue);
+  }
   g_string_append_printf (desc, "! mux. ");
 
   g_string_append_printf (desc, "source_audio. ");
   /*
      ASSESS ("assess-record-audio-source");
    */
-  g_string_append_printf (desc, "! queue2 ");
+  g_string_append_printf (desc, "! audioconvert ! audioresample ");
+  g_string_append_printf (desc, "! capsfilter name=audio_format caps=%s ",
+      GST_RECORDER_AUDIO_CAPS);
+  queue = gst_queue_policy_get_string (GST_QUEUE_ROLE_RECORD, NULL);
+  g_string_append_printf (desc, "! %s", queue);
+  g_free (queue);
   /*
      ASSESS ("assess-record-audio-queued");
    */
@@ -251,6 +383,18 @@ gst_recorder_get_pipeline_string (GstRecorder * rec)
   /*
      ASSESS ("assess-record-audio-encoded");
    */
+  if (recording) {
+    g_string_append_printf (desc, "! tee name=audio_encoded ");
+    if (segmented) {
+      queue = gst_queue_policy_get_string (GST_QUEUE_ROLE_RECORD, NULL);
+      g_string_append_printf (desc, "audio_encoded. ! %s"
+          "! disk_sink.audio_%%u ", queue);
+      g_free (queue);
+    }
+    queue = gst_queue_policy_get_string (GST_QUEUE_ROLE_RECORD, NULL);
+    g_string_append_printf (desc, "audio_encoded. ! %s", queue);
+    g_free (queue);
+  }
   g_string_append_printf (desc, "! mux. ");
 
   g_string_append_printf (desc, "avimux name=mux ");
@@ -259,28 +403,34 @@ gst_recorder_get_pipeline_string (GstRecorder * rec)
    */
   g_string_append_printf (desc, "! tee name=result ");
 
-  if (filename) {
-    g_string_append_printf (desc, "filesink name=disk_sink sync=false "
-        "location=\"%s\" ", filename);
+  if (segmented) {
+    /* Each segment is a complete Matroska file, split on a key frame. */
+    g_string_append_printf (desc, "splitmuxsink name=disk_sink "
+        "location=\"%s-%%05d.mkv\" ", rec->segment_base);
+    if (0 < opts.record_segment_time)
+      g_string_append_printf (desc, "max-size-time=%" G_GUINT64_FORMAT " ",
+          (guint64) opts.record_segment_time * GST_SECOND);
+    if (0 < opts.record_segment_size)
+      g_string_append_printf (desc, "max-size-bytes=%" G_GUINT64_FORMAT " ",
+          (guint64) opts.record_segment_size * 1024 * 1024);
     g_free ((gpointer) filename);
-    g_string_append_printf (desc, "result. ");
-    /*
-       ASSESS ("assess-record-file-to-queue");
-     */
-    g_string_append_printf (desc, "! queue2 ");
-    /*
-       ASSESS ("assess-record-file-to-sink");
-     */
-    g_string_append_printf (desc, "! disk_sink. ");
-  }
-
-  g_string_append_printf (desc, "tcpserversink name=tcp_sink sync=false "
-      "port=%d ", rec->sink_port);
+  }
+
+  /* Without segments, the file branch is attached to the "video_encoded"
+     and "audio_encoded" tees on preparing, so that it can be swapped for a
+     new file later. */
+
+  policy = gst_client_policy_get_string (GST_CLIENT_ROLE_ENCODE);
+  g_string_append_printf (desc, "tcpserversink name=tcp_sink sync=false %s"
+      "port=%d ", policy, rec->sink_port);
+  g_free (policy);
   g_string_append_printf (desc, "result. ");
   /*
      ASSESS ("assess-record-tcp-to-queue");
    */
-  g_string_append_printf (desc, "! queue2 ");
+  queue = gst_queue_policy_get_string (GST_QUEUE_ROLE_RECORD, NULL);
+  g_string_append_printf (desc, "! %s", queue);
+  g_free (queue);
   /*
      ASSESS ("assess-record-tcp-to-sink");
    */
@@ -299,7 +449,7 @@ gst_recorder_client_socket_added (GstElement * element,
 {
   g_return_if_fail (G_IS_SOCKET (socket));
 
-  INFO ("client-socket-added: %d", g_socket_get_fd (socket));
+  gst_client_policy_client_added (element, socket);
 }
 
 /**
@@ -319,6 +469,681 @@ gst_recorder_client_socket_removed (GstElement * element,
   g_socket_close (socket, NULL);
 }
 
+/**
+ * gst_recorder_running_time:
+ * @return the running time of @time in the segment of @pad, or
+ *         GST_CLOCK_TIME_NONE if there is no segment yet
+ */
+static GstClockTime
+gst_recorder_running_time (GstPad * pad, GstClockTime time)
+{
+  const GstSegment *segment = NULL;
+  GstEvent *event = NULL;
+
+  if (!GST_CLOCK_TIME_IS_VALID (time))
+    return GST_CLOCK_TIME_NONE;
+
+  event = gst_pad_get_sticky_event (pad, GST_EVENT_SEGMENT, 0);
+  if (!event)
+    return GST_CLOCK_TIME_NONE;
+
+  gst_event_parse_segment (event, &segment);
+  time = gst_segment_to_running_time (segment, GST_FORMAT_TIME, time);
+  gst_event_unref (event);
+  return time;
+}
+
+/**
+ * gst_recorder_video_probe:
+ *
+ * Track the running time the video coming into the recorder has reached.
+ */
+static GstPadProbeReturn
+gst_recorder_video_probe (GstPad * pad, GstPadProbeInfo * info,
+    GstRecorder * rec)
+{
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  GstClockTime end = GST_BUFFER_PTS (buffer);
+
+  if (GST_CLOCK_TIME_IS_VALID (end) && GST_BUFFER_DURATION_IS_VALID (buffer))
+    end += GST_BUFFER_DURATION (buffer);
+
+  end = gst_recorder_running_time (pad, end);
+  if (!GST_CLOCK_TIME_IS_VALID (end))
+    return GST_PAD_PROBE_OK;
+
+  GST_RECORDER_LOCK_DRIFT (rec);
+  rec->video_time = end;
+  GST_RECORDER_UNLOCK_DRIFT (rec);
+  return GST_PAD_PROBE_OK;
+}
+
+/**
+ * gst_recorder_stretch_audio:
+ * @return a new buffer of @frames plus @correction samples
+ *
+ * Drop or repeat @correction samples spread evenly over @buffer, the caps
+ * and the timestamp stay the same.
+ */
+static GstBuffer *
+gst_recorder_stretch_audio (GstBuffer * buffer, guint frames,
+    gint correction)
+{
+  GstBuffer *stretched = NULL;
+  GstMapInfo in, out;
+  guint n, count = frames + correction;
+
+  stretched = gst_buffer_new_allocate (NULL,
+      count * GST_RECORDER_AUDIO_FRAME, NULL);
+  gst_buffer_copy_into (stretched, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
+  GST_BUFFER_DURATION (stretched) = gst_util_uint64_scale_int (count,
+      GST_SECOND, GST_RECORDER_AUDIO_RATE);
+
+  gst_buffer_map (buffer, &in, GST_MAP_READ);
+  gst_buffer_map (stretched, &out, GST_MAP_WRITE);
+  for (n = 0; n < count; ++n) {
+    memcpy (out.data + n * GST_RECORDER_AUDIO_FRAME,
+        in.data + (n * frames / count) * GST_RECORDER_AUDIO_FRAME,
+        GST_RECORDER_AUDIO_FRAME);
+  }
+  gst_buffer_unmap (stretched, &out);
+  gst_buffer_unmap (buffer, &in);
+
+  gst_buffer_unref (buffer);
+  return stretched;
+}
+
+/**
+ * gst_recorder_audio_probe:
+ *
+ * Compare the audio with the video at the recorder input. The muxer lays
+ * the audio down sample after sample, so the audio time is taken from the
+ * samples passed since the first buffer rather than from the timestamps,
+ * and a producer running slower or faster than the video shows up as a
+ * growing or shrinking offset to the video running time. Past
+ * %GST_RECORDER_DRIFT_THRESHOLD, up to one sample in
+ * %GST_RECORDER_DRIFT_MAX_STEP is repeated or dropped until the offset is
+ * back, the caps never change.
+ */
+static GstPadProbeReturn
+gst_recorder_audio_probe (GstPad * pad, GstPadProbeInfo * info,
+    GstRecorder * rec)
+{
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  GstClockTime start, audio_time;
+  GstClockTimeDiff offset, drift;
+  guint frames = gst_buffer_get_size (buffer) / GST_RECORDER_AUDIO_FRAME;
+  gint correction = 0;
+
+  start = gst_recorder_running_time (pad, GST_BUFFER_PTS (buffer));
+  if (!GST_CLOCK_TIME_IS_VALID (start) || frames == 0)
+    return GST_PAD_PROBE_OK;
+
+  GST_RECORDER_LOCK_DRIFT (rec);
+  if (!GST_CLOCK_TIME_IS_VALID (rec->video_time)) {
+    /* nothing to line up with until the video comes */
+    GST_RECORDER_UNLOCK_DRIFT (rec);
+    return GST_PAD_PROBE_OK;
+  }
+
+  if (!GST_CLOCK_TIME_IS_VALID (rec->audio_start)) {
+    rec->audio_start = start;
+    rec->audio_frames = 0;
+  }
+
+  audio_time = rec->audio_start + gst_util_uint64_scale_int (rec->audio_frames,
+      GST_SECOND, GST_RECORDER_AUDIO_RATE);
+  offset = GST_CLOCK_DIFF (rec->video_time, audio_time);
+
+  if (rec->measured++ == 0)
+    rec->offset = offset;
+  else
+    rec->offset += (offset - rec->offset) / GST_RECORDER_DRIFT_SMOOTHING;
+
+  if (rec->measured == GST_RECORDER_DRIFT_SMOOTHING)
+    rec->base_offset = rec->offset;
+
+  if (GST_RECORDER_DRIFT_SMOOTHING < rec->measured) {
+    drift = rec->offset - rec->base_offset;
+    if (rec->correction == 0) {
+      if (GST_RECORDER_DRIFT_THRESHOLD < drift)
+        rec->correction = -1;
+      else if (drift < -GST_RECORDER_DRIFT_THRESHOLD)
+        rec->correction = 1;
+      if (rec->correction)
+        INFO ("%s: audio drifted %lld ms from the video",
+            GST_WORKER (rec)->name, (long long int) (drift / GST_MSECOND));
+    } else if (ABS (drift) < GST_RECORDER_DRIFT_THRESHOLD / 2) {
+      /* caught up */
+      rec->correction = 0;
+    }
+    correction = rec->correction * (gint) MAX (1,
+        frames / GST_RECORDER_DRIFT_MAX_STEP);
+  }
+
+  rec->audio_frames += frames + correction;
+  GST_RECORDER_UNLOCK_DRIFT (rec);
+
+  if (correction) {
+    GST_PAD_PROBE_INFO_DATA (info) =
+        gst_recorder_stretch_audio (buffer, frames, correction);
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+/**
+ * gst_recorder_probe_source:
+ *
+ * Install the drift probe on the source pad of the named element.
+ */
+static void
+gst_recorder_probe_source (GstRecorder * rec, const gchar * name,
+    GstPadProbeCallback callback)
+{
+  GstElement *source = NULL;
+  GstPad *pad = NULL;
+
+  source = gst_worker_get_element_unlocked (GST_WORKER (rec), name);
+  if (!source) {
+    WARN ("%s: no %s to probe", GST_WORKER (rec)->name, name);
+    return;
+  }
+
+  pad = gst_element_get_static_pad (source, "src");
+  if (pad) {
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, callback, rec, NULL);
+    gst_object_unref (pad);
+  }
+
+  gst_object_unref (source);
+}
+
+/**
+ * gst_recorder_format_location:
+ * @return the file name of the new segment
+ *
+ * Invoked when the segment @fragment_id is opened, the segment is added to
+ * the playlist written beside the segments.
+ */
+static gchar *
+gst_recorder_format_location (GstElement * splitmux, guint fragment_id,
+    GstRecorder * rec)
+{
+  gchar *location = NULL, *name = NULL, *path = NULL;
+  GError *error = NULL;
+
+  GST_RECORDER_LOCK_SEGMENT (rec);
+  location = g_strdup_printf ("%s-%05u.mkv", rec->segment_base, fragment_id);
+  path = g_strdup_printf ("%s.m3u", rec->segment_base);
+  name = g_path_get_basename (location);
+
+  if (!rec->manifest)
+    rec->manifest = g_string_new ("#EXTM3U\n");
+  g_string_append_printf (rec->manifest, "%s\n", name);
+
+  if (!g_file_set_contents (path, rec->manifest->str, -1, &error)) {
+    WARN ("%s: %s", GST_WORKER (rec)->name, error->message);
+    g_error_free (error);
+  }
+  GST_RECORDER_UNLOCK_SEGMENT (rec);
+
+  INFO ("%s: new segment %s", GST_WORKER (rec)->name, location);
+
+  g_free (name);
+  g_free (path);
+  return location;
+}
+
+/**
+ * gst_recorder_prepare_segments:
+ *
+ * Set up the segments muxer, and the playlist of the segments.
+ */
+static void
+gst_recorder_prepare_segments (GstRecorder * rec)
+{
+  GstElement *disk_sink = NULL;
+  GstElement *muxer = NULL;
+
+  GST_RECORDER_LOCK_SEGMENT (rec);
+  if (rec->manifest) {
+    g_string_free (rec->manifest, TRUE);
+    rec->manifest = NULL;
+  }
+  GST_RECORDER_UNLOCK_SEGMENT (rec);
+
+  disk_sink = gst_worker_get_element_unlocked (GST_WORKER (rec), "disk_sink");
+  if (!disk_sink) {
+    WARN ("%s: no disk sink for segments", GST_WORKER (rec)->name);
+    return;
+  }
+
+  muxer = gst_element_factory_make ("matroskamux", NULL);
+  if (muxer)
+    g_object_set (disk_sink, "muxer", muxer, NULL);
+
+  if (g_object_class_find_property (G_OBJECT_GET_CLASS (disk_sink),
+          "send-keyframe-requests"))
+    g_object_set (disk_sink, "send-keyframe-requests", TRUE, NULL);
+
+  if (g_signal_lookup ("format-location", G_OBJECT_TYPE (disk_sink))) {
+    g_signal_connect (disk_sink, "format-location",
+        G_CALLBACK (gst_recorder_format_location), rec);
+  } else {
+    WARN ("%s: no playlist for the segments", GST_WORKER (rec)->name);
+  }
+
+  gst_object_unref (disk_sink);
+}
+
+/**
+ * gst_recorder_new_segment:
+ * @return TRUE if a new segment is requested
+ *
+ * Close the current segment on the next key frame and continue recording
+ * into a new one, without restarting the recorder.
+ */
+gboolean
+gst_recorder_new_segment (GstRecorder * rec)
+{
+  GstWorker *worker = GST_WORKER (rec);
+  GstElement *disk_sink = NULL;
+  gboolean segmented = FALSE;
+  gboolean ok = FALSE;
+
+  g_return_val_if_fail (GST_IS_RECORDER (rec), FALSE);
+
+  GST_RECORDER_LOCK_SEGMENT (rec);
+  segmented = rec->segment_base != NULL;
+  GST_RECORDER_UNLOCK_SEGMENT (rec);
+
+  if (!segmented)
+    return FALSE;
+
+  g_mutex_lock (&worker->pipeline_lock);
+  if (worker->pipeline)
+    disk_sink = gst_worker_get_element_unlocked (worker, "disk_sink");
+  g_mutex_unlock (&worker->pipeline_lock);
+
+  if (disk_sink) {
+    if (g_signal_lookup ("split-now", G_OBJECT_TYPE (disk_sink))) {
+      g_signal_emit_by_name (disk_sink, "split-now");
+      ok = TRUE;
+    }
+    gst_object_unref (disk_sink);
+  }
+  return ok;
+}
+
+/**
+ * gst_recorder_has_record_sink:
+ * @return TRUE if the recordsink element of the gstswitch plugin is available
+ */
+static gboolean
+gst_recorder_has_record_sink (void)
+{
+  GstElementFactory *factory = gst_element_factory_find ("recordsink");
+  if (factory) {
+    gst_object_unref (factory);
+    return TRUE;
+  }
+  return FALSE;
+}
+
+/**
+ * gst_recorder_new_file_bin:
+ * @return a new bin muxing into @filename, with "video" and "audio" sink pads
+ *
+ * Create the file branch of the recorder.
+ */
+static GstElement *
+gst_recorder_new_file_bin (GstRecorder * rec, const gchar * filename)
+{
+  GstElement *bin = NULL, *queue = NULL;
+  GstPad *pad = NULL;
+  GError *error = NULL;
+  GString *desc;
+  gchar *name, *policy;
+
+  desc = g_string_new ("");
+  policy = gst_queue_policy_get_string (GST_QUEUE_ROLE_RECORD, "video_queue");
+  g_string_append_printf (desc, "%s! file_mux. ", policy);
+  g_free (policy);
+  policy = gst_queue_policy_get_string (GST_QUEUE_ROLE_RECORD, "audio_queue");
+  g_string_append_printf (desc, "%s! file_mux. ", policy);
+  g_free (policy);
+  g_string_append_printf (desc, "avimux name=file_mux ");
+  if (gst_recorder_has_record_sink ()) {
+    g_string_append_printf (desc, "! recordsink name=file_sink "
+        "direct=%s location=\"%s\" ", opts.record_direct ? "true" : "false",
+        filename);
+  } else {
+    g_string_append_printf (desc, "! filesink name=file_sink sync=false "
+        "location=\"%s\" ", filename);
+  }
+
+  bin = gst_parse_bin_from_description (desc->str, FALSE, &error);
+  g_string_free (desc, TRUE);
+
+  if (error) {
+    ERROR ("%s: %s", GST_WORKER (rec)->name, error->message);
+    g_error_free (error);
+    if (bin)
+      gst_object_unref (bin);
+    return NULL;
+  }
+
+  name = g_strdup_printf ("file_%u", rec->file_count++);
+  gst_element_set_name (bin, name);
+  g_free (name);
+
+  gst_queue_policy_watch (bin);
+
+  queue = gst_bin_get_by_name (GST_BIN (bin), "video_queue");
+  pad = gst_element_get_static_pad (queue, "sink");
+  gst_element_add_pad (bin, gst_ghost_pad_new ("video", pad));
+  gst_object_unref (pad);
+  gst_object_unref (queue);
+
+  queue = gst_bin_get_by_name (GST_BIN (bin), "audio_queue");
+  pad = gst_element_get_static_pad (queue, "sink");
+  gst_element_add_pad (bin, gst_ghost_pad_new ("audio", pad));
+  gst_object_unref (pad);
+  gst_object_unref (queue);
+
+  return bin;
+}
+
+/**
+ * gst_recorder_keyframe_probe:
+ *
+ * Drop the video frames entering a new file until a key frame arrives.
+ */
+static GstPadProbeReturn
+gst_recorder_keyframe_probe (GstPad * pad, GstPadProbeInfo * info,
+    GstRecorder * rec)
+{
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  GstPadProbeReturn ret = GST_PAD_PROBE_REMOVE;
+
+  GST_RECORDER_LOCK_FILE (rec);
+  if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT)) {
+    rec->rotation_dropped += 1;
+    ret = GST_PAD_PROBE_DROP;
+  } else {
+    INFO ("%s: %u frames dropped by rotation", GST_WORKER (rec)->name,
+        rec->rotation_dropped);
+  }
+  GST_RECORDER_UNLOCK_FILE (rec);
+  return ret;
+}
+
+/**
+ * gst_recorder_link_file_bin:
+ *
+ * Link the tee pad to the named sink pad of the file bin.
+ */
+static gboolean
+gst_recorder_link_file_bin (GstPad * tee_pad, GstElement * bin,
+    const gchar * name)
+{
+  GstPad *pad = gst_element_get_static_pad (bin, name);
+  GstPadLinkReturn ret = gst_pad_link (tee_pad, pad);
+  gst_object_unref (pad);
+  return GST_PAD_LINK_SUCCESSFUL (ret);
+}
+
+/**
+ * gst_recorder_close_file_bin:
+ *
+ * Invoked when the EOS reaches the sink of an old file, the file is
+ * complete and its bin can be removed.
+ */
+static gboolean
+gst_recorder_close_file_bin (GstElement * bin)
+{
+  GstObject *parent = gst_object_get_parent (GST_OBJECT (bin));
+
+  gst_element_set_state (bin, GST_STATE_NULL);
+  if (parent) {
+    gst_bin_remove (GST_BIN (parent), bin);
+    gst_object_unref (parent);
+  }
+
+  gst_object_unref (bin);
+  return FALSE;
+}
+
+/**
+ * gst_recorder_file_eos_probe:
+ *
+ * Wait for the EOS on the sink of an old file.
+ */
+static GstPadProbeReturn
+gst_recorder_file_eos_probe (GstPad * pad, GstPadProbeInfo * info,
+    GstElement * bin)
+{
+  GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+
+  if (GST_EVENT_TYPE (event) != GST_EVENT_EOS)
+    return GST_PAD_PROBE_OK;
+
+  g_idle_add ((GSourceFunc) gst_recorder_close_file_bin,
+      gst_object_ref (bin));
+  return GST_PAD_PROBE_REMOVE;
+}
+
+/**
+ * gst_recorder_finish_file_bin:
+ *
+ * Send EOS into an old file bin, so that its index is written.
+ */
+static void
+gst_recorder_finish_file_bin (GstElement * bin)
+{
+  GstElement *sink = gst_bin_get_by_name (GST_BIN (bin), "file_sink");
+  GstPad *pad = NULL;
+
+  if (sink) {
+    pad = gst_element_get_static_pad (sink, "sink");
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+        (GstPadProbeCallback) gst_recorder_file_eos_probe, bin, NULL);
+    gst_object_unref (pad);
+    gst_object_unref (sink);
+  }
+
+  pad = gst_element_get_static_pad (bin, "video");
+  gst_pad_send_event (pad, gst_event_new_eos ());
+  gst_object_unref (pad);
+
+  pad = gst_element_get_static_pad (bin, "audio");
+  gst_pad_send_event (pad, gst_event_new_eos ());
+  gst_object_unref (pad);
+}
+
+/**
+ * gst_recorder_rotate_probe:
+ *
+ * Invoked when one of the tee pads of the file branch is blocked. Once both
+ * are blocked, the old file bin is replaced by the new one.
+ */
+static GstPadProbeReturn
+gst_recorder_rotate_probe (GstPad * pad, GstPadProbeInfo * info,
+    GstRecorder * rec)
+{
+  GstElement *old_bin = NULL;
+  GstPad *other_pad = NULL, *peer = NULL;
+  gulong other_block = 0;
+  GstStructure *s = NULL;
+
+  GST_RECORDER_LOCK_FILE (rec);
+  if (!rec->next_file_bin) {
+    GST_RECORDER_UNLOCK_FILE (rec);
+    return GST_PAD_PROBE_REMOVE;
+  }
+
+  /* Wait for the other pad to be blocked too. */
+  if (rec->blocked_file_pads++ == 0) {
+    GST_RECORDER_UNLOCK_FILE (rec);
+    return GST_PAD_PROBE_OK;
+  }
+
+  if (pad == rec->video_file_pad) {
+    other_pad = rec->audio_file_pad;
+    other_block = rec->audio_block;
+  } else {
+    other_pad = rec->video_file_pad;
+    other_block = rec->video_block;
+  }
+
+  old_bin = rec->file_bin;
+  if ((peer = gst_pad_get_peer (rec->video_file_pad))) {
+    gst_pad_unlink (rec->video_file_pad, peer);
+    gst_object_unref (peer);
+  }
+  if ((peer = gst_pad_get_peer (rec->audio_file_pad))) {
+    gst_pad_unlink (rec->audio_file_pad, peer);
+    gst_object_unref (peer);
+  }
+
+  rec->file_bin = rec->next_file_bin;
+  rec->next_file_bin = NULL;
+  gst_recorder_link_file_bin (rec->video_file_pad, rec->file_bin, "video");
+  gst_recorder_link_file_bin (rec->audio_file_pad, rec->file_bin, "audio");
+
+  rec->video_block = 0;
+  rec->audio_block = 0;
+  rec->blocked_file_pads = 0;
+
+  /* Ask the encoder for the key frame the new file starts with. */
+  s = gst_structure_new ("GstForceKeyUnit",
+      "running-time", GST_TYPE_CLOCK_TIME, GST_CLOCK_TIME_NONE,
+      "all-headers", G_TYPE_BOOLEAN, TRUE, "count", G_TYPE_UINT, 0, NULL);
+  gst_pad_send_event (rec->video_file_pad,
+      gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM, s));
+
+  gst_pad_remove_probe (other_pad, other_block);
+  GST_RECORDER_UNLOCK_FILE (rec);
+
+  gst_recorder_finish_file_bin (old_bin);
+  gst_object_unref (old_bin);
+  return GST_PAD_PROBE_REMOVE;
+}
+
+/**
+ * gst_recorder_request_file_pad:
+ * @return a new source pad of the named tee
+ */
+static GstPad *
+gst_recorder_request_file_pad (GstRecorder * rec, const gchar * name)
+{
+  GstElement *tee = gst_worker_get_element_unlocked (GST_WORKER (rec), name);
+  GstPad *pad = NULL;
+
+  if (tee) {
+    pad = gst_element_get_request_pad (tee, "src_%u");
+    gst_object_unref (tee);
+  }
+  return pad;
+}
+
+/**
+ * gst_recorder_prepare_file:
+ * @return TRUE if the file branch is attached
+ *
+ * Attach the file branch to the encoded video and audio.
+ */
+static gboolean
+gst_recorder_prepare_file (GstRecorder * rec)
+{
+  const gchar *filename = gst_recorder_new_filename (rec);
+  GstElement *bin = NULL;
+  gboolean ok = FALSE;
+
+  gst_recorder_forget_file (rec);
+
+  if (!filename)
+    return TRUE;
+
+  bin = gst_recorder_new_file_bin (rec, filename);
+  g_free ((gpointer) filename);
+  if (!bin)
+    return FALSE;
+
+  GST_RECORDER_LOCK_FILE (rec);
+  rec->file_bin = gst_object_ref (bin);
+  gst_bin_add (GST_BIN (GST_WORKER (rec)->pipeline), bin);
+
+  rec->video_file_pad = gst_recorder_request_file_pad (rec, "video_encoded");
+  rec->audio_file_pad = gst_recorder_request_file_pad (rec, "audio_encoded");
+  if (rec->video_file_pad && rec->audio_file_pad) {
+    ok = gst_recorder_link_file_bin (rec->video_file_pad, bin, "video") &&
+        gst_recorder_link_file_bin (rec->audio_file_pad, bin, "audio");
+  }
+  GST_RECORDER_UNLOCK_FILE (rec);
+
+  if (!ok)
+    ERROR ("%s: failed to attach the recording file", GST_WORKER (rec)->name);
+  return ok;
+}
+
+/**
+ * gst_recorder_new_file:
+ * @return TRUE if the recording is switching to a new file
+ *
+ * Swap the file branch for a new file, the encoders and the network output
+ * keep running.
+ */
+gboolean
+gst_recorder_new_file (GstRecorder * rec)
+{
+  GstWorker *worker = GST_WORKER (rec);
+  const gchar *filename = NULL;
+  GstElement *bin = NULL;
+  GstPad *pad = NULL;
+  gboolean ok = FALSE;
+
+  g_return_val_if_fail (GST_IS_RECORDER (rec), FALSE);
+
+  g_mutex_lock (&worker->pipeline_lock);
+  GST_RECORDER_LOCK_FILE (rec);
+  if (!worker->pipeline || !rec->file_bin || rec->next_file_bin)
+    goto end;
+
+  if (!(filename = gst_recorder_new_filename (rec)))
+    goto end;
+
+  bin = gst_recorder_new_file_bin (rec, filename);
+  g_free ((gpointer) filename);
+  if (!bin)
+    goto end;
+
+  rec->next_file_bin = gst_object_ref (bin);
+  rec->blocked_file_pads = 0;
+  rec->rotation_dropped = 0;
+  gst_bin_add (GST_BIN (worker->pipeline), bin);
+  gst_element_sync_state_with_parent (bin);
+
+  /* The new file has to start with a key frame. */
+  pad = gst_element_get_static_pad (bin, "video");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+      (GstPadProbeCallback) gst_recorder_keyframe_probe, rec, NULL);
+  gst_object_unref (pad);
+
+  rec->video_block = gst_pad_add_probe (rec->video_file_pad,
+      GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM,
+      (GstPadProbeCallback) gst_recorder_rotate_probe, rec, NULL);
+  rec->audio_block = gst_pad_add_probe (rec->audio_file_pad,
+      GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM,
+      (GstPadProbeCallback) gst_recorder_rotate_probe, rec, NULL);
+  ok = TRUE;
+
+end:
+  GST_RECORDER_UNLOCK_FILE (rec);
+  g_mutex_unlock (&worker->pipeline_lock);
+  return ok;
+}
+
 /**
  * gst_recorder_prepare:
  * @return TRUE indicating the recorder is prepared, FALSE otherwise.
@@ -336,13 +1161,71 @@ gst_recorder_prepare (GstRecorder * rec)
 
   g_return_val_if_fail (GST_IS_ELEMENT (tcp_sink), FALSE);
 
+  gst_queue_policy_watch (GST_WORKER (rec)->pipeline);
+
   g_signal_connect (tcp_sink, "client-added",
       G_CALLBACK (gst_recorder_client_socket_added), rec);
 
+  g_signal_connect (tcp_sink, "client-removed",
+      G_CALLBACK (gst_client_policy_client_removed), rec);
+
   g_signal_connect (tcp_sink, "client-socket-removed",
       G_CALLBACK (gst_recorder_client_socket_removed), rec);
 
   gst_object_unref (tcp_sink);
+
+  GST_RECORDER_LOCK_DRIFT (rec);
+  rec->video_time = GST_CLOCK_TIME_NONE;
+  rec->audio_start = GST_CLOCK_TIME_NONE;
+  rec->audio_frames = 0;
+  rec->offset = 0;
+  rec->base_offset = 0;
+  rec->measured = 0;
+  rec->correction = 0;
+  GST_RECORDER_UNLOCK_DRIFT (rec);
+
+  gst_recorder_probe_source (rec, "source_video",
+      (GstPadProbeCallback) gst_recorder_video_probe);
+  gst_recorder_probe_source (rec, "audio_format",
+      (GstPadProbeCallback) gst_recorder_audio_probe);
+
+  if (rec->segment_base)
+    gst_recorder_prepare_segments (rec);
+  else if (!gst_recorder_prepare_file (rec))
+    return FALSE;
+  return TRUE;
+}
+
+/**
+ * gst_recorder_message:
+ * @return %TRUE to receive all further messages.
+ *
+ * Report the disk writer falling behind.
+ */
+static gboolean
+gst_recorder_message (GstRecorder * rec, GstMessage * message)
+{
+  const GstStructure *s;
+  guint64 latency = 0, latency_max = 0;
+  guint level = 0;
+
+  if (GST_MESSAGE_TYPE (message) != GST_MESSAGE_ELEMENT)
+    return TRUE;
+
+  s = gst_message_get_structure (message);
+  if (!gst_structure_has_name (s, "recordsink-stats"))
+    return TRUE;
+
+  gst_structure_get_uint (s, "ring-level", &level);
+  gst_structure_get_uint64 (s, "write-latency", &latency);
+  gst_structure_get_uint64 (s, "max-write-latency", &latency_max);
+
+  if (GST_RECORDER_DISK_LEVEL_WARNING <= level ||
+      GST_RECORDER_DISK_LATENCY_WARNING <= latency_max) {
+    WARN ("%s: disk is slow, %u%% buffered, %lld us per write (max %lld us)",
+        GST_WORKER (rec)->name, level, (long long) latency,
+        (long long) latency_max);
+  }
   return TRUE;
 }
 
@@ -394,7 +1277,16 @@ gst_recorder_class_init (GstRecorderClass * klass)
           GST_SWITCH_COMPOSITE_DEFAULT_HEIGHT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (object_class, PROP_FRAMERATE,
+      g_param_spec_uint ("framerate",
+          "Input Framerate",
+          "Input video frames per second",
+          1, GST_SWITCH_COMPOSITE_MAX_FRAMERATE,
+          GST_SWITCH_COMPOSITE_DEFAULT_FRAMERATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   worker_class->prepare = (GstWorkerPrepareFunc) gst_recorder_prepare;
+  worker_class->message = (GstWorkerMessageFunc) gst_recorder_message;
   worker_class->get_pipeline_string = (GstWorkerGetPipelineStringFunc)
       gst_recorder_get_pipeline_string;
 }
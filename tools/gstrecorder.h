@@ -45,7 +45,30 @@ typedef struct _GstRecorderClass GstRecorderClass;
  *  @param sink_port the encode sink port
  *  @param width the video width
  *  @param height the video height
+ *  @param framerate the video frames per second
  *  @param mode the composite mode which is the same as in GstComposite
+ *  @param drift_lock lock for the drift states
+ *  @param video_time the running time the input video has reached
+ *  @param audio_start the running time of the first input audio
+ *  @param audio_frames the audio samples passed since %audio_start
+ *  @param offset smoothed offset of the input audio to the video
+ *  @param base_offset %offset when the measuring started
+ *  @param measured number of audio buffers measured
+ *  @param correction -1 while dropping samples, 1 while repeating them
+ *  @param segment_lock lock for the segment states
+ *  @param segment_base the file name of the segments without the suffix,
+ *         NULL if not recording into segments
+ *  @param manifest the playlist of the recorded segments
+ *  @param file_lock lock for the file branch states
+ *  @param file_bin the bin muxing and writing the recording file
+ *  @param next_file_bin the bin replacing %file_bin in a rotation
+ *  @param video_file_pad the tee pad feeding encoded video to %file_bin
+ *  @param audio_file_pad the tee pad feeding encoded audio to %file_bin
+ *  @param video_block the blocking probe on %video_file_pad
+ *  @param audio_block the blocking probe on %audio_file_pad
+ *  @param blocked_file_pads the number of tee pads blocked for a rotation
+ *  @param file_count the number of file bins created
+ *  @param rotation_dropped the video frames dropped by the last rotation
  */
 struct _GstRecorder
 {
@@ -54,8 +77,33 @@ struct _GstRecorder
   gint sink_port;
   guint width;
   guint height;
+  guint framerate;
 
   GstCompositeMode mode;
+
+  GMutex drift_lock;
+  GstClockTime video_time;
+  GstClockTime audio_start;
+  guint64 audio_frames;
+  GstClockTimeDiff offset;
+  GstClockTimeDiff base_offset;
+  guint64 measured;
+  gint correction;
+
+  GMutex segment_lock;
+  gchar *segment_base;
+  GString *manifest;
+
+  GMutex file_lock;
+  GstElement *file_bin;
+  GstElement *next_file_bin;
+  GstPad *video_file_pad;
+  GstPad *audio_file_pad;
+  gulong video_block;
+  gulong audio_block;
+  guint blocked_file_pads;
+  guint file_count;
+  guint rotation_dropped;
 };
 
 /**
@@ -71,5 +119,7 @@ struct _GstRecorderClass
 };
 
 GType gst_recorder_get_type (void);
+gboolean gst_recorder_new_segment (GstRecorder * rec);
+gboolean gst_recorder_new_file (GstRecorder * rec);
 
 #endif //__GST_RECORDER_H__by_Duzy_Chan__
@@ -218,6 +218,38 @@ gst_switch_client_get_preview_ports (GstSwitchClient * client)
       NULL, G_VARIANT_TYPE ("(s)"));
 }
 
+/**
+ * gst_switch_client_get_preview_shm:
+ *  @param client the GstSwitchClient instance
+ *  @param port the preview port
+ *  @param caps return location for the caps of the frames
+ *  @return the socket of the shared memory preview, or NULL
+ *
+ *  Ask for the shared memory preview of a video preview port, which is only
+ *  of use on the host of the server. The strings are to be freed.
+ *
+ */
+gchar *
+gst_switch_client_get_preview_shm (GstSwitchClient * client, gint port,
+    gchar ** caps)
+{
+  gchar *path = NULL;
+  GVariant *value =
+      gst_switch_client_call_controller (client, "get_preview_shm",
+      g_variant_new ("(i)", port), G_VARIANT_TYPE ("(ss)"));
+  *caps = NULL;
+  if (value) {
+    const gchar *p = NULL, *c = NULL;
+    g_variant_get (value, "(&s&s)", &p, &c);
+    if (*p && *c) {
+      path = g_strdup (p);
+      *caps = g_strdup (c);
+    }
+    g_variant_unref (value);
+  }
+  return path;
+}
+
 /**
  * gst_switch_client_switch:
  *  @param client the GstSwitchClient instance
@@ -243,6 +275,32 @@ gst_switch_client_switch (GstSwitchClient * client, gint channel, gint port)
   return result;
 }
 
+/**
+ * gst_switch_client_transition:
+ *  @param client the GstSwitchClient instance
+ *  @param channel The channel to be switched, 'A' to 'I'
+ *  @param port The target port number
+ *  @param blend The blending effect, e.g. COMPOSITE_BLEND_CROSSFADE
+ *  @param duration The duration of the transition in milliseconds
+ *  @return TRUE when requested.
+ *
+ *  Switch the channel to the target port with a timed transition.
+ *
+ */
+gboolean
+gst_switch_client_transition (GstSwitchClient * client, gint channel,
+    gint port, gint blend, gint duration)
+{
+  gboolean result = FALSE;
+  GVariant *value = gst_switch_client_call_controller (client, "transition",
+      g_variant_new ("(iiii)", channel, port, blend, duration),
+      G_VARIANT_TYPE ("(b)"));
+  if (value) {
+    g_variant_get (value, "(b)", &result);
+  }
+  return result;
+}
+
 /**
  * gst_switch_client_set_composite_mode:
  *  @param client the GstSwitchClient instance
@@ -330,6 +388,616 @@ gst_switch_client_adjust_pip (GstSwitchClient * client, gint dx, gint dy,
   return result;
 }
 
+/**
+ * gst_switch_client_set_layout:
+ *  @param client the GstSwitchClient instance
+ *  @param name the layout name
+ *  @return TRUE when requested.
+ *
+ *  Change the composite layout of the server.
+ *
+ */
+gboolean
+gst_switch_client_set_layout (GstSwitchClient * client, const gchar * name)
+{
+  gboolean result = FALSE;
+  GVariant *value = gst_switch_client_call_controller (client,
+      "set_layout", g_variant_new ("(s)", name), G_VARIANT_TYPE ("(b)"));
+  if (value) {
+    g_variant_get (value, "(b)", &result);
+  }
+  return result;
+}
+
+/**
+ * gst_switch_client_set_video_format:
+ *  @param client the GstSwitchClient instance
+ *  @param width the output width
+ *  @param height the output height
+ *  @param framerate the output frames per second
+ *  @return TRUE when requested.
+ *
+ *  Change the output format of the server.
+ *
+ */
+gboolean
+gst_switch_client_set_video_format (GstSwitchClient * client, gint width,
+    gint height, gint framerate)
+{
+  gboolean result = FALSE;
+  GVariant *value = gst_switch_client_call_controller (client,
+      "set_video_format", g_variant_new ("(iii)", width, height, framerate),
+      G_VARIANT_TYPE ("(b)"));
+  if (value) {
+    g_variant_get (value, "(b)", &result);
+  }
+  return result;
+}
+
+/**
+ * gst_switch_client_set_audio_gain:
+ *  @param client the GstSwitchClient instance
+ *  @param port the audio input port
+ *  @param gain the linear gain
+ *  @return TRUE when requested.
+ *
+ *  Change the gain of a mixed audio input.
+ *
+ */
+gboolean
+gst_switch_client_set_audio_gain (GstSwitchClient * client, gint port,
+    gdouble gain)
+{
+  gboolean result = FALSE;
+  GVariant *value = gst_switch_client_call_controller (client,
+      "set_audio_gain",
+      g_variant_new ("(id)", port, gain),
+      G_VARIANT_TYPE ("(b)"));
+  if (value) {
+    g_variant_get (value, "(b)", &result);
+  }
+  return result;
+}
+
+/**
+ * gst_switch_client_set_audio_mute:
+ *  @param client the GstSwitchClient instance
+ *  @param port the audio input port
+ *  @param mute TRUE to mute the input
+ *  @return TRUE when requested.
+ *
+ *  Mute or unmute a mixed audio input.
+ *
+ */
+gboolean
+gst_switch_client_set_audio_mute (GstSwitchClient * client, gint port,
+    gboolean mute)
+{
+  gboolean result = FALSE;
+  GVariant *value = gst_switch_client_call_controller (client,
+      "set_audio_mute",
+      g_variant_new ("(ib)", port, mute),
+      G_VARIANT_TYPE ("(b)"));
+  if (value) {
+    g_variant_get (value, "(b)", &result);
+  }
+  return result;
+}
+
+/**
+ * gst_switch_client_set_audio_duck:
+ *  @param client the GstSwitchClient instance
+ *  @param port the audio input port
+ *  @param duck TRUE to let the input duck the others
+ *  @return TRUE when requested.
+ *
+ *  Enable or disable ducking by a mixed audio input.
+ *
+ */
+gboolean
+gst_switch_client_set_audio_duck (GstSwitchClient * client, gint port,
+    gboolean duck)
+{
+  gboolean result = FALSE;
+  GVariant *value = gst_switch_client_call_controller (client,
+      "set_audio_duck",
+      g_variant_new ("(ib)", port, duck),
+      G_VARIANT_TYPE ("(b)"));
+  if (value) {
+    g_variant_get (value, "(b)", &result);
+  }
+  return result;
+}
+
+/**
+ * @brief The pending state of an asynchronous remote call.
+ */
+typedef struct _GstSwitchClientCall
+{
+  gchar *method_name;
+  void (*reply_func) (GstSwitchClient * client, GVariant * value);
+} GstSwitchClientCall;
+
+static void
+gst_switch_client_call_free (GstSwitchClientCall * call)
+{
+  g_free (call->method_name);
+  g_free (call);
+}
+
+static void
+gst_switch_client_call_done (GDBusConnection * connection,
+    GAsyncResult * result, GTask * task)
+{
+  GstSwitchClient *client = GST_SWITCH_CLIENT (g_task_get_source_object (task));
+  GstSwitchClientCall *call = g_task_get_task_data (task);
+  GError *error = NULL;
+  GVariant *value;
+
+  value = g_dbus_connection_call_finish (connection, result, &error);
+  if (value) {
+    if (call->reply_func)
+      (*call->reply_func) (client, value);
+    g_task_return_pointer (task, value, (GDestroyNotify) g_variant_unref);
+  } else {
+    ERROR ("%s (%s)", error->message, call->method_name);
+    if (call->reply_func)
+      (*call->reply_func) (client, NULL);
+    g_task_return_error (task, error);
+  }
+  g_object_unref (task);
+}
+
+/**
+ * gst_switch_client_call_controller_async:
+ *
+ * Invoke a remote method without waiting for the reply. Any number of calls
+ * may be in flight, @callback is invoked in the thread-default main context
+ * of the caller once the reply arrived, @reply_func before it. @reply_func
+ * is given NULL if the call failed.
+ */
+static void
+gst_switch_client_call_controller_async (GstSwitchClient * client,
+    const gchar * method_name, GVariant * parameters,
+    const GVariantType * reply_type,
+    void (*reply_func) (GstSwitchClient *, GVariant *),
+    GAsyncReadyCallback callback, gpointer user_data)
+{
+  GTask *task = g_task_new (client, NULL, callback, user_data);
+  GstSwitchClientCall *call = g_new0 (GstSwitchClientCall, 1);
+  GDBusConnection *connection = NULL;
+
+  call->method_name = g_strdup (method_name);
+  call->reply_func = reply_func;
+  g_task_set_task_data (task, call, (GDestroyNotify) gst_switch_client_call_free);
+
+  GST_SWITCH_CLIENT_LOCK_CONTROLLER (client);
+  if (client->controller)
+    connection = G_DBUS_CONNECTION (g_object_ref (client->controller));
+  GST_SWITCH_CLIENT_UNLOCK_CONTROLLER (client);
+
+  if (!connection) {
+    if (parameters)
+      g_variant_unref (g_variant_ref_sink (parameters));
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_NOT_CONNECTED,
+        "No controller connection");
+    g_object_unref (task);
+    return;
+  }
+
+  g_dbus_connection_call (connection, NULL,     /* bus_name */
+      SWITCH_CONTROLLER_OBJECT_PATH, SWITCH_CONTROLLER_OBJECT_NAME,
+      method_name, parameters, reply_type, G_DBUS_CALL_FLAGS_NONE, 5000,
+      NULL, (GAsyncReadyCallback) gst_switch_client_call_done, task);
+  g_object_unref (connection);
+}
+
+static GVariant *
+gst_switch_client_call_controller_finish (GstSwitchClient * client,
+    GAsyncResult * result, GError ** error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, client), NULL);
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/**
+ * gst_switch_client_get_compose_port_async:
+ *  @param client the GstSwitchClient instance
+ *  @param callback invoked when the reply arrived
+ *  @param user_data the data passed to @callback
+ *
+ *  Get the compose port number without blocking, the reply is read by
+ *  %gst_switch_client_finish_port.
+ */
+void
+gst_switch_client_get_compose_port_async (GstSwitchClient * client,
+    GAsyncReadyCallback callback, gpointer user_data)
+{
+  gst_switch_client_call_controller_async (client, "get_compose_port",
+      NULL, G_VARIANT_TYPE ("(i)"), NULL, callback, user_data);
+}
+
+/**
+ * gst_switch_client_get_encode_port_async:
+ *  @param client the GstSwitchClient instance
+ *  @param callback invoked when the reply arrived
+ *  @param user_data the data passed to @callback
+ *
+ *  Get the encode port number without blocking, the reply is read by
+ *  %gst_switch_client_finish_port.
+ */
+void
+gst_switch_client_get_encode_port_async (GstSwitchClient * client,
+    GAsyncReadyCallback callback, gpointer user_data)
+{
+  gst_switch_client_call_controller_async (client, "get_encode_port",
+      NULL, G_VARIANT_TYPE ("(i)"), NULL, callback, user_data);
+}
+
+/**
+ * gst_switch_client_get_audio_port_async:
+ *  @param client the GstSwitchClient instance
+ *  @param callback invoked when the reply arrived
+ *  @param user_data the data passed to @callback
+ *
+ *  Get the audio port number without blocking, the reply is read by
+ *  %gst_switch_client_finish_port.
+ */
+void
+gst_switch_client_get_audio_port_async (GstSwitchClient * client,
+    GAsyncReadyCallback callback, gpointer user_data)
+{
+  gst_switch_client_call_controller_async (client, "get_audio_port",
+      NULL, G_VARIANT_TYPE ("(i)"), NULL, callback, user_data);
+}
+
+/**
+ * gst_switch_client_get_preview_ports_async:
+ *  @param client the GstSwitchClient instance
+ *  @param callback invoked when the reply arrived
+ *  @param user_data the data passed to @callback
+ *
+ *  Get the preview ports without blocking, the reply is read by
+ *  %gst_switch_client_finish_preview_ports.
+ */
+void
+gst_switch_client_get_preview_ports_async (GstSwitchClient * client,
+    GAsyncReadyCallback callback, gpointer user_data)
+{
+  gst_switch_client_call_controller_async (client, "get_preview_ports",
+      NULL, G_VARIANT_TYPE ("(s)"), NULL, callback, user_data);
+}
+
+/**
+ * gst_switch_client_switch_async:
+ *  @param client the GstSwitchClient instance
+ *  @param channel The channel to be switched, 'A' to 'I', or 'a'
+ *  @param port The target port number
+ *  @param callback invoked when the reply arrived
+ *  @param user_data the data passed to @callback
+ *
+ *  Switch the channel to the target port without blocking, the reply is
+ *  read by %gst_switch_client_finish_request.
+ */
+void
+gst_switch_client_switch_async (GstSwitchClient * client, gint channel,
+    gint port, GAsyncReadyCallback callback, gpointer user_data)
+{
+  gst_switch_client_call_controller_async (client, "switch",
+      g_variant_new ("(ii)", channel, port), G_VARIANT_TYPE ("(b)"), NULL,
+      callback, user_data);
+}
+
+/**
+ * gst_switch_client_transition_async:
+ *  @param client the GstSwitchClient instance
+ *  @param channel The channel to be switched, 'A' to 'I'
+ *  @param port The target port number
+ *  @param blend The blending effect, e.g. COMPOSITE_BLEND_CROSSFADE
+ *  @param duration The duration of the transition in milliseconds
+ *  @param callback invoked when the reply arrived
+ *  @param user_data the data passed to @callback
+ *
+ *  Start a timed transition without blocking, the reply is read by
+ *  %gst_switch_client_finish_request.
+ */
+void
+gst_switch_client_transition_async (GstSwitchClient * client, gint channel,
+    gint port, gint blend, gint duration, GAsyncReadyCallback callback,
+    gpointer user_data)
+{
+  gst_switch_client_call_controller_async (client, "transition",
+      g_variant_new ("(iiii)", channel, port, blend, duration),
+      G_VARIANT_TYPE ("(b)"), NULL, callback, user_data);
+}
+
+/**
+ * gst_switch_client_composite_mode_reply:
+ *
+ * The change is not happening if the call failed or the server refused it,
+ * otherwise the flag is left to %gst_switch_client_new_mode_online, which
+ * may have cleared it already.
+ */
+static void
+gst_switch_client_composite_mode_reply (GstSwitchClient * client,
+    GVariant * value)
+{
+  gboolean result = FALSE;
+  if (value)
+    g_variant_get (value, "(b)", &result);
+  if (!result) {
+    GST_SWITCH_CLIENT_LOCK_COMPOSITE_MODE (client);
+    client->changing_composite_mode = FALSE;
+    GST_SWITCH_CLIENT_UNLOCK_COMPOSITE_MODE (client);
+  }
+}
+
+/**
+ * gst_switch_client_set_composite_mode_async:
+ *  @param client the GstSwitchClient instance
+ *  @param mode new composite mode
+ *  @param callback invoked when the reply arrived
+ *  @param user_data the data passed to @callback
+ *
+ *  Set the current composite mode without blocking, the reply is read by
+ *  %gst_switch_client_finish_request. Like the blocking call, a change is
+ *  not requested while another one is not online yet.
+ */
+void
+gst_switch_client_set_composite_mode_async (GstSwitchClient * client,
+    gint mode, GAsyncReadyCallback callback, gpointer user_data)
+{
+  gboolean changing;
+
+  /* Taken before sending, so concurrent calls don't all get through. */
+  GST_SWITCH_CLIENT_LOCK_COMPOSITE_MODE (client);
+  changing = client->changing_composite_mode;
+  client->changing_composite_mode = TRUE;
+  GST_SWITCH_CLIENT_UNLOCK_COMPOSITE_MODE (client);
+
+  if (changing) {
+    GTask *task = g_task_new (client, NULL, callback, user_data);
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_BUSY,
+        "Composite mode is changing");
+    g_object_unref (task);
+    return;
+  }
+
+  gst_switch_client_call_controller_async (client, "set_composite_mode",
+      g_variant_new ("(i)", mode), G_VARIANT_TYPE ("(b)"),
+      gst_switch_client_composite_mode_reply, callback, user_data);
+}
+
+/**
+ * gst_switch_client_new_record_async:
+ *  @param client the GstSwitchClient instance
+ *  @param callback invoked when the reply arrived
+ *  @param user_data the data passed to @callback
+ *
+ *  Start a new recording without blocking, the reply is read by
+ *  %gst_switch_client_finish_request.
+ */
+void
+gst_switch_client_new_record_async (GstSwitchClient * client,
+    GAsyncReadyCallback callback, gpointer user_data)
+{
+  gst_switch_client_call_controller_async (client, "new_record",
+      g_variant_new ("()"), G_VARIANT_TYPE ("(b)"), NULL, callback,
+      user_data);
+}
+
+/**
+ * gst_switch_client_adjust_pip_async:
+ *  @param client the GstSwitchClient instance
+ *  @param dx x position to be adjusted
+ *  @param dy y position to be adjusted
+ *  @param dw w position to be adjusted
+ *  @param dh h position to be adjusted
+ *  @param callback invoked when the reply arrived
+ *  @param user_data the data passed to @callback
+ *
+ *  Adjust the PIP without blocking, the reply is read by
+ *  %gst_switch_client_finish_adjust_pip.
+ */
+void
+gst_switch_client_adjust_pip_async (GstSwitchClient * client, gint dx,
+    gint dy, gint dw, gint dh, GAsyncReadyCallback callback,
+    gpointer user_data)
+{
+  gst_switch_client_call_controller_async (client, "adjust_pip",
+      g_variant_new ("(iiii)", dx, dy, dw, dh), G_VARIANT_TYPE ("(u)"), NULL,
+      callback, user_data);
+}
+
+/**
+ * gst_switch_client_set_layout_async:
+ *  @param client the GstSwitchClient instance
+ *  @param name the layout name
+ *  @param callback invoked when the reply arrived
+ *  @param user_data the data passed to @callback
+ *
+ *  Change the composite layout without blocking, the reply is read by
+ *  %gst_switch_client_finish_request.
+ */
+void
+gst_switch_client_set_layout_async (GstSwitchClient * client,
+    const gchar * name, GAsyncReadyCallback callback, gpointer user_data)
+{
+  gst_switch_client_call_controller_async (client, "set_layout",
+      g_variant_new ("(s)", name), G_VARIANT_TYPE ("(b)"), NULL, callback,
+      user_data);
+}
+
+/**
+ * gst_switch_client_set_video_format_async:
+ *  @param client the GstSwitchClient instance
+ *  @param width the output width
+ *  @param height the output height
+ *  @param framerate the output frames per second
+ *  @param callback invoked when the reply arrived
+ *  @param user_data the data passed to @callback
+ *
+ *  Change the output format without blocking, the reply is read by
+ *  %gst_switch_client_finish_request.
+ */
+void
+gst_switch_client_set_video_format_async (GstSwitchClient * client,
+    gint width, gint height, gint framerate, GAsyncReadyCallback callback,
+    gpointer user_data)
+{
+  gst_switch_client_call_controller_async (client, "set_video_format",
+      g_variant_new ("(iii)", width, height, framerate),
+      G_VARIANT_TYPE ("(b)"), NULL, callback, user_data);
+}
+
+/**
+ * gst_switch_client_set_audio_gain_async:
+ *  @param client the GstSwitchClient instance
+ *  @param port the audio input port
+ *  @param gain the linear gain
+ *  @param callback invoked when the reply arrived
+ *  @param user_data the data passed to @callback
+ *
+ *  Change the gain of a mixed audio input without blocking, the reply is
+ *  read by %gst_switch_client_finish_request.
+ */
+void
+gst_switch_client_set_audio_gain_async (GstSwitchClient * client, gint port,
+    gdouble gain, GAsyncReadyCallback callback, gpointer user_data)
+{
+  gst_switch_client_call_controller_async (client, "set_audio_gain",
+      g_variant_new ("(id)", port, gain), G_VARIANT_TYPE ("(b)"), NULL,
+      callback, user_data);
+}
+
+/**
+ * gst_switch_client_set_audio_mute_async:
+ *  @param client the GstSwitchClient instance
+ *  @param port the audio input port
+ *  @param mute TRUE to mute the input
+ *  @param callback invoked when the reply arrived
+ *  @param user_data the data passed to @callback
+ *
+ *  Mute or unmute a mixed audio input without blocking, the reply is read
+ *  by %gst_switch_client_finish_request.
+ */
+void
+gst_switch_client_set_audio_mute_async (GstSwitchClient * client, gint port,
+    gboolean mute, GAsyncReadyCallback callback, gpointer user_data)
+{
+  gst_switch_client_call_controller_async (client, "set_audio_mute",
+      g_variant_new ("(ib)", port, mute), G_VARIANT_TYPE ("(b)"), NULL,
+      callback, user_data);
+}
+
+/**
+ * gst_switch_client_set_audio_duck_async:
+ *  @param client the GstSwitchClient instance
+ *  @param port the audio input port
+ *  @param duck TRUE to let the input duck the others
+ *  @param callback invoked when the reply arrived
+ *  @param user_data the data passed to @callback
+ *
+ *  Enable or disable ducking by a mixed audio input without blocking, the
+ *  reply is read by %gst_switch_client_finish_request.
+ */
+void
+gst_switch_client_set_audio_duck_async (GstSwitchClient * client, gint port,
+    gboolean duck, GAsyncReadyCallback callback, gpointer user_data)
+{
+  gst_switch_client_call_controller_async (client, "set_audio_duck",
+      g_variant_new ("(ib)", port, duck), G_VARIANT_TYPE ("(b)"), NULL,
+      callback, user_data);
+}
+
+/**
+ * gst_switch_client_finish_port:
+ *  @param client the GstSwitchClient instance
+ *  @param result the result passed to the callback
+ *  @param error return location for an error, or NULL
+ *  @return the port number, or 0 on errors
+ *
+ *  Finish an asynchronous get_compose_port, get_encode_port or
+ *  get_audio_port call.
+ */
+gint
+gst_switch_client_finish_port (GstSwitchClient * client,
+    GAsyncResult * result, GError ** error)
+{
+  gint port = 0;
+  GVariant *value = gst_switch_client_call_controller_finish (client, result,
+      error);
+  if (value) {
+    g_variant_get (value, "(i)", &port);
+    g_variant_unref (value);
+  }
+  return port;
+}
+
+/**
+ * gst_switch_client_finish_preview_ports:
+ *  @param client the GstSwitchClient instance
+ *  @param result the result passed to the callback
+ *  @param error return location for an error, or NULL
+ *  @return The preview ports of type GVariant, or NULL on errors
+ *
+ *  Finish an asynchronous get_preview_ports call.
+ */
+GVariant *
+gst_switch_client_finish_preview_ports (GstSwitchClient * client,
+    GAsyncResult * result, GError ** error)
+{
+  return gst_switch_client_call_controller_finish (client, result, error);
+}
+
+/**
+ * gst_switch_client_finish_request:
+ *  @param client the GstSwitchClient instance
+ *  @param result the result passed to the callback
+ *  @param error return location for an error, or NULL
+ *  @return TRUE if the request was accepted by the server
+ *
+ *  Finish an asynchronous call replying a boolean: switch, transition,
+ *  set_composite_mode, new_record, set_layout, set_video_format and the
+ *  audio mixing calls.
+ */
+gboolean
+gst_switch_client_finish_request (GstSwitchClient * client,
+    GAsyncResult * result, GError ** error)
+{
+  gboolean ok = FALSE;
+  GVariant *value = gst_switch_client_call_controller_finish (client, result,
+      error);
+  if (value) {
+    g_variant_get (value, "(b)", &ok);
+    g_variant_unref (value);
+  }
+  return ok;
+}
+
+/**
+ * gst_switch_client_finish_adjust_pip:
+ *  @param client the GstSwitchClient instance
+ *  @param result the result passed to the callback
+ *  @param error return location for an error, or NULL
+ *  @return the changed components, as %gst_switch_client_adjust_pip
+ *
+ *  Finish an asynchronous adjust_pip call.
+ */
+guint
+gst_switch_client_finish_adjust_pip (GstSwitchClient * client,
+    GAsyncResult * result, GError ** error)
+{
+  guint changed = 0;
+  GVariant *value = gst_switch_client_call_controller_finish (client, result,
+      error);
+  if (value) {
+    g_variant_get (value, "(u)", &changed);
+    g_variant_unref (value);
+  }
+  return changed;
+}
+
 /**
  * gst_switch_client_method_match:
  *
@@ -429,7 +1097,7 @@ static const GDBusInterfaceVTable gst_switch_client_interface_vtable = {
 /**
  * gst_switch_client_on_signal_received:
  *
- * Remote signal handler (useless currently).
+ * Remote signal handler, the audio levels are passed on to the subclass.
  */
 static void
 gst_switch_client_on_signal_received (GDBusConnection * connection,
@@ -439,8 +1107,19 @@ gst_switch_client_on_signal_received (GDBusConnection * connection,
     const gchar * signal_name, GVariant * parameters, gpointer user_data)
 {
   GstSwitchClient *client = GST_SWITCH_CLIENT (user_data);
-
-  (void) client;
+  GstSwitchClientClass *klass =
+      GST_SWITCH_CLIENT_CLASS (G_OBJECT_GET_CLASS (client));
+  gdouble rms, peak, decay;
+  gint port;
+
+  if (g_strcmp0 (signal_name, "audio_level") == 0 &&
+      g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(iddd)"))) {
+    if (klass->audio_level) {
+      g_variant_get (parameters, "(iddd)", &port, &rms, &peak, &decay);
+      (*klass->audio_level) (client, port, rms, peak, decay);
+    }
+    return;
+  }
 
   INFO ("signal: %s, %s", sender_name, signal_name);
 }
@@ -51,6 +51,8 @@ typedef void (*GstSwitchClientAddPreviewPortFunc) (GstSwitchClient * client,
     gint port, gint serve, gint type);
 typedef void (*GstSwitchClientNewModeOnlineFunc) (GstSwitchClient * client,
     gint port);
+typedef void (*GstSwitchClientAudioLevelFunc) (GstSwitchClient * client,
+    gint port, gdouble rms, gdouble peak, gdouble decay);
 
 /**
  *  GstSwitchClient:
@@ -84,6 +86,8 @@ struct _GstSwitchClientClass
   void (*add_preview_port) (GstSwitchClient * client, gint port, gint serve,
       gint type);
   void (*new_mode_online) (GstSwitchClient * client, gint mode);
+  void (*audio_level) (GstSwitchClient * client, gint port, gdouble rms,
+      gdouble peak, gdouble decay);
 };
 
 GType gst_switch_client_get_type (void);
@@ -94,12 +98,70 @@ gint gst_switch_client_get_compose_port (GstSwitchClient * client);
 gint gst_switch_client_get_encode_port (GstSwitchClient * client);
 gint gst_switch_client_get_audio_port (GstSwitchClient * client);
 GVariant *gst_switch_client_get_preview_ports (GstSwitchClient * client);
+gchar *gst_switch_client_get_preview_shm (GstSwitchClient * client,
+    gint port, gchar ** caps);
 gboolean gst_switch_client_switch (GstSwitchClient * client, gint channel,
     gint port);
+gboolean gst_switch_client_transition (GstSwitchClient * client,
+    gint channel, gint port, gint blend, gint duration);
 gboolean gst_switch_client_set_composite_mode (GstSwitchClient * client,
     gint mode);
 gboolean gst_switch_client_new_record (GstSwitchClient * client);
 guint gst_switch_client_adjust_pip (GstSwitchClient * client, gint dx,
     gint dy, gint dw, gint dh);
+gboolean gst_switch_client_set_layout (GstSwitchClient * client,
+    const gchar * name);
+gboolean gst_switch_client_set_video_format (GstSwitchClient * client,
+    gint width, gint height, gint framerate);
+gboolean gst_switch_client_set_audio_gain (GstSwitchClient * client,
+    gint port, gdouble gain);
+gboolean gst_switch_client_set_audio_mute (GstSwitchClient * client,
+    gint port, gboolean mute);
+gboolean gst_switch_client_set_audio_duck (GstSwitchClient * client,
+    gint port, gboolean duck);
+
+void gst_switch_client_get_compose_port_async (GstSwitchClient * client,
+    GAsyncReadyCallback callback, gpointer user_data);
+void gst_switch_client_get_encode_port_async (GstSwitchClient * client,
+    GAsyncReadyCallback callback, gpointer user_data);
+void gst_switch_client_get_audio_port_async (GstSwitchClient * client,
+    GAsyncReadyCallback callback, gpointer user_data);
+void gst_switch_client_get_preview_ports_async (GstSwitchClient * client,
+    GAsyncReadyCallback callback, gpointer user_data);
+void gst_switch_client_switch_async (GstSwitchClient * client, gint channel,
+    gint port, GAsyncReadyCallback callback, gpointer user_data);
+void gst_switch_client_transition_async (GstSwitchClient * client,
+    gint channel, gint port, gint blend, gint duration,
+    GAsyncReadyCallback callback, gpointer user_data);
+void gst_switch_client_set_composite_mode_async (GstSwitchClient * client,
+    gint mode, GAsyncReadyCallback callback, gpointer user_data);
+void gst_switch_client_new_record_async (GstSwitchClient * client,
+    GAsyncReadyCallback callback, gpointer user_data);
+void gst_switch_client_adjust_pip_async (GstSwitchClient * client, gint dx,
+    gint dy, gint dw, gint dh, GAsyncReadyCallback callback,
+    gpointer user_data);
+void gst_switch_client_set_layout_async (GstSwitchClient * client,
+    const gchar * name, GAsyncReadyCallback callback, gpointer user_data);
+void gst_switch_client_set_video_format_async (GstSwitchClient * client,
+    gint width, gint height, gint framerate, GAsyncReadyCallback callback,
+    gpointer user_data);
+void gst_switch_client_set_audio_gain_async (GstSwitchClient * client,
+    gint port, gdouble gain, GAsyncReadyCallback callback,
+    gpointer user_data);
+void gst_switch_client_set_audio_mute_async (GstSwitchClient * client,
+    gint port, gboolean mute, GAsyncReadyCallback callback,
+    gpointer user_data);
+void gst_switch_client_set_audio_duck_async (GstSwitchClient * client,
+    gint port, gboolean duck, GAsyncReadyCallback callback,
+    gpointer user_data);
+
+gint gst_switch_client_finish_port (GstSwitchClient * client,
+    GAsyncResult * result, GError ** error);
+GVariant *gst_switch_client_finish_preview_ports (GstSwitchClient * client,
+    GAsyncResult * result, GError ** error);
+gboolean gst_switch_client_finish_request (GstSwitchClient * client,
+    GAsyncResult * result, GError ** error);
+guint gst_switch_client_finish_adjust_pip (GstSwitchClient * client,
+    GAsyncResult * result, GError ** error);
 
 #endif //__GST_SWITCH_CLIENT_H__by_Duzy_Chan__
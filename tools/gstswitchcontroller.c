@@ -34,6 +34,62 @@
 
 #define GST_SWITCH_CONTROLLER_LOCK_UIS(c) (g_mutex_lock (&(c)->uis_lock))
 #define GST_SWITCH_CONTROLLER_UNLOCK_UIS(c) (g_mutex_unlock (&(c)->uis_lock))
+#define GST_SWITCH_CONTROLLER_LOCK_LISTENERS(c) (g_mutex_lock (&(c)->listeners_lock))
+#define GST_SWITCH_CONTROLLER_UNLOCK_LISTENERS(c) (g_mutex_unlock (&(c)->listeners_lock))
+
+#define GST_SWITCH_CONTROLLER_CALL_TIMEOUT 5000 /* ms */
+#define GST_SWITCH_CONTROLLER_MAX_PENDING 64    /* messages queued per UI */
+
+/**
+ * A message waiting in the outbound queue of a UI, either a remote method
+ * call or a signal.
+ */
+typedef struct _GstSwitchControllerMessage
+{
+  gboolean is_call;
+  gchar *name;
+  GVariant *parameters;
+  GVariantType *reply_type;
+} GstSwitchControllerMessage;
+
+/**
+ * A connected UI. Only one method call is in flight at a time, the messages
+ * queued behind it are sent in order when its reply arrives.
+ */
+typedef struct _GstSwitchControllerUi
+{
+  GDBusConnection *connection;
+  gulong closed_handler;
+  GQueue queue;
+  gboolean busy;
+} GstSwitchControllerUi;
+
+/**
+ * A function told about the notifications sent to the UIs.
+ */
+typedef struct _GstSwitchControllerListenerEntry
+{
+  GstSwitchControllerListener func;
+  gpointer data;
+} GstSwitchControllerListenerEntry;
+
+/**
+ * The messages only telling the latest value, a queued one is replaced by a
+ * newer one of the same name rather than sent twice.
+ */
+static const gchar *gst_switch_controller_latest_only[] = {
+  "audio_port", "compose_port", "encode_port",
+  "set_audio_port", "set_compose_port", "set_encode_port",
+  "new_mode_online", NULL
+};
+
+/**
+ * The messages only telling the latest value of a port, the first
+ * parameter. A queued one is replaced by a newer one of the same port.
+ */
+static const gchar *gst_switch_controller_latest_per_port[] = {
+  "audio_level", NULL
+};
 
 enum
 {
@@ -62,6 +118,11 @@ static const gchar introspection_xml[] =
     "    <method name='get_preview_ports'>"
     "      <arg type='s' name='ports' direction='out'/>"
     "    </method>"
+    "    <method name='get_preview_shm'>"
+    "      <arg type='i' name='port' direction='in'/>"
+    "      <arg type='s' name='path' direction='out'/>"
+    "      <arg type='s' name='caps' direction='out'/>"
+    "    </method>"
     "    <method name='set_composite_mode'>"
     "      <arg type='i' name='channel' direction='in'/>"
     "      <arg type='b' name='result' direction='out'/>"
@@ -84,6 +145,38 @@ static const gchar introspection_xml[] =
     "      <arg type='i' name='channel' direction='in'/>"
     "      <arg type='i' name='port' direction='in'/>"
     "      <arg type='b' name='result' direction='out'/>" "    </method>"
+    "    <method name='transition'>"
+    "      <arg type='i' name='channel' direction='in'/>"
+    "      <arg type='i' name='port' direction='in'/>"
+    "      <arg type='i' name='blend' direction='in'/>"
+    "      <arg type='i' name='duration' direction='in'/>"
+    "      <arg type='b' name='result' direction='out'/>"
+    "    </method>"
+    "    <method name='set_layout'>"
+    "      <arg type='s' name='name' direction='in'/>"
+    "      <arg type='b' name='result' direction='out'/>"
+    "    </method>"
+    "    <method name='set_video_format'>"
+    "      <arg type='i' name='width' direction='in'/>"
+    "      <arg type='i' name='height' direction='in'/>"
+    "      <arg type='i' name='framerate' direction='in'/>"
+    "      <arg type='b' name='result' direction='out'/>"
+    "    </method>"
+    "    <method name='set_audio_gain'>"
+    "      <arg type='i' name='port' direction='in'/>"
+    "      <arg type='d' name='gain' direction='in'/>"
+    "      <arg type='b' name='result' direction='out'/>"
+    "    </method>"
+    "    <method name='set_audio_mute'>"
+    "      <arg type='i' name='port' direction='in'/>"
+    "      <arg type='b' name='mute' direction='in'/>"
+    "      <arg type='b' name='result' direction='out'/>"
+    "    </method>"
+    "    <method name='set_audio_duck'>"
+    "      <arg type='i' name='port' direction='in'/>"
+    "      <arg type='b' name='duck' direction='in'/>"
+    "      <arg type='b' name='result' direction='out'/>"
+    "    </method>"
 #if ENABLE_TEST
     "    <signal name='testsignal'>"
     "      <arg type='s' name='str'/>" "    </signal>"
@@ -101,6 +194,12 @@ static const gchar introspection_xml[] =
     "      <arg type='i' name='port'/>"
     "      <arg type='i' name='serve'/>"
     "      <arg type='i' name='type'/>"
+    "    </signal>"
+    "    <signal name='audio_level'>"
+    "      <arg type='i' name='port'/>"
+    "      <arg type='d' name='rms'/>"
+    "      <arg type='d' name='peak'/>"
+    "      <arg type='d' name='decay'/>"
     "    </signal>" "  </interface>" "</node>";
 /*
   "    <property type='s' name='Name' access='readwrite'/>"
@@ -273,42 +372,292 @@ gst_switch_controller_export (GstSwitchController * controller)
 }
 #endif
 
+static GstSwitchControllerMessage *
+gst_switch_controller_message_new (gboolean is_call, const gchar * name,
+    GVariant * parameters, const GVariantType * reply_type)
+{
+  GstSwitchControllerMessage *msg = g_new0 (GstSwitchControllerMessage, 1);
+  msg->is_call = is_call;
+  msg->name = g_strdup (name);
+  msg->parameters = g_variant_ref (parameters);
+  msg->reply_type = reply_type ? g_variant_type_copy (reply_type) : NULL;
+  return msg;
+}
+
+static void
+gst_switch_controller_message_free (GstSwitchControllerMessage * msg)
+{
+  g_free (msg->name);
+  g_variant_unref (msg->parameters);
+  if (msg->reply_type)
+    g_variant_type_free (msg->reply_type);
+  g_free (msg);
+}
+
+static void gst_switch_controller_on_connection_closed (GDBusConnection *,
+    gboolean, GError *, gpointer);
+
+static GstSwitchControllerUi *
+gst_switch_controller_ui_new (GstSwitchController * controller,
+    GDBusConnection * connection)
+{
+  GstSwitchControllerUi *ui = g_new0 (GstSwitchControllerUi, 1);
+  ui->connection = G_DBUS_CONNECTION (g_object_ref (connection));
+  ui->closed_handler = g_signal_connect (connection, "closed",
+      G_CALLBACK (gst_switch_controller_on_connection_closed), controller);
+  g_queue_init (&ui->queue);
+  ui->busy = FALSE;
+  return ui;
+}
+
+static void
+gst_switch_controller_ui_free (GstSwitchControllerUi * ui)
+{
+  GstSwitchControllerMessage *msg;
+
+  g_signal_handler_disconnect (ui->connection, ui->closed_handler);
+  while ((msg = g_queue_pop_head (&ui->queue)))
+    gst_switch_controller_message_free (msg);
+  g_object_unref (ui->connection);
+  g_free (ui);
+}
+
 /**
- * gst_switch_controller_emit_ui_signal:
+ * gst_switch_controller_find_ui:
  *
- * Perform sending remote signals to connected clients.
+ * Find the UI of a connection, the %uis_lock must be held.
+ */
+static GList *
+gst_switch_controller_find_ui (GstSwitchController * controller,
+    GDBusConnection * connection)
+{
+  GList *item;
+  for (item = controller->uis; item; item = g_list_next (item)) {
+    if (((GstSwitchControllerUi *) item->data)->connection == connection)
+      return item;
+  }
+  return NULL;
+}
+
+/**
+ * gst_switch_controller_same_port:
+ * @return TRUE if both parameters start with the same port number.
+ */
+static gboolean
+gst_switch_controller_same_port (GVariant * a, GVariant * b)
+{
+  GVariant *pa = g_variant_get_child_value (a, 0);
+  GVariant *pb = g_variant_get_child_value (b, 0);
+  gboolean same = g_variant_equal (pa, pb);
+  g_variant_unref (pa);
+  g_variant_unref (pb);
+  return same;
+}
+
+/**
+ * gst_switch_controller_coalesce:
+ * @return TRUE if a queued message is dropped for @msg.
+ *
+ * A queued message of the same name, and of the same port for the
+ * per-port messages, is dropped if only the latest value matters, an
+ * identical queued message is dropped too. @msg is then queued at the
+ * tail, so the UI still gets the messages in the order they were sent.
+ */
+static gboolean
+gst_switch_controller_coalesce (GstSwitchControllerUi * ui,
+    GstSwitchControllerMessage * msg)
+{
+  gboolean latest_only = FALSE, per_port = FALSE;
+  GList *item;
+  gint n;
+
+  for (n = 0; gst_switch_controller_latest_only[n]; ++n) {
+    if (g_strcmp0 (gst_switch_controller_latest_only[n], msg->name) == 0)
+      latest_only = TRUE;
+  }
+  for (n = 0; gst_switch_controller_latest_per_port[n]; ++n) {
+    if (g_strcmp0 (gst_switch_controller_latest_per_port[n], msg->name) == 0)
+      per_port = TRUE;
+  }
+
+  for (item = ui->queue.head; item; item = g_list_next (item)) {
+    GstSwitchControllerMessage *queued = item->data;
+    if (queued->is_call != msg->is_call ||
+        g_strcmp0 (queued->name, msg->name) != 0)
+      continue;
+    if (per_port && !gst_switch_controller_same_port (queued->parameters,
+            msg->parameters))
+      continue;
+    if (latest_only || per_port ||
+        g_variant_equal (queued->parameters, msg->parameters)) {
+      g_queue_delete_link (&ui->queue, item);
+      gst_switch_controller_message_free (queued);
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+static void gst_switch_controller_call_done (GObject *, GAsyncResult *,
+    gpointer);
+
+/**
+ * gst_switch_controller_flush_ui:
+ *
+ * Send the queued messages of a UI until a method call is in flight. The
+ * %uis_lock must be held, nothing here blocks on the UI.
  */
 static void
-gst_switch_controller_emit_ui_signal (GstSwitchController * controller,
-    const gchar * signame, GVariant * parameters)
+gst_switch_controller_flush_ui (GstSwitchController * controller,
+    GstSwitchControllerUi * ui)
 {
+  GstSwitchControllerMessage *msg;
   GError *error;
-  gboolean res;
-  GList *ui;
-  gint num;
+
+  while (!ui->busy && (msg = g_queue_pop_head (&ui->queue))) {
+    if (msg->is_call) {
+      /* the reply is handled by the main loop */
+      g_main_context_push_thread_default (NULL);
+      g_dbus_connection_call (ui->connection, NULL,     /* bus_name */
+          SWITCH_CLIENT_OBJECT_PATH, SWITCH_CLIENT_OBJECT_NAME,
+          msg->name, msg->parameters, msg->reply_type,
+          G_DBUS_CALL_FLAGS_NONE, GST_SWITCH_CONTROLLER_CALL_TIMEOUT,
+          NULL, gst_switch_controller_call_done, g_object_ref (controller));
+      g_main_context_pop_thread_default (NULL);
+      ui->busy = TRUE;
+    } else {
+      error = NULL;
+      if (!g_dbus_connection_emit_signal (ui->connection, NULL,  /* destination_bus_name */
+              SWITCH_CLIENT_OBJECT_PATH, SWITCH_CLIENT_OBJECT_NAME,
+              msg->name, msg->parameters, &error)) {
+        ERROR ("emit: %s (%s)", error->message, msg->name);
+        g_error_free (error);
+      }
+    }
+    gst_switch_controller_message_free (msg);
+  }
+}
+
+/**
+ * gst_switch_controller_call_done:
+ *
+ * Invoked in the main loop when a UI replied to a method call, or the call
+ * timed out. The next queued messages of the UI are sent.
+ */
+static void
+gst_switch_controller_call_done (GObject * source, GAsyncResult * result,
+    gpointer data)
+{
+  GstSwitchController *controller = GST_SWITCH_CONTROLLER (data);
+  GDBusConnection *connection = G_DBUS_CONNECTION (source);
+  GError *error = NULL;
+  GVariant *value;
+  GList *item;
+
+  value = g_dbus_connection_call_finish (connection, result, &error);
+  if (value) {
+    g_variant_unref (value);
+  } else {
+    ERROR ("call: %s", error->message);
+    g_error_free (error);
+  }
 
   GST_SWITCH_CONTROLLER_LOCK_UIS (controller);
+  if ((item = gst_switch_controller_find_ui (controller, connection))) {
+    GstSwitchControllerUi *ui = item->data;
+    ui->busy = FALSE;
+    gst_switch_controller_flush_ui (controller, ui);
+  }
+  GST_SWITCH_CONTROLLER_UNLOCK_UIS (controller);
+
+  g_object_unref (controller);
+}
+
+/**
+ * gst_switch_controller_dispatch:
+ *
+ * Queue a method call or a signal to every connected UI and send it unless
+ * the UI is still busy with an earlier call. A UI falling behind by more
+ * than GST_SWITCH_CONTROLLER_MAX_PENDING messages is disconnected, so a
+ * hung UI never holds back the server or the other UIs.
+ */
+static void
+gst_switch_controller_dispatch (GstSwitchController * controller,
+    gboolean is_call, const gchar * name, GVariant * parameters,
+    const GVariantType * reply_type)
+{
+  GstSwitchControllerMessage *msg;
+  GstSwitchControllerUi *ui;
+  GList *item, *next;
+
   g_assert (parameters);
   g_variant_ref_sink (parameters);
 
-  for (ui = controller->uis, num = 0; ui; ui = g_list_next (ui)) {
-    error = NULL;
-    res = g_dbus_connection_emit_signal (G_DBUS_CONNECTION (ui->data), NULL,    /* destination_bus_name */
-        SWITCH_CLIENT_OBJECT_PATH,
-        SWITCH_CLIENT_OBJECT_NAME, signame, parameters, &error);
+  GST_SWITCH_CONTROLLER_LOCK_UIS (controller);
+  if (controller->uis == NULL && is_call)
+    WARN ("%s: no connections", name);
+
+  for (item = controller->uis; item; item = next) {
+    next = g_list_next (item);
+    ui = item->data;
+    if (g_dbus_connection_is_closed (ui->connection))
+      continue;
 
-    if (!res) {
-      ERROR ("emit: (%d) %s", num, error->message);
-    } else {
-      ++num;
+    msg = gst_switch_controller_message_new (is_call, name, parameters,
+        reply_type);
+    gst_switch_controller_coalesce (ui, msg);
+    g_queue_push_tail (&ui->queue, msg);
+    if (GST_SWITCH_CONTROLLER_MAX_PENDING < g_queue_get_length (&ui->queue)) {
+      WARN ("UI %p is not responding, disconnecting", ui->connection);
+      controller->uis = g_list_delete_link (controller->uis, item);
+      g_dbus_connection_close (ui->connection, NULL, NULL, NULL);
+      gst_switch_controller_ui_free (ui);
+      continue;
     }
+
+    gst_switch_controller_flush_ui (controller, ui);
   }
-  /*
-     INFO ("emit: %s (%d/%d)", signame, num, g_list_length (controller->uis));
-   */
+  GST_SWITCH_CONTROLLER_UNLOCK_UIS (controller);
+
   g_variant_unref (parameters);
+}
 
-  GST_SWITCH_CONTROLLER_UNLOCK_UIS (controller);
+/**
+ * gst_switch_controller_notify_listeners:
+ *
+ * Tell the listeners about a notification sent to the UIs.
+ */
+static void
+gst_switch_controller_notify_listeners (GstSwitchController * controller,
+    const gchar * name, GVariant * parameters)
+{
+  GstSwitchControllerListenerEntry *entry;
+  GSList *item;
+
+  GST_SWITCH_CONTROLLER_LOCK_LISTENERS (controller);
+  for (item = controller->listeners; item; item = g_slist_next (item)) {
+    entry = item->data;
+    (*entry->func) (name, parameters, entry->data);
+  }
+  GST_SWITCH_CONTROLLER_UNLOCK_LISTENERS (controller);
+}
+
+/**
+ * gst_switch_controller_emit_ui_signal:
+ *
+ * Perform sending remote signals to connected clients.
+ */
+static void
+gst_switch_controller_emit_ui_signal (GstSwitchController * controller,
+    const gchar * signame, GVariant * parameters)
+{
+  g_variant_ref_sink (parameters);
+  gst_switch_controller_dispatch (controller, FALSE, signame, parameters,
+      NULL);
+
+  gst_switch_controller_notify_listeners (controller, signame, parameters);
+
+  g_variant_unref (parameters);
 }
 
 /**
@@ -321,17 +670,17 @@ gst_switch_controller_on_connection_closed (GDBusConnection * connection,
     gboolean vanished, GError * error, gpointer user_data)
 {
   GstSwitchController *controller = GST_SWITCH_CONTROLLER (user_data);
-
-  (void) controller;
+  GList *item;
 
   if (error) {
     WARN ("close: %s", error->message);
-    g_error_free (error);
   }
 
-  g_object_unref (connection);
   GST_SWITCH_CONTROLLER_LOCK_UIS (controller);
-  controller->uis = g_list_remove (controller->uis, connection);
+  if ((item = gst_switch_controller_find_ui (controller, connection))) {
+    gst_switch_controller_ui_free (item->data);
+    controller->uis = g_list_delete_link (controller->uis, item);
+  }
   GST_SWITCH_CONTROLLER_UNLOCK_UIS (controller);
 
   INFO ("closed: %p, %d (%d uis)", connection, vanished,
@@ -352,11 +701,8 @@ gst_switch_controller_on_new_connection (GDBusServer * server,
   GError *error = NULL;
 
   GST_SWITCH_CONTROLLER_LOCK_UIS (controller);
-  controller->uis = g_list_append (controller->uis, connection);
-  g_object_ref (connection);
-
-  g_signal_connect (connection, "closed",
-      G_CALLBACK (gst_switch_controller_on_connection_closed), controller);
+  controller->uis = g_list_append (controller->uis,
+      gst_switch_controller_ui_new (controller, connection));
   GST_SWITCH_CONTROLLER_UNLOCK_UIS (controller);
 
   register_id = g_dbus_connection_register_object (connection, SWITCH_CONTROLLER_OBJECT_PATH, introspection_data->interfaces[0], &gst_switch_controller_interface_vtable, controller,   /* user_data */
@@ -381,10 +727,13 @@ gst_switch_controller_on_new_connection (GDBusServer * server,
   /* ERRORS */
 error_register_object:
   {
+    GList *item;
     ERROR ("register: %s", error->message);
     GST_SWITCH_CONTROLLER_LOCK_UIS (controller);
-    controller->uis = g_list_remove (controller->uis, connection);
-    g_object_unref (connection);
+    if ((item = gst_switch_controller_find_ui (controller, connection))) {
+      gst_switch_controller_ui_free (item->data);
+      controller->uis = g_list_delete_link (controller->uis, item);
+    }
     GST_SWITCH_CONTROLLER_UNLOCK_UIS (controller);
     return FALSE;
   }
@@ -421,6 +770,8 @@ gst_switch_controller_init (GstSwitchController * controller)
 
   g_mutex_init (&controller->uis_lock);
   controller->uis = NULL;
+  g_mutex_init (&controller->listeners_lock);
+  controller->listeners = NULL;
 
   flags |= G_DBUS_SERVER_FLAGS_RUN_IN_THREAD;
   flags |= G_DBUS_SERVER_FLAGS_AUTHENTICATION_ALLOW_ANONYMOUS;
@@ -478,7 +829,13 @@ gst_switch_controller_finalize (GstSwitchController * controller)
     controller->bus_server = NULL;
   }
 
+  g_list_free_full (controller->uis,
+      (GDestroyNotify) gst_switch_controller_ui_free);
+  controller->uis = NULL;
   g_mutex_clear (&controller->uis_lock);
+  g_slist_free_full (controller->listeners, g_free);
+  controller->listeners = NULL;
+  g_mutex_clear (&controller->listeners_lock);
 
   if (G_OBJECT_CLASS (gst_switch_controller_parent_class)->finalize)
     (*G_OBJECT_CLASS (gst_switch_controller_parent_class)->finalize)
@@ -504,6 +861,22 @@ gst_switch_controller_is_valid (GstSwitchController * controller)
   return valid;
 }
 
+/**
+ * gst_switch_controller_call_uis:
+ *
+ * Invoke a remote method on all connected clients, without waiting for
+ * the replies.
+ */
+static void
+gst_switch_controller_call_uis (GstSwitchController * controller,
+    const gchar * method_name,
+    GVariant * parameters, const GVariantType * reply_type)
+{
+  gst_switch_controller_dispatch (controller, TRUE, method_name, parameters,
+      reply_type);
+}
+
+#if ENABLE_TEST
 /**
  * gst_switch_controller_call_ui:
  *
@@ -523,8 +896,9 @@ gst_switch_controller_call_ui (GstSwitchController * controller,
    */
 
   value = g_dbus_connection_call_sync (connection, NULL,        /* bus_name */
-      SWITCH_CLIENT_OBJECT_PATH, SWITCH_CLIENT_OBJECT_NAME, method_name, parameters, reply_type, G_DBUS_CALL_FLAGS_NONE, 5000,  /* timeout_msec */
-      NULL /* TODO: cancellable */ ,
+      SWITCH_CLIENT_OBJECT_PATH, SWITCH_CLIENT_OBJECT_NAME, method_name,
+      parameters, reply_type, G_DBUS_CALL_FLAGS_NONE,
+      GST_SWITCH_CONTROLLER_CALL_TIMEOUT, NULL /* TODO: cancellable */ ,
       &error);
 
   if (!value)
@@ -541,51 +915,6 @@ error_call_sync:
   }
 }
 
-/**
- * gst_switch_controller_call_uis:
- *
- * Invoke a remote method on all connected clients.
- */
-static void
-gst_switch_controller_call_uis (GstSwitchController * controller,
-    const gchar * method_name,
-    GVariant * parameters, const GVariantType * reply_type)
-{
-  GDBusConnection *connection;
-  GVariant *value;
-  GList *ui;
-
-  g_variant_ref_sink (parameters);
-
-  if (controller->uis == NULL) {
-    WARN ("%s: no connections", method_name);
-    g_variant_unref (parameters);
-    return;
-  }
-
-  GST_SWITCH_CONTROLLER_LOCK_UIS (controller);
-  for (ui = controller->uis; ui;) {
-    connection = G_DBUS_CONNECTION (ui->data);
-    if (g_dbus_connection_is_closed (connection)) {
-      INFO ("UI closed: %p", connection);
-      ui = g_list_next (ui);
-      g_object_unref (connection);
-      controller->uis = g_list_remove (controller->uis, connection);
-      continue;
-    }
-    value = gst_switch_controller_call_ui (controller,
-        connection, method_name, parameters, reply_type);
-    if (value) {
-      // ...
-    }
-    ui = g_list_next (ui);
-  }
-
-  g_variant_unref (parameters);
-  GST_SWITCH_CONTROLLER_UNLOCK_UIS (controller);
-}
-
-#if ENABLE_TEST
 static gchar *
 gst_switch_controller_test_ui (GstSwitchController * controller,
     GDBusConnection * connection, gchar * s)
@@ -764,6 +1093,24 @@ gst_switch_controller_tell_preview_port (GstSwitchController * controller,
   gst_switch_controller_add_ui_preview_port (controller, port, serve, type);
 }
 
+/**
+ * gst_switch_controller_tell_audio_level:
+ *  @param controller the GstSwitchController instance
+ *  @param port the port number of the audio preview
+ *  @param rms the RMS level (in dB)
+ *  @param peak the peak level (in dB)
+ *  @param decay the decaying peak level (in dB)
+ *
+ *  Tell the level of an audio input to the clients.
+ */
+void
+gst_switch_controller_tell_audio_level (GstSwitchController * controller,
+    gint port, gdouble rms, gdouble peak, gdouble decay)
+{
+  gst_switch_controller_emit_ui_signal (controller, "audio_level",
+      g_variant_new ("(iddd)", port, rms, peak, decay));
+}
+
 /**
  * gst_switch_controller_tell_new_mode_onlne:
  *  @param controller the GstSwitchController instance
@@ -775,8 +1122,207 @@ void
 gst_switch_controller_tell_new_mode_onlne (GstSwitchController * controller,
     gint mode)
 {
+  GVariant *parameters = g_variant_ref_sink (g_variant_new ("(i)", mode));
+
   gst_switch_controller_call_uis (controller, "new_mode_online",
-      g_variant_new ("(i)", mode), G_VARIANT_TYPE ("()"));
+      parameters, G_VARIANT_TYPE ("()"));
+
+  gst_switch_controller_notify_listeners (controller, "new_mode_online",
+      parameters);
+
+  g_variant_unref (parameters);
+}
+
+/**
+ * gst_switch_controller_add_listener:
+ *  @param controller the GstSwitchController instance
+ *  @param func the function to be told
+ *  @param data the data passed to @func
+ *
+ *  Tell @func about every signal sent to the UIs and about the new
+ *  composite modes online. It's invoked from the server threads and must
+ *  not block.
+ */
+void
+gst_switch_controller_add_listener (GstSwitchController * controller,
+    GstSwitchControllerListener func, gpointer data)
+{
+  GstSwitchControllerListenerEntry *entry =
+      g_new0 (GstSwitchControllerListenerEntry, 1);
+  entry->func = func;
+  entry->data = data;
+
+  GST_SWITCH_CONTROLLER_LOCK_LISTENERS (controller);
+  controller->listeners = g_slist_append (controller->listeners, entry);
+  GST_SWITCH_CONTROLLER_UNLOCK_LISTENERS (controller);
+}
+
+/**
+ * gst_switch_controller_remove_listener:
+ *  @param controller the GstSwitchController instance
+ *  @param func the function added by %gst_switch_controller_add_listener
+ *  @param data the data added with @func
+ *
+ *  Stop telling @func, it's not invoked any more once this returns.
+ */
+void
+gst_switch_controller_remove_listener (GstSwitchController * controller,
+    GstSwitchControllerListener func, gpointer data)
+{
+  GstSwitchControllerListenerEntry *entry;
+  GSList *item;
+
+  GST_SWITCH_CONTROLLER_LOCK_LISTENERS (controller);
+  for (item = controller->listeners; item; item = g_slist_next (item)) {
+    entry = item->data;
+    if (entry->func == func && entry->data == data) {
+      controller->listeners = g_slist_delete_link (controller->listeners,
+          item);
+      g_free (entry);
+      break;
+    }
+  }
+  GST_SWITCH_CONTROLLER_UNLOCK_LISTENERS (controller);
+}
+
+/**
+ * gst_switch_controller_get_in_type:
+ *  @param controller the GstSwitchController instance
+ *  @param method_name the remote method name
+ *  @return the tuple type of the method parameters, free it with
+ *          g_variant_type_free, or NULL for an unknown method
+ */
+GVariantType *
+gst_switch_controller_get_in_type (GstSwitchController * controller,
+    const gchar * method_name)
+{
+  GDBusMethodInfo *info;
+  GString *signature;
+  GVariantType *type;
+  gint n;
+
+  info = g_dbus_interface_info_lookup_method (introspection_data->
+      interfaces[0], method_name);
+  if (!info)
+    return NULL;
+
+  signature = g_string_new ("(");
+  for (n = 0; info->in_args && info->in_args[n]; ++n)
+    g_string_append (signature, info->in_args[n]->signature);
+  g_string_append (signature, ")");
+  type = g_variant_type_new (signature->str);
+  g_string_free (signature, TRUE);
+  return type;
+}
+
+/**
+ * A method invoked by another control protocol, run by the main loop in
+ * turn with the D-Bus calls while the protocol thread waits for it.
+ */
+typedef struct _GstSwitchControllerInvocation
+{
+  GstSwitchController *controller;
+  MethodFunc entry;
+  GVariant *parameters;
+  GVariant *results;
+  gboolean done;
+  GMutex lock;
+  GCond cond;
+} GstSwitchControllerInvocation;
+
+/**
+ * gst_switch_controller_run_invocation:
+ * @return Always FALSE, the invocation runs once.
+ *
+ * Run an invoked method in the main loop and wake up the waiting thread.
+ */
+static gboolean
+gst_switch_controller_run_invocation (GstSwitchControllerInvocation * inv)
+{
+  GVariant *results = (*inv->entry) (G_OBJECT (inv->controller), NULL,
+      inv->parameters);
+
+  g_mutex_lock (&inv->lock);
+  inv->results = results ? g_variant_ref_sink (results) : NULL;
+  inv->done = TRUE;
+  g_cond_signal (&inv->cond);
+  g_mutex_unlock (&inv->lock);
+  return FALSE;
+}
+
+/**
+ * gst_switch_controller_invoke:
+ *  @param controller the GstSwitchController instance
+ *  @param method_name the remote method name
+ *  @param parameters the method parameters, of the type of
+ *         %gst_switch_controller_get_in_type
+ *  @param error return location for an error, or NULL
+ *  @return the method results, or NULL on errors
+ *
+ *  Invoke a remote method stub directly, for the other control protocols
+ *  than D-Bus. The stub runs in the main loop like the D-Bus calls, the
+ *  calling thread is blocked until it's done.
+ */
+GVariant *
+gst_switch_controller_invoke (GstSwitchController * controller,
+    const gchar * method_name, GVariant * parameters, GError ** error)
+{
+  GstSwitchControllerClass *klass =
+      GST_SWITCH_CONTROLLER_CLASS (G_OBJECT_GET_CLASS (controller));
+  MethodFunc entry = (MethodFunc) g_hash_table_find (klass->methods,
+      (GHRFunc) gst_switch_controller_method_match, (gpointer) method_name);
+  GstSwitchControllerInvocation inv;
+  GVariantType *type;
+
+  type = gst_switch_controller_get_in_type (controller, method_name);
+  if (!entry || !type) {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+        "Unsupported call %s", method_name);
+    goto end;
+  }
+
+  if (!g_variant_is_of_type (parameters, type)) {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+        "Parameters of %s are not %s", method_name,
+        g_variant_type_peek_string (type));
+    goto end;
+  }
+
+  inv.controller = controller;
+  inv.entry = entry;
+  inv.parameters = parameters;
+  inv.results = NULL;
+  inv.done = FALSE;
+  g_mutex_init (&inv.lock);
+  g_cond_init (&inv.cond);
+
+  if (g_main_context_is_owner (g_main_context_default ())) {
+    gst_switch_controller_run_invocation (&inv);
+  } else {
+    g_main_context_invoke (NULL,
+        (GSourceFunc) gst_switch_controller_run_invocation, &inv);
+    g_mutex_lock (&inv.lock);
+    while (!inv.done)
+      g_cond_wait (&inv.cond, &inv.lock);
+    g_mutex_unlock (&inv.lock);
+  }
+
+  g_cond_clear (&inv.cond);
+  g_mutex_clear (&inv.lock);
+
+  if (!inv.results) {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_INITIALIZED,
+        "The server is not ready for %s", method_name);
+    goto end;
+  }
+
+  g_variant_type_free (type);
+  return inv.results;
+
+end:
+  if (type)
+    g_variant_type_free (type);
+  return NULL;
 }
 
 #if ENABLE_TEST
@@ -961,6 +1507,151 @@ gst_switch_controller__switch (GstSwitchController * controller,
   return result;
 }
 
+/**
+ * gst_switch_controller__transition:
+ *
+ * Remoting method stub of "transition".
+ */
+static GVariant *
+gst_switch_controller__transition (GstSwitchController * controller,
+    GDBusConnection * connection, GVariant * parameters)
+{
+  GVariant *result = NULL;
+  gint channel, port, blend, duration;
+  gboolean ok = FALSE;
+  g_variant_get (parameters, "(iiii)", &channel, &port, &blend, &duration);
+  if (controller->server) {
+    ok = gst_switch_server_transition (controller->server, channel, port,
+        blend, duration);
+    result = g_variant_new ("(b)", ok);
+  }
+  return result;
+}
+
+/**
+ * gst_switch_controller__set_layout:
+ *
+ * Remoting method stub of "set_layout".
+ */
+static GVariant *
+gst_switch_controller__set_layout (GstSwitchController * controller,
+    GDBusConnection * connection, GVariant * parameters)
+{
+  GVariant *result = NULL;
+  const gchar *name = NULL;
+  gboolean ok = FALSE;
+  g_variant_get (parameters, "(&s)", &name);
+  if (controller->server) {
+    ok = gst_switch_server_set_layout (controller->server, name);
+    result = g_variant_new ("(b)", ok);
+  }
+  return result;
+}
+
+/**
+ * gst_switch_controller__set_video_format:
+ *
+ * Remoting method stub of "set_video_format".
+ */
+static GVariant *
+gst_switch_controller__set_video_format (GstSwitchController * controller,
+    GDBusConnection * connection, GVariant * parameters)
+{
+  GVariant *result = NULL;
+  gint width, height, framerate;
+  gboolean ok = FALSE;
+  g_variant_get (parameters, "(iii)", &width, &height, &framerate);
+  if (controller->server) {
+    ok = gst_switch_server_set_video_format (controller->server, width,
+        height, framerate);
+    result = g_variant_new ("(b)", ok);
+  }
+  return result;
+}
+
+/**
+ * gst_switch_controller__set_audio_gain:
+ *
+ * Remoting method stub of "set_audio_gain".
+ */
+static GVariant *
+gst_switch_controller__set_audio_gain (GstSwitchController * controller,
+    GDBusConnection * connection, GVariant * parameters)
+{
+  GVariant *result = NULL;
+  gint port;
+  gdouble gain;
+  gboolean ok = FALSE;
+  g_variant_get (parameters, "(id)", &port, &gain);
+  if (controller->server) {
+    ok = gst_switch_server_set_audio_gain (controller->server, port, gain);
+    result = g_variant_new ("(b)", ok);
+  }
+  return result;
+}
+
+/**
+ * gst_switch_controller__set_audio_mute:
+ *
+ * Remoting method stub of "set_audio_mute".
+ */
+static GVariant *
+gst_switch_controller__set_audio_mute (GstSwitchController * controller,
+    GDBusConnection * connection, GVariant * parameters)
+{
+  GVariant *result = NULL;
+  gint port;
+  gboolean mute, ok = FALSE;
+  g_variant_get (parameters, "(ib)", &port, &mute);
+  if (controller->server) {
+    ok = gst_switch_server_set_audio_mute (controller->server, port, mute);
+    result = g_variant_new ("(b)", ok);
+  }
+  return result;
+}
+
+/**
+ * gst_switch_controller__set_audio_duck:
+ *
+ * Remoting method stub of "set_audio_duck".
+ */
+static GVariant *
+gst_switch_controller__set_audio_duck (GstSwitchController * controller,
+    GDBusConnection * connection, GVariant * parameters)
+{
+  GVariant *result = NULL;
+  gint port;
+  gboolean duck, ok = FALSE;
+  g_variant_get (parameters, "(ib)", &port, &duck);
+  if (controller->server) {
+    ok = gst_switch_server_set_audio_duck (controller->server, port, duck);
+    result = g_variant_new ("(b)", ok);
+  }
+  return result;
+}
+
+/**
+ * gst_switch_controller__get_preview_shm:
+ *
+ * Remoting method stub of "get_preview_shm".
+ */
+static GVariant *
+gst_switch_controller__get_preview_shm (GstSwitchController * controller,
+    GDBusConnection * connection, GVariant * parameters)
+{
+  GVariant *result = NULL;
+  gchar *path = NULL, *caps = NULL;
+  gint port;
+  g_variant_get (parameters, "(i)", &port);
+  if (controller->server) {
+    gst_switch_server_get_preview_shm (controller->server, port, &path, &caps);
+    result = g_variant_new ("(ss)", path ? path : "", caps ? caps : "");
+    g_free (path);
+    g_free (caps);
+  }
+  return result;
+}
+
 /**
  * gst_switch_controller_method_table:
  *
@@ -975,11 +1666,18 @@ static MethodTableEntry gst_switch_controller_method_table[] = {
   {"get_audio_port", (MethodFunc) gst_switch_controller__get_audio_port},
   {"get_preview_ports",
       (MethodFunc) gst_switch_controller__get_preview_ports},
+  {"get_preview_shm", (MethodFunc) gst_switch_controller__get_preview_shm},
   {"set_composite_mode",
       (MethodFunc) gst_switch_controller__set_composite_mode},
   {"new_record", (MethodFunc) gst_switch_controller__new_record},
   {"adjust_pip", (MethodFunc) gst_switch_controller__adjust_pip},
   {"switch", (MethodFunc) gst_switch_controller__switch},
+  {"transition", (MethodFunc) gst_switch_controller__transition},
+  {"set_layout", (MethodFunc) gst_switch_controller__set_layout},
+  {"set_video_format", (MethodFunc) gst_switch_controller__set_video_format},
+  {"set_audio_gain", (MethodFunc) gst_switch_controller__set_audio_gain},
+  {"set_audio_mute", (MethodFunc) gst_switch_controller__set_audio_mute},
+  {"set_audio_duck", (MethodFunc) gst_switch_controller__set_audio_duck},
   {NULL, NULL}
 };
 
@@ -47,6 +47,8 @@ typedef struct _GstSwitchController GstSwitchController;
 typedef struct _GstSwitchControllerClass GstSwitchControllerClass;
 
 typedef GVariant *(*MethodFunc) (GObject *, GDBusConnection *, GVariant *);
+typedef void (*GstSwitchControllerListener) (const gchar * name,
+    GVariant * parameters, gpointer data);
 typedef struct _MethodTableEntry MethodTableEntry;
 
 /**
@@ -64,7 +66,10 @@ struct _MethodTableEntry
  *  @param server the GstSwitchServer instance
  *  @param bus_server the dbus server instance
  *  @param uis_lock the lock for %uis
- *  @param uis the client list
+ *  @param uis the connected clients, each with its queue of outbound calls
+ *         and signals
+ *  @param listeners_lock the lock for %listeners
+ *  @param listeners the functions told about the notifications
  */
 struct _GstSwitchController
 {
@@ -74,6 +79,8 @@ struct _GstSwitchController
   GDBusServer *bus_server;
   GMutex uis_lock;
   GList *uis;
+  GMutex listeners_lock;
+  GSList *listeners;
 };
 
 /**
@@ -96,7 +103,17 @@ void gst_switch_controller_tell_compose_port (GstSwitchController *, gint port);
 void gst_switch_controller_tell_encode_port (GstSwitchController *, gint port);
 void gst_switch_controller_tell_preview_port (GstSwitchController *,
     gint port, gint serve, gint type);
+void gst_switch_controller_tell_audio_level (GstSwitchController *,
+    gint port, gdouble rms, gdouble peak, gdouble decay);
 void gst_switch_controller_tell_new_mode_onlne (GstSwitchController *,
     gint mode);
+void gst_switch_controller_add_listener (GstSwitchController *,
+    GstSwitchControllerListener func, gpointer data);
+void gst_switch_controller_remove_listener (GstSwitchController *,
+    GstSwitchControllerListener func, gpointer data);
+GVariantType *gst_switch_controller_get_in_type (GstSwitchController *,
+    const gchar * method_name);
+GVariant *gst_switch_controller_invoke (GstSwitchController *,
+    const gchar * method_name, GVariant * parameters, GError ** error);
 
 #endif //__GST_SWITCH_CONTROLLER_H__by_Duzy_Chan__
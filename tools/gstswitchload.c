@@ -0,0 +1,365 @@
+/* GstSwitch
+ * Copyright (C) 2012,2013 Duzy Chan <code@duzy.info>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*! @file */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <json-glib/json-glib.h>
+#include "gstswitchclient.h"
+#include "../logutils.h"
+
+gboolean verbose;
+static gint opt_requests = 10000;
+static gint opt_window = 64;
+static gchar *opt_method = NULL;
+static gboolean opt_json = FALSE;
+static gchar *opt_host = NULL;
+static gint opt_port = 5000;
+
+static GOptionEntry entries[] = {
+  {"verbose", 'v', 0, G_OPTION_ARG_NONE, &verbose, "Be verbose", NULL},
+  {"requests", 'n', 0, G_OPTION_ARG_INT, &opt_requests,
+      "Number of calls to make (default 10000)", "NUM"},
+  {"window", 'w', 0, G_OPTION_ARG_INT, &opt_window,
+      "Number of calls in flight (default 64)", "NUM"},
+  {"method", 'm', 0, G_OPTION_ARG_STRING, &opt_method,
+        "The method to call: get_compose_port (default), get_preview_ports "
+        "or adjust_pip", "NAME"},
+  {"json", 'j', 0, G_OPTION_ARG_NONE, &opt_json,
+      "Use the JSON protocol of the control port instead of D-Bus", NULL},
+  {"host", 0, 0, G_OPTION_ARG_STRING, &opt_host,
+      "The host of the control port (default localhost)", "HOST"},
+  {"port", 'p', 0, G_OPTION_ARG_INT, &opt_port,
+      "The control port (default 5000)", "NUM"},
+  {NULL}
+};
+
+/**
+ * @brief The state of a load test.
+ */
+typedef struct _GstSwitchLoad
+{
+  GstSwitchClient *client;
+  GMainLoop *main_loop;
+  gint issued;                  /* calls started */
+  gint completed;               /* calls replied or failed */
+  gint failed;
+  gint64 start_time;
+  gint64 *latencies;            /* microseconds, per call */
+} GstSwitchLoad;
+
+/**
+ * @brief A call in flight.
+ */
+typedef struct _GstSwitchLoadCall
+{
+  GstSwitchLoad *load;
+  gint64 start_time;
+  gint index;
+} GstSwitchLoadCall;
+
+static void gst_switch_load_issue (GstSwitchLoad * load);
+
+static void
+gst_switch_load_done (GstSwitchClient * client, GAsyncResult * result,
+    GstSwitchLoadCall * call)
+{
+  GstSwitchLoad *load = call->load;
+  GError *error = NULL;
+  GVariant *value;
+
+  if (g_strcmp0 (opt_method, "adjust_pip") == 0) {
+    gst_switch_client_finish_adjust_pip (client, result, &error);
+  } else if (g_strcmp0 (opt_method, "get_preview_ports") == 0) {
+    value = gst_switch_client_finish_preview_ports (client, result, &error);
+    if (value)
+      g_variant_unref (value);
+  } else {
+    gst_switch_client_finish_port (client, result, &error);
+  }
+
+  load->latencies[call->index] = g_get_monotonic_time () - call->start_time;
+  if (error) {
+    if (verbose)
+      WARN ("call %d: %s", call->index, error->message);
+    g_error_free (error);
+    load->failed += 1;
+  }
+  g_free (call);
+
+  if (++load->completed == opt_requests) {
+    g_main_loop_quit (load->main_loop);
+    return;
+  }
+
+  if (load->issued < opt_requests)
+    gst_switch_load_issue (load);
+}
+
+/**
+ * gst_switch_load_issue:
+ *
+ * Start the next call, the replies keep the window full.
+ */
+static void
+gst_switch_load_issue (GstSwitchLoad * load)
+{
+  GstSwitchLoadCall *call = g_new0 (GstSwitchLoadCall, 1);
+  GAsyncReadyCallback callback = (GAsyncReadyCallback) gst_switch_load_done;
+
+  call->load = load;
+  call->index = load->issued++;
+  call->start_time = g_get_monotonic_time ();
+
+  if (g_strcmp0 (opt_method, "adjust_pip") == 0) {
+    gst_switch_client_adjust_pip_async (load->client, 0, 0, 0, 0, callback,
+        call);
+  } else if (g_strcmp0 (opt_method, "get_preview_ports") == 0) {
+    gst_switch_client_get_preview_ports_async (load->client, callback, call);
+  } else {
+    gst_switch_client_get_compose_port_async (load->client, callback, call);
+  }
+}
+
+/**
+ * gst_switch_load_json_request:
+ *
+ * Make the request line of a call over the control port.
+ */
+static gchar *
+gst_switch_load_json_request (gint id)
+{
+  if (g_strcmp0 (opt_method, "adjust_pip") == 0) {
+    return g_strdup_printf ("{\"id\":%d,\"method\":\"adjust_pip\","
+        "\"params\":[0,0,0,0]}\n", id);
+  } else if (g_strcmp0 (opt_method, "get_preview_ports") == 0) {
+    return g_strdup_printf ("{\"id\":%d,\"method\":\"get_preview_ports\"}\n",
+        id);
+  }
+  return g_strdup_printf ("{\"id\":%d,\"method\":\"get_compose_port\"}\n",
+      id);
+}
+
+/**
+ * gst_switch_load_run_json:
+ *
+ * Pipeline the calls over the control port, keeping the window full. The
+ * replies come back in order.
+ */
+static gboolean
+gst_switch_load_run_json (GstSwitchLoad * load)
+{
+  GSocketClient *client = g_socket_client_new ();
+  GSocketConnection *connection;
+  GDataInputStream *input;
+  GOutputStream *output;
+  JsonParser *parser;
+  JsonObject *reply;
+  GError *error = NULL;
+  gint64 *start_times;
+  gchar *request, *line;
+  gint id;
+
+  connection = g_socket_client_connect_to_host (client,
+      opt_host ? opt_host : "localhost", opt_port, NULL, &error);
+  g_object_unref (client);
+  if (!connection) {
+    g_print ("can't connect to the control port: %s\n", error->message);
+    g_error_free (error);
+    return FALSE;
+  }
+
+  g_socket_set_option (g_socket_connection_get_socket (connection),
+      IPPROTO_TCP, TCP_NODELAY, 1, NULL);
+  input = g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM
+          (connection)));
+  output = g_io_stream_get_output_stream (G_IO_STREAM (connection));
+  parser = json_parser_new ();
+  start_times = g_new0 (gint64, opt_requests);
+  load->start_time = g_get_monotonic_time ();
+
+  while (load->completed < opt_requests) {
+    while (load->issued < opt_requests &&
+        load->issued - load->completed < opt_window) {
+      request = gst_switch_load_json_request (load->issued);
+      start_times[load->issued++] = g_get_monotonic_time ();
+      if (!g_output_stream_write_all (output, request, strlen (request),
+              NULL, NULL, &error)) {
+        g_free (request);
+        goto error;
+      }
+      g_free (request);
+    }
+
+    line = g_data_input_stream_read_line (input, NULL, NULL, &error);
+    if (!line)
+      goto error;
+
+    id = -1;
+    if (json_parser_load_from_data (parser, line, -1, NULL) &&
+        JSON_NODE_HOLDS_OBJECT (json_parser_get_root (parser))) {
+      reply = json_node_get_object (json_parser_get_root (parser));
+      if (json_object_has_member (reply, "id"))
+        id = json_object_get_int_member (reply, "id");
+      if (!json_object_has_member (reply, "result")) {
+        if (verbose)
+          WARN ("call %d: %s", id, line);
+        load->failed += 1;
+      }
+    }
+    g_free (line);
+
+    if (id < 0 || opt_requests <= id) {
+      WARN ("unexpected reply");
+      load->failed += 1;
+      id = load->completed;
+    }
+    load->latencies[load->completed++] =
+        g_get_monotonic_time () - start_times[id];
+  }
+
+end:
+  g_free (start_times);
+  g_object_unref (parser);
+  g_object_unref (input);
+  g_object_unref (connection);
+  return TRUE;
+
+error:
+  {
+    WARN ("control port: %s", error ? error->message : "closed");
+    if (error)
+      g_error_free (error);
+    load->failed += opt_requests - load->completed;
+    load->completed = opt_requests;
+    goto end;
+  }
+}
+
+static gint
+gst_switch_load_compare (const gint64 * a, const gint64 * b)
+{
+  return *a < *b ? -1 : (*a > *b ? 1 : 0);
+}
+
+static gint64
+gst_switch_load_percentile (GstSwitchLoad * load, gdouble percentile)
+{
+  gint n = (gint) (percentile * (opt_requests - 1) / 100.0 + 0.5);
+  return load->latencies[CLAMP (n, 0, opt_requests - 1)];
+}
+
+static void
+gst_switch_load_report (GstSwitchLoad * load)
+{
+  gint64 elapsed = g_get_monotonic_time () - load->start_time;
+
+  qsort (load->latencies, opt_requests, sizeof (gint64),
+      (GCompareFunc) gst_switch_load_compare);
+
+  g_print ("%s over %s: %d calls (%d failed), %d in flight, %.3f s\n",
+      opt_method ? opt_method : "get_compose_port",
+      opt_json ? "the control port" : "D-Bus", opt_requests,
+      load->failed, opt_window, elapsed / 1e6);
+  g_print ("throughput: %.1f calls/s\n", opt_requests * 1e6 / MAX (elapsed,
+          1));
+  g_print ("latency (ms): p50 %.3f, p90 %.3f, p99 %.3f, p99.9 %.3f, "
+      "max %.3f\n", gst_switch_load_percentile (load, 50) / 1e3,
+      gst_switch_load_percentile (load, 90) / 1e3,
+      gst_switch_load_percentile (load, 99) / 1e3,
+      gst_switch_load_percentile (load, 99.9) / 1e3,
+      load->latencies[opt_requests - 1] / 1e3);
+}
+
+static void
+gst_switch_load_parse_args (int *argc, char **argv[])
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  context = g_option_context_new ("");
+  g_option_context_set_summary (context,
+      "Measure the throughput and latency of the gst-switch controller, "
+      "over D-Bus or the JSON protocol of the control port.");
+  g_option_context_add_main_entries (context, entries, "gst-switch");
+  if (!g_option_context_parse (context, argc, argv, &error)) {
+    g_print ("option parsing failed: %s\n", error->message);
+    exit (1);
+  }
+  g_option_context_free (context);
+
+  if (opt_requests <= 0 || opt_window <= 0) {
+    g_print ("--requests and --window must be positive\n");
+    exit (1);
+  }
+}
+
+int
+main (int argc, char *argv[])
+{
+  GstSwitchLoad load;
+  gint n;
+
+  gst_switch_load_parse_args (&argc, &argv);
+  gst_init (&argc, &argv);
+
+  memset (&load, 0, sizeof (load));
+  load.latencies = g_new0 (gint64, opt_requests);
+
+  if (opt_json) {
+    if (!gst_switch_load_run_json (&load))
+      return 1;
+    gst_switch_load_report (&load);
+    g_free (load.latencies);
+    return load.failed ? 1 : 0;
+  }
+
+  load.client = GST_SWITCH_CLIENT (g_object_new (GST_TYPE_SWITCH_CLIENT,
+          NULL));
+  if (!gst_switch_client_connect (load.client)) {
+    g_print ("can't connect to the gst-switch server\n");
+    return 1;
+  }
+
+  load.main_loop = g_main_loop_new (NULL, FALSE);
+  load.start_time = g_get_monotonic_time ();
+
+  for (n = 0; n < opt_window && load.issued < opt_requests; ++n)
+    gst_switch_load_issue (&load);
+
+  g_main_loop_run (load.main_loop);
+  gst_switch_load_report (&load);
+
+  g_free (load.latencies);
+  g_main_loop_unref (load.main_loop);
+  g_object_unref (load.client);
+  return load.failed ? 1 : 0;
+}
@@ -31,10 +31,17 @@
 
 #include <gst/gst.h>
 #include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
+#include <glib/gstdio.h>
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 #include "gstswitchserver.h"
 #include "gstrecorder.h"
 #include "gstcase.h"
+#include "gstswitchtcpcontrol.h"
+#include "gstclientpolicy.h"
+#include "gstqueuepolicy.h"
 #include "./gio/gsocketinputstream.h"
 
 #define GST_SWITCH_SERVER_DEFAULT_HOST "localhost"
@@ -42,6 +49,10 @@
 #define GST_SWITCH_SERVER_DEFAULT_AUDIO_ACCEPTOR_PORT	4000
 #define GST_SWITCH_SERVER_DEFAULT_CONTROLLER_PORT	5000
 #define GST_SWITCH_SERVER_LISTEN_BACKLOG 8      /* client connection queue */
+#define GST_SWITCH_SERVER_MIN_HEALTH_CHECK_INTERVAL 10  /* ms */
+#define GST_SWITCH_SERVER_DEFAULT_AUDIO_LEVEL_INTERVAL 100       /* ms */
+#define GST_SWITCH_SERVER_SHM_INPUT_DELAY 200   /* ms, for shmsink to listen */
+#define GST_SWITCH_SERVER_RTP_MTU 1400  /* bytes, below the Ethernet MTU */
 
 #define GST_SWITCH_SERVER_LOCK_MAIN_LOOP(srv) (g_mutex_lock (&(srv)->main_loop_lock))
 #define GST_SWITCH_SERVER_UNLOCK_MAIN_LOOP(srv) (g_mutex_unlock (&(srv)->main_loop_lock))
@@ -70,6 +81,10 @@ GstSwitchServerOpts opts = {
   GST_SWITCH_SERVER_DEFAULT_VIDEO_ACCEPTOR_PORT,
   GST_SWITCH_SERVER_DEFAULT_AUDIO_ACCEPTOR_PORT,
   GST_SWITCH_SERVER_DEFAULT_CONTROLLER_PORT,
+  0, FALSE, 0, 0, FALSE, FALSE, 0, NULL, 0, NULL,
+  GST_SWITCH_SERVER_DEFAULT_AUDIO_LEVEL_INTERVAL, FALSE, NULL, NULL, NULL,
+  GST_CLIENT_POLICY_DEFAULT_MAX_LAG, 0,
+  GST_CLIENT_POLICY_DEFAULT_DISCONNECT_LAG, NULL,
 };
 
 gboolean verbose = FALSE;
@@ -88,9 +103,110 @@ static GOptionEntry entries[] = {
       "Specify the audio input listen port.", "NUM"},
   {"control-port", 'p', 0, G_OPTION_ARG_INT, &opts.control_port,
       "Specify the control port.", "NUM"},
+  {"failover-deadline", 0, 0, G_OPTION_ARG_INT, &opts.failover_deadline,
+        "Fail over an unhealthy composite input to a standby input after "
+        "MSEC milliseconds (0 disables failover).", "MSEC"},
+  {"audio-mix", 0, 0, G_OPTION_ARG_NONE, &opts.audio_mix,
+      "Mix all audio inputs instead of switching between them", NULL},
+  {"record-segment", 0, 0, G_OPTION_ARG_INT, &opts.record_segment_time,
+        "Record into Matroska segments of SEC seconds with a playlist, "
+        "instead of into one file", "SEC"},
+  {"record-segment-size", 0, 0, G_OPTION_ARG_INT, &opts.record_segment_size,
+        "Record into Matroska segments of at most MB MiB with a playlist, "
+        "instead of into one file", "MB"},
+  {"record-direct", 0, 0, G_OPTION_ARG_NONE, &opts.record_direct,
+      "Write the recording with O_DIRECT, bypassing the page cache", NULL},
+  {"record-iso", 0, 0, G_OPTION_ARG_NONE, &opts.record_iso,
+      "Also record every input into a file of its own", NULL},
+  {"record-iso-threads", 0, 0, G_OPTION_ARG_INT, &opts.record_iso_threads,
+        "Share at most NUM encoder threads between the input recordings "
+        "(0 for half of the processors)", "NUM"},
+  {"decode-threads", 0, 0, G_OPTION_ARG_INT, &opts.decode_threads,
+        "Share at most NUM decoder threads between the compressed inputs "
+        "(0 for the number of processors)", "NUM"},
+  {"video-size", 0, 0, G_OPTION_ARG_STRING, &opts.video_size,
+      "Specify the output video size, e.g. 1920x1080", "WxH"},
+  {"video-framerate", 0, 0, G_OPTION_ARG_INT, &opts.video_framerate,
+      "Specify the output frames per second", "FPS"},
+  {"layouts", 0, 0, G_OPTION_ARG_FILENAME, &opts.layouts_file,
+      "Load extra composite layouts from FILE", "FILE"},
+  {"audio-level-interval", 0, 0, G_OPTION_ARG_INT, &opts.audio_level_interval,
+        "Tell the audio levels to the UIs every MSEC milliseconds "
+        "(default 100, 0 disables)", "MSEC"},
+  {"preview-shm", 0, 0, G_OPTION_ARG_NONE, &opts.preview_shm,
+      "Also expose the video previews in shared memory to local UIs", NULL},
+  {"input-dir", 0, 0, G_OPTION_ARG_FILENAME, &opts.input_dir,
+        "Accept local inputs on Unix sockets and shared memory in DIR",
+      "DIR"},
+  {"rtp-output", 0, 0, G_OPTION_ARG_STRING, &opts.rtp_output,
+        "Also send the composite as RTP to a UDP unicast or multicast "
+        "HOST:PORT", "HOST:PORT"},
+  {"rtp-format", 0, 0, G_OPTION_ARG_STRING, &opts.rtp_format,
+      "The RTP payload: raw (RFC 4175, default), h264 or vp8", "FORMAT"},
+  {"client-max-lag", 0, 0, G_OPTION_ARG_INT, &opts.client_max_lag,
+        "Resync a client of a TCP port lagging behind more than MSEC "
+        "milliseconds (default 500)", "MSEC"},
+  {"client-max-bytes", 0, 0, G_OPTION_ARG_INT, &opts.client_max_bytes,
+        "Resync a client of a TCP port lagging behind more than KB KiB, "
+        "instead of limiting the time", "KB"},
+  {"client-disconnect-lag", 0, 0, G_OPTION_ARG_INT,
+        &opts.client_disconnect_lag,
+        "Disconnect a client of a TCP port lagging behind more than MSEC "
+        "milliseconds (default 5000)", "MSEC"},
+  {"client-drop", 0, 0, G_OPTION_ARG_STRING, &opts.client_drop,
+        "Resync a lagging client from the latest buffer (default), the "
+        "latest keyframe, or none to only disconnect it", "DROP"},
   {NULL}
 };
 
+/**
+ * gst_switch_server_parse_video_size:
+ * @return TRUE if @size is a valid video size like "1280x720"
+ */
+static gboolean
+gst_switch_server_parse_video_size (const gchar * size, gint * width,
+    gint * height)
+{
+  gint w = 0, h = 0;
+  gchar c = 0;
+
+  if (sscanf (size, "%dx%d%c", &w, &h, &c) != 2 ||
+      w < GST_SWITCH_COMPOSITE_MIN_PIP_W || h < GST_SWITCH_COMPOSITE_MIN_PIP_H)
+    return FALSE;
+
+  if (width)
+    *width = w;
+  if (height)
+    *height = h;
+  return TRUE;
+}
+
+/**
+ * gst_switch_server_parse_rtp_output:
+ * @return TRUE if @output is a valid RTP destination like "239.0.0.1:5004"
+ */
+static gboolean
+gst_switch_server_parse_rtp_output (const gchar * output, gchar ** host,
+    gint * port)
+{
+  const gchar *colon = strrchr (output, ':');
+  gchar *end = NULL;
+  glong p;
+
+  if (!colon || colon == output)
+    return FALSE;
+
+  p = strtol (colon + 1, &end, 10);
+  if (*end || p < GST_SWITCH_MIN_SINK_PORT || GST_SWITCH_MAX_SINK_PORT < p)
+    return FALSE;
+
+  if (host)
+    *host = g_strndup (output, colon - output);
+  if (port)
+    *port = (gint) p;
+  return TRUE;
+}
+
 /**
  * gst_switch_server_parse_args:
  *
@@ -111,6 +227,50 @@ gst_switch_server_parse_args (int *argc, char **argv[])
   }
 
   g_option_context_free (context);
+
+  if (opts.video_size && !gst_switch_server_parse_video_size (opts.video_size,
+          NULL, NULL)) {
+    ERROR ("invalid video size: %s", opts.video_size);
+    exit (1);
+  }
+
+  if (opts.video_framerate < 0 ||
+      GST_SWITCH_COMPOSITE_MAX_FRAMERATE < opts.video_framerate) {
+    ERROR ("invalid video framerate: %d", opts.video_framerate);
+    exit (1);
+  }
+
+  if (opts.rtp_output && !gst_switch_server_parse_rtp_output (opts.rtp_output,
+          NULL, NULL)) {
+    ERROR ("invalid RTP output: %s", opts.rtp_output);
+    exit (1);
+  }
+
+  if (opts.rtp_format && g_strcmp0 (opts.rtp_format, "raw") != 0 &&
+      g_strcmp0 (opts.rtp_format, "h264") != 0 &&
+      g_strcmp0 (opts.rtp_format, "vp8") != 0) {
+    ERROR ("invalid RTP format: %s", opts.rtp_format);
+    exit (1);
+  }
+
+  if (opts.client_max_lag <= 0 || opts.client_max_bytes < 0 ||
+      opts.client_disconnect_lag <= 0) {
+    ERROR ("invalid client limits: %d ms, %d KiB, %d ms", opts.client_max_lag,
+        opts.client_max_bytes, opts.client_disconnect_lag);
+    exit (1);
+  }
+
+  if (opts.client_drop && g_strcmp0 (opts.client_drop, "latest") != 0 &&
+      g_strcmp0 (opts.client_drop, "keyframe") != 0 &&
+      g_strcmp0 (opts.client_drop, "none") != 0) {
+    ERROR ("invalid client drop: %s", opts.client_drop);
+    exit (1);
+  }
+
+  if (opts.layouts_file && !gst_layout_load (opts.layouts_file, &error)) {
+    ERROR ("invalid layouts: %s", error->message);
+    exit (1);
+  }
 }
 
 /**
@@ -131,6 +291,11 @@ gst_switch_server_init (GstSwitchServer * srv)
   srv->audio_acceptor_port = opts.audio_input_port;
   srv->audio_acceptor_socket = NULL;
   srv->audio_acceptor = NULL;
+  srv->local_acceptor = NULL;
+  srv->local_loop = NULL;
+  srv->local_video_socket = NULL;
+  srv->local_audio_socket = NULL;
+  srv->local_monitor = NULL;
   srv->controller_port = opts.control_port;
   srv->controller_socket = NULL;
   srv->controller_thread = NULL;
@@ -144,8 +309,13 @@ gst_switch_server_init (GstSwitchServer * srv)
   srv->pip_y = 0;
   srv->pip_w = 0;
   srv->pip_h = 0;
+  srv->format_changed = FALSE;
 
   srv->clock = gst_system_clock_obtain ();
+  srv->base_time = gst_clock_get_time (srv->clock);
+  srv->failover_watch = 0;
+  srv->audio_level_watch = 0;
+  srv->audio_mix = NULL;
 
   g_mutex_init (&srv->main_loop_lock);
   g_mutex_init (&srv->video_acceptor_lock);
@@ -156,6 +326,8 @@ gst_switch_server_init (GstSwitchServer * srv)
   g_mutex_init (&srv->pip_lock);
   g_mutex_init (&srv->recorder_lock);
   g_mutex_init (&srv->clock_lock);
+
+  gst_worker_use_clock (srv->clock, srv->base_time);
 }
 
 /**
@@ -197,6 +369,16 @@ gst_switch_server_finalize (GstSwitchServer * srv)
     g_thread_join (srv->audio_acceptor);
   }
 */
+  if (srv->local_loop) {
+    g_main_loop_quit (srv->local_loop);
+    if (srv->local_acceptor) {
+      g_thread_join (srv->local_acceptor);
+      srv->local_acceptor = NULL;
+    }
+    g_main_loop_unref (srv->local_loop);
+    srv->local_loop = NULL;
+  }
+
   if (srv->controller_socket) {
     g_object_unref (srv->controller_socket);
     srv->controller_socket = NULL;
@@ -222,6 +404,22 @@ gst_switch_server_finalize (GstSwitchServer * srv)
     srv->composite = NULL;
   }
 
+  if (srv->failover_watch) {
+    g_source_remove (srv->failover_watch);
+    srv->failover_watch = 0;
+  }
+
+  if (srv->audio_level_watch) {
+    g_source_remove (srv->audio_level_watch);
+    srv->audio_level_watch = 0;
+  }
+
+  if (srv->audio_mix) {
+    g_object_unref (srv->audio_mix);
+    srv->audio_mix = NULL;
+  }
+
+  gst_worker_use_clock (NULL, GST_CLOCK_TIME_NONE);
   gst_object_unref (srv->clock);
 
   g_mutex_clear (&srv->main_loop_lock);
@@ -308,6 +506,7 @@ static void
 gst_switch_server_end_case (GstCase * cas, GstSwitchServer * srv)
 {
   gint caseport = 0;
+  gboolean mixed = FALSE;
   GList *item;
 
   GST_SWITCH_SERVER_LOCK_CASES (srv);
@@ -326,6 +525,7 @@ gst_switch_server_end_case (GstCase * cas, GstSwitchServer * srv)
       INFO ("Removed %s %p (%d cases left)", GST_WORKER (cas)->name, cas,
           g_list_length (srv->cases));
       caseport = cas->sink_port;
+      mixed = (cas->type == GST_CASE_INPUT_a && srv->audio_mix != NULL);
       g_object_unref (cas);
       for (item = srv->cases; item;) {
         GstCase *c = GST_CASE (item->data);
@@ -345,6 +545,9 @@ gst_switch_server_end_case (GstCase * cas, GstSwitchServer * srv)
 
   GST_SWITCH_SERVER_UNLOCK_CASES (srv);
 
+  if (mixed)
+    gst_audio_mix_remove_input (srv->audio_mix, caseport);
+
   if (caseport)
     gst_switch_server_revoke_port (srv, caseport);
 }
@@ -357,16 +560,8 @@ gst_switch_server_end_case (GstCase * cas, GstSwitchServer * srv)
 static void
 gst_switch_server_start_case (GstCase * cas, GstSwitchServer * srv)
 {
-  gboolean is_branch = FALSE;
-  switch (cas->type) {
-    case GST_CASE_BRANCH_A:
-    case GST_CASE_BRANCH_B:
-    case GST_CASE_BRANCH_a:
-    case GST_CASE_BRANCH_p:
-      is_branch = TRUE;
-    default:
-      break;
-  }
+  gboolean is_branch = GST_CASE_IS_BRANCH_VIDEO (cas->type) ||
+      cas->type == GST_CASE_BRANCH_a || cas->type == GST_CASE_BRANCH_p;
 
   if (srv->controller && is_branch) {
     GST_SWITCH_SERVER_LOCK_CONTROLLER (srv);
@@ -392,67 +587,38 @@ gst_switch_server_suggest_case_type (GstSwitchServer * srv,
     GstSwitchServeStreamType serve_type)
 {
   GstCaseType type = GST_CASE_UNKNOWN;
-  gboolean has_composite_A = FALSE;
-  gboolean has_composite_B = FALSE;
+  gboolean has_composite[GST_CASE_MAX_CHANNELS] = { FALSE };
   gboolean has_composite_a = FALSE;
   GList *item = srv->cases;
+  gint channel, channels;
 
   for (; item; item = g_list_next (item)) {
     GstCase *cas = GST_CASE (item->data);
-#if 0
-    switch (cas->serve_type) {
-      case GST_SERVE_VIDEO_STREAM:
-      {
-        switch (cas->type) {
-          case GST_CASE_COMPOSITE_A:
-            has_composite_A = TRUE;
-            break;
-          case GST_CASE_COMPOSITE_B:
-            has_composite_B = TRUE;
-            break;
-          default:
-            break;
-        }
-      }
-        break;
-      case GST_SERVE_AUDIO_STREAM:
-      {
-        if (cas->type == GST_CASE_COMPOSITE_a)
-          has_composite_a = TRUE;
-      }
-        break;
-      case GST_SERVE_NOTHING:
-        break;
-    }
-#else
-    switch (cas->type) {
-      case GST_CASE_COMPOSITE_A:
-        has_composite_A = TRUE;
-        break;
-      case GST_CASE_COMPOSITE_B:
-        has_composite_B = TRUE;
-        break;
-      case GST_CASE_COMPOSITE_a:
-        has_composite_a = TRUE;
-        break;
-      default:
-        break;
+    channel = gst_case_get_channel (cas->type);
+    if (GST_CASE_IS_COMPOSITE_VIDEO (cas->type)) {
+      has_composite[channel - 'A'] = TRUE;
+    } else if (cas->type == GST_CASE_COMPOSITE_a) {
+      has_composite_a = TRUE;
     }
-#endif
     //INFO ("case: %d, %d, %d", cas->sink_port, cas->type, cas->serve_type);
   }
 
+  /* A and B are always filled, more channels if the layout shows them */
+  channels = MAX (2, srv->composite->num_channels);
+
   switch (serve_type) {
     case GST_SERVE_VIDEO_STREAM:
-      if (!has_composite_A)
-        type = GST_CASE_COMPOSITE_A;
-      else if (!has_composite_B)
-        type = GST_CASE_COMPOSITE_B;
-      else
-        type = GST_CASE_PREVIEW;
+      type = GST_CASE_PREVIEW;
+      for (channel = 0; channel < channels; ++channel) {
+        if (!has_composite[channel]) {
+          type = gst_case_get_composite_type ('A' + channel);
+          break;
+        }
+      }
       break;
     case GST_SERVE_AUDIO_STREAM:
-      if (!has_composite_a)
+      /* All audio inputs are previews when they're mixed. */
+      if (!has_composite_a && !srv->audio_mix)
         type = GST_CASE_COMPOSITE_a;
       else
         type = GST_CASE_PREVIEW;
@@ -468,17 +634,19 @@ gst_switch_server_suggest_case_type (GstSwitchServer * srv,
 
 /**
  * gst_switch_server_serve:
+ *  @param client the socket of a new input, or NULL
+ *  @param shm_path the socket of a new shared memory input if @client is NULL
  *
  * The gst-switch-srv serving thread.
  */
 static void
 gst_switch_server_serve (GstSwitchServer * srv, GSocket * client,
-    GstSwitchServeStreamType serve_type)
+    const gchar * shm_path, GstSwitchServeStreamType serve_type)
 {
-  GSocketInputStreamX *stream =
+  GSocketInputStreamX *stream = client ?
       G_SOCKET_INPUT_STREAM (g_object_new
       (G_TYPE_SOCKET_INPUT_STREAM, "socket", client,
-          NULL));
+          NULL)) : NULL;
   GstCaseType type = GST_CASE_UNKNOWN;
   GstCaseType inputtype = GST_CASE_UNKNOWN;
   GstCaseType branchtype = GST_CASE_UNKNOWN;
@@ -503,22 +671,9 @@ gst_switch_server_serve (GstSwitchServer * srv, GSocket * client,
   }
 
   type = gst_switch_server_suggest_case_type (srv, serve_type);
-  switch (type) {
-    case GST_CASE_COMPOSITE_A:
-      branchtype = GST_CASE_BRANCH_A;
-      break;
-    case GST_CASE_COMPOSITE_B:
-      branchtype = GST_CASE_BRANCH_B;
-      break;
-    case GST_CASE_COMPOSITE_a:
-      branchtype = GST_CASE_BRANCH_a;
-      break;
-    case GST_CASE_PREVIEW:
-      branchtype = GST_CASE_BRANCH_p;
-      break;
-    default:
-      goto error_unknown_case_type;
-  }
+  branchtype = gst_case_get_branch_type (type);
+  if (branchtype == GST_CASE_UNKNOWN)
+    goto error_unknown_case_type;
 
   port = gst_switch_server_alloc_port (srv);
 
@@ -527,9 +682,11 @@ gst_switch_server_serve (GstSwitchServer * srv, GSocket * client,
   name = g_strdup_printf ("input_%d", port);
   input = GST_CASE (g_object_new (GST_TYPE_CASE, "name", name,
           "type", inputtype, "port", port, "serve",
-          serve_type, "stream", stream, NULL));
-  g_object_unref (stream);
-  g_object_unref (client);
+          serve_type, "stream", stream, "shm-path", shm_path, NULL));
+  if (stream)
+    g_object_unref (stream);
+  if (client)
+    g_object_unref (client);
   g_free (name);
 
   name = g_strdup_printf ("branch_%d", port);
@@ -552,6 +709,7 @@ gst_switch_server_serve (GstSwitchServer * srv, GSocket * client,
     g_object_set (input,
         "width", srv->composite->width,
         "height", srv->composite->height,
+        "framerate", srv->composite->framerate,
         "awidth", srv->composite->a_width,
         "aheight", srv->composite->a_height,
         "bwidth", srv->composite->b_width,
@@ -584,6 +742,9 @@ gst_switch_server_serve (GstSwitchServer * srv, GSocket * client,
   if (!gst_worker_start (GST_WORKER (workcase)))
     goto error_start_workcase;
 
+  if (serve_type == GST_SERVE_AUDIO_STREAM && srv->audio_mix)
+    gst_audio_mix_add_input (srv->audio_mix, port);
+
   GST_SWITCH_SERVER_UNLOCK_SERVE (srv);
   return;
 
@@ -591,8 +752,10 @@ gst_switch_server_serve (GstSwitchServer * srv, GSocket * client,
 error_unknown_serve_type:
   {
     ERROR ("unknown serve type %d", serve_type);
-    g_object_unref (stream);
-    g_object_unref (client);
+    if (stream)
+      g_object_unref (stream);
+    if (client)
+      g_object_unref (client);
     GST_SWITCH_SERVER_UNLOCK_CASES (srv);
     GST_SWITCH_SERVER_UNLOCK_SERVE (srv);
     return;
@@ -601,8 +764,10 @@ error_unknown_serve_type:
 error_unknown_case_type:
   {
     ERROR ("unknown case type (serve type %d)", serve_type);
-    g_object_unref (stream);
-    g_object_unref (client);
+    if (stream)
+      g_object_unref (stream);
+    if (client)
+      g_object_unref (client);
     GST_SWITCH_SERVER_UNLOCK_CASES (srv);
     GST_SWITCH_SERVER_UNLOCK_SERVE (srv);
     return;
@@ -616,7 +781,8 @@ error_start_workcase:
     srv->cases = g_list_remove (srv->cases, branch);
     srv->cases = g_list_remove (srv->cases, workcase);
     GST_SWITCH_SERVER_UNLOCK_CASES (srv);
-    g_object_unref (stream);
+    if (stream)
+      g_object_unref (stream);
     g_object_unref (branch);
     g_object_unref (workcase);
     gst_switch_server_revoke_port (srv, port);
@@ -628,13 +794,28 @@ error_start_workcase:
 /**
  * gst_switch_server_allow_tcp_control:
  *
- * (deprecated)
+ * Serve the line-delimited JSON control protocol to a client of the
+ * control port, see gstswitchtcpcontrol.c.
  */
 static void
 gst_switch_server_allow_tcp_control (GstSwitchServer * srv, GSocket * client)
 {
-  ERROR ("control via TCP not implemented");
-  g_object_unref (client);
+  GstSwitchController *controller = NULL;
+
+  GST_SWITCH_SERVER_LOCK_CONTROLLER (srv);
+  if (srv->controller)
+    controller = GST_SWITCH_CONTROLLER (g_object_ref (srv->controller));
+  GST_SWITCH_SERVER_UNLOCK_CONTROLLER (srv);
+
+  if (!controller) {
+    WARN ("TCP control client before the controller is ready");
+    g_socket_close (client, NULL);
+    g_object_unref (client);
+    return;
+  }
+
+  gst_switch_tcp_control_serve (controller, client);
+  g_object_unref (controller);
 }
 
 /**
@@ -776,7 +957,7 @@ gst_switch_server_video_acceptor (GstSwitchServer * srv)
       continue;
     }
 
-    gst_switch_server_serve (srv, socket, GST_SERVE_VIDEO_STREAM);
+    gst_switch_server_serve (srv, socket, NULL, GST_SERVE_VIDEO_STREAM);
   }
 
   GST_SWITCH_SERVER_LOCK_VIDEO_ACCEPTOR (srv);
@@ -813,7 +994,7 @@ gst_switch_server_audio_acceptor (GstSwitchServer * srv)
       continue;
     }
 
-    gst_switch_server_serve (srv, socket, GST_SERVE_AUDIO_STREAM);
+    gst_switch_server_serve (srv, socket, NULL, GST_SERVE_AUDIO_STREAM);
   }
 
   GST_SWITCH_SERVER_LOCK_AUDIO_ACCEPTOR (srv);
@@ -823,6 +1004,236 @@ gst_switch_server_audio_acceptor (GstSwitchServer * srv)
   return NULL;
 }
 
+/**
+ * gst_switch_server_listen_local:
+ * @return the socket listening on the Unix socket @name of the input
+ *         directory, or NULL
+ */
+static GSocket *
+gst_switch_server_listen_local (GstSwitchServer * srv, const gchar * name)
+{
+  GSocketAddress *saddr;
+  GSocket *socket;
+  GError *err = NULL;
+  gchar *path = g_build_filename (opts.input_dir, name, NULL);
+  gboolean ok;
+
+  /* a socket left by a previous run */
+  g_unlink (path);
+
+  socket = g_socket_new (G_SOCKET_FAMILY_UNIX, G_SOCKET_TYPE_STREAM,
+      G_SOCKET_PROTOCOL_DEFAULT, &err);
+  if (!socket)
+    goto error;
+
+  saddr = g_unix_socket_address_new (path);
+  ok = g_socket_bind (socket, saddr, FALSE, &err);
+  g_object_unref (saddr);
+  if (!ok)
+    goto error;
+
+  g_socket_set_listen_backlog (socket, GST_SWITCH_SERVER_LISTEN_BACKLOG);
+  if (!g_socket_listen (socket, &err))
+    goto error;
+
+  g_socket_set_blocking (socket, FALSE);
+  INFO ("Listening on %s", path);
+  g_free (path);
+  return socket;
+
+  /* Errors Handling */
+error:
+  {
+    ERROR ("listen %s: %s", path, err->message);
+    g_clear_error (&err);
+    if (socket)
+      g_object_unref (socket);
+    g_free (path);
+    return NULL;
+  }
+}
+
+/**
+ * gst_switch_server_local_accept:
+ *
+ * Invoked when a local producer connects to the video or audio socket of
+ * the input directory, it's served as an input of the TCP ports.
+ */
+static gboolean
+gst_switch_server_local_accept (GSocket * listener, GIOCondition condition,
+    GstSwitchServer * srv)
+{
+  GstSwitchServeStreamType serve_type = GST_SERVE_VIDEO_STREAM;
+  GError *error = NULL;
+  GSocket *socket;
+
+  if (listener == srv->local_audio_socket)
+    serve_type = GST_SERVE_AUDIO_STREAM;
+
+  socket = g_socket_accept (listener, NULL, &error);
+  if (!socket) {
+    ERROR ("accept: %s", error->message);
+    g_clear_error (&error);
+    return TRUE;
+  }
+
+  g_socket_set_blocking (socket, TRUE);
+  gst_switch_server_serve (srv, socket, NULL, serve_type);
+  return TRUE;
+}
+
+/**
+ * @brief A shared memory input waiting for its producer to listen.
+ */
+typedef struct _GstSwitchServerShmInput
+{
+  GstSwitchServer *srv;
+  GstSwitchServeStreamType serve_type;
+  gchar *path;
+} GstSwitchServerShmInput;
+
+/**
+ * gst_switch_server_serve_shm:
+ * @return Always FALSE to remove the timeout source.
+ */
+static gboolean
+gst_switch_server_serve_shm (GstSwitchServerShmInput * input)
+{
+  if (g_file_test (input->path, G_FILE_TEST_EXISTS)) {
+    INFO ("shared memory input: %s", input->path);
+    gst_switch_server_serve (input->srv, NULL, input->path,
+        input->serve_type);
+  }
+  g_free (input->path);
+  g_free (input);
+  return FALSE;
+}
+
+/**
+ * gst_switch_server_local_changed:
+ *
+ * Invoked when a file is created in the input directory. A socket named
+ * "video-*" or "audio-*" is taken as the shmsink of a local producer.
+ * The producer has to wait for the server (wait-for-connection=true): the
+ * caps packet of gdppay is only sent once, and shmsink doesn't repeat it
+ * to a late reader, which then can't negotiate.
+ */
+static void
+gst_switch_server_local_changed (GFileMonitor * monitor, GFile * file,
+    GFile * other, GFileMonitorEvent event, GstSwitchServer * srv)
+{
+  GstSwitchServerShmInput *input;
+  GstSwitchServeStreamType serve_type;
+  GSource *source;
+  gchar *name;
+
+  if (event != G_FILE_MONITOR_EVENT_CREATED)
+    return;
+
+  name = g_file_get_basename (file);
+  if (g_str_has_prefix (name, "video-"))
+    serve_type = GST_SERVE_VIDEO_STREAM;
+  else if (g_str_has_prefix (name, "audio-"))
+    serve_type = GST_SERVE_AUDIO_STREAM;
+  else
+    serve_type = GST_SERVE_NOTHING;
+  g_free (name);
+
+  if (serve_type == GST_SERVE_NOTHING)
+    return;
+
+  input = g_new0 (GstSwitchServerShmInput, 1);
+  input->srv = srv;
+  input->serve_type = serve_type;
+  input->path = g_file_get_path (file);
+
+  /* the socket is created before shmsink listens on it */
+  source = g_timeout_source_new (GST_SWITCH_SERVER_SHM_INPUT_DELAY);
+  g_source_set_callback (source, (GSourceFunc) gst_switch_server_serve_shm,
+      input, NULL);
+  g_source_attach (source, g_main_loop_get_context (srv->local_loop));
+  g_source_unref (source);
+}
+
+/**
+ * gst_switch_server_local_acceptor:
+ *
+ * Thread for accepting local inputs from the input directory, on Unix
+ * sockets and in shared memory.
+ */
+static gpointer
+gst_switch_server_local_acceptor (GstSwitchServer * srv)
+{
+  GMainContext *context = g_main_loop_get_context (srv->local_loop);
+  GSocket *sockets[2];
+  GSource *source;
+  GFile *dir;
+  GError *error = NULL;
+  gchar *path;
+  gint n;
+
+  g_main_context_push_thread_default (context);
+
+  if (g_mkdir_with_parents (opts.input_dir, 0700) != 0) {
+    ERROR ("can't create %s", opts.input_dir);
+    gst_switch_server_quit (srv, -__LINE__);
+    goto done;
+  }
+
+  sockets[0] = srv->local_video_socket =
+      gst_switch_server_listen_local (srv, "video");
+  sockets[1] = srv->local_audio_socket =
+      gst_switch_server_listen_local (srv, "audio");
+  if (!srv->local_video_socket || !srv->local_audio_socket) {
+    gst_switch_server_quit (srv, -__LINE__);
+    goto done;
+  }
+
+  for (n = 0; n < 2; ++n) {
+    source = g_socket_create_source (sockets[n], G_IO_IN, NULL);
+    g_source_set_callback (source,
+        (GSourceFunc) gst_switch_server_local_accept, srv, NULL);
+    g_source_attach (source, context);
+    g_source_unref (source);
+  }
+
+  dir = g_file_new_for_path (opts.input_dir);
+  srv->local_monitor = g_file_monitor_directory (dir, G_FILE_MONITOR_NONE,
+      NULL, &error);
+  g_object_unref (dir);
+  if (srv->local_monitor) {
+    g_signal_connect (srv->local_monitor, "changed",
+        G_CALLBACK (gst_switch_server_local_changed), srv);
+  } else {
+    ERROR ("watch %s: %s", opts.input_dir, error->message);
+    g_clear_error (&error);
+  }
+
+  g_main_loop_run (srv->local_loop);
+
+done:
+  if (srv->local_monitor) {
+    g_object_unref (srv->local_monitor);
+    srv->local_monitor = NULL;
+  }
+  if (srv->local_video_socket) {
+    g_object_unref (srv->local_video_socket);
+    srv->local_video_socket = NULL;
+    path = g_build_filename (opts.input_dir, "video", NULL);
+    g_unlink (path);
+    g_free (path);
+  }
+  if (srv->local_audio_socket) {
+    g_object_unref (srv->local_audio_socket);
+    srv->local_audio_socket = NULL;
+    path = g_build_filename (opts.input_dir, "audio", NULL);
+    g_unlink (path);
+    g_free (path);
+  }
+  g_main_context_pop_thread_default (context);
+  return NULL;
+}
+
 /**
  * gst_switch_server_controller:
  *
@@ -970,18 +1381,14 @@ gst_switch_server_get_preview_sink_ports (GstSwitchServer * srv,
 
   GST_SWITCH_SERVER_LOCK_CASES (srv);
   for (item = srv->cases; item; item = g_list_next (item)) {
-    switch (GST_CASE (item->data)->type) {
-      case GST_CASE_BRANCH_A:
-      case GST_CASE_BRANCH_B:
-      case GST_CASE_BRANCH_a:
-      case GST_CASE_PREVIEW:
-        a = g_array_append_val (a, GST_CASE (item->data)->sink_port);
-        if (s)
-          *s = g_array_append_val (*s, GST_CASE (item->data)->serve_type);
-        if (t)
-          *t = g_array_append_val (*t, GST_CASE (item->data)->type);
-      default:
-        break;
+    GstCaseType type = GST_CASE (item->data)->type;
+    if (GST_CASE_IS_BRANCH_VIDEO (type) || type == GST_CASE_BRANCH_a ||
+        type == GST_CASE_PREVIEW) {
+      a = g_array_append_val (a, GST_CASE (item->data)->sink_port);
+      if (s)
+        *s = g_array_append_val (*s, GST_CASE (item->data)->serve_type);
+      if (t)
+        *t = g_array_append_val (*t, GST_CASE (item->data)->type);
     }
   }
   GST_SWITCH_SERVER_UNLOCK_CASES (srv);
@@ -1000,16 +1407,19 @@ gst_switch_server_set_composite_mode (GstSwitchServer * srv, gint mode)
 {
   gboolean result = FALSE;
 
+  const GstLayout *layout = gst_layout_get_builtin (mode);
+
   GST_SWITCH_SERVER_LOCK_PIP (srv);
 
-  if (mode == srv->composite->mode) {
+  if (layout && g_strcmp0 (layout->name, srv->composite->layout->name) == 0) {
     WARN ("ignore the same composite mode %d", mode);
     goto end;
   }
 
   g_object_set (srv->composite, "mode", mode, NULL);
 
-  result = (mode == srv->composite->mode);
+  result = (layout && mode == srv->composite->mode &&
+      srv->composite->transition);
 
   if (result) {
     srv->pip_x = srv->composite->b_x;
@@ -1030,36 +1440,55 @@ gst_switch_server_start_audio (GstCase * cas, GstSwitchServer * srv)
   gst_switch_controller_tell_audio_port (srv->controller, cas->sink_port);
 }
 
+/**
+ * gst_switch_server_restart_recorder:
+ *  @return TRUE if the recorder is restarted.
+ *
+ *  Restart the recorder with the current composite parameters, into a new
+ *  file. The %recorder_lock must be held.
+ */
+static gboolean
+gst_switch_server_restart_recorder (GstSwitchServer * srv)
+{
+  GstWorkerClass *worker_class;
+
+  gst_worker_stop (GST_WORKER (srv->recorder));
+  g_object_set (G_OBJECT (srv->recorder),
+      "mode", srv->composite->mode,
+      "port", srv->composite->encode_sink_port,
+      "width", srv->composite->width,
+      "height", srv->composite->height,
+      "framerate", srv->composite->framerate, NULL);
+  worker_class = GST_WORKER_CLASS (G_OBJECT_GET_CLASS (srv->recorder));
+  if (!worker_class->reset (GST_WORKER (srv->recorder))) {
+    ERROR ("failed to reset composite recorder");
+    return FALSE;
+  }
+  return gst_worker_start (GST_WORKER (srv->recorder));
+}
+
 /**
  * gst_switch_server_new_record:
  *  @return: TRUE if succeeded.
  *
- *  Start a new recording.
+ *  Start a new recording. Only the file output is switched to a new file or
+ *  segment, the encoders and the network output keep running.
  *  
  */
 gboolean
 gst_switch_server_new_record (GstSwitchServer * srv)
 {
-  GstWorkerClass *worker_class;
   gboolean result = FALSE;
 
   g_return_val_if_fail (GST_IS_RECORDER (srv->recorder), FALSE);
 
   if (srv->recorder) {
     GST_SWITCH_SERVER_LOCK_RECORDER (srv);
-    if (srv->recorder) {
-      gst_worker_stop (GST_WORKER (srv->recorder));
-      g_object_set (G_OBJECT (srv->recorder),
-          "mode", srv->composite->mode,
-          "port", srv->composite->encode_sink_port,
-          "width", srv->composite->width,
-          "height", srv->composite->height, NULL);
-      worker_class = GST_WORKER_CLASS (G_OBJECT_GET_CLASS (srv->recorder));
-      if (worker_class->reset (GST_WORKER (srv->recorder))) {
-        result = gst_worker_start (GST_WORKER (srv->recorder));
-      } else {
-        ERROR ("failed to reset composite recorder");
-      }
+    if (srv->recorder && (gst_recorder_new_segment (srv->recorder) ||
+            gst_recorder_new_file (srv->recorder))) {
+      result = TRUE;
+    } else if (srv->recorder) {
+      result = gst_switch_server_restart_recorder (srv);
     }
     GST_SWITCH_SERVER_UNLOCK_RECORDER (srv);
   }
@@ -1067,108 +1496,323 @@ gst_switch_server_new_record (GstSwitchServer * srv)
 }
 
 /**
- * gst_switch_server_adjust_pip:
- *  @return: a unsigned number of indicating which compononent (x,y,w,h) has
- *           been changed
+ * gst_switch_server_set_layout:
+ *  @param srv the GstSwitchServer instance
+ *  @param name the layout name
+ *  @return: TRUE if the layout is being applied.
  *
- *  Adjust the PIP position and size.
+ *  Change the composite layout to a built-in or loaded layout.
  *
  */
-guint
-gst_switch_server_adjust_pip (GstSwitchServer * srv,
-    gint dx, gint dy, gint dw, gint dh)
+gboolean
+gst_switch_server_set_layout (GstSwitchServer * srv, const gchar * name)
 {
-  guint result = 0;
+  const GstLayout *layout = gst_layout_lookup (name);
+  gboolean result = FALSE;
 
-  g_return_val_if_fail (GST_IS_COMPOSITE (srv->composite), 0);
+  if (!layout) {
+    WARN ("no layout %s", name);
+    return FALSE;
+  }
 
   GST_SWITCH_SERVER_LOCK_PIP (srv);
+  if (g_strcmp0 (name, srv->composite->layout->name) == 0) {
+    WARN ("ignore the same layout %s", name);
+    goto end;
+  }
 
-  srv->pip_x += dx, srv->pip_y += dy;
-  srv->pip_w += dw, srv->pip_h += dh;
-  if (srv->pip_x < 0)
-    srv->pip_x = 0;
-  if (srv->pip_y < 0)
-    srv->pip_y = 0;
-  if (srv->pip_w < GST_SWITCH_COMPOSITE_MIN_PIP_W)
-    srv->pip_w = GST_SWITCH_COMPOSITE_MIN_PIP_W;
-  if (srv->pip_h < GST_SWITCH_COMPOSITE_MIN_PIP_H)
-    srv->pip_h = GST_SWITCH_COMPOSITE_MIN_PIP_H;
-
-  result = gst_composite_adjust_pip (srv->composite,
-      srv->pip_x, srv->pip_y, srv->pip_w, srv->pip_h);
-
-  if (dx != 0)
-    result |= (1 << 0);
-  if (dy != 0)
-    result |= (1 << 1);
-  if (dw != 0)
-    result |= (1 << 2);
-  if (dh != 0)
-    result |= (1 << 3);
+  result = gst_composite_set_layout (srv->composite, layout);
+  if (result) {
+    srv->pip_x = srv->composite->b_x;
+    srv->pip_y = srv->composite->b_y;
+    srv->pip_w = srv->composite->b_width;
+    srv->pip_h = srv->composite->b_height;
+  }
 
+end:
   GST_SWITCH_SERVER_UNLOCK_PIP (srv);
   return result;
 }
 
-static void gst_switch_server_worker_start (GstWorker *, GstSwitchServer *);
-static void gst_switch_server_worker_null (GstWorker *, GstSwitchServer *);
-
 /**
- * gst_switch_server_switch:
- *  @return: TRUE if succeeded.
+ * gst_switch_server_set_video_format:
+ *  @param srv the GstSwitchServer instance
+ *  @param width the output width
+ *  @param height the output height
+ *  @param framerate the output frames per second
+ *  @return: TRUE if the new format is being applied.
  *
- *  Switch the channel to the specific port.
+ *  Change the output format. The layouts and the scalers are derived from
+ *  it, the output and the recorder are restarted once the composite is.
+ *  Inputs connected before keep their format and are scaled.
  *
  */
 gboolean
-gst_switch_server_switch (GstSwitchServer * srv, gint channel, gint port)
+gst_switch_server_set_video_format (GstSwitchServer * srv, gint width,
+    gint height, gint framerate)
 {
-  GList *item;
   gboolean result = FALSE;
-  GstCase *compose_case, *candidate_case;
-  GstCase *work1, *work2;
-  GCallback callback = G_CALLBACK (gst_switch_server_end_case);
-  gchar *name;
+
+  GST_SWITCH_SERVER_LOCK_PIP (srv);
+  if (width == srv->composite->width && height == srv->composite->height &&
+      framerate == srv->composite->framerate) {
+    WARN ("ignore the same video format %dx%d@%d", width, height, framerate);
+    goto end;
+  }
+
+  if (width <= 0 || height <= 0 || framerate <= 0)
+    goto end;
+
+  result = gst_composite_set_format (srv->composite, width, height,
+      framerate);
+  if (result) {
+    srv->format_changed = TRUE;
+    srv->pip_x = srv->composite->b_x;
+    srv->pip_y = srv->composite->b_y;
+    srv->pip_w = srv->composite->b_width;
+    srv->pip_h = srv->composite->b_height;
+  }
+
+end:
+  GST_SWITCH_SERVER_UNLOCK_PIP (srv);
+  return result;
+}
+
+/**
+ * gst_switch_server_set_audio_gain:
+ *  @param srv the GstSwitchServer instance
+ *  @param port the audio input port
+ *  @param gain the linear gain
+ *  @return TRUE if succeeded.
+ *
+ *  Change the gain of a mixed audio input.
+ *
+ */
+gboolean
+gst_switch_server_set_audio_gain (GstSwitchServer * srv, gint port,
+    gdouble gain)
+{
+  if (!srv->audio_mix) {
+    WARN ("audio mixing is not enabled");
+    return FALSE;
+  }
+  return gst_audio_mix_set_gain (srv->audio_mix, port, gain);
+}
+
+/**
+ * gst_switch_server_set_audio_mute:
+ *  @param srv the GstSwitchServer instance
+ *  @param port the audio input port
+ *  @param mute TRUE to mute the input
+ *  @return TRUE if succeeded.
+ *
+ *  Mute or unmute a mixed audio input.
+ *
+ */
+gboolean
+gst_switch_server_set_audio_mute (GstSwitchServer * srv, gint port,
+    gboolean mute)
+{
+  if (!srv->audio_mix) {
+    WARN ("audio mixing is not enabled");
+    return FALSE;
+  }
+  return gst_audio_mix_set_mute (srv->audio_mix, port, mute);
+}
+
+/**
+ * gst_switch_server_set_audio_duck:
+ *  @param srv the GstSwitchServer instance
+ *  @param port the audio input port
+ *  @param duck TRUE to let the input duck the others
+ *  @return TRUE if succeeded.
+ *
+ *  Enable or disable ducking by a mixed audio input.
+ *
+ */
+gboolean
+gst_switch_server_set_audio_duck (GstSwitchServer * srv, gint port,
+    gboolean duck)
+{
+  if (!srv->audio_mix) {
+    WARN ("audio mixing is not enabled");
+    return FALSE;
+  }
+  return gst_audio_mix_set_duck (srv->audio_mix, port, duck);
+}
+
+/**
+ * gst_switch_server_get_preview_shm:
+ *  @param srv the GstSwitchServer instance
+ *  @param port the preview port
+ *  @param path return location for the socket of the shared memory preview
+ *  @param caps return location for the caps of the frames
+ *  @return TRUE if the preview is exposed in shared memory.
+ *
+ *  Find the shared memory preview of a video preview port, so that a UI on
+ *  the same host can map the frames instead of receiving them over TCP.
+ *
+ */
+gboolean
+gst_switch_server_get_preview_shm (GstSwitchServer * srv, gint port,
+    gchar ** path, gchar ** caps)
+{
+  gboolean ok = FALSE;
+  GList *item;
+
+  *path = *caps = NULL;
+
+  GST_SWITCH_SERVER_LOCK_CASES (srv);
+  for (item = srv->cases; item; item = g_list_next (item)) {
+    GstCase *cas = GST_CASE (item->data);
+    if (cas->sink_port != port || cas->serve_type != GST_SERVE_VIDEO_STREAM)
+      continue;
+    if (GST_CASE_IS_BRANCH_VIDEO (cas->type)
+        || cas->type == GST_CASE_BRANCH_p) {
+      ok = gst_case_get_shm (cas, path, caps);
+      break;
+    }
+  }
+  GST_SWITCH_SERVER_UNLOCK_CASES (srv);
+  return ok;
+}
+
+/**
+ * gst_switch_server_adjust_pip:
+ *  @return: a unsigned number of indicating which compononent (x,y,w,h) has
+ *           been changed
+ *
+ *  Adjust the PIP position and size.
+ *
+ */
+guint
+gst_switch_server_adjust_pip (GstSwitchServer * srv,
+    gint dx, gint dy, gint dw, gint dh)
+{
+  guint result = 0;
+
+  g_return_val_if_fail (GST_IS_COMPOSITE (srv->composite), 0);
+
+  GST_SWITCH_SERVER_LOCK_PIP (srv);
+
+  srv->pip_x += dx, srv->pip_y += dy;
+  srv->pip_w += dw, srv->pip_h += dh;
+  if (srv->pip_x < 0)
+    srv->pip_x = 0;
+  if (srv->pip_y < 0)
+    srv->pip_y = 0;
+  if (srv->pip_w < GST_SWITCH_COMPOSITE_MIN_PIP_W)
+    srv->pip_w = GST_SWITCH_COMPOSITE_MIN_PIP_W;
+  if (srv->pip_h < GST_SWITCH_COMPOSITE_MIN_PIP_H)
+    srv->pip_h = GST_SWITCH_COMPOSITE_MIN_PIP_H;
+
+  result = gst_composite_adjust_pip (srv->composite,
+      srv->pip_x, srv->pip_y, srv->pip_w, srv->pip_h);
+
+  if (dx != 0)
+    result |= (1 << 0);
+  if (dy != 0)
+    result |= (1 << 1);
+  if (dw != 0)
+    result |= (1 << 2);
+  if (dh != 0)
+    result |= (1 << 3);
+
+  GST_SWITCH_SERVER_UNLOCK_PIP (srv);
+  return result;
+}
+
+static void gst_switch_server_worker_start (GstWorker *, GstSwitchServer *);
+static void gst_switch_server_worker_null (GstWorker *, GstSwitchServer *);
+
+/**
+ * gst_switch_server_promote:
+ *  @return: TRUE if succeeded.
+ *
+ *  Make a preview case the input of an empty composite channel. The
+ *  %cases_lock must be held.
+ */
+static gboolean
+gst_switch_server_promote (GstSwitchServer * srv, GstCase * preview,
+    GstCaseType type)
+{
+  GstCase *work;
+
+  work = GST_CASE (g_object_new (GST_TYPE_CASE,
+          "name", GST_WORKER (preview)->name,
+          "type", type,
+          "serve", preview->serve_type,
+          "port", preview->sink_port,
+          "input", preview->input, "branch", preview->branch, NULL));
+  g_object_set (work,
+      "width", preview->width,
+      "height", preview->height,
+      "awidth", preview->a_width,
+      "aheight", preview->a_height,
+      "bwidth", preview->b_width, "bheight", preview->b_height, NULL);
+
+  preview->switching = TRUE;
+  g_signal_connect (preview, "worker-null",
+      G_CALLBACK (gst_switch_server_worker_null), srv);
+  gst_worker_stop (GST_WORKER (preview));
+
+  g_signal_connect (work, "start-worker",
+      G_CALLBACK (gst_switch_server_worker_start), srv);
+  g_signal_connect (work, "end-worker",
+      G_CALLBACK (gst_switch_server_end_case), srv);
+
+  if (!gst_worker_start (GST_WORKER (work))) {
+    ERROR ("failed to start %s", GST_WORKER (work)->name);
+    g_object_unref (work);
+    return FALSE;
+  }
+
+  srv->cases = g_list_append (srv->cases, work);
+
+  INFO ("promoted: %s to %c", GST_WORKER (work)->name,
+      (gchar) gst_case_get_channel (type));
+  return TRUE;
+}
+
+/**
+ * gst_switch_server_switch:
+ *  @return: TRUE if succeeded.
+ *
+ *  Switch the channel to the specific port. A composite channel without an
+ *  input takes the preview of the port.
+ *
+ */
+gboolean
+gst_switch_server_switch (GstSwitchServer * srv, gint channel, gint port)
+{
+  GList *item;
+  gboolean result = FALSE;
+  GstCase *compose_case, *candidate_case;
+  GstCase *work1, *work2;
+  GCallback callback = G_CALLBACK (gst_switch_server_end_case);
+  GstCaseType type = gst_case_get_composite_type (channel);
+  gchar *name;
 
   compose_case = NULL;
   candidate_case = NULL;
 
+  if (type == GST_CASE_UNKNOWN) {
+    WARN ("unknown channel %c", (gchar) channel);
+    return FALSE;
+  }
+
   GST_SWITCH_SERVER_LOCK_CASES (srv);
 
   for (item = srv->cases; item; item = g_list_next (item)) {
     GstCase *cas = GST_CASE (item->data);
-    switch (channel) {
-      case 'A':
-        if (cas->type == GST_CASE_COMPOSITE_A)
-          goto get_target_stream;
-        break;
-      case 'B':
-        if (cas->type == GST_CASE_COMPOSITE_B)
-          goto get_target_stream;
-        break;
-      case 'a':
-        if (cas->type == GST_CASE_COMPOSITE_a)
-          goto get_target_stream;
-        break;
-      default:
-        WARN ("unknown channel %c", (gchar) channel);
-        break;
-      get_target_stream:
-        if (compose_case == NULL) {
-          compose_case = cas;
-        }
+    if (cas->type == type && compose_case == NULL) {
+      compose_case = cas;
     }
-    switch (cas->type) {
-      case GST_CASE_COMPOSITE_A:
-      case GST_CASE_COMPOSITE_B:
-      case GST_CASE_COMPOSITE_a:
-      case GST_CASE_PREVIEW:
-        if (cas->sink_port == port) {
-          candidate_case = cas;
-        }
-      default:
-        break;
+    if (GST_CASE_IS_COMPOSITE_VIDEO (cas->type) ||
+        cas->type == GST_CASE_COMPOSITE_a || cas->type == GST_CASE_PREVIEW) {
+      if (cas->sink_port == port) {
+        candidate_case = cas;
+      }
     }
   }
 
@@ -1177,6 +1821,13 @@ gst_switch_server_switch (GstSwitchServer * srv, gint channel, gint port)
     goto end;
   }
 
+  if (!compose_case && GST_CASE_IS_COMPOSITE_VIDEO (type) &&
+      candidate_case->type == GST_CASE_PREVIEW &&
+      candidate_case->serve_type == GST_SERVE_VIDEO_STREAM) {
+    result = gst_switch_server_promote (srv, candidate_case, type);
+    goto end;
+  }
+
   if (!compose_case) {
     ERROR ("no stream for port %d (compose)", port);
     goto end;
@@ -1279,6 +1930,247 @@ error_start_work:
   }
 }
 
+/**
+ * gst_switch_server_transition:
+ *  @param srv the GstSwitchServer instance
+ *  @param channel the channel to be switched, 'A' to 'I'
+ *  @param port the target port number
+ *  @param blend the blending effect, @see GstCompositeBlend
+ *  @param duration the duration of the transition in milliseconds
+ *  @return: TRUE if the transition is started.
+ *
+ *  Switch the channel to the specific port with a timed transition. A zero
+ *  duration is the same as a cut by %gst_switch_server_switch.
+ *
+ */
+gboolean
+gst_switch_server_transition (GstSwitchServer * srv, gint channel, gint port,
+    gint blend, gint duration)
+{
+  GstCase *candidate_case = NULL;
+  GList *item;
+
+  if (duration <= 0)
+    return gst_switch_server_switch (srv, channel, port);
+
+  if (!GST_CASE_IS_COMPOSITE_VIDEO (gst_case_get_composite_type (channel))) {
+    WARN ("no transition for channel %c", (gchar) channel);
+    return FALSE;
+  }
+
+  if (blend < 0 || COMPOSITE_BLEND__LAST < blend) {
+    WARN ("unknown blending %d", blend);
+    return FALSE;
+  }
+
+  GST_SWITCH_SERVER_LOCK_CASES (srv);
+  for (item = srv->cases; item; item = g_list_next (item)) {
+    GstCase *cas = GST_CASE (item->data);
+    if (GST_CASE_IS_COMPOSITE_VIDEO (cas->type) ||
+        cas->type == GST_CASE_PREVIEW) {
+      if (cas->sink_port == port &&
+          cas->serve_type == GST_SERVE_VIDEO_STREAM) {
+        candidate_case = cas;
+      }
+    }
+  }
+
+  if (candidate_case &&
+      candidate_case->type == gst_case_get_composite_type (channel)) {
+    ERROR ("stream on %d already at %c", port, (gchar) channel);
+    candidate_case = NULL;
+  } else if (!candidate_case) {
+    ERROR ("no stream for port %d (candidate)", port);
+  }
+  GST_SWITCH_SERVER_UNLOCK_CASES (srv);
+
+  if (!candidate_case)
+    return FALSE;
+
+  return gst_composite_start_blend (srv->composite, channel, port, blend,
+      MIN (duration, GST_COMPOSITE_MAX_BLEND_DURATION));
+}
+
+/**
+ * gst_switch_server_end_blend:
+ *
+ * The composite has blended the new source into a channel, make it the
+ * input of the channel in place. The UIs are told the composite, encode
+ * and audio ports as after a switch.
+ */
+static void
+gst_switch_server_end_blend (GstComposite * composite, gint channel,
+    gint port, GstSwitchServer * srv)
+{
+  GstCaseType type = gst_case_get_composite_type (channel);
+  GstCase *compose_case = NULL, *candidate_case = NULL;
+  gboolean swapped = FALSE;
+  gint audio_port = 0;
+  GList *item;
+
+  GST_SWITCH_SERVER_LOCK_CASES (srv);
+  for (item = srv->cases; item; item = g_list_next (item)) {
+    GstCase *cas = GST_CASE (item->data);
+    if (cas->type == type && compose_case == NULL)
+      compose_case = cas;
+    if (cas->type == GST_CASE_COMPOSITE_a)
+      audio_port = cas->sink_port;
+    if (GST_CASE_IS_COMPOSITE_VIDEO (cas->type) ||
+        cas->type == GST_CASE_PREVIEW) {
+      if (cas->sink_port == port &&
+          cas->serve_type == GST_SERVE_VIDEO_STREAM) {
+        candidate_case = cas;
+      }
+    }
+  }
+
+  if (compose_case && candidate_case && compose_case != candidate_case) {
+    swapped = gst_case_swap_input (compose_case, candidate_case);
+  } else {
+    WARN ("blended input %d is gone", port);
+  }
+  GST_SWITCH_SERVER_UNLOCK_CASES (srv);
+
+  if (!swapped)
+    return;
+
+  GST_SWITCH_SERVER_LOCK_CONTROLLER (srv);
+  if (srv->controller) {
+    gst_switch_controller_tell_compose_port (srv->controller,
+        srv->composite->sink_port);
+    gst_switch_controller_tell_encode_port (srv->controller,
+        srv->composite->encode_sink_port);
+    if (audio_port)
+      gst_switch_controller_tell_audio_port (srv->controller, audio_port);
+  }
+  GST_SWITCH_SERVER_UNLOCK_CONTROLLER (srv);
+}
+
+/**
+ * gst_switch_server_find_standby:
+ * @return a healthy preview case able to replace @cas, or NULL
+ *
+ * Find a standby case for the unhealthy composite case.
+ */
+static GstCase *
+gst_switch_server_find_standby (GstSwitchServer * srv, GstCase * cas,
+    GstClockTime deadline)
+{
+  GList *item;
+
+  for (item = srv->cases; item; item = g_list_next (item)) {
+    GstCase *candidate = GST_CASE (item->data);
+    if (candidate->type != GST_CASE_PREVIEW || candidate->switching)
+      continue;
+    if (candidate->serve_type != cas->serve_type || !candidate->input)
+      continue;
+    if (gst_case_get_health (candidate->input, deadline) == GST_CASE_HEALTH_OK)
+      return candidate;
+  }
+  return NULL;
+}
+
+/**
+ * gst_switch_server_check_health:
+ * @return Always TRUE to keep the health monitor running.
+ *
+ * The input health monitor and failover policy. Every composite case
+ * (A to I and audio) whose input stalled, jittered or reported errors within
+ * the failover deadline is swapped in place with a healthy preview input.
+ * The UIs are told the new audio port, or the composite output of a video
+ * failover, as after a switch.
+ */
+static gboolean
+gst_switch_server_check_health (GstSwitchServer * srv)
+{
+  GstClockTime deadline = opts.failover_deadline * GST_MSECOND;
+  gint audio_port = 0;
+  gboolean video = FALSE;
+  GList *item;
+
+  GST_SWITCH_SERVER_LOCK_CASES (srv);
+  for (item = srv->cases; item; item = g_list_next (item)) {
+    GstCase *cas = GST_CASE (item->data), *standby;
+    GstCaseHealth health;
+    if (!GST_CASE_IS_COMPOSITE_VIDEO (cas->type) &&
+        cas->type != GST_CASE_COMPOSITE_a)
+      continue;
+    if (cas->switching || !cas->input)
+      continue;
+    health = gst_case_get_health (cas->input, deadline);
+    if (health == GST_CASE_HEALTH_OK)
+      continue;
+    standby = gst_switch_server_find_standby (srv, cas, deadline);
+    if (!standby)
+      continue;
+    INFO ("failover: %s (%d, health %d) -> %d", GST_WORKER (cas)->name,
+        cas->sink_port, health, standby->sink_port);
+    if (!gst_case_swap_input (cas, standby))
+      continue;
+    if (cas->type == GST_CASE_COMPOSITE_a)
+      audio_port = cas->sink_port;
+    else
+      video = TRUE;
+  }
+  GST_SWITCH_SERVER_UNLOCK_CASES (srv);
+
+  if (audio_port || video) {
+    GST_SWITCH_SERVER_LOCK_CONTROLLER (srv);
+    if (srv->controller && audio_port) {
+      gst_switch_controller_tell_audio_port (srv->controller, audio_port);
+    }
+    if (srv->controller && video) {
+      gst_switch_controller_tell_compose_port (srv->controller,
+          srv->composite->sink_port);
+    }
+    GST_SWITCH_SERVER_UNLOCK_CONTROLLER (srv);
+  }
+  return TRUE;
+}
+
+/**
+ * gst_switch_server_tell_audio_levels:
+ * @return Always TRUE to keep the audio level reporter running.
+ *
+ * Tell the UIs the levels measured on the audio branches since the last
+ * time, so that they can draw level meters without decoding the audio.
+ */
+static gboolean
+gst_switch_server_tell_audio_levels (GstSwitchServer * srv)
+{
+  GArray *levels = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  GArray *ports = g_array_new (FALSE, FALSE, sizeof (gint));
+  gdouble level[3];
+  GList *item;
+  guint n;
+
+  GST_SWITCH_SERVER_LOCK_CASES (srv);
+  for (item = srv->cases; item; item = g_list_next (item)) {
+    GstCase *cas = GST_CASE (item->data);
+    if (cas->serve_type != GST_SERVE_AUDIO_STREAM ||
+        (cas->type != GST_CASE_BRANCH_a && cas->type != GST_CASE_BRANCH_p))
+      continue;
+    if (gst_case_get_audio_level (cas, &level[0], &level[1], &level[2])) {
+      g_array_append_val (ports, cas->sink_port);
+      g_array_append_vals (levels, level, 3);
+    }
+  }
+  GST_SWITCH_SERVER_UNLOCK_CASES (srv);
+
+  GST_SWITCH_SERVER_LOCK_CONTROLLER (srv);
+  for (n = 0; srv->controller && n < ports->len; ++n) {
+    gst_switch_controller_tell_audio_level (srv->controller,
+        g_array_index (ports, gint, n), g_array_index (levels, gdouble, n * 3),
+        g_array_index (levels, gdouble, n * 3 + 1),
+        g_array_index (levels, gdouble, n * 3 + 2));
+  }
+  GST_SWITCH_SERVER_UNLOCK_CONTROLLER (srv);
+
+  g_array_free (levels, TRUE);
+  g_array_free (ports, TRUE);
+  return TRUE;
+}
+
 /**
  * gst_switch_server_worker_start:
  *
@@ -1361,8 +2253,30 @@ gst_switch_server_start_recorder (GstWorker * worker, GstSwitchServer * srv)
 static void
 gst_switch_server_end_transition (GstWorker * worker, GstSwitchServer * srv)
 {
+  GstWorkerClass *worker_class;
+  gboolean format_changed;
+
   g_return_if_fail (GST_IS_WORKER (worker));
 
+  GST_SWITCH_SERVER_LOCK_PIP (srv);
+  format_changed = srv->format_changed;
+  srv->format_changed = FALSE;
+  GST_SWITCH_SERVER_UNLOCK_PIP (srv);
+
+  if (format_changed && srv->output) {
+    gst_worker_stop (srv->output);
+    worker_class = GST_WORKER_CLASS (G_OBJECT_GET_CLASS (srv->output));
+    if (!worker_class->reset (srv->output) || !gst_worker_start (srv->output))
+      ERROR ("failed to restart the output");
+  }
+
+  if (format_changed && srv->recorder) {
+    GST_SWITCH_SERVER_LOCK_RECORDER (srv);
+    if (srv->recorder && !gst_switch_server_restart_recorder (srv))
+      ERROR ("failed to restart the recorder");
+    GST_SWITCH_SERVER_UNLOCK_RECORDER (srv);
+  }
+
   GST_SWITCH_SERVER_LOCK_CONTROLLER (srv);
   if (srv->controller) {
     gint mode = srv->composite->mode;
@@ -1382,7 +2296,7 @@ gst_switch_server_output_client_socket_added (GstElement * element,
 {
   g_return_if_fail (G_IS_SOCKET (socket));
 
-  //INFO ("client-socket-added: %d", g_socket_get_fd (socket));
+  gst_client_policy_client_added (element, socket);
 }
 
 /**
@@ -1412,7 +2326,7 @@ static gboolean
 gst_switch_server_prepare_composite (GstSwitchServer * srv,
     GstCompositeMode mode)
 {
-  gint port, encode;
+  gint port, encode, width, height, framerate;
 
   if (srv->composite) {
     return TRUE;
@@ -1424,9 +2338,17 @@ gst_switch_server_prepare_composite (GstSwitchServer * srv,
   INFO ("Compose sink to %d, %d", port, encode);
 
   g_assert (srv->composite == NULL);
+  width = GST_SWITCH_COMPOSITE_DEFAULT_WIDTH;
+  height = GST_SWITCH_COMPOSITE_DEFAULT_HEIGHT;
+  if (opts.video_size)
+    gst_switch_server_parse_video_size (opts.video_size, &width, &height);
+  framerate = 0 < opts.video_framerate ? opts.video_framerate :
+      GST_SWITCH_COMPOSITE_DEFAULT_FRAMERATE;
+
   srv->composite = GST_COMPOSITE (g_object_new (GST_TYPE_COMPOSITE,
-          "name", "composite", "port",
-          port, "encode", encode, "mode", mode, NULL));
+          "name", "composite", "port", port, "encode", encode,
+          "width", width, "height", height, "framerate", framerate,
+          "mode", mode, NULL));
 
   g_signal_connect (srv->composite, "start-worker",
       G_CALLBACK (gst_switch_server_worker_start), srv);
@@ -1441,6 +2363,8 @@ gst_switch_server_prepare_composite (GstSwitchServer * srv,
    */
   g_signal_connect (srv->composite, "end-transition",
       G_CALLBACK (gst_switch_server_end_transition), srv);
+  g_signal_connect (srv->composite, "end-blend",
+      G_CALLBACK (gst_switch_server_end_blend), srv);
 
   GST_SWITCH_SERVER_LOCK_PIP (srv);
   srv->pip_x = srv->composite->b_x;
@@ -1462,6 +2386,45 @@ error_start_composite:
   }
 }
 
+/**
+ * gst_switch_server_append_rtp_output:
+ *
+ * Append the RTP branch of the composite output, teed from "out". Every
+ * packet is sent once to the UDP destination however many receivers joined
+ * the group, and a slow encoder drops frames rather than holding back the
+ * TCP output.
+ */
+static void
+gst_switch_server_append_rtp_output (GstSwitchServer * srv, GString * desc)
+{
+  gchar *host = NULL, *queue;
+  gint port = 0;
+
+  gst_switch_server_parse_rtp_output (opts.rtp_output, &host, &port);
+
+  queue = gst_queue_policy_get_string (GST_QUEUE_ROLE_PREVIEW, NULL);
+  g_string_append_printf (desc, "out. ! %s", queue);
+  g_free (queue);
+  if (g_strcmp0 (opts.rtp_format, "h264") == 0) {
+    g_string_append_printf (desc, "! x264enc tune=zerolatency "
+        "speed-preset=ultrafast key-int-max=%d ", srv->composite->framerate);
+    g_string_append_printf (desc, "! rtph264pay config-interval=1 pt=96 ");
+  } else if (g_strcmp0 (opts.rtp_format, "vp8") == 0) {
+    g_string_append_printf (desc, "! vp8enc deadline=1 "
+        "keyframe-max-dist=%d ", srv->composite->framerate);
+    g_string_append_printf (desc, "! rtpvp8pay pt=96 ");
+  } else {
+    g_string_append_printf (desc, "! rtpvrawpay pt=96 ");
+  }
+  g_string_append_printf (desc, "mtu=%d ", GST_SWITCH_SERVER_RTP_MTU);
+  g_string_append_printf (desc, "! udpsink name=rtp host=%s port=%d "
+      "auto-multicast=true sync=false async=false ", host, port);
+
+  INFO ("RTP output to %s:%d (%s)", host, port,
+      opts.rtp_format ? opts.rtp_format : "raw");
+  g_free (host);
+}
+
 /**
  * gst_switch_server_get_output_string:
  * @return The composite output pipeline string, needs freeing after used
@@ -1472,16 +2435,27 @@ static GString *
 gst_switch_server_get_output_string (GstWorker * worker, GstSwitchServer * srv)
 {
   GString *desc;
+  gchar *policy, *queue;
 
   desc = g_string_new ("");
 
   g_string_append_printf (desc, "intervideosrc name=source "
       "channel=composite_out ");
-  g_string_append_printf (desc, "tcpserversink name=sink "
-      "port=%d ", srv->composite->sink_port);
-  g_string_append_printf (desc, "source. ! video/x-raw,width=%d,height=%d ",
-      srv->composite->width, srv->composite->height);
+  policy = gst_client_policy_get_string (GST_CLIENT_ROLE_OUTPUT);
+  g_string_append_printf (desc, "tcpserversink name=sink %s"
+      "port=%d ", policy, srv->composite->sink_port);
+  g_free (policy);
+  g_string_append_printf (desc, "source. ! video/x-raw,width=%d,height=%d,"
+      "framerate=%d/1 ", srv->composite->width, srv->composite->height,
+      srv->composite->framerate);
   ASSESS ("assess-output");
+  if (opts.rtp_output) {
+    g_string_append_printf (desc, "! tee name=out ");
+    gst_switch_server_append_rtp_output (srv, desc);
+    queue = gst_queue_policy_get_string (GST_QUEUE_ROLE_PREVIEW, NULL);
+    g_string_append_printf (desc, "out. ! %s", queue);
+    g_free (queue);
+  }
   g_string_append_printf (desc, "! gdppay ");
   /*
      ASSESS ("assess-output-payed");
@@ -1504,9 +2478,14 @@ gst_switch_server_prepare_output (GstWorker * worker, GstSwitchServer * srv)
 
   g_return_if_fail (GST_IS_ELEMENT (sink));
 
+  gst_queue_policy_watch (worker->pipeline);
+
   g_signal_connect (sink, "client-added",
       G_CALLBACK (gst_switch_server_output_client_socket_added), srv);
 
+  g_signal_connect (sink, "client-removed",
+      G_CALLBACK (gst_client_policy_client_removed), srv);
+
   g_signal_connect (sink, "client-socket-removed",
       G_CALLBACK (gst_switch_server_output_client_socket_removed), srv);
 
@@ -1559,7 +2538,8 @@ gst_switch_server_create_recorder (GstSwitchServer * srv)
           "name", "recorder", "port",
           srv->composite->encode_sink_port, "mode",
           srv->composite->mode, "width",
-          srv->composite->width, "height", srv->composite->height, NULL));
+          srv->composite->width, "height", srv->composite->height,
+          "framerate", srv->composite->framerate, NULL));
 
   g_signal_connect (srv->recorder, "start-worker",
       G_CALLBACK (gst_switch_server_start_recorder), srv);
@@ -1569,6 +2549,40 @@ gst_switch_server_create_recorder (GstSwitchServer * srv)
   return TRUE;
 }
 
+/**
+ * gst_switch_server_create_audio_mix:
+ * @return TRUE if the audio mixer is created or not required.
+ *
+ * Creating the audio mixer.
+ */
+static gboolean
+gst_switch_server_create_audio_mix (GstSwitchServer * srv)
+{
+  if (!opts.audio_mix || srv->audio_mix) {
+    return TRUE;
+  }
+
+  srv->audio_mix = GST_AUDIO_MIX (g_object_new (GST_TYPE_AUDIO_MIX,
+          "name", "audio-mix", NULL));
+
+  g_signal_connect (srv->audio_mix, "start-worker",
+      G_CALLBACK (gst_switch_server_worker_start), srv);
+  g_signal_connect (srv->audio_mix, "worker-null",
+      G_CALLBACK (gst_switch_server_worker_null), srv);
+
+  if (!gst_worker_start (GST_WORKER (srv->audio_mix)))
+    goto error_start_audio_mix;
+
+  return TRUE;
+
+error_start_audio_mix:
+  {
+    g_object_unref (srv->audio_mix);
+    srv->audio_mix = NULL;
+    return FALSE;
+  }
+}
+
 /*
 gboolean timeout(gpointer user_data) {
   INFO ("Exiting!");
@@ -1600,6 +2614,20 @@ gst_switch_server_run (GstSwitchServer * srv)
   if (!gst_switch_server_create_recorder (srv))
     goto error_prepare_recorder;
 
+  if (!gst_switch_server_create_audio_mix (srv))
+    goto error_prepare_audio_mix;
+
+  if (0 < opts.failover_deadline) {
+    srv->failover_watch = g_timeout_add (MAX (opts.failover_deadline / 4,
+            GST_SWITCH_SERVER_MIN_HEALTH_CHECK_INTERVAL),
+        (GSourceFunc) gst_switch_server_check_health, srv);
+  }
+
+  if (0 < opts.audio_level_interval) {
+    srv->audio_level_watch = g_timeout_add (opts.audio_level_interval,
+        (GSourceFunc) gst_switch_server_tell_audio_levels, srv);
+  }
+
   srv->video_acceptor = g_thread_new ("switch-server-video-acceptor",
       (GThreadFunc)
       gst_switch_server_video_acceptor, srv);
@@ -1608,6 +2636,14 @@ gst_switch_server_run (GstSwitchServer * srv)
       (GThreadFunc)
       gst_switch_server_audio_acceptor, srv);
 
+  if (opts.input_dir) {
+    GMainContext *context = g_main_context_new ();
+    srv->local_loop = g_main_loop_new (context, FALSE);
+    g_main_context_unref (context);
+    srv->local_acceptor = g_thread_new ("switch-server-local-acceptor",
+        (GThreadFunc) gst_switch_server_local_acceptor, srv);
+  }
+
   srv->controller_thread = g_thread_new ("switch-server-controller",
       (GThreadFunc)
       gst_switch_server_controller, srv);
@@ -1644,6 +2680,11 @@ error_prepare_recorder:
     ERROR ("error preparing server");
     return;
   }
+error_prepare_audio_mix:
+  {
+    ERROR ("error preparing server");
+    return;
+  }
 }
 
 int
@@ -29,6 +29,7 @@
 #define __GST_SWITCH_SERVER_H__by_Duzy_Chan__ 1
 #include <gio/gio.h>
 #include "gstcomposite.h"
+#include "gstaudiomix.h"
 #include "gstswitchcontroller.h"
 #include "../logutils.h"
 
@@ -52,6 +53,39 @@ typedef struct _GstSwitchServerOpts GstSwitchServerOpts;
  *  @param video_input_port the video input TCP port
  *  @param audio_input_port the audio input TCP port
  *  @param control_port (discarded)
+ *  @param failover_deadline the time (in ms) a composite input is allowed to
+ *         be unhealthy before failing over to a standby, 0 disables failover
+ *  @param audio_mix TRUE to mix all audio inputs instead of switching between
+ *         them
+ *  @param record_segment_time the duration (in seconds) of a recording
+ *         segment, 0 for no limit
+ *  @param record_segment_size the size (in MiB) of a recording segment,
+ *         0 for no limit
+ *  @param record_direct TRUE to write the recording with O_DIRECT
+ *  @param record_iso TRUE to also record every input into a file of its own
+ *  @param record_iso_threads the encoder threads shared by the ISO
+ *         recordings, 0 for half of the processors
+ *  @param decode_threads the decoder threads shared by the compressed
+ *         inputs, 0 for the number of processors
+ *  @param video_size the output size, e.g. "1920x1080"
+ *  @param video_framerate the output frames per second, 0 for the default
+ *  @param layouts_file the file of extra composite layouts
+ *  @param audio_level_interval the time (in ms) between the audio levels
+ *         told to the UIs, 0 disables the level meters
+ *  @param preview_shm TRUE to also expose the video previews in shared
+ *         memory for UIs on the same host
+ *  @param input_dir the directory of the Unix sockets and shared memory
+ *         of local inputs, NULL to only accept inputs on the TCP ports
+ *  @param rtp_output the UDP HOST:PORT the composite is also sent to as RTP
+ *  @param rtp_format the RTP payload of the composite: raw, h264 or vp8
+ *  @param client_max_lag the time (in ms) a client of a TCP port may lag
+ *         behind before it's resynced
+ *  @param client_max_bytes the data (in KiB) a client of a TCP port may lag
+ *         behind before it's resynced, 0 to limit the time instead
+ *  @param client_disconnect_lag the time (in ms) a client of a TCP port may
+ *         lag behind before it's disconnected
+ *  @param client_drop how a lagging client is resynced: latest, keyframe or
+ *         none
  */
 struct _GstSwitchServerOpts
 {
@@ -61,6 +95,26 @@ struct _GstSwitchServerOpts
   gint video_input_port;
   gint audio_input_port;
   gint control_port;
+  gint failover_deadline;
+  gboolean audio_mix;
+  gint record_segment_time;
+  gint record_segment_size;
+  gboolean record_direct;
+  gboolean record_iso;
+  gint record_iso_threads;
+  gint decode_threads;
+  gchar *video_size;
+  gint video_framerate;
+  gchar *layouts_file;
+  gint audio_level_interval;
+  gboolean preview_shm;
+  gchar *input_dir;
+  gchar *rtp_output;
+  gchar *rtp_format;
+  gint client_max_lag;
+  gint client_max_bytes;
+  gint client_disconnect_lag;
+  gchar *client_drop;
 };
 
 /**
@@ -79,10 +133,15 @@ struct _GstSwitchServerOpts
  *  @param audio_acceptor the audio acceptor thread
  *  @param audio_acceptor_socket the audio acceptor socket
  *  @param audio_acceptor_port the audio acceptor port
+ *  @param local_acceptor the thread accepting local inputs
+ *  @param local_loop the main loop of the %local_acceptor
+ *  @param local_video_socket the Unix socket for local video inputs
+ *  @param local_audio_socket the Unix socket for local audio inputs
+ *  @param local_monitor the monitor of the shared memory inputs
  *  @param controller_lock the lock for controller
- *  @param controller_thread the controller thread (deprecated)
- *  @param controller_socket the controller socket (deprecated)
- *  @param controller_port the controller port number (deprecated)
+ *  @param controller_thread the thread accepting TCP control clients
+ *  @param controller_socket the TCP control socket
+ *  @param controller_port the TCP control port number
  *  @param controller the controller instance
  *  @param alloc_port_lock the lock for %alloc_port_count
  *  @param alloc_port_count port allocation counter
@@ -99,8 +158,14 @@ struct _GstSwitchServerOpts
  *  @param pip_y the PIP y position
  *  @param pip_w the PIP width
  *  @param pip_h the PIP height
+ *  @param format_changed TRUE if the output format changed with the current
+ *         composite transition
  *  @param clock_lock the lock for %clock
  *  @param clock a system clock
+ *  @param base_time the base time shared by all worker pipelines
+ *  @param failover_watch the source ID of the input health monitor
+ *  @param audio_level_watch the source ID of the audio level reporter
+ *  @param audio_mix the audio mixer, NULL unless audio mixing is enabled
  */
 struct _GstSwitchServer
 {
@@ -123,6 +188,12 @@ struct _GstSwitchServer
   GSocket *audio_acceptor_socket;
   gint audio_acceptor_port;
 
+  GThread *local_acceptor;
+  GMainLoop *local_loop;
+  GSocket *local_video_socket;
+  GSocket *local_audio_socket;
+  GFileMonitor *local_monitor;
+
   GMutex controller_lock;
   GThread *controller_thread;
   GSocket *controller_socket;
@@ -146,9 +217,16 @@ struct _GstSwitchServer
 
   GMutex pip_lock;
   gint pip_x, pip_y, pip_w, pip_h;
+  gboolean format_changed;
 
   GMutex clock_lock;
   GstClock *clock;
+  GstClockTime base_time;
+
+  guint failover_watch;
+  guint audio_level_watch;
+
+  GstAudioMix *audio_mix;
 };
 
 /**
@@ -170,9 +248,23 @@ gboolean gst_switch_server_set_composite_mode (GstSwitchServer * srv,
     gint mode);
 gboolean gst_switch_server_switch (GstSwitchServer * srv, gint channel,
     gint port);
+gboolean gst_switch_server_transition (GstSwitchServer * srv, gint channel,
+    gint port, gint blend, gint duration);
 guint gst_switch_server_adjust_pip (GstSwitchServer * srv, gint dx, gint dy,
     gint dw, gint dh);
 gboolean gst_switch_server_new_record (GstSwitchServer * srv);
+gboolean gst_switch_server_set_layout (GstSwitchServer * srv,
+    const gchar * name);
+gboolean gst_switch_server_set_video_format (GstSwitchServer * srv,
+    gint width, gint height, gint framerate);
+gboolean gst_switch_server_set_audio_gain (GstSwitchServer * srv, gint port,
+    gdouble gain);
+gboolean gst_switch_server_set_audio_mute (GstSwitchServer * srv, gint port,
+    gboolean mute);
+gboolean gst_switch_server_set_audio_duck (GstSwitchServer * srv, gint port,
+    gboolean duck);
+gboolean gst_switch_server_get_preview_shm (GstSwitchServer * srv, gint port,
+    gchar ** path, gchar ** caps);
 
 extern GstSwitchServerOpts opts;
 
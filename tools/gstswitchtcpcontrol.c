@@ -0,0 +1,430 @@
+/* GstSwitch
+ * Copyright (C) 2012,2013 Duzy Chan <code@duzy.info>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*! @file */
+
+/*
+ * The TCP control protocol, one JSON object per line:
+ *
+ *   -> {"id":1,"method":"switch","params":["A",3003]}
+ *   <- {"id":1,"result":[true]}
+ *   -> {"id":2,"method":"subscribe"}
+ *   <- {"id":2,"result":[]}
+ *   <- {"event":"preview_port","params":[3004,1,1]}
+ *
+ * The methods and their parameters are the ones of the D-Bus interface,
+ * channels may also be given as "A" to "I". Requests may be pipelined,
+ * they're answered in order, and a request without "id" is answered
+ * without it.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <json-glib/json-glib.h>
+#include "gstswitchtcpcontrol.h"
+#include "../logutils.h"
+
+/**
+ * @brief A client connected to the control port.
+ * @param controller the controller invoked by the session
+ * @param connection the client connection
+ * @param input the line reader of the connection
+ * @param outbox the lines to be sent to the client
+ * @param writer the thread sending the lines of %outbox
+ * @param subscribed TRUE if the client is told about the events
+ * @param overflow TRUE once the client fell too far behind
+ */
+typedef struct _GstSwitchTcpSession
+{
+  GstSwitchController *controller;
+  GSocketConnection *connection;
+  GDataInputStream *input;
+  GAsyncQueue *outbox;
+  GThread *writer;
+  gboolean subscribed;
+  gint overflow;
+} GstSwitchTcpSession;
+
+/**
+ * Pushed into the outbox to stop the writer.
+ */
+static gchar gst_switch_tcp_control_quit[] = "";
+
+/**
+ * gst_switch_tcp_control_to_line:
+ *  @param builder a builder holding a complete object
+ *  @return a newly allocated line of JSON text
+ */
+static gchar *
+gst_switch_tcp_control_to_line (JsonBuilder * builder)
+{
+  JsonGenerator *generator = json_generator_new ();
+  JsonNode *root = json_builder_get_root (builder);
+  gchar *text, *line;
+
+  json_generator_set_root (generator, root);
+  text = json_generator_to_data (generator, NULL);
+  line = g_strconcat (text, "\n", NULL);
+
+  g_free (text);
+  json_node_free (root);
+  g_object_unref (generator);
+  g_object_unref (builder);
+  return line;
+}
+
+/**
+ * gst_switch_tcp_control_post:
+ *
+ * Queue a line for the client, or close the session if the client doesn't
+ * keep up with it.
+ */
+static void
+gst_switch_tcp_control_post (GstSwitchTcpSession * session, gchar * line)
+{
+  GSocket *socket;
+
+  if (g_atomic_int_get (&session->overflow)) {
+    g_free (line);
+    return;
+  }
+
+  if (GST_SWITCH_TCP_CONTROL_MAX_PENDING <=
+      g_async_queue_length (session->outbox)) {
+    WARN ("TCP control client is %d lines behind, closing",
+        GST_SWITCH_TCP_CONTROL_MAX_PENDING);
+    g_atomic_int_set (&session->overflow, TRUE);
+    socket = g_socket_connection_get_socket (session->connection);
+    g_socket_shutdown (socket, TRUE, TRUE, NULL);
+    g_free (line);
+    return;
+  }
+
+  g_async_queue_push (session->outbox, line);
+}
+
+/**
+ * gst_switch_tcp_control_notify:
+ *
+ * Invoked by the controller for the signals sent to the UIs.
+ */
+static void
+gst_switch_tcp_control_notify (const gchar * name, GVariant * parameters,
+    GstSwitchTcpSession * session)
+{
+  JsonBuilder *builder = json_builder_new ();
+
+  json_builder_begin_object (builder);
+  json_builder_set_member_name (builder, "event");
+  json_builder_add_string_value (builder, name);
+  json_builder_set_member_name (builder, "params");
+  json_builder_add_value (builder, json_gvariant_serialize (parameters));
+  json_builder_end_object (builder);
+
+  gst_switch_tcp_control_post (session,
+      gst_switch_tcp_control_to_line (builder));
+}
+
+/**
+ * gst_switch_tcp_control_parse_params:
+ *  @param params the JSON array of the parameters, or NULL for none
+ *  @param type the tuple type of the method parameters
+ *  @return the method parameters, or NULL on errors
+ */
+static GVariant *
+gst_switch_tcp_control_parse_params (JsonNode * params,
+    const GVariantType * type, GError ** error)
+{
+  const GVariantType *item;
+  JsonNode *element, *empty = NULL;
+  JsonArray *array;
+  const gchar *channel;
+  gchar *signature;
+  GVariant *parameters;
+  guint n;
+
+  if (!params) {
+    params = empty = json_node_new (JSON_NODE_ARRAY);
+    json_node_take_array (empty, json_array_new ());
+  }
+
+  if (!JSON_NODE_HOLDS_ARRAY (params)) {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+        "\"params\" is not an array");
+    return NULL;
+  }
+
+  /* Accept "A" to "I" for the channel parameters. */
+  array = json_node_get_array (params);
+  item = g_variant_type_first (type);
+  for (n = 0; item && n < json_array_get_length (array); ++n) {
+    element = json_array_get_element (array, n);
+    if (g_variant_type_equal (item, G_VARIANT_TYPE_INT32) &&
+        JSON_NODE_HOLDS_VALUE (element) &&
+        json_node_get_value_type (element) == G_TYPE_STRING) {
+      channel = json_node_get_string (element);
+      if (channel && channel[0] && !channel[1])
+        json_node_set_int (element, channel[0]);
+    }
+    item = g_variant_type_next (item);
+  }
+
+  signature = g_variant_type_dup_string (type);
+  parameters = json_gvariant_deserialize (params, signature, error);
+  g_free (signature);
+
+  if (empty)
+    json_node_free (empty);
+  return parameters;
+}
+
+/**
+ * gst_switch_tcp_control_handle:
+ *  @param session the session of the request
+ *  @param line a line of JSON text
+ *  @return the reply line
+ */
+static gchar *
+gst_switch_tcp_control_handle (GstSwitchTcpSession * session,
+    const gchar * line)
+{
+  JsonParser *parser = json_parser_new ();
+  JsonBuilder *builder = json_builder_new ();
+  JsonNode *root, *id = NULL, *method_node;
+  JsonObject *request;
+  const gchar *method = NULL;
+  GVariantType *type = NULL;
+  GVariant *parameters = NULL, *results = NULL;
+  GError *error = NULL;
+
+  if (!json_parser_load_from_data (parser, line, -1, &error))
+    goto reply;
+
+  root = json_parser_get_root (parser);
+  if (!root || !JSON_NODE_HOLDS_OBJECT (root)) {
+    g_set_error (&error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+        "The request is not an object");
+    goto reply;
+  }
+
+  request = json_node_get_object (root);
+  id = json_object_get_member (request, "id");
+  method_node = json_object_get_member (request, "method");
+  if (method_node && JSON_NODE_HOLDS_VALUE (method_node) &&
+      json_node_get_value_type (method_node) == G_TYPE_STRING)
+    method = json_node_get_string (method_node);
+  if (!method) {
+    g_set_error (&error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+        "The request has no \"method\"");
+    goto reply;
+  }
+
+  if (g_strcmp0 (method, "subscribe") == 0) {
+    if (!session->subscribed)
+      gst_switch_controller_add_listener (session->controller,
+          (GstSwitchControllerListener) gst_switch_tcp_control_notify,
+          session);
+    session->subscribed = TRUE;
+    results = g_variant_ref_sink (g_variant_new ("()"));
+    goto reply;
+  }
+
+  if (g_strcmp0 (method, "unsubscribe") == 0) {
+    if (session->subscribed)
+      gst_switch_controller_remove_listener (session->controller,
+          (GstSwitchControllerListener) gst_switch_tcp_control_notify,
+          session);
+    session->subscribed = FALSE;
+    results = g_variant_ref_sink (g_variant_new ("()"));
+    goto reply;
+  }
+
+  type = gst_switch_controller_get_in_type (session->controller, method);
+  if (!type) {
+    g_set_error (&error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+        "Unsupported call %s", method);
+    goto reply;
+  }
+
+  parameters = gst_switch_tcp_control_parse_params (json_object_get_member
+      (request, "params"), type, &error);
+  if (parameters) {
+    g_variant_ref_sink (parameters);
+    results = gst_switch_controller_invoke (session->controller, method,
+        parameters, &error);
+  }
+
+reply:
+  json_builder_begin_object (builder);
+  if (id) {
+    json_builder_set_member_name (builder, "id");
+    json_builder_add_value (builder, json_node_copy (id));
+  }
+  if (results) {
+    json_builder_set_member_name (builder, "result");
+    json_builder_add_value (builder, json_gvariant_serialize (results));
+    g_variant_unref (results);
+  } else {
+    json_builder_set_member_name (builder, "error");
+    json_builder_add_string_value (builder,
+        error ? error->message : "Unknown error");
+  }
+  json_builder_end_object (builder);
+
+  if (error)
+    g_error_free (error);
+  if (parameters)
+    g_variant_unref (parameters);
+  if (type)
+    g_variant_type_free (type);
+  g_object_unref (parser);
+  return gst_switch_tcp_control_to_line (builder);
+}
+
+/**
+ * gst_switch_tcp_control_write:
+ *
+ * The writer thread of a session, every line queued meanwhile is sent with
+ * a single write.
+ */
+static gpointer
+gst_switch_tcp_control_write (GstSwitchTcpSession * session)
+{
+  GOutputStream *output =
+      g_io_stream_get_output_stream (G_IO_STREAM (session->connection));
+  GString *batch = g_string_new (NULL);
+  GError *error = NULL;
+  gboolean quit = FALSE, failed = FALSE;
+  gchar *line;
+
+  while (!quit) {
+    line = g_async_queue_pop (session->outbox);
+    do {
+      if (line == gst_switch_tcp_control_quit) {
+        quit = TRUE;
+        break;
+      }
+      g_string_append (batch, line);
+      g_free (line);
+    } while ((line = g_async_queue_try_pop (session->outbox)));
+
+    if (!failed && batch->len && !g_output_stream_write_all (output,
+            batch->str, batch->len, NULL, NULL, &error)) {
+      INFO ("TCP control: %s", error->message);
+      g_clear_error (&error);
+      failed = TRUE;
+      g_socket_shutdown (g_socket_connection_get_socket (session->connection),
+          TRUE, TRUE, NULL);
+    }
+    g_string_truncate (batch, 0);
+  }
+
+  g_string_free (batch, TRUE);
+  return NULL;
+}
+
+/**
+ * gst_switch_tcp_control_read:
+ *
+ * The reader thread of a session, it invokes the requests in order and
+ * tears the session down when the client is gone. Each request waits for
+ * the main loop to run it, see gst_switch_controller_invoke().
+ */
+static gpointer
+gst_switch_tcp_control_read (GstSwitchTcpSession * session)
+{
+  GError *error = NULL;
+  gchar *line;
+
+  while ((line = g_data_input_stream_read_line (session->input, NULL, NULL,
+              &error))) {
+    if (line[0])
+      gst_switch_tcp_control_post (session,
+          gst_switch_tcp_control_handle (session, line));
+    g_free (line);
+  }
+
+  if (error) {
+    INFO ("TCP control: %s", error->message);
+    g_error_free (error);
+  }
+
+  if (session->subscribed)
+    gst_switch_controller_remove_listener (session->controller,
+        (GstSwitchControllerListener) gst_switch_tcp_control_notify, session);
+
+  g_async_queue_push (session->outbox, gst_switch_tcp_control_quit);
+  g_thread_join (session->writer);
+
+  g_io_stream_close (G_IO_STREAM (session->connection), NULL, NULL);
+  g_object_unref (session->input);
+  g_object_unref (session->connection);
+  g_async_queue_unref (session->outbox);
+  g_object_unref (session->controller);
+  g_free (session);
+  return NULL;
+}
+
+/**
+ * gst_switch_tcp_control_serve:
+ *  @param controller the controller to be invoked
+ *  @param client the accepted client socket, the session takes it
+ *
+ *  Serve the TCP control protocol to a client on threads of its own.
+ */
+void
+gst_switch_tcp_control_serve (GstSwitchController * controller,
+    GSocket * client)
+{
+  GstSwitchTcpSession *session;
+  GError *error = NULL;
+  GThread *thread;
+
+  if (!g_socket_set_option (client, IPPROTO_TCP, TCP_NODELAY, 1, &error)) {
+    WARN ("TCP_NODELAY: %s", error->message);
+    g_clear_error (&error);
+  }
+
+  session = g_new0 (GstSwitchTcpSession, 1);
+  session->controller = GST_SWITCH_CONTROLLER (g_object_ref (controller));
+  session->connection = g_socket_connection_factory_create_connection (client);
+  session->input = g_data_input_stream_new (g_io_stream_get_input_stream
+      (G_IO_STREAM (session->connection)));
+  g_data_input_stream_set_newline_type (session->input,
+      G_DATA_STREAM_NEWLINE_TYPE_ANY);
+  session->outbox = g_async_queue_new ();
+  g_object_unref (client);
+
+  session->writer = g_thread_new ("tcp-control-writer",
+      (GThreadFunc) gst_switch_tcp_control_write, session);
+  thread = g_thread_new ("tcp-control",
+      (GThreadFunc) gst_switch_tcp_control_read, session);
+  g_thread_unref (thread);
+}
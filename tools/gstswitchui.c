@@ -30,9 +30,11 @@
 #endif
 
 #include <stdlib.h>
+#include <math.h>
 #include "gstswitchui.h"
 #include "gstswitchcontroller.h"
 #include "gstvideodisp.h"
+#include "gstvideomosaic.h"
 #include "gstaudiovisual.h"
 #include "gstcase.h"
 
@@ -44,6 +46,9 @@
 #define gst_switch_ui_update(w) ((void) FALSE)
 #endif
 
+#define GST_SWITCH_UI_MOSAIC_SHARE 3   /* the mosaic takes 1/3 of the width */
+#define GST_SWITCH_UI_MOSAIC_MAX_COLUMNS 16
+
 #define GST_SWITCH_UI_LOCK_AUDIO(ui) (g_mutex_lock (&(ui)->audio_lock))
 #define GST_SWITCH_UI_UNLOCK_AUDIO(ui) (g_mutex_unlock (&(ui)->audio_lock))
 #define GST_SWITCH_UI_LOCK_COMPOSE(ui) (g_mutex_lock (&(ui)->compose_lock))
@@ -54,9 +59,12 @@
 G_DEFINE_TYPE (GstSwitchUI, gst_switch_ui, GST_TYPE_SWITCH_CLIENT);
 
 gboolean verbose;
+static gboolean opt_mosaic;
 
 static GOptionEntry entries[] = {
   {"verbose", 'v', 0, G_OPTION_ARG_NONE, &verbose, "Be verbose", NULL},
+  {"mosaic", 'm', 0, G_OPTION_ARG_NONE, &opt_mosaic,
+      "Render all video previews in one pipeline and window", NULL},
   {NULL}
 };
 
@@ -203,10 +211,15 @@ static gboolean gst_switch_ui_key_event (GtkWidget *, GdkEvent *,
 static gboolean gst_switch_ui_compose_key_event (GtkWidget *, GdkEvent *,
     GstSwitchUI *);
 
+static gboolean gst_switch_ui_mosaic_press (GtkWidget *, GdkEventButton *,
+    GstSwitchUI *);
+static gboolean gst_switch_ui_window_configured (GtkWidget *,
+    GdkEventConfigure *, GstSwitchUI *);
+
 static void
 gst_switch_ui_init (GstSwitchUI * ui)
 {
-  GtkWidget *main_box, *right_box;
+  GtkWidget *main_box, *left_box, *right_box;
   GtkWidget *scrollwin;
   GtkWidget *overlay;
   GtkStyleContext *style;
@@ -233,6 +246,7 @@ gst_switch_ui_init (GstSwitchUI * ui)
       G_CALLBACK (gst_switch_ui_key_event), ui);
 
   main_box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 5);
+  left_box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 5);
   right_box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 5);
   //gtk_widget_set_hexpand (right_box, TRUE);
   //gtk_widget_set_vexpand (right_box, TRUE);
@@ -299,13 +313,29 @@ gst_switch_ui_init (GstSwitchUI * ui)
 
   gtk_box_pack_start (GTK_BOX (right_box), overlay, TRUE, TRUE, 0);
   gtk_box_pack_start (GTK_BOX (right_box), ui->status, FALSE, FALSE, 0);
-  gtk_box_pack_start (GTK_BOX (main_box), scrollwin, FALSE, TRUE, 0);
+  if (opt_mosaic) {
+    ui->mosaic_view = gtk_drawing_area_new ();
+    gtk_widget_set_name (ui->mosaic_view, "mosaic");
+    gtk_widget_set_double_buffered (ui->mosaic_view, FALSE);
+    gtk_widget_set_size_request (ui->mosaic_view,
+        GST_VIDEO_MOSAIC_TILE_WIDTH, 0);
+    gtk_widget_set_events (ui->mosaic_view, GDK_BUTTON_RELEASE_MASK |
+        GDK_BUTTON_PRESS_MASK);
+    g_signal_connect (G_OBJECT (ui->mosaic_view), "button-press-event",
+        G_CALLBACK (gst_switch_ui_mosaic_press), ui);
+    gtk_box_pack_start (GTK_BOX (left_box), ui->mosaic_view, FALSE, FALSE, 0);
+  }
+  gtk_box_pack_start (GTK_BOX (left_box), scrollwin, TRUE, TRUE, 0);
+
+  gtk_box_pack_start (GTK_BOX (main_box), left_box, FALSE, TRUE, 0);
   gtk_box_pack_start (GTK_BOX (main_box), right_box, TRUE, TRUE, 0);
   gtk_container_add (GTK_CONTAINER (ui->window), main_box);
   gtk_container_set_border_width (GTK_CONTAINER (ui->window), 5);
 
   g_signal_connect (G_OBJECT (ui->window), "delete-event",
       G_CALLBACK (gst_switch_ui_window_closed), ui);
+  g_signal_connect (G_OBJECT (ui->window), "configure-event",
+      G_CALLBACK (gst_switch_ui_window_configured), ui);
 
   /*
      g_signal_connect (G_OBJECT (ui->compose_view), "expose-event",
@@ -323,6 +353,12 @@ gst_switch_ui_init (GstSwitchUI * ui)
 static void
 gst_switch_ui_finalize (GstSwitchUI * ui)
 {
+  if (ui->mosaic) {
+    gst_worker_stop_force (GST_WORKER (ui->mosaic), TRUE);
+    g_object_unref (ui->mosaic);
+    ui->mosaic = NULL;
+  }
+
   gtk_widget_destroy (GTK_WIDGET (ui->window));
   ui->window = NULL;
 
@@ -389,6 +425,24 @@ gst_switch_ui_prepare_videos (GstSwitchUI * ui)
   }
 }
 
+/**
+ * gst_switch_ui_audio_level:
+ *
+ * Invoked when the server tells the level of an audio input, the level of
+ * the active audio is shown instead of the one measured by its visual.
+ */
+static void
+gst_switch_ui_audio_level (GstSwitchUI * ui, gint port, gdouble rms,
+    gdouble peak, gdouble decay)
+{
+  GST_SWITCH_UI_LOCK_AUDIO (ui);
+  if (port == ui->audio_port) {
+    ui->audio_level = pow (10, rms / 20);
+    ui->audio_level_time = g_get_monotonic_time ();
+  }
+  GST_SWITCH_UI_UNLOCK_AUDIO (ui);
+}
+
 static gboolean
 gst_switch_ui_tick (GstSwitchUI * ui)
 {
@@ -398,9 +452,16 @@ gst_switch_ui_tick (GstSwitchUI * ui)
     GstClockTime endtime, diff;
     gdouble value = 0;
     GST_SWITCH_UI_LOCK_AUDIO (ui);
-    endtime = gst_audio_visual_get_endtime (ui->audio);
-    diff = endtime - ui->audio_endtime;
-    value = gst_audio_visual_get_value (ui->audio);
+    if (ui->audio_level_time) {
+      /* told by the server, no need to measure it */
+      endtime = ui->audio_level_time * GST_USECOND;
+      diff = g_get_monotonic_time () * GST_USECOND - endtime;
+      value = ui->audio_level;
+    } else {
+      endtime = gst_audio_visual_get_endtime (ui->audio);
+      diff = endtime - ui->audio_endtime;
+      value = gst_audio_visual_get_value (ui->audio);
+    }
     stucked = ((GST_MSECOND * 700) <= diff);
     if (ui->audio_value == value)
       ui->audio_stuck_count += 1;
@@ -441,6 +502,9 @@ gst_switch_ui_tick (GstSwitchUI * ui)
   return TRUE;
 }
 
+static void gst_switch_ui_end_mosaic_port (GstVideoMosaic *, gint,
+    GstSwitchUI *);
+
 static void
 gst_switch_ui_run (GstSwitchUI * ui)
 {
@@ -450,6 +514,14 @@ gst_switch_ui_run (GstSwitchUI * ui)
 
   gtk_widget_show_all (ui->window);
   gtk_widget_realize (ui->window);
+  if (ui->mosaic_view) {
+    GdkWindow *xview = gtk_widget_get_window (ui->mosaic_view);
+    ui->mosaic = GST_VIDEO_MOSAIC (g_object_new (GST_TYPE_VIDEO_MOSAIC,
+            "name", "mosaic", "handle", (gulong) GDK_WINDOW_XID (xview),
+            NULL));
+    g_signal_connect (G_OBJECT (ui->mosaic), "end-port",
+        G_CALLBACK (gst_switch_ui_end_mosaic_port), ui);
+  }
   gst_switch_ui_prepare_videos (ui);
   gtk_main ();
 }
@@ -459,14 +531,26 @@ gst_switch_ui_new_video_disp (GstSwitchUI * ui, GtkWidget * view, gint port)
 {
   gchar *name = g_strdup_printf ("video-%d", port);
   GdkWindow *xview = gtk_widget_get_window (view);
-  GstVideoDisp *disp = GST_VIDEO_DISP (g_object_new (GST_TYPE_VIDEO_DISP,
+  gchar *caps = NULL;
+  gchar *shm = gst_switch_client_get_preview_shm (GST_SWITCH_CLIENT (ui),
+      port, &caps);
+  GstVideoDisp *disp;
+
+  /* the socket is only found if the server runs on this host */
+  if (shm && !g_file_test (shm, G_FILE_TEST_EXISTS)) {
+    g_free (shm), shm = NULL;
+  }
+  disp = GST_VIDEO_DISP (g_object_new (GST_TYPE_VIDEO_DISP,
           "name", name, "port",
           port,
           "handle",
           (gulong)
-          GDK_WINDOW_XID (xview),
-          NULL));
+          GDK_WINDOW_XID (xview), "shm-path", shm, "shm-caps", caps, NULL));
+  if (shm)
+    INFO ("preview %d in shared memory: %s", port, shm);
   g_free (name);
+  g_free (shm);
+  g_free (caps);
   g_object_set_data (G_OBJECT (view), "video-display", disp);
   if (!gst_worker_start (GST_WORKER (disp)))
     ERROR ("failed to start video display");
@@ -549,6 +633,72 @@ gst_switch_ui_end_audio_visual (GstWorker * worker, GstSwitchUI * ui)
   }
 }
 
+/**
+ * gst_switch_ui_resize_mosaic:
+ *
+ * Fit as many tiles in a row as a share of the window width takes, and
+ * size the mosaic view for its rows.
+ */
+static void
+gst_switch_ui_resize_mosaic (GstSwitchUI * ui)
+{
+  gint width = 0;
+  guint columns;
+
+  gtk_window_get_size (GTK_WINDOW (ui->window), &width, NULL);
+  columns = CLAMP (width / GST_SWITCH_UI_MOSAIC_SHARE /
+      GST_VIDEO_MOSAIC_TILE_WIDTH, 1, GST_SWITCH_UI_MOSAIC_MAX_COLUMNS);
+
+  if (columns != ui->mosaic->columns)
+    g_object_set (ui->mosaic, "columns", columns, NULL);
+
+  gtk_widget_set_size_request (ui->mosaic_view, GST_VIDEO_MOSAIC_TILE_WIDTH
+      * columns,
+      GST_VIDEO_MOSAIC_TILE_HEIGHT * gst_video_mosaic_get_rows (ui->mosaic));
+}
+
+/**
+ * gst_switch_ui_window_configured:
+ *
+ * Invoked when the window is resized, the mosaic is laid out again.
+ */
+static gboolean
+gst_switch_ui_window_configured (GtkWidget * widget,
+    GdkEventConfigure * event, GstSwitchUI * ui)
+{
+  if (ui->mosaic)
+    gst_switch_ui_resize_mosaic (ui);
+  return FALSE;
+}
+
+/**
+ * gst_switch_ui_end_mosaic_port:
+ *
+ * Invoked when a preview of the mosaic ended, its frame is removed as
+ * gst_switch_ui_end_video_disp does for a standalone display.
+ */
+static void
+gst_switch_ui_end_mosaic_port (GstVideoMosaic * mosaic, gint port,
+    GstSwitchUI * ui)
+{
+  GstVideoDisp *disp = NULL;
+  GList *v;
+
+  INFO ("video ended: mosaic, %d", port);
+
+  v = gtk_container_get_children (GTK_CONTAINER (ui->preview_box));
+  for (; v; v = g_list_next (v)) {
+    gpointer data = g_object_get_data (G_OBJECT (v->data), "video-display");
+    if (GST_IS_VIDEO_DISP (data) && GST_VIDEO_DISP (data)->port == port) {
+      disp = GST_VIDEO_DISP (data);
+      break;
+    }
+  }
+  if (disp)
+    gst_switch_ui_remove_preview (ui, GST_WORKER (disp), "video-display");
+  gst_switch_ui_resize_mosaic (ui);
+}
+
 static void
 gst_switch_ui_set_compose_port (GstSwitchUI * ui, gint port)
 {
@@ -585,6 +735,7 @@ gst_switch_ui_set_audio_port (GstSwitchUI * ui, gint port)
 
   GST_SWITCH_UI_LOCK_AUDIO (ui);
   ui->audio_port = port;
+  ui->audio_level_time = 0;
 
   v = gtk_container_get_children (GTK_CONTAINER (ui->preview_box));
   for (; v; v = g_list_next (v)) {
@@ -719,14 +870,10 @@ gst_switch_ui_preview_click (GtkWidget * w, GdkEvent * event, GstSwitchUI * ui)
           disp->type = newvideotype;
           if (prevframe && prevdisp) {
             GtkStyleContext *style = gtk_widget_get_style_context (prevframe);
-            switch (t) {
-              case GST_CASE_BRANCH_A:
-              case GST_CASE_BRANCH_B:
-                gtk_style_context_add_class (style, "active_video_frame");
-                break;
-              case GST_CASE_BRANCH_p:
-                gtk_style_context_remove_class (style, "active_video_frame");
-                break;
+            if (GST_CASE_IS_BRANCH_VIDEO (t)) {
+              gtk_style_context_add_class (style, "active_video_frame");
+            } else if (t == GST_CASE_BRANCH_p) {
+              gtk_style_context_remove_class (style, "active_video_frame");
             }
             gst_switch_ui_update (prevframe);
             prevdisp->type = t;
@@ -739,6 +886,38 @@ gst_switch_ui_preview_click (GtkWidget * w, GdkEvent * event, GstSwitchUI * ui)
   return TRUE;
 }
 
+/**
+ * gst_switch_ui_mosaic_press:
+ *
+ * A click on a tile of the mosaic acts as a click on the frame of the
+ * preview.
+ */
+static gboolean
+gst_switch_ui_mosaic_press (GtkWidget * w, GdkEventButton * event,
+    GstSwitchUI * ui)
+{
+  GList *v;
+  gint port;
+
+  if (!ui->mosaic)
+    return FALSE;
+
+  port = gst_video_mosaic_get_port_at (ui->mosaic,
+      event->x / gtk_widget_get_allocated_width (w),
+      event->y / gtk_widget_get_allocated_height (w));
+  if (port == 0)
+    return FALSE;
+
+  v = gtk_container_get_children (GTK_CONTAINER (ui->preview_box));
+  for (; v; v = g_list_next (v)) {
+    gpointer data = g_object_get_data (G_OBJECT (v->data), "video-display");
+    if (GST_IS_VIDEO_DISP (data) && GST_VIDEO_DISP (data)->port == port)
+      return gst_switch_ui_preview_click (GTK_WIDGET (v->data),
+          (GdkEvent *) event, ui);
+  }
+  return FALSE;
+}
+
 static void
 gst_switch_ui_add_preview_port (GstSwitchUI * ui, gint port, gint serve,
     gint type)
@@ -747,9 +926,19 @@ gst_switch_ui_add_preview_port (GstSwitchUI * ui, gint port, gint serve,
   GstAudioVisual *visual = NULL;
   GtkStyleContext *style = NULL;
   GtkWidget *frame = gtk_frame_new (NULL);
-  GtkWidget *preview = gtk_drawing_area_new ();
-  gtk_widget_set_double_buffered (preview, FALSE);
-  gtk_widget_set_size_request (preview, -1, 80);
+  GtkWidget *preview;
+  gboolean tiled = (ui->mosaic && serve == GST_SERVE_VIDEO_STREAM);
+
+  if (tiled) {
+    gchar *label = g_strdup_printf ("port %d", port);
+    preview = gtk_event_box_new ();
+    gtk_container_add (GTK_CONTAINER (preview), gtk_label_new (label));
+    g_free (label);
+  } else {
+    preview = gtk_drawing_area_new ();
+    gtk_widget_set_double_buffered (preview, FALSE);
+    gtk_widget_set_size_request (preview, -1, 80);
+  }
   gtk_widget_set_events (preview, GDK_BUTTON_RELEASE_MASK |
       GDK_BUTTON_PRESS_MASK);
   gtk_container_add (GTK_CONTAINER (frame), preview);
@@ -779,18 +968,24 @@ gst_switch_ui_add_preview_port (GstSwitchUI * ui, gint port, gint serve,
 
   switch (serve) {
     case GST_SERVE_VIDEO_STREAM:
-      disp = gst_switch_ui_new_video_disp (ui, preview, port);
+      if (tiled) {
+        /* The display only keeps the port and type of the preview, the
+         * mosaic renders it. */
+        disp = GST_VIDEO_DISP (g_object_new (GST_TYPE_VIDEO_DISP,
+                "port", port, NULL));
+        gst_video_mosaic_add_port (ui->mosaic, port);
+        gst_switch_ui_resize_mosaic (ui);
+      } else {
+        disp = gst_switch_ui_new_video_disp (ui, preview, port);
+        g_signal_connect (G_OBJECT (disp), "end-worker",
+            G_CALLBACK (gst_switch_ui_end_video_disp), ui);
+      }
       disp->type = type;
       g_object_set_data (G_OBJECT (frame), "video-display", disp);
-      g_signal_connect (G_OBJECT (disp), "end-worker",
-          G_CALLBACK (gst_switch_ui_end_video_disp), ui);
-      switch (type) {
-        case GST_CASE_BRANCH_A:
-        case GST_CASE_BRANCH_B:
-          style = gtk_widget_get_style_context (frame);
-          gtk_style_context_add_class (style, "active_video_frame");
-          gst_switch_ui_mark_active_video (ui, port, type);
-          break;
+      if (GST_CASE_IS_BRANCH_VIDEO (type)) {
+        style = gtk_widget_get_style_context (frame);
+        gtk_style_context_add_class (style, "active_video_frame");
+        gst_switch_ui_mark_active_video (ui, port, type);
       }
       gst_switch_ui_update (frame);
       break;
@@ -950,18 +1145,33 @@ gst_switch_ui_next_compose_off (GstSwitchUI * ui)
 }
 
 static void
-gst_switch_ui_new_record (GstSwitchUI * ui)
+gst_switch_ui_new_record_done (GstSwitchClient * client,
+    GAsyncResult * result, gpointer data)
 {
-  gboolean ok = gst_switch_client_new_record (GST_SWITCH_CLIENT (ui));
+  gboolean ok = gst_switch_client_finish_request (client, result, NULL);
   INFO ("new record: %d", ok);
 }
 
+static void
+gst_switch_ui_new_record (GstSwitchUI * ui)
+{
+  gst_switch_client_new_record_async (GST_SWITCH_CLIENT (ui),
+      (GAsyncReadyCallback) gst_switch_ui_new_record_done, NULL);
+}
+
+static void
+gst_switch_ui_adjust_pip_done (GstSwitchClient * client,
+    GAsyncResult * result, gpointer data)
+{
+  guint changed = gst_switch_client_finish_adjust_pip (client, result, NULL);
+  INFO ("adjust-pip: (%d) %d", GPOINTER_TO_INT (data), changed);
+}
+
 static void
 gst_switch_ui_adjust_pip (GstSwitchUI * ui, gboolean resize, gint key)
 {
   const gint step = 1;
   gint dx = 0, dy = 0, dw = 0, dh = 0;
-  guint result;
 
   if (resize) {
     switch (key) {
@@ -995,9 +1205,10 @@ gst_switch_ui_adjust_pip (GstSwitchUI * ui, gboolean resize, gint key)
     }
   }
 
-  result = gst_switch_client_adjust_pip (GST_SWITCH_CLIENT (ui),
-      dx, dy, dw, dh);
-  INFO ("adjust-pip: (%d) %d", resize, result);
+  /* key repeats are sent without waiting for the replies */
+  gst_switch_client_adjust_pip_async (GST_SWITCH_CLIENT (ui),
+      dx, dy, dw, dh, (GAsyncReadyCallback) gst_switch_ui_adjust_pip_done,
+      GINT_TO_POINTER (resize));
 }
 
 static gboolean
@@ -1089,6 +1300,8 @@ gst_switch_ui_class_init (GstSwitchUIClass * klass)
       gst_switch_ui_set_audio_port;
   client_class->add_preview_port = (GstSwitchClientAddPreviewPortFunc)
       gst_switch_ui_add_preview_port;
+  client_class->audio_level = (GstSwitchClientAudioLevelFunc)
+      gst_switch_ui_audio_level;
 }
 
 int
@@ -32,6 +32,7 @@
 #include "gstswitchclient.h"
 #include "gstworker.h"
 #include "gstvideodisp.h"
+#include "gstvideomosaic.h"
 #include "gstaudiovisual.h"
 
 #define GST_TYPE_SWITCH_UI (gst_switch_ui_get_type ())
@@ -58,6 +59,7 @@ struct _GstSwitchUI
   GtkWidget *compose_view;
   GtkWidget *compose_overlay;
   GtkWidget *preview_box;
+  GtkWidget *mosaic_view;
   GtkWidget *status;
 
   GMutex select_lock;
@@ -69,10 +71,14 @@ struct _GstSwitchUI
   GstClockTime audio_endtime;
   gdouble audio_value;
   gint audio_stuck_count;
+  gdouble audio_level;
+  gint64 audio_level_time;
 
   GMutex compose_lock;
   GstVideoDisp *compose;
 
+  GstVideoMosaic *mosaic;
+
   guint32 tabtime;
   gint compose_mode;
   gint timer;
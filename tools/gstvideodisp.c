@@ -40,6 +40,8 @@ enum
   PROP_0,
   PROP_PORT,
   PROP_HANDLE,
+  PROP_SHM_PATH,
+  PROP_SHM_CAPS,
 };
 
 extern gboolean verbose;
@@ -62,6 +64,9 @@ gst_video_disp_dispose (GstVideoDisp * disp)
 static void
 gst_video_disp_finalize (GstVideoDisp * disp)
 {
+  g_free (disp->shm_path);
+  g_free (disp->shm_caps);
+
   if (G_OBJECT_CLASS (parent_class)->finalize)
     (*G_OBJECT_CLASS (parent_class)->finalize) (G_OBJECT (disp));
 }
@@ -77,6 +82,14 @@ gst_video_disp_set_property (GstVideoDisp * disp, guint property_id,
     case PROP_HANDLE:
       disp->handle = g_value_get_ulong (value);
       break;
+    case PROP_SHM_PATH:
+      g_free (disp->shm_path);
+      disp->shm_path = g_value_dup_string (value);
+      break;
+    case PROP_SHM_CAPS:
+      g_free (disp->shm_caps);
+      disp->shm_caps = g_value_dup_string (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (G_OBJECT (disp), property_id, pspec);
       break;
@@ -94,6 +107,12 @@ gst_video_disp_get_property (GstVideoDisp * disp, guint property_id,
     case PROP_HANDLE:
       g_value_set_ulong (value, disp->handle);
       break;
+    case PROP_SHM_PATH:
+      g_value_set_string (value, disp->shm_path);
+      break;
+    case PROP_SHM_CAPS:
+      g_value_set_string (value, disp->shm_caps);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (G_OBJECT (disp), property_id, pspec);
       break;
@@ -109,9 +128,16 @@ gst_video_disp_get_pipeline_string (GstVideoDisp * disp)
 
   desc = g_string_new ("");
 
-  g_string_append_printf (desc, "tcpclientsrc name=source "
-      "port=%d ", disp->port);
-  g_string_append_printf (desc, "! gdpdepay ");
+  if (disp->shm_path && disp->shm_caps) {
+    /* the frames are mapped from the server, the caps are told apart */
+    g_string_append_printf (desc, "shmsrc name=source socket-path=%s "
+        "is-live=true do-timestamp=true ", disp->shm_path);
+    g_string_append_printf (desc, "! capsfilter name=caps ");
+  } else {
+    g_string_append_printf (desc, "tcpclientsrc name=source "
+        "port=%d ", disp->port);
+    g_string_append_printf (desc, "! gdpdepay ");
+  }
   g_string_append_printf (desc, "! videoconvert ");
   g_string_append_printf (desc, "! xvimagesink name=sink ");
 
@@ -130,6 +156,15 @@ gst_video_disp_prepare (GstVideoDisp * disp)
 
   gst_object_unref (sink);
 
+  if (disp->shm_path && disp->shm_caps) {
+    GstElement *filter = gst_worker_get_element_unlocked (worker, "caps");
+    GstCaps *caps = gst_caps_from_string (disp->shm_caps);
+    g_return_val_if_fail (GST_IS_ELEMENT (filter), FALSE);
+    g_object_set (filter, "caps", caps, NULL);
+    gst_caps_unref (caps);
+    gst_object_unref (filter);
+  }
+
   //INFO ("prepared display video on %ld", disp->handle);
   return TRUE;
 }
@@ -160,6 +195,16 @@ gst_video_disp_class_init (GstVideoDispClass * klass)
           "Window Handle", 0,
           ((gulong) - 1), 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (object_class, PROP_SHM_PATH,
+      g_param_spec_string ("shm-path", "Shared Memory Path",
+          "Socket of the shared memory preview", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_SHM_CAPS,
+      g_param_spec_string ("shm-caps", "Shared Memory Caps",
+          "Caps of the frames in shared memory", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   worker_class->prepare = (GstWorkerPrepareFunc) gst_video_disp_prepare;
   worker_class->get_pipeline_string = (GstWorkerGetPipelineStringFunc)
       gst_video_disp_get_pipeline_string;
@@ -44,6 +44,9 @@ typedef struct _GstVideoDispClass GstVideoDispClass;
  *  @param port the port number
  *  @param type video type
  *  @param handle the X window handle for rendering the video
+ *  @param shm_path the socket of the shared memory preview, NULL to receive
+ *         the preview over TCP
+ *  @param shm_caps the caps of the frames in shared memory
  */
 struct _GstVideoDisp
 {
@@ -51,6 +54,8 @@ struct _GstVideoDisp
 
   gint port, type;
   gulong handle;
+  gchar *shm_path;
+  gchar *shm_caps;
 };
 
 /**
@@ -0,0 +1,661 @@
+/* GstSwitch
+ * Copyright (C) 2012,2013 Duzy Chan <code@duzy.info>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*! @file */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include "gstvideomosaic.h"
+#include "gstswitchserver.h"
+#include <gst/video/videooverlay.h>
+
+#define parent_class gst_video_mosaic_parent_class
+
+#define GST_VIDEO_MOSAIC_LOCK_PORTS(m) (g_mutex_lock (&(m)->ports_lock))
+#define GST_VIDEO_MOSAIC_UNLOCK_PORTS(m) (g_mutex_unlock (&(m)->ports_lock))
+
+enum
+{
+  PROP_0,
+  PROP_HANDLE,
+  PROP_COLUMNS,
+  PROP_SINK,
+};
+
+enum
+{
+  SIGNAL_END_PORT,
+  SIGNAL__LAST,                 /*!< @internal */
+};
+
+static guint gst_video_mosaic_signals[SIGNAL__LAST] = { 0 };
+
+extern gboolean verbose;
+
+G_DEFINE_TYPE (GstVideoMosaic, gst_video_mosaic, GST_TYPE_WORKER);
+
+/**
+ * @brief A preview stream ended, told from a streaming thread.
+ */
+typedef struct _GstVideoMosaicEnd
+{
+  GstVideoMosaic *mosaic;
+  gint port;
+} GstVideoMosaicEnd;
+
+static void
+gst_video_mosaic_init (GstVideoMosaic * mosaic)
+{
+  mosaic->handle = 0;
+  mosaic->columns = 1;
+  mosaic->sink = g_strdup ("xvimagesink");
+
+  g_mutex_init (&mosaic->ports_lock);
+  mosaic->ports = g_array_new (FALSE, FALSE, sizeof (gint));
+}
+
+static void
+gst_video_mosaic_finalize (GstVideoMosaic * mosaic)
+{
+  g_array_free (mosaic->ports, TRUE);
+  g_mutex_clear (&mosaic->ports_lock);
+  g_free (mosaic->sink);
+
+  if (G_OBJECT_CLASS (parent_class)->finalize)
+    (*G_OBJECT_CLASS (parent_class)->finalize) (G_OBJECT (mosaic));
+}
+
+static void gst_video_mosaic_layout (GstVideoMosaic * mosaic);
+
+static void
+gst_video_mosaic_set_property (GstVideoMosaic * mosaic, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  switch (property_id) {
+    case PROP_HANDLE:
+      mosaic->handle = g_value_get_ulong (value);
+      break;
+    case PROP_COLUMNS:
+      mosaic->columns = g_value_get_uint (value);
+      gst_video_mosaic_layout (mosaic);
+      break;
+    case PROP_SINK:
+      g_free (mosaic->sink);
+      mosaic->sink = g_value_dup_string (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (G_OBJECT (mosaic), property_id,
+          pspec);
+      break;
+  }
+}
+
+static void
+gst_video_mosaic_get_property (GstVideoMosaic * mosaic, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  switch (property_id) {
+    case PROP_HANDLE:
+      g_value_set_ulong (value, mosaic->handle);
+      break;
+    case PROP_COLUMNS:
+      g_value_set_uint (value, mosaic->columns);
+      break;
+    case PROP_SINK:
+      g_value_set_string (value, mosaic->sink);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (G_OBJECT (mosaic), property_id,
+          pspec);
+      break;
+  }
+}
+
+/**
+ * gst_video_mosaic_get_scale_element:
+ * @return the scaler of the tiles, "stripescale" of the gstswitch plugin
+ *         if it's installed
+ */
+static const gchar *
+gst_video_mosaic_get_scale_element (void)
+{
+  static const gchar *scale = NULL;
+  GstElementFactory *factory;
+
+  if (scale == NULL) {
+    factory = gst_element_factory_find ("stripescale");
+    scale = factory ? "stripescale" : "videoscale";
+    if (factory)
+      gst_object_unref (factory);
+  }
+  return scale;
+}
+
+/**
+ * gst_video_mosaic_get_pipeline_string:
+ *
+ * A single mixer blends the tiles into one surface, rendered by a single
+ * video sink. The tiles are added and removed while it's playing.
+ */
+static GString *
+gst_video_mosaic_get_pipeline_string (GstVideoMosaic * mosaic)
+{
+  GString *desc;
+
+  desc = g_string_new ("");
+  g_string_append_printf (desc, "videomixer name=mix background=black ");
+  g_string_append_printf (desc, "! videoconvert ");
+  g_string_append_printf (desc, "! %s name=sink ", mosaic->sink);
+  return desc;
+}
+
+/**
+ * gst_video_mosaic_get_mix_pad:
+ * @return the mixer pad of the tile of @port, or NULL
+ */
+static GstPad *
+gst_video_mosaic_get_mix_pad (GstVideoMosaic * mosaic, gint port)
+{
+  GstElement *pipeline = GST_WORKER (mosaic)->pipeline;
+  GstElement *tile;
+  GstPad *pad, *peer = NULL;
+  gchar *name;
+
+  if (!pipeline)
+    return NULL;
+
+  name = g_strdup_printf ("tile_%d", port);
+  tile = gst_bin_get_by_name (GST_BIN (pipeline), name);
+  g_free (name);
+  if (!tile)
+    return NULL;
+
+  pad = gst_element_get_static_pad (tile, "src");
+  if (pad) {
+    peer = gst_pad_get_peer (pad);
+    gst_object_unref (pad);
+  }
+  gst_object_unref (tile);
+  return peer;
+}
+
+/**
+ * gst_video_mosaic_layout:
+ *
+ * Move every tile to its place, in the order of the ports.
+ */
+static void
+gst_video_mosaic_layout (GstVideoMosaic * mosaic)
+{
+  guint n, columns = MAX (mosaic->columns, 1);
+  GstPad *pad;
+
+  GST_VIDEO_MOSAIC_LOCK_PORTS (mosaic);
+  for (n = 0; n < mosaic->ports->len; ++n) {
+    pad = gst_video_mosaic_get_mix_pad (mosaic,
+        g_array_index (mosaic->ports, gint, n));
+    if (!pad)
+      continue;
+    g_object_set (pad, "xpos", (n % columns) * GST_VIDEO_MOSAIC_TILE_WIDTH,
+        "ypos", (n / columns) * GST_VIDEO_MOSAIC_TILE_HEIGHT, NULL);
+    gst_object_unref (pad);
+  }
+  GST_VIDEO_MOSAIC_UNLOCK_PORTS (mosaic);
+}
+
+/**
+ * gst_video_mosaic_end_port:
+ * @return Always FALSE to remove the idle source.
+ *
+ * Drop the tile of an ended preview, in the main loop.
+ */
+static gboolean
+gst_video_mosaic_end_port (GstVideoMosaicEnd * end)
+{
+  gst_video_mosaic_remove_port (end->mosaic, end->port);
+  g_signal_emit (end->mosaic, gst_video_mosaic_signals[SIGNAL_END_PORT], 0,
+      end->port);
+  g_object_unref (end->mosaic);
+  g_free (end);
+  return FALSE;
+}
+
+/**
+ * gst_video_mosaic_eos_probe:
+ *
+ * Watch for the end of a preview stream, the other tiles keep running.
+ */
+static GstPadProbeReturn
+gst_video_mosaic_eos_probe (GstPad * pad, GstPadProbeInfo * info,
+    GstVideoMosaic * mosaic)
+{
+  GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+  GstVideoMosaicEnd *end;
+  GstElement *depay;
+  gint port = 0;
+
+  if (GST_EVENT_TYPE (event) != GST_EVENT_EOS)
+    return GST_PAD_PROBE_OK;
+
+  depay = gst_pad_get_parent_element (pad);
+  if (depay) {
+    sscanf (GST_OBJECT_NAME (depay), "depay_%d", &port);
+    gst_object_unref (depay);
+  }
+
+  if (port) {
+    end = g_new0 (GstVideoMosaicEnd, 1);
+    end->mosaic = GST_VIDEO_MOSAIC (g_object_ref (mosaic));
+    end->port = port;
+    g_idle_add ((GSourceFunc) gst_video_mosaic_end_port, end);
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+/**
+ * gst_video_mosaic_rebase_probe:
+ *
+ * A tile joining a running mosaic carries the timestamps of the preview
+ * stream, far behind the mixer, so its frames would all be dropped late.
+ * On the first frame, the tile is shifted by the distance to the running
+ * time of the mixer.
+ */
+static GstPadProbeReturn
+gst_video_mosaic_rebase_probe (GstPad * pad, GstPadProbeInfo * info,
+    GstElement * pipeline)
+{
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  const GstSegment *segment = NULL;
+  GstEvent *event = NULL;
+  GstClock *clock = NULL;
+  GstClockTime position, now;
+
+  /* not until the mixer is running on the clock */
+  if (!GST_BUFFER_PTS_IS_VALID (buffer) ||
+      GST_STATE (pipeline) != GST_STATE_PLAYING)
+    return GST_PAD_PROBE_OK;
+
+  event = gst_pad_get_sticky_event (pad, GST_EVENT_SEGMENT, 0);
+  if (!event)
+    return GST_PAD_PROBE_OK;
+
+  gst_event_parse_segment (event, &segment);
+  position = gst_segment_to_running_time (segment, GST_FORMAT_TIME,
+      GST_BUFFER_PTS (buffer));
+  gst_event_unref (event);
+
+  clock = gst_element_get_clock (pipeline);
+  if (!clock || !GST_CLOCK_TIME_IS_VALID (position)) {
+    if (clock)
+      gst_object_unref (clock);
+    return GST_PAD_PROBE_OK;
+  }
+
+  now = gst_clock_get_time (clock) - gst_element_get_base_time (pipeline);
+  gst_object_unref (clock);
+
+  /* the segment is sent again with the offset before the next frame */
+  gst_pad_set_offset (pad, GST_CLOCK_DIFF (position, now));
+  return GST_PAD_PROBE_REMOVE;
+}
+
+/**
+ * gst_video_mosaic_add_tile:
+ *
+ * Depay and scale a preview into a tile, blended by a new pad of the
+ * mixer. The tile follows the state of the pipeline and is rebased on the
+ * running time of the mixer by gst_video_mosaic_rebase_probe().
+ */
+static gboolean
+gst_video_mosaic_add_tile (GstVideoMosaic * mosaic, gint port)
+{
+  GstElement *pipeline = GST_WORKER (mosaic)->pipeline;
+  GstElement *tile = NULL, *mix = NULL, *depay = NULL;
+  GstPad *pad = NULL, *mix_pad = NULL;
+  GError *error = NULL;
+  gboolean ok = FALSE;
+  gchar *desc, *name;
+
+  desc = g_strdup_printf ("tcpclientsrc port=%d "
+      "! gdpdepay name=depay_%d ! videoconvert ! %s "
+      "! video/x-raw,width=%d,height=%d ! queue2 ", port, port,
+      gst_video_mosaic_get_scale_element (), GST_VIDEO_MOSAIC_TILE_WIDTH,
+      GST_VIDEO_MOSAIC_TILE_HEIGHT);
+  tile = gst_parse_bin_from_description (desc, TRUE, &error);
+  g_free (desc);
+  if (error) {
+    ERROR ("tile %d: %s", port, error->message);
+    g_error_free (error);
+    return FALSE;
+  }
+
+  name = g_strdup_printf ("tile_%d", port);
+  gst_object_set_name (GST_OBJECT (tile), name);
+  g_free (name);
+
+  name = g_strdup_printf ("depay_%d", port);
+  depay = gst_bin_get_by_name (GST_BIN (tile), name);
+  g_free (name);
+  if (depay) {
+    pad = gst_element_get_static_pad (depay, "src");
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+        (GstPadProbeCallback) gst_video_mosaic_eos_probe, mosaic, NULL);
+    gst_object_unref (pad);
+    gst_object_unref (depay);
+  }
+
+  mix = gst_bin_get_by_name (GST_BIN (pipeline), "mix");
+  if (!mix)
+    goto end;
+
+  gst_bin_add (GST_BIN (pipeline), tile);
+  mix_pad = gst_element_get_request_pad (mix, "sink_%u");
+  pad = gst_element_get_static_pad (tile, "src");
+  if (mix_pad && gst_pad_link (pad, mix_pad) == GST_PAD_LINK_OK) {
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+        (GstPadProbeCallback) gst_video_mosaic_rebase_probe, pipeline, NULL);
+    gst_element_sync_state_with_parent (tile);
+    ok = TRUE;
+  } else {
+    ERROR ("tile %d: not linked", port);
+    if (mix_pad)
+      gst_element_release_request_pad (mix, mix_pad);
+    gst_bin_remove (GST_BIN (pipeline), tile);
+  }
+  gst_object_unref (pad);
+  if (mix_pad)
+    gst_object_unref (mix_pad);
+  gst_object_unref (mix);
+  return ok;
+
+end:
+  gst_object_unref (tile);
+  return FALSE;
+}
+
+/**
+ * gst_video_mosaic_drop_tile:
+ * @return Always FALSE to remove the idle source.
+ *
+ * Stop an unlinked tile and take it out of the pipeline, in the main loop.
+ */
+static gboolean
+gst_video_mosaic_drop_tile (GstElement * tile)
+{
+  GstObject *parent = gst_object_get_parent (GST_OBJECT (tile));
+
+  gst_element_set_state (tile, GST_STATE_NULL);
+  if (parent) {
+    gst_bin_remove (GST_BIN (parent), tile);
+    gst_object_unref (parent);
+  }
+  gst_object_unref (tile);
+  return FALSE;
+}
+
+/**
+ * gst_video_mosaic_unlink_tile:
+ *
+ * Once no frame is on the way, the tile is unlinked and its mixer pad is
+ * released, so the mixer never waits for it nor sees it unlinked while
+ * it's pushing.
+ */
+static GstPadProbeReturn
+gst_video_mosaic_unlink_tile (GstPad * pad, GstPadProbeInfo * info,
+    gpointer data)
+{
+  GstElement *tile = gst_pad_get_parent_element (pad);
+  GstPad *peer = gst_pad_get_peer (pad);
+
+  if (peer) {
+    GstElement *mix = gst_pad_get_parent_element (peer);
+    gst_pad_unlink (pad, peer);
+    if (mix) {
+      gst_element_release_request_pad (mix, peer);
+      gst_object_unref (mix);
+    }
+    gst_object_unref (peer);
+  }
+  if (tile)
+    g_idle_add ((GSourceFunc) gst_video_mosaic_drop_tile, tile);
+  return GST_PAD_PROBE_REMOVE;
+}
+
+/**
+ * gst_video_mosaic_remove_tile:
+ *
+ * Take the tile of @port out of the running pipeline.
+ */
+static void
+gst_video_mosaic_remove_tile (GstVideoMosaic * mosaic, gint port)
+{
+  GstElement *pipeline = GST_WORKER (mosaic)->pipeline;
+  GstElement *tile;
+  GstPad *pad;
+  gchar *name;
+
+  if (!pipeline)
+    return;
+
+  name = g_strdup_printf ("tile_%d", port);
+  tile = gst_bin_get_by_name (GST_BIN (pipeline), name);
+  g_free (name);
+  if (!tile)
+    return;
+
+  pad = gst_element_get_static_pad (tile, "src");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_IDLE,
+      (GstPadProbeCallback) gst_video_mosaic_unlink_tile, NULL, NULL);
+  gst_object_unref (pad);
+  gst_object_unref (tile);
+}
+
+static gboolean
+gst_video_mosaic_prepare (GstVideoMosaic * mosaic)
+{
+  GstWorker *worker = GST_WORKER (mosaic);
+  GstElement *sink = gst_worker_get_element_unlocked (worker, "sink");
+  guint n;
+
+  g_return_val_if_fail (GST_IS_ELEMENT (sink), FALSE);
+
+  if (GST_IS_VIDEO_OVERLAY (sink))
+    gst_video_overlay_set_window_handle (GST_VIDEO_OVERLAY (sink),
+        mosaic->handle);
+  gst_object_unref (sink);
+
+  GST_VIDEO_MOSAIC_LOCK_PORTS (mosaic);
+  INFO ("display %d videos in mosaic", mosaic->ports->len);
+  for (n = 0; n < mosaic->ports->len; ++n)
+    gst_video_mosaic_add_tile (mosaic, g_array_index (mosaic->ports, gint,
+            n));
+  GST_VIDEO_MOSAIC_UNLOCK_PORTS (mosaic);
+
+  gst_video_mosaic_layout (mosaic);
+  return TRUE;
+}
+
+/**
+ * gst_video_mosaic_is_playing:
+ * @return TRUE if the pipeline is not NULL
+ */
+static gboolean
+gst_video_mosaic_is_playing (GstVideoMosaic * mosaic)
+{
+  GstWorker *worker = GST_WORKER (mosaic);
+  GstState state = GST_STATE_NULL;
+
+  if (worker->pipeline)
+    gst_element_get_state (worker->pipeline, &state, NULL, 0);
+  return state != GST_STATE_NULL;
+}
+
+/**
+ * gst_video_mosaic_add_port:
+ *  @param mosaic the GstVideoMosaic instance
+ *  @param port the preview port
+ *
+ *  Show a new preview in the next tile, added to the running pipeline.
+ */
+void
+gst_video_mosaic_add_port (GstVideoMosaic * mosaic, gint port)
+{
+  GstWorkerClass *worker_class;
+
+  g_return_if_fail (GST_IS_VIDEO_MOSAIC (mosaic));
+
+  GST_VIDEO_MOSAIC_LOCK_PORTS (mosaic);
+  g_array_append_val (mosaic->ports, port);
+  GST_VIDEO_MOSAIC_UNLOCK_PORTS (mosaic);
+
+  if (gst_video_mosaic_is_playing (mosaic)) {
+    if (gst_video_mosaic_add_tile (mosaic, port))
+      gst_video_mosaic_layout (mosaic);
+    return;
+  }
+
+  worker_class = GST_WORKER_CLASS (G_OBJECT_GET_CLASS (mosaic));
+  if (!worker_class->reset (GST_WORKER (mosaic)) ||
+      !gst_worker_start (GST_WORKER (mosaic)))
+    ERROR ("failed to start mosaic");
+}
+
+/**
+ * gst_video_mosaic_remove_port:
+ *  @param mosaic the GstVideoMosaic instance
+ *  @param port the preview port
+ *
+ *  Remove the tile of a preview, the following tiles move up. The other
+ *  tiles keep playing.
+ */
+void
+gst_video_mosaic_remove_port (GstVideoMosaic * mosaic, gint port)
+{
+  gboolean found = FALSE;
+  guint n, len;
+
+  g_return_if_fail (GST_IS_VIDEO_MOSAIC (mosaic));
+
+  GST_VIDEO_MOSAIC_LOCK_PORTS (mosaic);
+  for (n = 0; n < mosaic->ports->len; ++n) {
+    if (g_array_index (mosaic->ports, gint, n) == port) {
+      g_array_remove_index (mosaic->ports, n);
+      found = TRUE;
+      break;
+    }
+  }
+  len = mosaic->ports->len;
+  GST_VIDEO_MOSAIC_UNLOCK_PORTS (mosaic);
+
+  if (!found || !gst_video_mosaic_is_playing (mosaic))
+    return;
+
+  if (len == 0) {
+    gst_worker_stop_force (GST_WORKER (mosaic), TRUE);
+  } else {
+    gst_video_mosaic_remove_tile (mosaic, port);
+    gst_video_mosaic_layout (mosaic);
+  }
+}
+
+/**
+ * gst_video_mosaic_get_rows:
+ *  @param mosaic the GstVideoMosaic instance
+ *  @return the number of tile rows
+ */
+guint
+gst_video_mosaic_get_rows (GstVideoMosaic * mosaic)
+{
+  guint columns = MAX (mosaic->columns, 1), rows;
+
+  GST_VIDEO_MOSAIC_LOCK_PORTS (mosaic);
+  rows = (mosaic->ports->len + columns - 1) / columns;
+  GST_VIDEO_MOSAIC_UNLOCK_PORTS (mosaic);
+  return rows;
+}
+
+/**
+ * gst_video_mosaic_get_port_at:
+ *  @param mosaic the GstVideoMosaic instance
+ *  @param x the X position, 0.0 to 1.0 of the rendered width
+ *  @param y the Y position, 0.0 to 1.0 of the rendered height
+ *  @return the preview port shown at the position, or 0
+ */
+gint
+gst_video_mosaic_get_port_at (GstVideoMosaic * mosaic, gdouble x, gdouble y)
+{
+  guint columns = MAX (mosaic->columns, 1), rows, n;
+  gint port = 0;
+
+  GST_VIDEO_MOSAIC_LOCK_PORTS (mosaic);
+  rows = (mosaic->ports->len + columns - 1) / columns;
+  if (0 <= x && x < 1 && 0 <= y && y < 1) {
+    n = (guint) (y * rows) * columns + (guint) (x * columns);
+    if (n < mosaic->ports->len)
+      port = g_array_index (mosaic->ports, gint, n);
+  }
+  GST_VIDEO_MOSAIC_UNLOCK_PORTS (mosaic);
+  return port;
+}
+
+static void
+gst_video_mosaic_class_init (GstVideoMosaicClass * klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GstWorkerClass *worker_class = GST_WORKER_CLASS (klass);
+
+  object_class->finalize = (GObjectFinalizeFunc) gst_video_mosaic_finalize;
+  object_class->set_property =
+      (GObjectSetPropertyFunc) gst_video_mosaic_set_property;
+  object_class->get_property =
+      (GObjectGetPropertyFunc) gst_video_mosaic_get_property;
+
+  gst_video_mosaic_signals[SIGNAL_END_PORT] =
+      g_signal_new ("end-port", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (GstVideoMosaicClass, end_port),
+      NULL, NULL, g_cclosure_marshal_generic, G_TYPE_NONE, 1, G_TYPE_INT);
+
+  g_object_class_install_property (object_class, PROP_HANDLE,
+      g_param_spec_ulong ("handle", "Handle",
+          "Window Handle", 0,
+          ((gulong) - 1), 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_COLUMNS,
+      g_param_spec_uint ("columns", "Columns",
+          "Number of tiles in a row", 1, 16, 1,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_SINK,
+      g_param_spec_string ("sink", "Sink",
+          "The video sink rendering the mosaic", "xvimagesink",
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  worker_class->prepare = (GstWorkerPrepareFunc) gst_video_mosaic_prepare;
+  worker_class->get_pipeline_string = (GstWorkerGetPipelineStringFunc)
+      gst_video_mosaic_get_pipeline_string;
+}
@@ -0,0 +1,84 @@
+/* GstSwitch
+ * Copyright (C) 2012,2013 Duzy Chan <code@duzy.info>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*! @file */
+
+#ifndef __GST_VIDEO_MOSAIC_H__by_Duzy_Chan__
+#define __GST_VIDEO_MOSAIC_H__by_Duzy_Chan__ 1
+#include "gstworker.h"
+
+#define GST_TYPE_VIDEO_MOSAIC (gst_video_mosaic_get_type ())
+#define GST_VIDEO_MOSAIC(object) (G_TYPE_CHECK_INSTANCE_CAST ((object), GST_TYPE_VIDEO_MOSAIC, GstVideoMosaic))
+#define GST_VIDEO_MOSAIC_CLASS(class) (G_TYPE_CHECK_CLASS_CAST ((class), GST_TYPE_VIDEO_MOSAIC, GstVideoMosaicClass))
+#define GST_IS_VIDEO_MOSAIC(object) (G_TYPE_CHECK_INSTANCE_TYPE ((object), GST_TYPE_VIDEO_MOSAIC))
+#define GST_IS_VIDEO_MOSAIC_CLASS(class) (G_TYPE_CHECK_CLASS_TYPE ((class), GST_TYPE_VIDEO_MOSAIC))
+
+#define GST_VIDEO_MOSAIC_TILE_WIDTH 240
+#define GST_VIDEO_MOSAIC_TILE_HEIGHT 135
+
+typedef struct _GstVideoMosaic GstVideoMosaic;
+typedef struct _GstVideoMosaicClass GstVideoMosaicClass;
+
+/**
+ *  GstVideoMosaic:
+ *  @param base the parent object
+ *  @param handle the X window handle for rendering the mosaic
+ *  @param columns the number of tiles in a row
+ *  @param sink the name of the video sink element
+ *  @param ports_lock the lock for %ports
+ *  @param ports the preview ports, in the order of the tiles
+ */
+struct _GstVideoMosaic
+{
+  GstWorker base;
+
+  gulong handle;
+  guint columns;
+  gchar *sink;
+
+  GMutex ports_lock;
+  GArray *ports;
+};
+
+/**
+ *  GstVideoMosaicClass:
+ *  @param base_class the parent class
+ *  @param end_port the default handler of the "end-port" signal
+ */
+struct _GstVideoMosaicClass
+{
+  GstWorkerClass base_class;
+
+  void (*end_port) (GstVideoMosaic * mosaic, gint port);
+};
+
+GType gst_video_mosaic_get_type (void);
+void gst_video_mosaic_add_port (GstVideoMosaic * mosaic, gint port);
+void gst_video_mosaic_remove_port (GstVideoMosaic * mosaic, gint port);
+guint gst_video_mosaic_get_rows (GstVideoMosaic * mosaic);
+gint gst_video_mosaic_get_port_at (GstVideoMosaic * mosaic, gdouble x,
+    gdouble y);
+
+#endif //__GST_VIDEO_MOSAIC_H__by_Duzy_Chan__
@@ -53,6 +53,11 @@ enum
 /*!< @internal */
 static guint gst_worker_signals[SIGNAL__LAST] = { 0 };
 
+/*!< @internal */
+static GMutex gst_worker_clock_lock;
+static GstClock *gst_worker_clock = NULL;
+static GstClockTime gst_worker_base_time = GST_CLOCK_TIME_NONE;
+
 extern gboolean verbose;
 
 #if ENABLE_ASSESSMENT
@@ -344,6 +349,118 @@ gst_worker_stop_force (GstWorker * worker, gboolean force)
   return ret == GST_STATE_CHANGE_SUCCESS ? TRUE : FALSE;
 }
 
+void
+gst_worker_use_clock (GstClock * clock, GstClockTime base_time)
+{
+  g_return_if_fail (clock == NULL || GST_IS_CLOCK (clock));
+
+  g_mutex_lock (&gst_worker_clock_lock);
+  if (clock)
+    gst_object_ref (clock);
+  if (gst_worker_clock)
+    gst_object_unref (gst_worker_clock);
+  gst_worker_clock = clock;
+  gst_worker_base_time = base_time;
+  g_mutex_unlock (&gst_worker_clock_lock);
+}
+
+/**
+ * GstWorkerAlignment:
+ *
+ * The offset of an inter source to the shared running time.
+ */
+typedef struct _GstWorkerAlignment
+{
+  gboolean aligned;
+  GstClockTimeDiff offset;
+} GstWorkerAlignment;
+
+/**
+ * gst_worker_align_probe:
+ *
+ * Invoked on the buffers of an inter source. The source stamps its buffers
+ * from zero when it starts, the first buffer gives the offset to the
+ * running time of the shared base time, every buffer is moved by it.
+ */
+static GstPadProbeReturn
+gst_worker_align_probe (GstPad * pad, GstPadProbeInfo * info,
+    GstWorkerAlignment * alignment)
+{
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  GstElement *element;
+  GstClock *clock;
+
+  if (!GST_BUFFER_PTS_IS_VALID (buffer))
+    return GST_PAD_PROBE_OK;
+
+  if (!alignment->aligned) {
+    element = GST_ELEMENT (gst_pad_get_parent (pad));
+    if (!element)
+      return GST_PAD_PROBE_OK;
+    clock = gst_element_get_clock (element);
+    if (clock) {
+      alignment->offset = GST_CLOCK_DIFF (GST_BUFFER_PTS (buffer),
+          gst_clock_get_time (clock) - gst_element_get_base_time (element));
+      alignment->aligned = TRUE;
+      gst_object_unref (clock);
+    }
+    gst_object_unref (element);
+  }
+
+  if (alignment->offset == 0)
+    return GST_PAD_PROBE_OK;
+
+  buffer = gst_buffer_make_writable (buffer);
+  GST_BUFFER_PTS (buffer) += alignment->offset;
+  if (GST_BUFFER_DTS_IS_VALID (buffer))
+    GST_BUFFER_DTS (buffer) += alignment->offset;
+  GST_PAD_PROBE_INFO_DATA (info) = buffer;
+  return GST_PAD_PROBE_OK;
+}
+
+void
+gst_worker_align_sources (GstElement * element)
+{
+  GstIterator *it;
+  GValue item = G_VALUE_INIT;
+  GstElement *source;
+  GstElementFactory *factory;
+  const gchar *name;
+  gboolean done = FALSE;
+  GstPad *pad;
+
+  g_return_if_fail (GST_IS_BIN (element));
+
+  it = gst_bin_iterate_recurse (GST_BIN (element));
+  while (!done) {
+    switch (gst_iterator_next (it, &item)) {
+      case GST_ITERATOR_OK:
+        source = GST_ELEMENT (g_value_get_object (&item));
+        factory = gst_element_get_factory (source);
+        name = factory ? GST_OBJECT_NAME (factory) : NULL;
+        if ((g_strcmp0 (name, "intervideosrc") == 0 ||
+                g_strcmp0 (name, "interaudiosrc") == 0) &&
+            (pad = gst_element_get_static_pad (source, "src"))) {
+          gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+              (GstPadProbeCallback) gst_worker_align_probe,
+              g_new0 (GstWorkerAlignment, 1), g_free);
+          gst_object_unref (pad);
+        }
+        g_value_reset (&item);
+        break;
+      case GST_ITERATOR_RESYNC:
+        gst_iterator_resync (it);
+        break;
+      case GST_ITERATOR_ERROR:
+      case GST_ITERATOR_DONE:
+        done = TRUE;
+        break;
+    }
+  }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+}
+
 GstElement *
 gst_worker_get_element_unlocked (GstWorker * worker, const gchar * name)
 {
@@ -683,6 +800,18 @@ gst_worker_prepare_unsafe (GstWorker * worker)
 
   gst_pipeline_set_auto_flush_bus (GST_PIPELINE (worker->pipeline), FALSE);
 
+  g_mutex_lock (&gst_worker_clock_lock);
+  if (gst_worker_clock)
+    gst_pipeline_use_clock (GST_PIPELINE (worker->pipeline), gst_worker_clock);
+  if (gst_worker_clock && GST_CLOCK_TIME_IS_VALID (gst_worker_base_time)) {
+    /* Keep the base time across state changes, so a restarted pipeline
+       runs on the same timeline as the others. */
+    gst_element_set_start_time (worker->pipeline, GST_CLOCK_TIME_NONE);
+    gst_element_set_base_time (worker->pipeline, gst_worker_base_time);
+    gst_worker_align_sources (worker->pipeline);
+  }
+  g_mutex_unlock (&gst_worker_clock_lock);
+
   worker->bus = gst_pipeline_get_bus (GST_PIPELINE (worker->pipeline));
   if (!worker->bus)
     goto error_get_bus;
@@ -213,6 +213,32 @@ gboolean gst_worker_stop_force (GstWorker * worker, gboolean force);
  */
 #define gst_worker_stop(worker) (gst_worker_stop_force ((worker), FALSE))
 
+/**
+ *  gst_worker_use_clock:
+ *  @param clock the clock to share, or NULL to let pipelines choose
+ *  @param base_time the base time to share, or GST_CLOCK_TIME_NONE
+ *
+ *  Make every worker pipeline prepared from now on use the same clock, so
+ *  that the buffers crossing the inter elements between pipelines are
+ *  timed against one clock. With a valid @base_time the pipelines also
+ *  share one base time and keep it over restarts, so their running times
+ *  are comparable.
+ *
+ *  MT safe.
+ */
+void gst_worker_use_clock (GstClock * clock, GstClockTime base_time);
+
+/**
+ *  gst_worker_align_sources:
+ *  @param element a pipeline or bin
+ *
+ *  Stamp the buffers of the inter sources in @element with the running
+ *  time of the shared base time, rather than from zero when they start, so
+ *  an input joining late lines up with the others. This is done for the
+ *  worker pipelines when they're prepared, bins added later need it too.
+ */
+void gst_worker_align_sources (GstElement * element);
+
 /**
  *  gst_worker_get_element_unlocked:
  *  @param worker the GstWorker instance